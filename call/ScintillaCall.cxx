@@ -12,6 +12,7 @@
 
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "ScintillaTypes.h"
 #include "ScintillaMessages.h"
@@ -146,6 +147,28 @@ Span ScintillaCall::SpanSearchInTarget(std::string_view text) {
 		return Span(posFound, 0);
 }
 
+Position ScintillaCall::SearchAllInTarget(std::string_view text) {
+	return CallString(Message::SearchAllInTarget, text.length(), text.data());
+}
+
+std::vector<Span> ScintillaCall::SpansSearchAllInTarget(std::string_view text) {
+	std::vector<Span> spans;
+	const Position matches = SearchAllInTarget(text);
+	if (matches > 0) {
+		std::vector<Position> ranges(matches * 2);
+		GetSearchAllRanges(matches, ranges.data());
+		spans.reserve(matches);
+		for (Position i = 0; i < matches; i++) {
+			spans.emplace_back(ranges[i * 2], ranges[i * 2 + 1]);
+		}
+	}
+	return spans;
+}
+
+Position ScintillaCall::IndicatorFillAllInTarget(std::string_view text) {
+	return CallString(Message::IndicatorFillAllInTarget, text.length(), text.data());
+}
+
 // Generated methods
 
 // ScintillaCall requires automatically generated casts as it is converting
@@ -335,6 +358,14 @@ void ScintillaCall::SetBufferedDraw(bool buffered) {
 	Call(Message::SetBufferedDraw, buffered);
 }
 
+bool ScintillaCall::RetainedDraw() {
+	return Call(Message::GetRetainedDraw);
+}
+
+void ScintillaCall::SetRetainedDraw(bool retained) {
+	Call(Message::SetRetainedDraw, retained);
+}
+
 void ScintillaCall::SetTabWidth(int tabWidth) {
 	Call(Message::SetTabWidth, tabWidth);
 }
@@ -1519,6 +1550,26 @@ FindOption ScintillaCall::SearchFlags() {
 	return static_cast<Scintilla::FindOption>(Call(Message::GetSearchFlags));
 }
 
+Position ScintillaCall::SearchAllInTarget(Position length, const char *text) {
+	return CallString(Message::SearchAllInTarget, length, text);
+}
+
+Position ScintillaCall::GetSearchAllRanges(Position count, void *ranges) {
+	return CallPointer(Message::GetSearchAllRanges, count, ranges);
+}
+
+Position ScintillaCall::IndicatorFillAllInTarget(Position length, const char *text) {
+	return CallString(Message::IndicatorFillAllInTarget, length, text);
+}
+
+void ScintillaCall::SetSearchThreads(int threads) {
+	Call(Message::SetSearchThreads, threads);
+}
+
+int ScintillaCall::SearchThreads() {
+	return static_cast<int>(Call(Message::GetSearchThreads));
+}
+
 void ScintillaCall::CallTipShow(Position pos, const char *definition) {
 	CallString(Message::CallTipShow, pos, definition);
 }
@@ -1771,6 +1822,18 @@ LineCache ScintillaCall::LayoutCache() {
 	return static_cast<Scintilla::LineCache>(Call(Message::GetLayoutCache));
 }
 
+void ScintillaCall::SetLayoutCacheMemoryLimit(Position bytes) {
+	Call(Message::SetLayoutCacheMemoryLimit, bytes);
+}
+
+Position ScintillaCall::LayoutCacheMemoryLimit() {
+	return Call(Message::GetLayoutCacheMemoryLimit);
+}
+
+Position ScintillaCall::LayoutCacheMemory() {
+	return Call(Message::GetLayoutCacheMemory);
+}
+
 void ScintillaCall::SetScrollWidth(int pixelWidth) {
 	Call(Message::SetScrollWidth, pixelWidth);
 }
@@ -2727,6 +2790,30 @@ int ScintillaCall::PositionCache() {
 	return static_cast<int>(Call(Message::GetPositionCache));
 }
 
+void ScintillaCall::SetPositionCacheKeyLength(int length) {
+	Call(Message::SetPositionCacheKeyLength, length);
+}
+
+int ScintillaCall::PositionCacheKeyLength() {
+	return static_cast<int>(Call(Message::GetPositionCacheKeyLength));
+}
+
+void ScintillaCall::SetPositionCacheAssociativity(int ways) {
+	Call(Message::SetPositionCacheAssociativity, ways);
+}
+
+int ScintillaCall::PositionCacheAssociativity() {
+	return static_cast<int>(Call(Message::GetPositionCacheAssociativity));
+}
+
+Position ScintillaCall::PositionCacheStatistic(Scintilla::PositionCacheStatistic statistic) {
+	return Call(Message::GetPositionCacheStatistic, static_cast<uintptr_t>(statistic));
+}
+
+Position ScintillaCall::ShapedTextCacheStatistic(Scintilla::ShapedTextCacheStatistic statistic) {
+	return Call(Message::GetShapedTextCacheStatistic, static_cast<uintptr_t>(statistic));
+}
+
 void ScintillaCall::SetLayoutThreads(int threads) {
 	Call(Message::SetLayoutThreads, threads);
 }
@@ -2735,6 +2822,14 @@ int ScintillaCall::LayoutThreads() {
 	return static_cast<int>(Call(Message::GetLayoutThreads));
 }
 
+void ScintillaCall::SetLazyLayoutLength(Position length) {
+	Call(Message::SetLazyLayoutLength, length);
+}
+
+Position ScintillaCall::LazyLayoutLength() {
+	return Call(Message::GetLazyLayoutLength);
+}
+
 void ScintillaCall::CopyAllowLine() {
 	Call(Message::CopyAllowLine);
 }
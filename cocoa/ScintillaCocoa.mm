@@ -787,6 +787,7 @@ Scintilla::Internal::Point ScintillaCocoa::ConvertPoint(NSPoint point) {
  * Do not clip like superclass as Cocoa is not reporting all of prepared area.
  */
 void ScintillaCocoa::RedrawRect(PRectangle rc) {
+	InvalidateRetained(rc);
 	if (!rc.Empty())
 		wMain.InvalidateRectangle(rc);
 }
@@ -809,6 +810,7 @@ void ScintillaCocoa::DiscardOverdraw() {
  * Ensure all of prepared content is also redrawn.
  */
 void ScintillaCocoa::Redraw() {
+	InvalidateRetained();
 	wMargin.InvalidateAll();
 	DiscardOverdraw();
 	wMain.InvalidateAll();
@@ -5,6 +5,7 @@
 
 #include <cstddef>
 #include <cstdlib>
+#include <cstdint>
 #include <cstring>
 #include <cstdio>
 #include <cmath>
@@ -15,8 +16,11 @@
 #include <map>
 #include <optional>
 #include <algorithm>
+#include <functional>
 #include <memory>
 #include <sstream>
+#include <atomic>
+#include <thread>
 
 #include <glib.h>
 #include <gmodule.h>
@@ -87,13 +91,36 @@ void LayoutSetText(PangoLayout *layout, std::string_view text) noexcept {
 
 enum class EncodingType { singleByte, utf8, dbcs };
 
+std::atomic<size_t> fontsAllocated{};
+
+// Draw each run of a laid out line with the glyphs found when it was laid out.
+// pango_cairo_show_glyph_string places each glyph at its geometry x_offset and y_offset
+// from the current point so, as in pango_cairo_show_layout_line, the current point is
+// moved to the baseline of each run.
+void ShowGlyphs(cairo_t *cr, const PangoLayoutLine *pll, XYPOSITION x, XYPOSITION ybase) {
+	for (const GSList *run = pll->runs; run; run = run->next) {
+		const PangoGlyphItem *glyphItem = static_cast<const PangoGlyphItem *>(run->data);
+		XYPOSITION yRun = ybase;
+#if PANGO_VERSION_CHECK(1,50,0)
+		// Runs may be shifted from the line's baseline with positive values moving up
+		yRun -= pango_units_to_double(glyphItem->y_offset);
+#endif
+		cairo_move_to(cr, x, yRun);
+		pango_cairo_show_glyph_string(cr, glyphItem->item->analysis.font, glyphItem->glyphs);
+		x += pango_units_to_double(pango_glyph_string_get_width(glyphItem->glyphs));
+	}
+}
+
 // Holds a PangoFontDescription*.
 class FontHandle : public Font {
 public:
 	UniquePangoFontDescription fd;
 	CharacterSet characterSet;
+	// Unique for each font so text shaped in a font can be found after the font is destroyed
+	// and its address reused.
+	size_t id;
 	explicit FontHandle(const FontParameters &fp) :
-		fd(pango_font_description_new()), characterSet(fp.characterSet) {
+		fd(pango_font_description_new()), characterSet(fp.characterSet), id(++fontsAllocated) {
 		if (fd) {
 			pango_font_description_set_family(fd.get(),
 				(fp.faceName[0] == '!') ? fp.faceName + 1 : fp.faceName);
@@ -114,6 +141,148 @@ const FontHandle *PFont(const Font *f) noexcept {
 	return dynamic_cast<const FontHandle *>(f);
 }
 
+UniquePangoContext CreateMeasuringContext(double resolution, PangoDirection direction,
+	const cairo_font_options_t *fontOptions, PangoLanguage *language) {
+	UniquePangoFontMap fmMeasure(pango_cairo_font_map_get_default());
+	PLATFORM_ASSERT(fmMeasure);
+	UniquePangoContext contextMeasure(pango_font_map_create_context(fmMeasure.release()));
+	PLATFORM_ASSERT(contextMeasure);
+	SetFractionalPositions(contextMeasure.get());
+
+	pango_cairo_context_set_resolution(contextMeasure.get(), resolution);
+	pango_context_set_base_dir(contextMeasure.get(), direction);
+	pango_cairo_context_set_font_options(contextMeasure.get(), fontOptions);
+	pango_context_set_language(contextMeasure.get(), language);
+
+	return contextMeasure;
+}
+
+bool SameFontOptions(const cairo_font_options_t *a, const cairo_font_options_t *b) noexcept {
+	if (!a || !b)
+		return a == b;
+	return cairo_font_options_equal(a, b);
+}
+
+// Set associative cache of layouts of short texts, so text measured while laying out a
+// line is not shaped again when it is drawn or when it is drawn again in later paints.
+// Layouts are created from a measuring context for the resolution, direction, font options,
+// and language of the surface using them so entries are keyed by those settings along with
+// the font and text. Surfaces with different settings share the cache without emptying it.
+// Pango font maps are per-thread so the cache is only used by the thread that initialised
+// the platform, which performs all drawing. Other threads lay out text themselves.
+class LayoutCache {
+	// A measuring context for one combination of settings that affect shaping.
+	struct Settings {
+		size_t id = 0;
+		double resolution = 0.0;
+		PangoDirection direction = PANGO_DIRECTION_LTR;
+		UniqueFontOptions fontOptions;
+		PangoLanguage *language = nullptr;
+		UniquePangoContext context;
+		uint64_t lastUsed = 0;
+		bool Matches(double resolution_, PangoDirection direction_,
+			const cairo_font_options_t *fontOptions_, PangoLanguage *language_) const noexcept {
+			return context && (resolution == resolution_) && (direction == direction_) &&
+				(language == language_) && SameFontOptions(fontOptions.get(), fontOptions_);
+		}
+	};
+	struct Entry {
+		size_t settingsId = 0;
+		size_t fontId = 0;
+		std::string text;
+		UniquePangoLayout layout;
+		uint64_t lastUsed = 0;
+	};
+	static constexpr size_t sets = 256;
+	static constexpr size_t ways = 4;
+	static constexpr size_t textLengthMaximum = 256;
+	// Commonly one setting for the screen with others for printing or a second display
+	static constexpr size_t settingsMaximum = 4;
+	std::vector<Settings> settings;
+	std::vector<Entry> entries;
+	uint64_t clock = 0;
+	size_t settingsAllocated = 0;
+
+	// Find the settings for a surface, replacing the least recently used when not present.
+	// Entries of replaced settings no longer match as each settings has a new id.
+	const Settings &SettingsFor(double resolution_, PangoDirection direction_,
+		const cairo_font_options_t *fontOptions_, PangoLanguage *language_) {
+		Settings *oldest = nullptr;
+		for (Settings &candidate : settings) {
+			if (candidate.Matches(resolution_, direction_, fontOptions_, language_)) {
+				candidate.lastUsed = ++clock;
+				return candidate;
+			}
+			if (!oldest || (candidate.lastUsed < oldest->lastUsed)) {
+				oldest = &candidate;
+			}
+		}
+		if (settings.size() < settingsMaximum) {
+			oldest = &settings.emplace_back();
+		}
+		oldest->id = ++settingsAllocated;
+		oldest->resolution = resolution_;
+		oldest->direction = direction_;
+		oldest->fontOptions.reset(fontOptions_ ? cairo_font_options_copy(fontOptions_) : nullptr);
+		oldest->language = language_;
+		oldest->context = CreateMeasuringContext(resolution_, direction_, oldest->fontOptions.get(), language_);
+		oldest->lastUsed = ++clock;
+		entries.resize(sets * ways);
+		return *oldest;
+	}
+public:
+	std::thread::id owner;
+	size_t hits = 0;
+	size_t misses = 0;
+	size_t evictions = 0;
+
+	bool Usable(std::string_view text) const noexcept {
+		return !text.empty() && (text.length() <= textLengthMaximum) && (owner == std::this_thread::get_id());
+	}
+
+	void Clear() noexcept {
+		entries.clear();
+		settings.clear();
+	}
+
+	PangoLayout *Find(const FontHandle *font, std::string_view text, double resolution_,
+		PangoDirection direction_, const cairo_font_options_t *fontOptions_, PangoLanguage *language_) {
+		const Settings &current = SettingsFor(resolution_, direction_, fontOptions_, language_);
+		const size_t hashValue = std::hash<std::string_view>{}(text) ^
+			(std::hash<size_t>{}(font->id) << 1) ^ (std::hash<size_t>{}(current.id) << 2);
+		const size_t set = hashValue % sets;
+		Entry *victim = nullptr;
+		for (size_t entry = set * ways; entry < (set + 1) * ways; entry++) {
+			Entry &candidate = entries[entry];
+			if (candidate.layout && (candidate.settingsId == current.id) &&
+				(candidate.fontId == font->id) && (candidate.text == text)) {
+				candidate.lastUsed = ++clock;
+				hits++;
+				return candidate.layout.get();
+			}
+			if (!victim || (candidate.lastUsed < victim->lastUsed)) {
+				victim = &candidate;
+			}
+		}
+		misses++;
+		if (victim->layout) {
+			evictions++;
+		}
+		if (!victim->layout || (victim->settingsId != current.id)) {
+			victim->layout.reset(pango_layout_new(current.context.get()));
+		}
+		victim->settingsId = current.id;
+		victim->fontId = font->id;
+		victim->text.assign(text);
+		victim->lastUsed = ++clock;
+		pango_layout_set_font_description(victim->layout.get(), font->fd.get());
+		LayoutSetText(victim->layout.get(), text);
+		return victim->layout.get();
+	}
+};
+
+LayoutCache layoutCache;
+
 }
 
 std::shared_ptr<Font> Font::Allocate(const FontParameters &fp) {
@@ -155,6 +324,9 @@ public:
 
 	void GetContextState() noexcept;
 	UniquePangoContext MeasuringContext();
+	// Returns a layout of UTF-8 text from the shared cache when possible, otherwise lays the text
+	// out in a new layout for measuring when layoutMeasure is set or else in this surface's layout.
+	PangoLayout *LayoutText(const Font *font_, std::string_view utf8, UniquePangoLayout *layoutMeasure);
 
 	void Init(WindowID wid) override;
 	void Init(SurfaceID sid, WindowID wid) override;
@@ -363,18 +535,24 @@ void SurfaceImpl::GetContextState() noexcept {
 }
 
 UniquePangoContext SurfaceImpl::MeasuringContext() {
-	UniquePangoFontMap fmMeasure(pango_cairo_font_map_get_default());
-	PLATFORM_ASSERT(fmMeasure);
-	UniquePangoContext contextMeasure(pango_font_map_create_context(fmMeasure.release()));
-	PLATFORM_ASSERT(contextMeasure);
-	SetFractionalPositions(contextMeasure.get());
-
-	pango_cairo_context_set_resolution(contextMeasure.get(), resolution);
-	pango_context_set_base_dir(contextMeasure.get(), direction);
-	pango_cairo_context_set_font_options(contextMeasure.get(), fontOptions);
-	pango_context_set_language(contextMeasure.get(), language);
+	return CreateMeasuringContext(resolution, direction, fontOptions, language);
+}
 
-	return contextMeasure;
+PangoLayout *SurfaceImpl::LayoutText(const Font *font_, std::string_view utf8, UniquePangoLayout *layoutMeasure) {
+	const FontHandle *pfont = PFont(font_);
+	if (layoutCache.Usable(utf8)) {
+		return layoutCache.Find(pfont, utf8, resolution, direction, fontOptions, language);
+	}
+	PangoLayout *layoutText = layout.get();
+	if (layoutMeasure) {
+		UniquePangoContext contextMeasure = MeasuringContext();
+		layoutMeasure->reset(pango_layout_new(contextMeasure.get()));
+		PLATFORM_ASSERT(*layoutMeasure);
+		layoutText = layoutMeasure->get();
+	}
+	pango_layout_set_font_description(layoutText, pfont->fd.get());
+	LayoutSetText(layoutText, utf8);
+	return layoutText;
 }
 
 void SurfaceImpl::Init(WindowID wid) {
@@ -776,25 +954,16 @@ size_t MultiByteLenFromIconv(const Converter &conv, const char *s, size_t len) n
 
 void SurfaceImpl::DrawTextBase(PRectangle rc, const Font *font_, XYPOSITION ybase, std::string_view text,
 			       ColourRGBA fore) {
-	if (context) {
-		PenColourAlpha(fore);
-		const XYPOSITION xText = rc.left;
-		if (PFont(font_)->fd) {
-			if (et == EncodingType::utf8) {
-				LayoutSetText(layout.get(), text);
-			} else {
-				SetConverter(PFont(font_)->characterSet);
-				std::string utfForm = UTF8FromIconv(conv, text);
-				if (utfForm.empty()) {	// iconv failed so treat as Latin1
-					utfForm = UTF8FromLatin1(text);
-				}
-				LayoutSetText(layout.get(), utfForm);
+	if (context && PFont(font_)->fd) {
+		if (et == EncodingType::utf8) {
+			DrawTextBaseUTF8(rc, font_, ybase, text, fore);
+		} else {
+			SetConverter(PFont(font_)->characterSet);
+			std::string utfForm = UTF8FromIconv(conv, text);
+			if (utfForm.empty()) {	// iconv failed so treat as Latin1
+				utfForm = UTF8FromLatin1(text);
 			}
-			pango_layout_set_font_description(layout.get(), PFont(font_)->fd.get());
-			pango_cairo_update_layout(context, layout.get());
-			PangoLayoutLine *pll = pango_layout_get_line_readonly(layout.get(), 0);
-			cairo_move_to(context, xText, ybase);
-			pango_cairo_show_layout_line(context, pll);
+			DrawTextBaseUTF8(rc, font_, ybase, utfForm, fore);
 		}
 	}
 }
@@ -837,7 +1006,6 @@ public:
 	int curIndex = 0;
 	ClusterIterator(PangoLayout *layout, std::string_view text) noexcept :
 		lenPositions(static_cast<int>(text.length())) {
-		LayoutSetText(layout, text);
 		iter.reset(pango_layout_get_iter(layout));
 		curIndex = pango_layout_iter_get_index(iter.get());
 		pango_layout_iter_get_cluster_extents(iter.get(), nullptr, &pos);
@@ -872,18 +1040,15 @@ void EquallySpaced(PangoLayout *layout, XYPOSITION *positions, size_t lenPositio
 
 void SurfaceImpl::MeasureWidths(const Font *font_, std::string_view text, XYPOSITION *positions) {
 	if (PFont(font_)->fd) {
-		UniquePangoContext contextMeasure = MeasuringContext();
-		UniquePangoLayout layoutMeasure(pango_layout_new(contextMeasure.get()));
-		PLATFORM_ASSERT(layoutMeasure);
-
-		pango_layout_set_font_description(layoutMeasure.get(), PFont(font_)->fd.get());
+		UniquePangoLayout layoutOwned;
 		if (et == EncodingType::utf8) {
 			// Simple and direct as UTF-8 is native Pango encoding
-			ClusterIterator iti(layoutMeasure.get(), text);
+			PangoLayout *layoutMeasure = LayoutText(font_, text, &layoutOwned);
+			ClusterIterator iti(layoutMeasure, text);
 			int i = iti.curIndex;
 			if (i != 0) {
 				// Unexpected start to iteration, could be bidirectional text
-				EquallySpaced(layoutMeasure.get(), positions, text.length());
+				EquallySpaced(layoutMeasure, positions, text.length());
 				return;
 			}
 			while (!iti.finished) {
@@ -930,11 +1095,12 @@ void SurfaceImpl::MeasureWidths(const Font *font_, std::string_view text, XYPOSI
 					// character byte lengths.
 					Converter convMeasure("UCS-2", charSetID, false);
 					int i = 0;
-					ClusterIterator iti(layoutMeasure.get(), utfForm);
+					PangoLayout *layoutMeasure = LayoutText(font_, utfForm, &layoutOwned);
+					ClusterIterator iti(layoutMeasure, utfForm);
 					int clusterStart = iti.curIndex;
 					if (clusterStart != 0) {
 						// Unexpected start to iteration, could be bidirectional text
-						EquallySpaced(layoutMeasure.get(), positions, text.length());
+						EquallySpaced(layoutMeasure, positions, text.length());
 						return;
 					}
 					while (!iti.finished) {
@@ -969,11 +1135,12 @@ void SurfaceImpl::MeasureWidths(const Font *font_, std::string_view text, XYPOSI
 				size_t i = 0;
 				// Each 8-bit input character may take 1 or 2 bytes in UTF-8
 				// and groups of up to 3 may be represented as ligatures.
-				ClusterIterator iti(layoutMeasure.get(), utfForm);
+				PangoLayout *layoutMeasure = LayoutText(font_, utfForm, &layoutOwned);
+				ClusterIterator iti(layoutMeasure, utfForm);
 				int clusterStart = iti.curIndex;
 				if (clusterStart != 0) {
 					// Unexpected start to iteration, could be bidirectional text
-					EquallySpaced(layoutMeasure.get(), positions, lenPositions);
+					EquallySpaced(layoutMeasure, positions, lenPositions);
 					return;
 				}
 				while (!iti.finished) {
@@ -986,7 +1153,7 @@ void SurfaceImpl::MeasureWidths(const Font *font_, std::string_view text, XYPOSI
 #ifdef DEBUG
 						fprintf(stderr, "MeasureWidths: result too long.\n");
 #endif
-						EquallySpaced(layoutMeasure.get(), positions, lenPositions);
+						EquallySpaced(layoutMeasure, positions, lenPositions);
 						return;
 					}
 					PLATFORM_ASSERT(ligatureLength > 0 && ligatureLength <= 3);
@@ -1012,21 +1179,15 @@ void SurfaceImpl::MeasureWidths(const Font *font_, std::string_view text, XYPOSI
 
 XYPOSITION SurfaceImpl::WidthText(const Font *font_, std::string_view text) {
 	if (PFont(font_)->fd) {
-		pango_layout_set_font_description(layout.get(), PFont(font_)->fd.get());
 		if (et == EncodingType::utf8) {
-			LayoutSetText(layout.get(), text);
-		} else {
-			SetConverter(PFont(font_)->characterSet);
-			std::string utfForm = UTF8FromIconv(conv, text);
-			if (utfForm.empty()) {	// iconv failed so treat as Latin1
-				utfForm = UTF8FromLatin1(text);
-			}
-			LayoutSetText(layout.get(), utfForm);
+			return WidthTextUTF8(font_, text);
 		}
-		PangoLayoutLine *pangoLine = pango_layout_get_line_readonly(layout.get(), 0);
-		PangoRectangle pos {};
-		pango_layout_line_get_extents(pangoLine, nullptr, &pos);
-		return pango_units_to_double(pos.width);
+		SetConverter(PFont(font_)->characterSet);
+		std::string utfForm = UTF8FromIconv(conv, text);
+		if (utfForm.empty()) {	// iconv failed so treat as Latin1
+			utfForm = UTF8FromLatin1(text);
+		}
+		return WidthTextUTF8(font_, utfForm);
 	}
 	return 1;
 }
@@ -1037,12 +1198,17 @@ void SurfaceImpl::DrawTextBaseUTF8(PRectangle rc, const Font *font_, XYPOSITION
 		PenColourAlpha(fore);
 		const XYPOSITION xText = rc.left;
 		if (PFont(font_)->fd) {
-			LayoutSetText(layout.get(), text);
-			pango_layout_set_font_description(layout.get(), PFont(font_)->fd.get());
-			pango_cairo_update_layout(context, layout.get());
-			PangoLayoutLine *pll = pango_layout_get_line_readonly(layout.get(), 0);
-			cairo_move_to(context, xText, ybase);
-			pango_cairo_show_layout_line(context, pll);
+			PangoLayout *layoutDraw = LayoutText(font_, text, nullptr);
+			PangoLayoutLine *pll = pango_layout_get_line_readonly(layoutDraw, 0);
+			if (layoutDraw == layout.get()) {
+				pango_cairo_update_layout(context, layoutDraw);
+				cairo_move_to(context, xText, ybase);
+				pango_cairo_show_layout_line(context, pll);
+			} else {
+				// Cached layouts share a measuring context which must not be updated for drawing
+				// as later measurements would then differ, so their glyphs are drawn as measured.
+				ShowGlyphs(context, pll, xText, ybase);
+			}
 		}
 	}
 }
@@ -1073,17 +1239,14 @@ void SurfaceImpl::DrawTextTransparentUTF8(PRectangle rc, const Font *font_, XYPO
 
 void SurfaceImpl::MeasureWidthsUTF8(const Font *font_, std::string_view text, XYPOSITION *positions) {
 	if (PFont(font_)->fd) {
-		UniquePangoContext contextMeasure = MeasuringContext();
-		UniquePangoLayout layoutMeasure(pango_layout_new(contextMeasure.get()));
-		PLATFORM_ASSERT(layoutMeasure);
-
-		pango_layout_set_font_description(layoutMeasure.get(), PFont(font_)->fd.get());
+		UniquePangoLayout layoutOwned;
+		PangoLayout *layoutMeasure = LayoutText(font_, text, &layoutOwned);
 		// Simple and direct as UTF-8 is native Pango encoding
-		ClusterIterator iti(layoutMeasure.get(), text);
+		ClusterIterator iti(layoutMeasure, text);
 		int i = iti.curIndex;
 		if (i != 0) {
 			// Unexpected start to iteration, could be bidirectional text
-			EquallySpaced(layoutMeasure.get(), positions, text.length());
+			EquallySpaced(layoutMeasure, positions, text.length());
 			return;
 		}
 		while (!iti.finished) {
@@ -1130,9 +1293,8 @@ void SurfaceImpl::MeasureWidthsUTF8(const Font *font_, std::string_view text, XY
 
 XYPOSITION SurfaceImpl::WidthTextUTF8(const Font *font_, std::string_view text) {
 	if (PFont(font_)->fd) {
-		pango_layout_set_font_description(layout.get(), PFont(font_)->fd.get());
-		LayoutSetText(layout.get(), text);
-		PangoLayoutLine *pangoLine = pango_layout_get_line_readonly(layout.get(), 0);
+		PangoLayout *layoutWidth = LayoutText(font_, text, nullptr);
+		PangoLayoutLine *pangoLine = pango_layout_get_line_readonly(layoutWidth, 0);
 		PangoRectangle pos{};
 		pango_layout_line_get_extents(pangoLine, nullptr, &pos);
 		return pango_units_to_double(pos.width);
@@ -2234,7 +2396,22 @@ void Platform::Assert(const char *c, const char *file, int line) noexcept {
 }
 
 void Platform_Initialise() {
+	// Text is drawn on this thread so only it uses the layout cache
+	layoutCache.owner = std::this_thread::get_id();
 }
 
 void Platform_Finalise() {
+	layoutCache.Clear();
+}
+
+size_t Platform_ShapedTextCacheStatistic(ShapedTextCacheStatistic statistic) noexcept {
+	switch (statistic) {
+	case ShapedTextCacheStatistic::Hits:
+		return layoutCache.hits;
+	case ShapedTextCacheStatistic::Misses:
+		return layoutCache.misses;
+	case ShapedTextCacheStatistic::Evictions:
+		return layoutCache.evictions;
+	}
+	return 0;
 }
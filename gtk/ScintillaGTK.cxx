@@ -101,6 +101,7 @@ using namespace Scintilla::Internal;
 extern std::string UTF8FromLatin1(std::string_view text);
 extern void Platform_Initialise();
 extern void Platform_Finalise();
+extern size_t Platform_ShapedTextCacheStatistic(ShapedTextCacheStatistic statistic) noexcept;
 
 namespace {
 
@@ -918,6 +919,9 @@ sptr_t ScintillaGTK::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		case Message::GetRectangularSelectionModifier:
 			return rectangularSelectionModifier;
 
+		case Message::GetShapedTextCacheStatistic:
+			return Platform_ShapedTextCacheStatistic(static_cast<ShapedTextCacheStatistic>(wParam));
+
 		case Message::SetReadOnly: {
 				const sptr_t ret = ScintillaBase::WndProc(iMessage, wParam, lParam);
 				if (accessible) {
@@ -78,6 +78,14 @@ struct CairoSurfaceReleaser {
 
 using UniqueCairoSurface = std::unique_ptr<cairo_surface_t, CairoSurfaceReleaser>;
 
+struct FontOptionsReleaser {
+	void operator()(cairo_font_options_t *options) noexcept {
+		cairo_font_options_destroy(options);
+	}
+};
+
+using UniqueFontOptions = std::unique_ptr<cairo_font_options_t, FontOptionsReleaser>;
+
 // GTK
 
 using UniqueIMContext = std::unique_ptr<GtkIMContext, GObjectReleaser>;
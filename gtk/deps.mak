@@ -114,6 +114,45 @@ AutoComplete.o: \
 	../src/CharacterType.h \
 	../src/Position.h \
 	../src/AutoComplete.h
+BackgroundWrap.o: \
+	../src/BackgroundWrap.cxx \
+	../include/ScintillaTypes.h \
+	../include/ScintillaMessages.h \
+	../include/ScintillaStructures.h \
+	../include/ILoader.h \
+	../include/Sci_Position.h \
+	../include/ILexer.h \
+	../src/Debugging.h \
+	../src/Geometry.h \
+	../src/Platform.h \
+	../src/CharacterType.h \
+	../src/CharacterCategoryMap.h \
+	../src/Position.h \
+	../src/UniqueString.h \
+	../src/SplitVector.h \
+	../src/Partitioning.h \
+	../src/RunStyles.h \
+	../src/ContractionState.h \
+	../src/CellBuffer.h \
+	../src/PerLine.h \
+	../src/KeyMap.h \
+	../src/Indicator.h \
+	../src/LineMarker.h \
+	../src/Style.h \
+	../src/ViewStyle.h \
+	../src/CharClassify.h \
+	../src/Decoration.h \
+	../src/CaseFolder.h \
+	../src/Document.h \
+	../src/UniConversion.h \
+	../src/Selection.h \
+	../src/PositionCache.h \
+	../src/EditModel.h \
+	../src/MarginView.h \
+	../src/EditView.h \
+	../src/ElapsedPeriod.h \
+	../src/ThreadPool.h \
+	../src/BackgroundWrap.h
 CallTip.o: \
 	../src/CallTip.cxx \
 	../include/ScintillaTypes.h \
@@ -138,7 +177,10 @@ CellBuffer.o: \
 	../src/Debugging.h \
 	../src/Position.h \
 	../src/SplitVector.h \
+	../src/RopeVector.h \
 	../src/Partitioning.h \
+	../src/TreePartitioning.h \
+	../src/PieceTable.h \
 	../src/RunStyles.h \
 	../src/SparseVector.h \
 	../src/ChangeHistory.h \
@@ -172,6 +214,7 @@ ContractionState.o: \
 	../src/UniqueString.h \
 	../src/SplitVector.h \
 	../src/Partitioning.h \
+	../src/TreePartitioning.h \
 	../src/RunStyles.h \
 	../src/SparseVector.h \
 	../src/ContractionState.h
@@ -207,8 +250,10 @@ Document.o: \
 	../src/CaseFolder.h \
 	../src/Document.h \
 	../src/RESearch.h \
+	../src/LinearRegex.h \
 	../src/UniConversion.h \
-	../src/ElapsedPeriod.h
+	../src/ElapsedPeriod.h \
+	../src/ThreadPool.h
 EditModel.o: \
 	../src/EditModel.cxx \
 	../include/ScintillaTypes.h \
@@ -276,7 +321,9 @@ Editor.o: \
 	../src/MarginView.h \
 	../src/EditView.h \
 	../src/Editor.h \
-	../src/ElapsedPeriod.h
+	../src/ElapsedPeriod.h \
+	../src/ThreadPool.h \
+	../src/BackgroundWrap.h
 EditView.o: \
 	../src/EditView.cxx \
 	../include/ScintillaTypes.h \
@@ -313,7 +360,8 @@ EditView.o: \
 	../src/EditModel.h \
 	../src/MarginView.h \
 	../src/EditView.h \
-	../src/ElapsedPeriod.h
+	../src/ElapsedPeriod.h \
+	../src/ThreadPool.h
 Geometry.o: \
 	../src/Geometry.cxx \
 	../src/Geometry.h
@@ -333,6 +381,27 @@ KeyMap.o: \
 	../src/Geometry.h \
 	../src/Platform.h \
 	../src/KeyMap.h
+LinearRegex.o: \
+	../src/LinearRegex.cxx \
+	../include/ScintillaTypes.h \
+	../include/ILoader.h \
+	../include/Sci_Position.h \
+	../include/ILexer.h \
+	../src/Debugging.h \
+	../src/CharacterType.h \
+	../src/CharacterCategoryMap.h \
+	../src/Position.h \
+	../src/SplitVector.h \
+	../src/Partitioning.h \
+	../src/RunStyles.h \
+	../src/CellBuffer.h \
+	../src/PerLine.h \
+	../src/CharClassify.h \
+	../src/Decoration.h \
+	../src/CaseFolder.h \
+	../src/Document.h \
+	../src/LinearRegex.h \
+	../src/UniConversion.h
 LineMarker.o: \
 	../src/LineMarker.cxx \
 	../include/ScintillaTypes.h \
@@ -430,6 +499,7 @@ RunStyles.o: \
 	../src/Position.h \
 	../src/SplitVector.h \
 	../src/Partitioning.h \
+	../src/TreePartitioning.h \
 	../src/RunStyles.h
 ScintillaBase.o: \
 	../src/ScintillaBase.cxx \
@@ -473,6 +543,10 @@ Selection.o: \
 	../src/Debugging.h \
 	../src/Position.h \
 	../src/Selection.h
+SplitVector.o: \
+	../src/SplitVector.cxx \
+	../src/Debugging.h \
+	../src/SplitVector.h
 Style.o: \
 	../src/Style.cxx \
 	../include/ScintillaTypes.h \
@@ -480,6 +554,9 @@ Style.o: \
 	../src/Geometry.h \
 	../src/Platform.h \
 	../src/Style.h
+ThreadPool.o: \
+	../src/ThreadPool.cxx \
+	../src/ThreadPool.h
 UndoHistory.o: \
 	../src/UndoHistory.cxx \
 	../include/ScintillaTypes.h \
@@ -97,6 +97,8 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_SETSTYLING 2033
 #define SCI_GETBUFFEREDDRAW 2034
 #define SCI_SETBUFFEREDDRAW 2035
+#define SCI_GETRETAINEDDRAW 2823
+#define SCI_SETRETAINEDDRAW 2824
 #define SCI_SETTABWIDTH 2036
 #define SCI_GETTABWIDTH 2121
 #define SCI_SETTABMINIMUMWIDTH 2724
@@ -522,6 +524,7 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCFIND_REGEXP 0x00200000
 #define SCFIND_POSIX 0x00400000
 #define SCFIND_CXX11REGEX 0x00800000
+#define SCFIND_LINEARREGEX 0x01000000
 #define SCI_FINDTEXT 2150
 #define SCI_FINDTEXTFULL 2196
 #define SCI_FORMATRANGE 2151
@@ -593,6 +596,11 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_SEARCHINTARGET 2197
 #define SCI_SETSEARCHFLAGS 2198
 #define SCI_GETSEARCHFLAGS 2199
+#define SCI_SEARCHALLINTARGET 2828
+#define SCI_GETSEARCHALLRANGES 2829
+#define SCI_INDICATORFILLALLINTARGET 2830
+#define SCI_SETSEARCHTHREADS 2831
+#define SCI_GETSEARCHTHREADS 2832
 #define SCI_CALLTIPSHOW 2200
 #define SCI_CALLTIPCANCEL 2201
 #define SCI_CALLTIPACTIVE 2202
@@ -700,8 +708,12 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SC_CACHE_CARET 1
 #define SC_CACHE_PAGE 2
 #define SC_CACHE_DOCUMENT 3
+#define SC_CACHE_DOCUMENT_BOUNDED 4
 #define SCI_SETLAYOUTCACHE 2272
 #define SCI_GETLAYOUTCACHE 2273
+#define SCI_SETLAYOUTCACHEMEMORYLIMIT 2820
+#define SCI_GETLAYOUTCACHEMEMORYLIMIT 2821
+#define SCI_GETLAYOUTCACHEMEMORY 2822
 #define SCI_SETSCROLLWIDTH 2274
 #define SCI_GETSCROLLWIDTH 2275
 #define SCI_SETSCROLLWIDTHTRACKING 2516
@@ -840,6 +852,9 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SC_DOCUMENTOPTION_DEFAULT 0
 #define SC_DOCUMENTOPTION_STYLES_NONE 0x1
 #define SC_DOCUMENTOPTION_TEXT_LARGE 0x100
+#define SC_DOCUMENTOPTION_TEXT_ROPE 0x200
+#define SC_DOCUMENTOPTION_TEXT_MAPPED 0x400
+#define SC_DOCUMENTOPTION_LINES_TREE 0x800
 #define SCI_CREATEDOCUMENT 2375
 #define SCI_ADDREFDOCUMENT 2376
 #define SCI_RELEASEDOCUMENT 2377
@@ -990,8 +1005,22 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_INDICATOREND 2509
 #define SCI_SETPOSITIONCACHE 2514
 #define SCI_GETPOSITIONCACHE 2515
+#define SCI_SETPOSITIONCACHEKEYLENGTH 2815
+#define SCI_GETPOSITIONCACHEKEYLENGTH 2816
+#define SCI_SETPOSITIONCACHEASSOCIATIVITY 2817
+#define SCI_GETPOSITIONCACHEASSOCIATIVITY 2818
+#define SC_POSITIONCACHESTATISTIC_HITS 0
+#define SC_POSITIONCACHESTATISTIC_MISSES 1
+#define SC_POSITIONCACHESTATISTIC_EVICTIONS 2
+#define SCI_GETPOSITIONCACHESTATISTIC 2819
+#define SC_SHAPEDTEXTCACHESTATISTIC_HITS 0
+#define SC_SHAPEDTEXTCACHESTATISTIC_MISSES 1
+#define SC_SHAPEDTEXTCACHESTATISTIC_EVICTIONS 2
+#define SCI_GETSHAPEDTEXTCACHESTATISTIC 2825
 #define SCI_SETLAYOUTTHREADS 2775
 #define SCI_GETLAYOUTTHREADS 2776
+#define SCI_SETLAZYLAYOUTLENGTH 2826
+#define SCI_GETLAZYLAYOUTLENGTH 2827
 #define SCI_COPYALLOWLINE 2519
 #define SCI_CUTALLOWLINE 2810
 #define SCI_SETCOPYSEPARATOR 2811
@@ -1317,6 +1346,7 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCN_AUTOCCOMPLETED 2030
 #define SCN_MARGINRIGHTCLICK 2031
 #define SCN_AUTOCSELECTIONCHANGE 2032
+#define SCN_WRAPPROGRESS 2033
 #ifndef SCI_DISABLE_PROVISIONAL
 #define SC_BIDIRECTIONAL_DISABLED 0
 #define SC_BIDIRECTIONAL_L2R 1
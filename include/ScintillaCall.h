@@ -81,6 +81,9 @@ public:
 	Position ReplaceTargetMinimal(std::string_view text);
 	Position SearchInTarget(std::string_view text);
 	Span SpanSearchInTarget(std::string_view text);
+	Position SearchAllInTarget(std::string_view text);
+	std::vector<Span> SpansSearchAllInTarget(std::string_view text);
+	Position IndicatorFillAllInTarget(std::string_view text);
 
 	// Generated APIs
 //++Autogenerated -- start of section automatically generated from Scintilla.iface
@@ -129,6 +132,8 @@ public:
 	void SetStyling(Position length, int style);
 	bool BufferedDraw();
 	void SetBufferedDraw(bool buffered);
+	bool RetainedDraw();
+	void SetRetainedDraw(bool retained);
 	void SetTabWidth(int tabWidth);
 	int TabWidth();
 	void SetTabMinimumWidth(int pixels);
@@ -425,6 +430,11 @@ public:
 	Position SearchInTarget(Position length, const char *text);
 	void SetSearchFlags(Scintilla::FindOption searchFlags);
 	Scintilla::FindOption SearchFlags();
+	Position SearchAllInTarget(Position length, const char *text);
+	Position GetSearchAllRanges(Position count, void *ranges);
+	Position IndicatorFillAllInTarget(Position length, const char *text);
+	void SetSearchThreads(int threads);
+	int SearchThreads();
 	void CallTipShow(Position pos, const char *definition);
 	void CallTipCancel();
 	bool CallTipActive();
@@ -488,6 +498,9 @@ public:
 	Scintilla::WrapIndentMode WrapIndentMode();
 	void SetLayoutCache(Scintilla::LineCache cacheMode);
 	Scintilla::LineCache LayoutCache();
+	void SetLayoutCacheMemoryLimit(Position bytes);
+	Position LayoutCacheMemoryLimit();
+	Position LayoutCacheMemory();
 	void SetScrollWidth(int pixelWidth);
 	int ScrollWidth();
 	void SetScrollWidthTracking(bool tracking);
@@ -727,8 +740,16 @@ public:
 	Position IndicatorEnd(int indicator, Position pos);
 	void SetPositionCache(int size);
 	int PositionCache();
+	void SetPositionCacheKeyLength(int length);
+	int PositionCacheKeyLength();
+	void SetPositionCacheAssociativity(int ways);
+	int PositionCacheAssociativity();
+	Position PositionCacheStatistic(Scintilla::PositionCacheStatistic statistic);
+	Position ShapedTextCacheStatistic(Scintilla::ShapedTextCacheStatistic statistic);
 	void SetLayoutThreads(int threads);
 	int LayoutThreads();
+	void SetLazyLayoutLength(Position length);
+	Position LazyLayoutLength();
 	void CopyAllowLine();
 	void CutAllowLine();
 	void SetCopySeparator(const char *separator);
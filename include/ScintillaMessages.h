@@ -59,6 +59,8 @@ enum class Message {
 	SetStyling = 2033,
 	GetBufferedDraw = 2034,
 	SetBufferedDraw = 2035,
+	GetRetainedDraw = 2823,
+	SetRetainedDraw = 2824,
 	SetTabWidth = 2036,
 	GetTabWidth = 2121,
 	SetTabMinimumWidth = 2724,
@@ -346,6 +348,11 @@ enum class Message {
 	SearchInTarget = 2197,
 	SetSearchFlags = 2198,
 	GetSearchFlags = 2199,
+	SearchAllInTarget = 2828,
+	GetSearchAllRanges = 2829,
+	IndicatorFillAllInTarget = 2830,
+	SetSearchThreads = 2831,
+	GetSearchThreads = 2832,
 	CallTipShow = 2200,
 	CallTipCancel = 2201,
 	CallTipActive = 2202,
@@ -408,6 +415,9 @@ enum class Message {
 	GetWrapIndentMode = 2473,
 	SetLayoutCache = 2272,
 	GetLayoutCache = 2273,
+	SetLayoutCacheMemoryLimit = 2820,
+	GetLayoutCacheMemoryLimit = 2821,
+	GetLayoutCacheMemory = 2822,
 	SetScrollWidth = 2274,
 	GetScrollWidth = 2275,
 	SetScrollWidthTracking = 2516,
@@ -641,8 +651,16 @@ enum class Message {
 	IndicatorEnd = 2509,
 	SetPositionCache = 2514,
 	GetPositionCache = 2515,
+	SetPositionCacheKeyLength = 2815,
+	GetPositionCacheKeyLength = 2816,
+	SetPositionCacheAssociativity = 2817,
+	GetPositionCacheAssociativity = 2818,
+	GetPositionCacheStatistic = 2819,
+	GetShapedTextCacheStatistic = 2825,
 	SetLayoutThreads = 2775,
 	GetLayoutThreads = 2776,
+	SetLazyLayoutLength = 2826,
+	GetLazyLayoutLength = 2827,
 	CopyAllowLine = 2519,
 	CutAllowLine = 2810,
 	SetCopySeparator = 2811,
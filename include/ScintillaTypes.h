@@ -290,6 +290,7 @@ enum class FindOption {
 	RegExp = 0x00200000,
 	Posix = 0x00400000,
 	Cxx11RegEx = 0x00800000,
+	LinearRegEx = 0x01000000,
 };
 
 enum class ChangeHistoryOption {
@@ -376,6 +377,7 @@ enum class LineCache {
 	Caret = 1,
 	Page = 2,
 	Document = 3,
+	DocumentBounded = 4,
 };
 
 enum class PhasesDraw {
@@ -419,6 +421,9 @@ enum class DocumentOption {
 	Default = 0,
 	StylesNone = 0x1,
 	TextLarge = 0x100,
+	TextRope = 0x200,
+	TextMapped = 0x400,
+	LinesTree = 0x800,
 };
 
 enum class Status {
@@ -481,6 +486,18 @@ enum class CaretStyle {
 	BlockAfter = 0x100,
 };
 
+enum class PositionCacheStatistic {
+	Hits = 0,
+	Misses = 1,
+	Evictions = 2,
+};
+
+enum class ShapedTextCacheStatistic {
+	Hits = 0,
+	Misses = 1,
+	Evictions = 2,
+};
+
 enum class MarginOption {
 	None = 0,
 	SubLineSelect = 1,
@@ -687,6 +704,7 @@ enum class Notification {
 	AutoCCompleted = 2030,
 	MarginRightClick = 2031,
 	AutoCSelectionChange = 2032,
+	WrapProgress = 2033,
 };
 //--Autogenerated -- end of section automatically generated from Scintilla.iface
 
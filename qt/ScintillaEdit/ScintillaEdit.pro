@@ -26,7 +26,9 @@ SOURCES += \
     ../../src/UndoHistory.cxx \
     ../../src/UniqueString.cxx \
     ../../src/UniConversion.cxx \
+    ../../src/ThreadPool.cxx \
     ../../src/Style.cxx \
+    ../../src/SplitVector.cxx \
     ../../src/Selection.cxx \
     ../../src/ScintillaBase.cxx \
     ../../src/RunStyles.cxx \
@@ -35,6 +37,7 @@ SOURCES += \
     ../../src/PerLine.cxx \
     ../../src/MarginView.cxx \
     ../../src/LineMarker.cxx \
+    ../../src/LinearRegex.cxx \
     ../../src/KeyMap.cxx \
     ../../src/Indicator.cxx \
     ../../src/Geometry.cxx \
@@ -53,6 +56,7 @@ SOURCES += \
     ../../src/CaseFolder.cxx \
     ../../src/CaseConvert.cxx \
     ../../src/CallTip.cxx \
+    ../../src/BackgroundWrap.cxx \
     ../../src/AutoComplete.cxx
 
 HEADERS  += \
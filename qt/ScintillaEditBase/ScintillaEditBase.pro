@@ -24,7 +24,9 @@ SOURCES += \
     ../../src/UniqueString.cxx \
     ../../src/UniConversion.cxx \
     ../../src/UndoHistory.cxx \
+    ../../src/ThreadPool.cxx \
     ../../src/Style.cxx \
+    ../../src/SplitVector.cxx \
     ../../src/Selection.cxx \
     ../../src/ScintillaBase.cxx \
     ../../src/RunStyles.cxx \
@@ -33,6 +35,7 @@ SOURCES += \
     ../../src/PerLine.cxx \
     ../../src/MarginView.cxx \
     ../../src/LineMarker.cxx \
+    ../../src/LinearRegex.cxx \
     ../../src/KeyMap.cxx \
     ../../src/Indicator.cxx \
     ../../src/Geometry.cxx \
@@ -51,6 +54,7 @@ SOURCES += \
     ../../src/CaseFolder.cxx \
     ../../src/CaseConvert.cxx \
     ../../src/CallTip.cxx \
+    ../../src/BackgroundWrap.cxx \
     ../../src/AutoComplete.cxx
 
 HEADERS  += \
@@ -61,17 +65,22 @@ HEADERS  += \
     ../../src/ViewStyle.h \
     ../../src/UndoHistory.h \
     ../../src/UniConversion.h \
+    ../../src/TreePartitioning.h \
+    ../../src/ThreadPool.h \
     ../../src/Style.h \
     ../../src/SplitVector.h \
     ../../src/Selection.h \
     ../../src/ScintillaBase.h \
     ../../src/RunStyles.h \
+    ../../src/RopeVector.h \
     ../../src/RESearch.h \
     ../../src/PositionCache.h \
     ../../src/Platform.h \
+    ../../src/PieceTable.h \
     ../../src/PerLine.h \
     ../../src/Partitioning.h \
     ../../src/LineMarker.h \
+    ../../src/LinearRegex.h \
     ../../src/KeyMap.h \
     ../../src/Indicator.h \
     ../../src/Geometry.h \
@@ -87,6 +96,7 @@ HEADERS  += \
     ../../src/CaseFolder.h \
     ../../src/CaseConvert.h \
     ../../src/CallTip.h \
+    ../../src/BackgroundWrap.h \
     ../../src/AutoComplete.h \
     ../../include/Scintilla.h \
     ../../include/ILexer.h
@@ -0,0 +1,275 @@
+// Scintilla source code edit control
+/** @file BackgroundWrap.cxx
+ ** Defines wrapping of a block of lines on a worker thread.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstdint>
+#include <cassert>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+
+#include <stdexcept>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <set>
+#include <forward_list>
+#include <optional>
+#include <algorithm>
+#include <iterator>
+#include <functional>
+#include <memory>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <system_error>
+
+#include "ScintillaTypes.h"
+#include "ScintillaMessages.h"
+#include "ScintillaStructures.h"
+#include "ILoader.h"
+#include "ILexer.h"
+
+#include "Debugging.h"
+#include "Geometry.h"
+#include "Platform.h"
+
+#include "CharacterType.h"
+#include "CharacterCategoryMap.h"
+#include "Position.h"
+#include "UniqueString.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "ContractionState.h"
+#include "CellBuffer.h"
+#include "PerLine.h"
+#include "KeyMap.h"
+#include "Indicator.h"
+#include "LineMarker.h"
+#include "Style.h"
+#include "ViewStyle.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+#include "UniConversion.h"
+#include "Selection.h"
+#include "PositionCache.h"
+#include "EditModel.h"
+#include "MarginView.h"
+#include "EditView.h"
+#include "ElapsedPeriod.h"
+#include "ThreadPool.h"
+#include "BackgroundWrap.h"
+
+using namespace Scintilla;
+using namespace Scintilla::Internal;
+
+namespace {
+
+// Layouts able to hold longer lines are discarded after each block to limit memory use.
+constexpr int lengthLayoutRetained = 4000;
+
+}
+
+BackgroundWrap::BackgroundWrap() :
+	finished(true),
+	cancel(false),
+	pending(false),
+	width(LineLayout::wrapWidthInfinite),
+	lineStart(0),
+	lineEnd(0),
+	positionEnd(0),
+	stale(false),
+	styleChanged(true),
+	failed(false),
+	duration(0.0) {
+	pdoc->SetUndoCollection(false);
+}
+
+BackgroundWrap::~BackgroundWrap() {
+	Stop();
+}
+
+Sci::Line BackgroundWrap::TopLineOfMain() const noexcept {
+	return 0;
+}
+
+Point BackgroundWrap::GetVisibleOriginInMain() const {
+	return Point();
+}
+
+Sci::Line BackgroundWrap::LinesOnScreen() const {
+	return 1;
+}
+
+void BackgroundWrap::Work() noexcept {
+	try {
+		ElapsedPeriod epWrapping;
+		const size_t lines = linesAfterWrap.size();
+		const size_t threads = std::clamp<size_t>(view.GetLayoutThreads(), 1, lines);
+		while (layouts.size() < threads) {
+			layouts.push_back(std::make_shared<LineLayout>(-1, 200));
+		}
+		std::atomic<size_t> nextIndex = 0;
+		view.layoutPool->Run(threads, [this, &nextIndex, lines, threads](size_t thread) {
+			LineLayout *ll = layouts[thread].get();
+			while (!cancel.load(std::memory_order_relaxed)) {
+				const size_t i = nextIndex.fetch_add(1, std::memory_order_acq_rel);
+				if (i >= lines) {
+					break;
+				}
+				const Sci::Line line = static_cast<Sci::Line>(i);
+				ll->ReSet(line, pdoc->LineStart(line + 1) - pdoc->LineStart(line));
+				view.LayoutLine(*this, surface.get(), *vs, ll, width, threads > 1);
+				linesAfterWrap[i] = ll->lines;
+			}
+		});
+		// Heights come from linesAfterWrap so lines remeasured by the view are not needed
+		view.linesRemeasured.clear();
+		for (std::shared_ptr<LineLayout> &ll : layouts) {
+			if (ll->maxLineLength > lengthLayoutRetained) {
+				ll = std::make_shared<LineLayout>(-1, 200);
+			}
+		}
+		// Multiply duration by number of threads to produce (near) equivalence to duration if single threaded
+		duration = epWrapping.Duration() * threads;
+	} catch (...) {
+		// Owner wraps these lines itself
+		failed = true;
+	}
+	{
+		std::lock_guard<std::mutex> guard(mutexFinished);
+		finished = true;
+	}
+	cvFinished.notify_all();
+}
+
+bool BackgroundWrap::HasSurface() const noexcept {
+	return surface != nullptr;
+}
+
+// Set the surface used to measure blocks. Fonts are realised again for it before the next block.
+void BackgroundWrap::SetSurface(std::unique_ptr<Surface> surface_) {
+	Stop();
+	surface = std::move(surface_);
+	styleChanged = true;
+}
+
+bool BackgroundWrap::ThreadSafeMeasure() const noexcept {
+	return surface && surface->SupportsFeature(Supports::ThreadSafeMeasureWidths);
+}
+
+// Styles or technology changed so the surface and copied styles can not be used.
+void BackgroundWrap::DropGraphics() noexcept {
+	Stop();
+	surface.reset();
+	styleChanged = true;
+}
+
+void BackgroundWrap::Start(const Document *source, const EditView &viewSource, const ViewStyle &vsSource,
+	const SpecialRepresentations &reprsSource, int width_, Sci::Line lineStart_, Sci::Line lineEnd_) {
+	Stop();
+
+	lineStart = lineStart_;
+	lineEnd = lineEnd_;
+	const Sci::Position positionStart = source->LineStart(lineStart);
+	positionEnd = source->LineStart(lineEnd);
+	const Sci::Position length = positionEnd - positionStart;
+	stale = false;
+	failed = false;
+	duration = 0.0;
+	width = width_;
+
+	// Settings that affect layout
+	pdoc->SetDBCSCodePage(source->dbcsCodePage);
+	pdoc->tabInChars = source->tabInChars;
+	pdoc->indentInChars = source->indentInChars;
+	pdoc->actualIndentInChars = source->actualIndentInChars;
+	*reprs = reprsSource;
+	view.tabWidthMinimumPixels = viewSource.tabWidthMinimumPixels;
+	view.SetLayoutThreads(viewSource.GetLayoutThreads());
+	view.lazyLayoutLength = viewSource.lazyLayoutLength;
+	if (!vs || styleChanged) {
+		// Copying and realising fonts is expensive so only performed after styles change.
+		vs = std::make_unique<ViewStyle>(vsSource);
+		vs->Refresh(*surface, pdoc->tabInChars);
+		view.posCache->Clear();
+		styleChanged = false;
+	}
+
+	// Copy text and styles of block into this model's document
+	text.resize(length);
+	source->GetCharRange(text.data(), positionStart, length);
+	styles.resize(length);
+	source->GetStyleRange(reinterpret_cast<unsigned char *>(styles.data()), positionStart, length);
+	pdoc->DeleteChars(0, pdoc->Length());
+	pdoc->InsertString(0, text);
+	pdoc->StartStyling(0);
+	pdoc->SetStyles(length, styles.data());
+
+	linesAfterWrap.assign(lineEnd - lineStart, 1);
+	finished = false;
+	pending = true;
+	try {
+		worker = std::thread(&BackgroundWrap::Work, this);
+	} catch (const std::system_error &) {
+		// Threads not available so wrap on this thread
+		Work();
+	}
+}
+
+bool BackgroundWrap::Running() const noexcept {
+	return pending;
+}
+
+// Wait up to secondsWait for the block to be wrapped.
+// Returns true if wrapped after which linesAfterWrap may be read.
+bool BackgroundWrap::Finished(double secondsWait) {
+	if (!pending) {
+		return false;
+	}
+	{
+		std::unique_lock<std::mutex> lock(mutexFinished);
+		if (!cvFinished.wait_for(lock, std::chrono::duration<double>(secondsWait), [this] { return finished; })) {
+			return false;
+		}
+	}
+	if (worker.joinable()) {
+		worker.join();
+	}
+	pending = false;
+	return true;
+}
+
+// Abandon the current block, waiting for worker to notice.
+void BackgroundWrap::Stop() noexcept {
+	cancel = true;
+	if (worker.joinable()) {
+		worker.join();
+	}
+	cancel = false;
+	pending = false;
+}
+
+// The document was changed at position so results for lines after that are incorrect.
+void BackgroundWrap::Modified(Sci::Position position) noexcept {
+	if (pending && (position < positionEnd)) {
+		stale = true;
+	}
+}
+
+void BackgroundWrap::NeedWrapping(Sci::Line lineStart_, Sci::Line lineEnd_) noexcept {
+	if (pending && (lineStart_ < lineEnd) && (lineEnd_ > lineStart)) {
+		stale = true;
+	}
+}
@@ -0,0 +1,76 @@
+// Scintilla source code edit control
+/** @file BackgroundWrap.h
+ ** Defines wrapping of a block of lines on a worker thread.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef BACKGROUNDWRAP_H
+#define BACKGROUNDWRAP_H
+
+namespace Scintilla::Internal {
+
+/**
+ * Finds the number of sublines each line of a block wraps to on a worker thread.
+ * The text and styles of the block are copied into this model's own document and
+ * the view style is copied so the owner may continue to use and modify its document
+ * and settings while wrapping proceeds.
+ * The owner marks the block stale when a change makes the results unusable and reads
+ * linesAfterWrap after Finished returns true.
+ * The measurement surface is kept for each block until styles or technology change.
+ */
+class BackgroundWrap : public EditModel {
+	EditView view;
+	std::unique_ptr<ViewStyle> vs;
+	std::unique_ptr<Surface> surface;
+	// Layouts reused for each line by each thread
+	std::vector<std::shared_ptr<LineLayout>> layouts;
+	std::string text;
+	std::string styles;
+	std::thread worker;
+	std::mutex mutexFinished;
+	std::condition_variable cvFinished;
+	bool finished;
+	std::atomic<bool> cancel;
+	bool pending;
+	void Work() noexcept;
+public:
+	int width;
+	Sci::Line lineStart;
+	Sci::Line lineEnd;
+	Sci::Position positionEnd;
+	// Set by the owner when the results may no longer be correct.
+	bool stale;
+	// Set when the view style must be copied again before the next block.
+	bool styleChanged;
+	bool failed;
+	double duration;
+	std::vector<int> linesAfterWrap;
+
+	BackgroundWrap();
+	// Deleted so BackgroundWrap objects can not be copied.
+	BackgroundWrap(const BackgroundWrap &) = delete;
+	BackgroundWrap(BackgroundWrap &&) = delete;
+	BackgroundWrap &operator=(const BackgroundWrap &) = delete;
+	BackgroundWrap &operator=(BackgroundWrap &&) = delete;
+	~BackgroundWrap() override;
+
+	Sci::Line TopLineOfMain() const noexcept override;
+	Point GetVisibleOriginInMain() const override;
+	Sci::Line LinesOnScreen() const override;
+
+	bool HasSurface() const noexcept;
+	void SetSurface(std::unique_ptr<Surface> surface_);
+	bool ThreadSafeMeasure() const noexcept;
+	void DropGraphics() noexcept;
+	void Start(const Document *source, const EditView &viewSource, const ViewStyle &vsSource,
+		const SpecialRepresentations &reprsSource, int width_, Sci::Line lineStart_, Sci::Line lineEnd_);
+	bool Running() const noexcept;
+	bool Finished(double secondsWait);
+	void Stop() noexcept;
+	void Modified(Sci::Position position) noexcept;
+	void NeedWrapping(Sci::Line lineStart_, Sci::Line lineEnd_) noexcept;
+};
+
+}
+
+#endif
@@ -7,6 +7,7 @@
 
 #include <cstddef>
 #include <cstdlib>
+#include <cstdint>
 #include <cassert>
 #include <cstring>
 #include <cstdio>
@@ -19,7 +20,26 @@
 #include <vector>
 #include <optional>
 #include <algorithm>
+#include <functional>
 #include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SCI_LINE_END_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(SCI_LINE_END_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+// AVX2 code is compiled for a target attribute and only called when the processor supports it
+#define SCI_LINE_END_AVX2
+#include <immintrin.h>
+#endif
 
 #include "ScintillaTypes.h"
 
@@ -27,16 +47,125 @@
 
 #include "Position.h"
 #include "SplitVector.h"
+#include "RopeVector.h"
 #include "Partitioning.h"
+#include "TreePartitioning.h"
+#include "PieceTable.h"
 #include "RunStyles.h"
 #include "SparseVector.h"
 #include "ChangeHistory.h"
 #include "CellBuffer.h"
 #include "UndoHistory.h"
 #include "UniConversion.h"
+#include "ThreadPool.h"
 
 namespace Scintilla::Internal {
 
+namespace {
+
+constexpr unsigned char NEL2 = 0x85;	// Last byte of NEL
+constexpr unsigned char LS3 = 0xa8;	// Last byte of LS
+constexpr unsigned char PS3 = 0xa9;	// Last byte of PS
+
+constexpr bool IsLineEndByte(unsigned char ch, bool unicode) noexcept {
+	return (ch == '\r') || (ch == '\n') || (unicode && ((ch == NEL2) || (ch == LS3) || (ch == PS3)));
+}
+
+const char *FindLineEndByteScalar(const char *s, const char *end, bool unicode) noexcept {
+	while ((s < end) && !IsLineEndByte(*s, unicode)) {
+		s++;
+	}
+	return s;
+}
+
+#if defined(SCI_LINE_END_SSE2)
+
+int FirstSetBit(unsigned int mask) noexcept {
+#if defined(_MSC_VER)
+	unsigned long index = 0;
+	_BitScanForward(&index, mask);
+	return static_cast<int>(index);
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+// Compare 16 bytes at a time
+const char *FindLineEndByteSSE2(const char *s, const char *end, bool unicode) noexcept {
+	const __m128i cr = _mm_set1_epi8('\r');
+	const __m128i lf = _mm_set1_epi8('\n');
+	const __m128i nel = _mm_set1_epi8(static_cast<char>(NEL2));
+	const __m128i one = _mm_set1_epi8(1);
+	const __m128i ps = _mm_set1_epi8(static_cast<char>(PS3));
+	while ((end - s) >= 16) {
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+		__m128i match = _mm_or_si128(_mm_cmpeq_epi8(chunk, cr), _mm_cmpeq_epi8(chunk, lf));
+		if (unicode) {
+			// LS and PS differ only in the low bit
+			match = _mm_or_si128(match, _mm_cmpeq_epi8(chunk, nel));
+			match = _mm_or_si128(match, _mm_cmpeq_epi8(_mm_or_si128(chunk, one), ps));
+		}
+		const unsigned int mask = _mm_movemask_epi8(match);
+		if (mask) {
+			return s + FirstSetBit(mask);
+		}
+		s += 16;
+	}
+	return FindLineEndByteScalar(s, end, unicode);
+}
+
+#endif
+
+#if defined(SCI_LINE_END_AVX2)
+
+// Compare 32 bytes at a time
+__attribute__((target("avx2")))
+const char *FindLineEndByteAVX2(const char *s, const char *end, bool unicode) noexcept {
+	const __m256i cr = _mm256_set1_epi8('\r');
+	const __m256i lf = _mm256_set1_epi8('\n');
+	const __m256i nel = _mm256_set1_epi8(static_cast<char>(NEL2));
+	const __m256i one = _mm256_set1_epi8(1);
+	const __m256i ps = _mm256_set1_epi8(static_cast<char>(PS3));
+	while ((end - s) >= 32) {
+		const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s));
+		__m256i match = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, cr), _mm256_cmpeq_epi8(chunk, lf));
+		if (unicode) {
+			match = _mm256_or_si256(match, _mm256_cmpeq_epi8(chunk, nel));
+			match = _mm256_or_si256(match, _mm256_cmpeq_epi8(_mm256_or_si256(chunk, one), ps));
+		}
+		const unsigned int mask = _mm256_movemask_epi8(match);
+		if (mask) {
+			return s + FirstSetBit(mask);
+		}
+		s += 32;
+	}
+	return FindLineEndByteSSE2(s, end, unicode);
+}
+
+#endif
+
+using LineEndFinder = const char *(*)(const char *s, const char *end, bool unicode) noexcept;
+
+LineEndFinder ChooseLineEndFinder() noexcept {
+#if defined(SCI_LINE_END_AVX2)
+	if (__builtin_cpu_supports("avx2")) {
+		return FindLineEndByteAVX2;
+	}
+#endif
+#if defined(SCI_LINE_END_SSE2)
+	return FindLineEndByteSSE2;
+#else
+	return FindLineEndByteScalar;
+#endif
+}
+
+}
+
+const char *FindLineEndByte(const char *s, const char *end, bool unicode) noexcept {
+	static const LineEndFinder finder = ChooseLineEndFinder();
+	return finder(s, end, unicode);
+}
+
 struct CountWidths {
 	// Measures the number of characters in a string divided into those
 	// from the Base Multilingual Plane and those from other planes.
@@ -89,6 +218,28 @@ public:
 	virtual ~ILineVector() {}
 };
 
+class ITextStore {
+public:
+	virtual Sci::Position Length() const noexcept = 0;
+	virtual char ValueAt(Sci::Position position) const noexcept = 0;
+	virtual void SetValueAt(Sci::Position position, char value) noexcept = 0;
+	virtual bool FillRange(Sci::Position position, Sci::Position fillLength, char value) noexcept = 0;
+	virtual void GetRange(char *buffer, Sci::Position position, Sci::Position retrieveLength) const = 0;
+	virtual void InsertFromArray(Sci::Position position, const char *s, Sci::Position insertLength) = 0;
+	virtual void InsertValue(Sci::Position position, Sci::Position insertLength, char value) = 0;
+	/// Stores that can not refer to external memory copy it instead.
+	virtual void InsertReference(Sci::Position position, const char *s, Sci::Position insertLength) {
+		InsertFromArray(position, s, insertLength);
+	}
+	virtual void DeleteRange(Sci::Position position, Sci::Position deleteLength) = 0;
+	virtual void ReAllocate(Sci::Position newSize) = 0;
+	virtual const char *BufferPointer() = 0;
+	virtual const char *RangePointer(Sci::Position position, Sci::Position rangeLength) = 0;
+	virtual Sci::Position GapPosition() const noexcept = 0;
+	virtual const char *SegmentAt(Sci::Position position, Sci::Position &segmentStart, Sci::Position &segmentLength) const noexcept = 0;
+	virtual ~ITextStore() {}
+};
+
 }
 
 using namespace Scintilla;
@@ -152,9 +303,9 @@ public:
 	}
 };
 
-template <typename POS>
+template <typename POS, typename PARTITIONING>
 class LineVector : public ILineVector {
-	Partitioning<POS> starts;
+	PARTITIONING starts;
 	PerLine *perLine;
 	LineStartIndex<POS> startsUTF16;
 	LineStartIndex<POS> startsUTF32;
@@ -330,27 +481,254 @@ public:
 	}
 };
 
-CellBuffer::CellBuffer(bool hasStyles_, bool largeDocument_) :
-	hasStyles(hasStyles_), largeDocument(largeDocument_) {
+// Adapt SplitVector<char>, RopeVector<char>, or PieceTable<char> to ITextStore
+template <typename STORAGE>
+class TextStore : public ITextStore {
+protected:
+	STORAGE body;
+public:
+	Sci::Position Length() const noexcept override {
+		return body.Length();
+	}
+	char ValueAt(Sci::Position position) const noexcept override {
+		return body.ValueAt(position);
+	}
+	void SetValueAt(Sci::Position position, char value) noexcept override {
+		body.SetValueAt(position, value);
+	}
+	bool FillRange(Sci::Position position, Sci::Position fillLength, char value) noexcept override {
+		return body.FillRange(position, fillLength, value);
+	}
+	void GetRange(char *buffer, Sci::Position position, Sci::Position retrieveLength) const override {
+		body.GetRange(buffer, position, retrieveLength);
+	}
+	void InsertFromArray(Sci::Position position, const char *s, Sci::Position insertLength) override {
+		body.InsertFromArray(position, s, 0, insertLength);
+	}
+	void InsertValue(Sci::Position position, Sci::Position insertLength, char value) override {
+		body.InsertValue(position, insertLength, value);
+	}
+	void DeleteRange(Sci::Position position, Sci::Position deleteLength) override {
+		body.DeleteRange(position, deleteLength);
+	}
+	void ReAllocate(Sci::Position newSize) override {
+		body.ReAllocate(newSize);
+	}
+	const char *BufferPointer() override {
+		return body.BufferPointer();
+	}
+	const char *RangePointer(Sci::Position position, Sci::Position rangeLength) override {
+		return body.RangePointer(position, rangeLength);
+	}
+	Sci::Position GapPosition() const noexcept override {
+		return body.GapPosition();
+	}
+	const char *SegmentAt(Sci::Position position, Sci::Position &segmentStart, Sci::Position &segmentLength) const noexcept override {
+		return body.SegmentAt(position, segmentStart, segmentLength);
+	}
+	STORAGE &Body() noexcept {
+		return body;
+	}
+};
+
+using GapTextStore = TextStore<SplitVector<char>>;
+
+// Text that may refer to memory owned by the container
+class MappedTextStore : public TextStore<PieceTable<char>> {
+public:
+	void InsertReference(Sci::Position position, const char *s, Sci::Position insertLength) override {
+		body.InsertReference(position, s, insertLength);
+	}
+};
+
+// Styles held as runs so that unstyled text, such as much of a mapped document, takes no space.
+// Contiguous access requires a copy.
+class StyleRunStore : public ITextStore {
+	RunStyles<Sci::Position, char> runs;
+	std::vector<char> flat;
+public:
+	Sci::Position Length() const noexcept override {
+		return runs.Length();
+	}
+	char ValueAt(Sci::Position position) const noexcept override {
+		if ((position < 0) || (position >= runs.Length())) {
+			return 0;
+		}
+		return runs.ValueAt(position);
+	}
+	void SetValueAt(Sci::Position position, char value) noexcept override {
+		FillRange(position, 1, value);
+	}
+	bool FillRange(Sci::Position position, Sci::Position fillLength, char value) noexcept override {
+		try {
+			return runs.FillRange(position, value, fillLength).changed;
+		} catch (...) {
+			// Ignore any exception
+			return false;
+		}
+	}
+	void GetRange(char *buffer, Sci::Position position, Sci::Position retrieveLength) const override {
+		const Sci::Position end = position + retrieveLength;
+		while (position < end) {
+			const Sci::Position endRun = std::min(runs.EndRun(position), end);
+			std::fill(buffer, buffer + (endRun - position), runs.ValueAt(position));
+			buffer += endRun - position;
+			position = endRun;
+		}
+	}
+	void InsertFromArray(Sci::Position position, const char *s, Sci::Position insertLength) override {
+		runs.InsertSpace(position, insertLength);
+		for (Sci::Position i = 0; i < insertLength; i++) {
+			runs.SetValueAt(position + i, s[i]);
+		}
+	}
+	void InsertValue(Sci::Position position, Sci::Position insertLength, char value) override {
+		runs.InsertSpace(position, insertLength);
+		// InsertSpace continues the surrounding run so always fill
+		runs.FillRange(position, value, insertLength);
+	}
+	void DeleteRange(Sci::Position position, Sci::Position deleteLength) override {
+		if ((position == 0) && (deleteLength == runs.Length())) {
+			runs.DeleteAll();
+		} else {
+			runs.DeleteRange(position, deleteLength);
+		}
+	}
+	void ReAllocate(Sci::Position) override {
+	}
+	const char *BufferPointer() override {
+		flat.resize(runs.Length() + 1);
+		GetRange(flat.data(), 0, runs.Length());
+		flat[runs.Length()] = 0;
+		return flat.data();
+	}
+	const char *RangePointer(Sci::Position position, Sci::Position rangeLength) override {
+		flat.resize(rangeLength);
+		GetRange(flat.data(), position, rangeLength);
+		return flat.data();
+	}
+	Sci::Position GapPosition() const noexcept override {
+		return 0;
+	}
+	const char *SegmentAt(Sci::Position, Sci::Position &segmentStart, Sci::Position &segmentLength) const noexcept override {
+		// Not contiguous
+		segmentStart = 0;
+		segmentLength = 0;
+		return nullptr;
+	}
+};
+
+namespace {
+
+std::unique_ptr<ITextStore> TextStoreCreate(TextStorage storage) {
+	switch (storage) {
+	case TextStorage::rope:
+		return std::make_unique<TextStore<RopeVector<char>>>();
+	case TextStorage::mapped:
+		return std::make_unique<MappedTextStore>();
+	default:
+		return std::make_unique<GapTextStore>();
+	}
+}
+
+std::unique_ptr<ITextStore> StyleStoreCreate(TextStorage storage) {
+	if (storage == TextStorage::mapped)
+		return std::make_unique<StyleRunStore>();
+	return TextStoreCreate(storage);
+}
+
+std::unique_ptr<ILineVector> LineVectorCreate(bool largeDocument, bool linesTree) {
+	if (linesTree) {
+		if (largeDocument)
+			return std::make_unique<LineVector<Sci::Position, TreePartitioning<Sci::Position>>>();
+		else
+			return std::make_unique<LineVector<int, TreePartitioning<int>>>();
+	}
+	if (largeDocument)
+		return std::make_unique<LineVector<Sci::Position, Partitioning<Sci::Position>>>();
+	else
+		return std::make_unique<LineVector<int, Partitioning<int>>>();
+}
+
+}
+
+SegmentedView::SegmentedView(const CellBuffer *pcb_) noexcept : pcb(pcb_), length(pcb_->Length()) {
+}
+
+bool SegmentedView::Load(Sci::Position position) noexcept {
+	if ((position < 0) || (position >= length)) {
+		return false;
+	}
+	Sci::Position segmentLength = 0;
+	const char *text = pcb->SegmentAt(position, start, segmentLength);
+	end = start + segmentLength;
+	origin = text - start;
+	return true;
+}
+
+Sci::Position SegmentedView::FindLineEndByte(Sci::Position position, Sci::Position rangeLength, bool unicode) noexcept {
+	const Sci::Position endRange = std::min(position + rangeLength, length);
+	while (position < endRange) {
+		if (!((position >= start) && (position < end)) && !Load(position)) {
+			break;
+		}
+		const char *endSegment = origin + std::min(end, endRange);
+		const char *found = Internal::FindLineEndByte(origin + position, endSegment, unicode);
+		if (found < endSegment) {
+			return found - origin;
+		}
+		position = endSegment - origin;
+	}
+	return -1;
+}
+
+Sci::Position SegmentedView::FindChar(Sci::Position position, Sci::Position rangeLength, int ch) noexcept {
+	const Sci::Position endRange = std::min(position + rangeLength, length);
+	while (position < endRange) {
+		if (!((position >= start) && (position < end)) && !Load(position)) {
+			break;
+		}
+		const Sci::Position endSegment = std::min(end, endRange);
+		const char *match = static_cast<const char *>(memchr(origin + position, ch, endSegment - position));
+		if (match) {
+			return match - origin;
+		}
+		position = endSegment;
+	}
+	return -1;
+}
+
+CellBuffer::CellBuffer(bool hasStyles_, bool largeDocument_, TextStorage storage_, bool linesTree_) :
+	hasStyles(hasStyles_), largeDocument(largeDocument_), storage(storage_), linesTree(linesTree_) {
+	substance = TextStoreCreate(storage);
+	if (hasStyles) {
+		style = StyleStoreCreate(storage);
+	}
+	if (storage == TextStorage::gap) {
+		gapSubstance = &static_cast<GapTextStore *>(substance.get())->Body();
+		if (hasStyles) {
+			gapStyle = &static_cast<GapTextStore *>(style.get())->Body();
+		}
+	}
 	readOnly = false;
 	utf8Substance = false;
 	utf8LineEnds = LineEndType::Default;
 	collectingUndo = true;
 	uh = std::make_unique<UndoHistory>();
-	if (largeDocument)
-		plv = std::make_unique<LineVector<Sci::Position>>();
-	else
-		plv = std::make_unique<LineVector<int>>();
+	plv = LineVectorCreate(largeDocument, linesTree);
 }
 
 CellBuffer::~CellBuffer() noexcept = default;
 
 char CellBuffer::CharAt(Sci::Position position) const noexcept {
-	return substance.ValueAt(position);
+	if (gapSubstance) {
+		return gapSubstance->ValueAt(position);
+	}
+	return substance->ValueAt(position);
 }
 
 unsigned char CellBuffer::UCharAt(Sci::Position position) const noexcept {
-	return substance.ValueAt(position);
+	return CharAt(position);
 }
 
 void CellBuffer::GetCharRange(char *buffer, Sci::Position position, Sci::Position lengthRetrieve) const {
@@ -358,18 +736,21 @@ void CellBuffer::GetCharRange(char *buffer, Sci::Position position, Sci::Positio
 		return;
 	if (position < 0)
 		return;
-	if ((position + lengthRetrieve) > substance.Length()) {
+	if ((position + lengthRetrieve) > substance->Length()) {
 		Platform::DebugPrintf("Bad GetCharRange %.0f for %.0f of %.0f\n",
 				      static_cast<double>(position),
 				      static_cast<double>(lengthRetrieve),
-				      static_cast<double>(substance.Length()));
+				      static_cast<double>(substance->Length()));
 		return;
 	}
-	substance.GetRange(buffer, position, lengthRetrieve);
+	substance->GetRange(buffer, position, lengthRetrieve);
 }
 
 char CellBuffer::StyleAt(Sci::Position position) const noexcept {
-	return hasStyles ? style.ValueAt(position) : '\0';
+	if (gapStyle) {
+		return gapStyle->ValueAt(position);
+	}
+	return hasStyles ? style->ValueAt(position) : '\0';
 }
 
 void CellBuffer::GetStyleRange(unsigned char *buffer, Sci::Position position, Sci::Position lengthRetrieve) const {
@@ -381,45 +762,47 @@ void CellBuffer::GetStyleRange(unsigned char *buffer, Sci::Position position, Sc
 		std::fill(buffer, buffer + lengthRetrieve, static_cast<unsigned char>(0));
 		return;
 	}
-	if ((position + lengthRetrieve) > style.Length()) {
+	if ((position + lengthRetrieve) > style->Length()) {
 		Platform::DebugPrintf("Bad GetStyleRange %.0f for %.0f of %.0f\n",
 				      static_cast<double>(position),
 				      static_cast<double>(lengthRetrieve),
-				      static_cast<double>(style.Length()));
+				      static_cast<double>(style->Length()));
 		return;
 	}
-	style.GetRange(reinterpret_cast<char *>(buffer), position, lengthRetrieve);
+	style->GetRange(reinterpret_cast<char *>(buffer), position, lengthRetrieve);
 }
 
 const char *CellBuffer::BufferPointer() {
-	return substance.BufferPointer();
+	return substance->BufferPointer();
 }
 
 const char *CellBuffer::RangePointer(Sci::Position position, Sci::Position rangeLength) noexcept {
-	return substance.RangePointer(position, rangeLength);
+	if (gapSubstance) {
+		return gapSubstance->RangePointer(position, rangeLength);
+	}
+	try {
+		// Other stores may allocate to make the range contiguous
+		return substance->RangePointer(position, rangeLength);
+	} catch (...) {
+		// Ignore any exception
+		return nullptr;
+	}
 }
 
 Sci::Position CellBuffer::GapPosition() const noexcept {
-	return substance.GapPosition();
+	return substance->GapPosition();
 }
 
-SplitView CellBuffer::AllView() const noexcept {
-	const size_t length = substance.Length();
-	size_t length1 = substance.GapPosition();
-	if (length1 == 0) {
-		// Assign segment2 to segment1 / length1 to avoid useless test against 0 length1
-		length1 = length;
-	}
-	return SplitView {
-		substance.ElementPointer(0),
-		length1,
-		substance.ElementPointer(length1) - length1,
-		length
-	};
+const char *CellBuffer::SegmentAt(Sci::Position position, Sci::Position &segmentStart, Sci::Position &segmentLength) const noexcept {
+	return substance->SegmentAt(position, segmentStart, segmentLength);
+}
+
+SegmentedView CellBuffer::AllView() const noexcept {
+	return SegmentedView(this);
 }
 
 // The char* returned is to an allocation owned by the undo history
-const char *CellBuffer::InsertString(Sci::Position position, const char *s, Sci::Position insertLength, bool &startSequence) {
+const char *CellBuffer::InsertString(Sci::Position position, const char *s, Sci::Position insertLength, bool &startSequence, bool reference) {
 	// InsertString and DeleteChars are the bottleneck though which all changes occur
 	const char *data = s;
 	if (!readOnly) {
@@ -429,7 +812,7 @@ const char *CellBuffer::InsertString(Sci::Position position, const char *s, Sci:
 			data = uh->AppendAction(ActionType::insert, position, s, insertLength, startSequence);
 		}
 
-		BasicInsertString(position, s, insertLength);
+		BasicInsertString(position, s, insertLength, reference);
 		if (changeHistory) {
 			changeHistory->Insert(position, insertLength, collectingUndo, uh->BeforeReachableSavePoint());
 		}
@@ -441,9 +824,9 @@ bool CellBuffer::SetStyleAt(Sci::Position position, char styleValue) noexcept {
 	if (!hasStyles) {
 		return false;
 	}
-	const char curVal = style.ValueAt(position);
+	const char curVal = style->ValueAt(position);
 	if (curVal != styleValue) {
-		style.SetValueAt(position, styleValue);
+		style->SetValueAt(position, styleValue);
 		return true;
 	} else {
 		return false;
@@ -454,18 +837,9 @@ bool CellBuffer::SetStyleFor(Sci::Position position, Sci::Position lengthStyle,
 	if (!hasStyles) {
 		return false;
 	}
-	bool changed = false;
 	PLATFORM_ASSERT(lengthStyle == 0 ||
-		(lengthStyle > 0 && lengthStyle + position <= style.Length()));
-	while (lengthStyle--) {
-		const char curVal = style.ValueAt(position);
-		if (curVal != styleValue) {
-			style.SetValueAt(position, styleValue);
-			changed = true;
-		}
-		position++;
-	}
-	return changed;
+		(lengthStyle > 0 && lengthStyle + position <= style->Length()));
+	return style->FillRange(position, lengthStyle, styleValue);
 }
 
 // The char* returned is to an allocation owned by the undo history
@@ -477,7 +851,7 @@ const char *CellBuffer::DeleteChars(Sci::Position position, Sci::Position delete
 		if (collectingUndo) {
 			// Save into the undo/redo stack, but only the characters - not the formatting
 			// The gap would be moved to position anyway for the deletion so this doesn't cost extra
-			data = substance.RangePointer(position, deleteLength);
+			data = substance->RangePointer(position, deleteLength);
 			data = uh->AppendAction(ActionType::remove, position, data, deleteLength, startSequence);
 		}
 
@@ -492,16 +866,16 @@ const char *CellBuffer::DeleteChars(Sci::Position position, Sci::Position delete
 }
 
 Sci::Position CellBuffer::Length() const noexcept {
-	return substance.Length();
+	return substance->Length();
 }
 
 void CellBuffer::Allocate(Sci::Position newSize) {
 	if (!largeDocument && (newSize > INT32_MAX)) {
 		throw std::runtime_error("CellBuffer::Allocate: size of standard document limited to 2G.");
 	}
-	substance.ReAllocate(newSize);
+	substance->ReAllocate(newSize);
 	if (hasStyles) {
-		style.ReAllocate(newSize);
+		style->ReAllocate(newSize);
 	}
 }
 
@@ -519,19 +893,20 @@ void CellBuffer::SetLineEndTypes(LineEndType utf8LineEnds_) {
 }
 
 bool CellBuffer::ContainsLineEnd(const char *s, Sci::Position length) const noexcept {
-	unsigned char chBeforePrev = 0;
-	unsigned char chPrev = 0;
-	for (Sci::Position i = 0; i < length; i++) {
-		const unsigned char ch = s[i];
+	const bool unicode = utf8LineEnds == LineEndType::Unicode;
+	const char *end = s + length;
+	const char *found = FindLineEndByte(s, end, unicode);
+	while (found < end) {
+		const unsigned char ch = *found;
 		if ((ch == '\r') || (ch == '\n')) {
 			return true;
-		} else if (utf8LineEnds == LineEndType::Unicode) {
-			if (UTF8IsMultibyteLineEnd(chBeforePrev, chPrev, ch)) {
-				return true;
-			}
 		}
-		chBeforePrev = chPrev;
-		chPrev = ch;
+		const unsigned char chPrev = (found > s) ? found[-1] : 0;
+		const unsigned char chBeforePrev = (found - 1 > s) ? found[-2] : 0;
+		if (UTF8IsMultibyteLineEnd(chBeforePrev, chPrev, ch)) {
+			return true;
+		}
+		found = FindLineEndByte(found + 1, end, unicode);
 	}
 	return false;
 }
@@ -625,6 +1000,14 @@ bool CellBuffer::IsLarge() const noexcept {
 	return largeDocument;
 }
 
+bool CellBuffer::IsLinesTree() const noexcept {
+	return linesTree;
+}
+
+TextStorage CellBuffer::Storage() const noexcept {
+	return storage;
+}
+
 bool CellBuffer::HasStyles() const noexcept {
 	return hasStyles;
 }
@@ -668,10 +1051,10 @@ void CellBuffer::RemoveLine(Sci::Line line) {
 
 bool CellBuffer::UTF8LineEndOverlaps(Sci::Position position) const noexcept {
 	const unsigned char bytes[] = {
-		static_cast<unsigned char>(substance.ValueAt(position-2)),
-		static_cast<unsigned char>(substance.ValueAt(position-1)),
-		static_cast<unsigned char>(substance.ValueAt(position)),
-		static_cast<unsigned char>(substance.ValueAt(position+1)),
+		static_cast<unsigned char>(substance->ValueAt(position-2)),
+		static_cast<unsigned char>(substance->ValueAt(position-1)),
+		static_cast<unsigned char>(substance->ValueAt(position)),
+		static_cast<unsigned char>(substance->ValueAt(position+1)),
 	};
 	return UTF8IsSeparator(bytes) || UTF8IsSeparator(bytes+1) || UTF8IsNEL(bytes+1);
 }
@@ -685,7 +1068,7 @@ bool CellBuffer::UTF8IsCharacterBoundary(Sci::Position position) const {
 			if (posBack < 0) {
 				return false;
 			}
-			back.insert(0, 1, substance.ValueAt(posBack));
+			back.insert(0, 1, substance->ValueAt(posBack));
 			if (!UTF8IsTrailByte(back.front())) {
 				if (i > 0) {
 					// Have reached a non-trail
@@ -699,7 +1082,7 @@ bool CellBuffer::UTF8IsCharacterBoundary(Sci::Position position) const {
 		}
 	}
 	if (position < Length()) {
-		const unsigned char fore = substance.ValueAt(position);
+		const unsigned char fore = substance->ValueAt(position);
 		if (UTF8IsTrailByte(fore)) {
 			return false;
 		}
@@ -707,40 +1090,121 @@ bool CellBuffer::UTF8IsCharacterBoundary(Sci::Position position) const {
 	return true;
 }
 
+namespace {
+
+// Each thread finding line ends scans at least this many bytes
+constexpr Sci::Position bytesPerLineEndThread = 0x100000;
+
+// Find the position after each line end in [start, end) and append to positions.
+// Only reads the buffer so may run on a worker thread.
+// A CR LF line end is recorded for the CR so that adjacent ranges do not both record it.
+void FindLineEnds(const CellBuffer *pcb, Sci::Position start, Sci::Position end, bool unicode, std::vector<Sci::Position> &positions) {
+	Sci::Position position = start;
+	while (position < end) {
+		Sci::Position segmentStart = 0;
+		Sci::Position segmentLength = 0;
+		const char *segment = pcb->SegmentAt(position, segmentStart, segmentLength);
+		const Sci::Position endSegment = std::min(segmentStart + segmentLength, end);
+		if (!segment || (endSegment <= position)) {
+			break;
+		}
+		const char *origin = segment - segmentStart;
+		auto byteAt = [=](Sci::Position pos) noexcept -> unsigned char {
+			if ((pos >= segmentStart) && (pos < segmentStart + segmentLength)) {
+				return origin[pos];
+			}
+			return pcb->UCharAt(pos);
+		};
+		while (position < endSegment) {
+			const char *found = FindLineEndByte(origin + position, origin + endSegment, unicode);
+			position = found - origin;
+			if (position >= endSegment) {
+				break;
+			}
+			const unsigned char ch = *found;
+			if (ch == '\r') {
+				positions.push_back(position + ((byteAt(position + 1) == '\n') ? 2 : 1));
+			} else if (ch == '\n') {
+				if (byteAt(position - 1) != '\r') {
+					positions.push_back(position + 1);
+				}
+			} else if (UTF8IsMultibyteLineEnd(byteAt(position - 2), byteAt(position - 1), ch)) {
+				positions.push_back(position + 1);
+			}
+			position++;
+		}
+		position = endSegment;
+	}
+}
+
+// Documents share a pool so loading each large document does not start threads.
+// The pool, with its threads, is destroyed along with the last document holding it.
+std::shared_ptr<ThreadPool> SharedLineEndPool() {
+	static std::mutex mutexPool;
+	static std::weak_ptr<ThreadPool> poolShared;
+	std::lock_guard<std::mutex> guard(mutexPool);
+	std::shared_ptr<ThreadPool> pool = poolShared.lock();
+	if (!pool) {
+		pool = std::make_shared<ThreadPool>();
+		poolShared = pool;
+	}
+	return pool;
+}
+
+}
+
 void CellBuffer::ResetLineEnds() {
 	// Reinitialize line data -- too much work to preserve
+	lineEndsDeferred = false;
 	const Sci::Line lines = plv->Lines();
 	plv->Init();
 	plv->AllocateLines(lines);
 
-	constexpr Sci::Position position = 0;
 	const Sci::Position length = Length();
 	plv->InsertText(0, length);
-	Sci::Line lineInsert = 1;
-	constexpr bool atLineStart = true;
-	unsigned char chBeforePrev = 0;
-	unsigned char chPrev = 0;
-	for (Sci::Position i = 0; i < length; i++) {
-		const unsigned char ch = substance.ValueAt(position + i);
-		if (ch == '\r') {
-			InsertLine(lineInsert, (position + i) + 1, atLineStart);
-			lineInsert++;
-		} else if (ch == '\n') {
-			if (chPrev == '\r') {
-				// Patch up what was end of line
-				plv->SetLineStart(lineInsert - 1, (position + i) + 1);
-			} else {
-				InsertLine(lineInsert, (position + i) + 1, atLineStart);
-				lineInsert++;
-			}
-		} else if (utf8LineEnds == LineEndType::Unicode) {
-			if (UTF8IsMultibyteLineEnd(chBeforePrev, chPrev, ch)) {
-				InsertLine(lineInsert, (position + i) + 1, atLineStart);
-				lineInsert++;
-			}
+
+	// Large documents are divided into ranges scanned in parallel
+	const size_t threadsForLength = std::max<Sci::Position>(1, length / bytesPerLineEndThread);
+	const size_t threads = std::min<size_t>(threadsForLength, std::max(1U, std::thread::hardware_concurrency()));
+	const bool unicode = utf8LineEnds == LineEndType::Unicode;
+	std::vector<std::vector<Sci::Position>> positions(threads);
+	if (threads > 1) {
+		if (!lineEndPool) {
+			lineEndPool = SharedLineEndPool();
 		}
-		chBeforePrev = chPrev;
-		chPrev = ch;
+		std::atomic<size_t> nextRange = 0;
+		lineEndPool->Run(threads, [&](size_t) {
+			while (true) {
+				const size_t range = nextRange.fetch_add(1, std::memory_order_acq_rel);
+				if (range >= threads) {
+					break;
+				}
+				FindLineEnds(this, length * range / threads, length * (range + 1) / threads,
+					unicode, positions[range]);
+			}
+		});
+	} else {
+		FindLineEnds(this, 0, length, unicode, positions[0]);
+	}
+
+	// Merge into line vector in bulk
+	constexpr bool atLineStart = true;
+	Sci::Line lineInsert = 1;
+	for (const std::vector<Sci::Position> &positionsThread : positions) {
+		plv->InsertLines(lineInsert, positionsThread.data(), positionsThread.size(), atLineStart);
+		lineInsert += positionsThread.size();
+	}
+}
+
+void CellBuffer::DeferLineEnds() noexcept {
+	if ((Length() == 0) && !MaintainingLineCharacterIndex()) {
+		lineEndsDeferred = true;
+	}
+}
+
+void CellBuffer::ResolveLineEnds() {
+	if (lineEndsDeferred) {
+		ResetLineEnds();
 	}
 }
 
@@ -780,12 +1244,29 @@ void CellBuffer::RecalculateIndexLineStarts(Sci::Line lineFirst, Sci::Line lineL
 	}
 }
 
-void CellBuffer::BasicInsertString(Sci::Position position, const char *s, Sci::Position insertLength) {
+void CellBuffer::BasicInsertString(Sci::Position position, const char *s, Sci::Position insertLength, bool reference) {
 	if (insertLength == 0)
 		return;
 	PLATFORM_ASSERT(insertLength > 0);
 
-	const unsigned char chAfter = substance.ValueAt(position);
+	if (lineEndsDeferred) {
+		if (position == Length()) {
+			// Loading just appends text with line ends found once loading completes
+			if (reference) {
+				substance->InsertReference(position, s, insertLength);
+			} else {
+				substance->InsertFromArray(position, s, insertLength);
+			}
+			if (hasStyles) {
+				style->InsertValue(position, insertLength, 0);
+			}
+			plv->InsertText(plv->Lines() - 1, insertLength);
+			return;
+		}
+		ResetLineEnds();
+	}
+
+	const unsigned char chAfter = substance->ValueAt(position);
 	bool breakingUTF8LineEnd = false;
 	if (utf8LineEnds == LineEndType::Unicode && UTF8IsTrailByte(chAfter)) {
 		breakingUTF8LineEnd = UTF8LineEndOverlaps(position);
@@ -807,16 +1288,20 @@ void CellBuffer::BasicInsertString(Sci::Position position, const char *s, Sci::P
 			UTF8IsValid(std::string_view(s, insertLength));
 	}
 
-	substance.InsertFromArray(position, s, 0, insertLength);
+	if (reference) {
+		substance->InsertReference(position, s, insertLength);
+	} else {
+		substance->InsertFromArray(position, s, insertLength);
+	}
 	if (hasStyles) {
-		style.InsertValue(position, insertLength, 0);
+		style->InsertValue(position, insertLength, 0);
 	}
 
 	const bool atLineStart = plv->LineStart(lineInsert-1) == position;
 	// Point all the lines after the insertion point further along in the buffer
 	plv->InsertText(lineInsert-1, insertLength);
-	unsigned char chBeforePrev = substance.ValueAt(position - 2);
-	unsigned char chPrev = substance.ValueAt(position - 1);
+	unsigned char chBeforePrev = substance->ValueAt(position - 2);
+	unsigned char chPrev = substance->ValueAt(position - 1);
 	if (chPrev == '\r' && chAfter == '\n') {
 		// Splitting up a crlf pair at position
 		InsertLine(lineInsert, position, false);
@@ -854,15 +1339,21 @@ void CellBuffer::BasicInsertString(Sci::Position position, const char *s, Sci::P
 			eolTable[0xa9] = 3;
 		}
 
+		const bool unicode = utf8LineEnds == LineEndType::Unicode;
 		do {
-			// skip to line end
-			ch = *ptr++;
-			uint8_t type;
-			while ((type = eolTable[ch]) == 0 && ptr < end) {
-				chBeforePrev = chPrev;
-				chPrev = ch;
-				ch = *ptr++;
+			// skip to possible line end
+			const char *found = FindLineEndByte(ptr, end, unicode);
+			if (found == end) {
+				// Final byte handled after loop
+				found = end - 1;
 			}
+			if (found > ptr) {
+				chBeforePrev = (found - 1 > ptr) ? found[-2] : chPrev;
+				chPrev = found[-1];
+			}
+			ptr = found;
+			ch = *ptr++;
+			const uint8_t type = eolTable[ch];
 			switch (type) {
 			case 2: // '\r'
 				if (*ptr == '\n') {
@@ -927,7 +1418,7 @@ void CellBuffer::BasicInsertString(Sci::Position position, const char *s, Sci::P
 		chPrev = ch;
 		// May have end of UTF-8 line end in buffer and start in insertion
 		for (int j = 0; j < UTF8SeparatorLength-1; j++) {
-			const unsigned char chAt = substance.ValueAt(position + insertLength + j);
+			const unsigned char chAt = substance->ValueAt(position + insertLength + j);
 			const unsigned char back3[3] = {chBeforePrev, chPrev, chAt};
 			if (UTF8IsSeparator(back3)) {
 				InsertLine(lineInsert, (position + insertLength + j) + 1, atLineStart);
@@ -955,9 +1446,11 @@ void CellBuffer::BasicDeleteChars(Sci::Position position, Sci::Position deleteLe
 	if (deleteLength == 0)
 		return;
 
+	ResolveLineEnds();
+
 	Sci::Line lineRecalculateStart = Sci::invalidPosition;
 
-	if ((position == 0) && (deleteLength == substance.Length())) {
+	if ((position == 0) && (deleteLength == substance->Length())) {
 		// If whole buffer is being deleted, faster to reinitialise lines data
 		// than to delete each line.
 		plv->Init();
@@ -969,9 +1462,9 @@ void CellBuffer::BasicDeleteChars(Sci::Position position, Sci::Position deleteLe
 		Sci::Line lineRemove = linePosition + 1;
 
 		plv->InsertText(lineRemove-1, - (deleteLength));
-		const unsigned char chPrev = substance.ValueAt(position - 1);
+		const unsigned char chPrev = substance->ValueAt(position - 1);
 		const unsigned char chBefore = chPrev;
-		unsigned char chNext = substance.ValueAt(position);
+		unsigned char chNext = substance->ValueAt(position);
 
 		// Check for breaking apart a UTF-8 sequence
 		// Needs further checks that text is UTF-8 or that some other break apart is occurring
@@ -1010,8 +1503,24 @@ void CellBuffer::BasicDeleteChars(Sci::Position position, Sci::Position deleteLe
 		}
 
 		unsigned char ch = chNext;
+		SegmentedView view = AllView();
+		const bool unicode = utf8LineEnds == LineEndType::Unicode;
 		for (Sci::Position i = 0; i < deleteLength; i++) {
-			chNext = substance.ValueAt(position + i + 1);
+			if ((ch != '\r') && (ch != '\n') && (!unicode || UTF8IsAscii(ch))) {
+				// Skip to next possible line end. Multi-byte line ends are found by their
+				// last byte which may be after the deletion so move back to their start.
+				const Sci::Position lookAhead = unicode ? UTF8SeparatorLength - 1 : 0;
+				const Sci::Position found = view.FindLineEndByte(position + i + 1, deleteLength - i - 1 + lookAhead, unicode);
+				if (found < 0) {
+					break;
+				}
+				i = std::max(i + 1, found - position - lookAhead);
+				if (i >= deleteLength) {
+					break;
+				}
+				ch = view.CharAt(position + i);
+			}
+			chNext = view.CharAt(position + i + 1);
 			if (ch == '\r') {
 				if (chNext != '\n') {
 					RemoveLine(lineRemove);
@@ -1025,7 +1534,7 @@ void CellBuffer::BasicDeleteChars(Sci::Position position, Sci::Position deleteLe
 			} else if (utf8LineEnds == LineEndType::Unicode) {
 				if (!UTF8IsAscii(ch)) {
 					const unsigned char next3[3] = {ch, chNext,
-						static_cast<unsigned char>(substance.ValueAt(position + i + 2))};
+						static_cast<unsigned char>(view.CharAt(position + i + 2))};
 					if (UTF8IsSeparator(next3) || UTF8IsNEL(next3)) {
 						RemoveLine(lineRemove);
 					}
@@ -1036,19 +1545,19 @@ void CellBuffer::BasicDeleteChars(Sci::Position position, Sci::Position deleteLe
 		}
 		// May have to fix up end if last deletion causes cr to be next to lf
 		// or removes one of a crlf pair
-		const char chAfter = substance.ValueAt(position + deleteLength);
+		const char chAfter = substance->ValueAt(position + deleteLength);
 		if (chBefore == '\r' && chAfter == '\n') {
 			// Using lineRemove-1 as cr ended line before start of deletion
 			RemoveLine(lineRemove - 1);
 			plv->SetLineStart(lineRemove - 1, position + 1);
 		}
 	}
-	substance.DeleteRange(position, deleteLength);
+	substance->DeleteRange(position, deleteLength);
 	if (lineRecalculateStart >= 0) {
 		RecalculateIndexLineStarts(lineRecalculateStart, lineRecalculateStart);
 	}
 	if (hasStyles) {
-		style.DeleteRange(position, deleteLength);
+		style->DeleteRange(position, deleteLength);
 	}
 }
 
@@ -1103,7 +1612,7 @@ void CellBuffer::PerformUndoStep() {
 		changeHistory->StartReversion();
 	}
 	if (previousStep.at == ActionType::insert) {
-		if (substance.Length() < previousStep.lenData) {
+		if (substance->Length() < previousStep.lenData) {
 			throw std::runtime_error(
 				"CellBuffer::PerformUndoStep: deletion must be less than document length.");
 		}
@@ -23,11 +23,24 @@ public:
 class UndoHistory;
 class ChangeHistory;
 
+/**
+ * The text store holds the bytes of the document or their styles.
+ */
+class ITextStore;
+
 /**
  * The line vector contains information about each of the lines in a cell buffer.
  */
 class ILineVector;
 
+class ThreadPool;
+
+/**
+ * How the text of a CellBuffer is stored: contiguously with a gap, as a rope of blocks,
+ * or as pieces that may refer to read-only memory supplied by the container.
+ */
+enum class TextStorage { gap, rope, mapped };
+
 enum class ActionType : unsigned char { insert, remove, container };
 
 /**
@@ -41,31 +54,65 @@ struct Action {
 	Sci::Position lenData = 0;
 };
 
-struct SplitView {
-	const char *segment1 = nullptr;
-	size_t length1 = 0;
-	const char *segment2 = nullptr;
-	size_t length = 0;
+/// Find the first byte in [s, end) that may end a line: CR or LF and, when unicode is true,
+/// the last byte of NEL, LS, or PS. Callers check multi-byte line ends with UTF8IsMultibyteLineEnd.
+/// Examines multiple bytes at a time with SIMD instructions chosen for the processor.
+/// @return pointer to the byte or end if none found.
+const char *FindLineEndByte(const char *s, const char *end, bool unicode) noexcept;
 
-	bool operator==(const SplitView &other) const noexcept {
-		return segment1 == other.segment1 && length1 == other.length1 &&
-			segment2 == other.segment2 && length == other.length;
-	}
-	bool operator!=(const SplitView &other) const noexcept {
-		return !(*this == other);
+class CellBuffer;
+
+/**
+ * Read access to the text of a CellBuffer that works whichever text store is used.
+ * Text is retrieved as contiguous segments and the most recent segment is remembered so
+ * that sequential access is fast. Replaces direct access to the two sides of the gap
+ * in a SplitVector.
+ */
+class SegmentedView {
+	const CellBuffer *pcb;
+	const char *origin = nullptr;	// Segment text moved back by segment start so can be indexed by position
+	Sci::Position start = 0;
+	Sci::Position end = 0;
+	Sci::Position length = 0;
+	bool Load(Sci::Position position) noexcept;
+public:
+	explicit SegmentedView(const CellBuffer *pcb_) noexcept;
+
+	Sci::Position Length() const noexcept {
+		return length;
 	}
 
-	char CharAt(size_t position) const noexcept {
-		if (position < length1) {
-			return segment1[position];
+	/// Retrieving positions outside the range of the buffer works and returns 0
+	char CharAt(Sci::Position position) noexcept {
+		if ((position >= start) && (position < end)) {
+			return origin[position];
 		}
-		if (position < length) {
-			return segment2[position];
+		if (Load(position)) {
+			return origin[position];
 		}
 		return 0;
 	}
-};
 
+	/// Contiguous text around position for searches that read memory directly.
+	/// The result is indexed by document position and is valid until another segment is loaded.
+	/// @return nullptr if position is outside the text otherwise segmentStart and segmentEnd are set to the extent of the segment.
+	const char *Segment(Sci::Position position, Sci::Position &segmentStart, Sci::Position &segmentEnd) noexcept {
+		if (!((position >= start) && (position < end)) && !Load(position)) {
+			return nullptr;
+		}
+		segmentStart = start;
+		segmentEnd = end;
+		return origin;
+	}
+
+	/// Equivalent of memchr over the segments.
+	/// @return position of ch in [position, position+rangeLength) or -1 if not found.
+	Sci::Position FindChar(Sci::Position position, Sci::Position rangeLength, int ch) noexcept;
+
+	/// Equivalent of FindLineEndByte over the segments.
+	/// @return position of the byte in [position, position+rangeLength) or -1 if not found.
+	Sci::Position FindLineEndByte(Sci::Position position, Sci::Position rangeLength, bool unicode) noexcept;
+};
 
 /**
  * Holder for an expandable array of characters that supports undo and line markers.
@@ -76,8 +123,15 @@ class CellBuffer {
 private:
 	bool hasStyles;
 	bool largeDocument;
-	SplitVector<char> substance;
-	SplitVector<char> style;
+	TextStorage storage;
+	bool linesTree;
+	bool lineEndsDeferred = false;
+	std::unique_ptr<ITextStore> substance;
+	std::unique_ptr<ITextStore> style;
+	// The default gap buffer stores are also held directly so the most frequent
+	// accesses avoid virtual calls. nullptr for other storage.
+	SplitVector<char> *gapSubstance = nullptr;
+	SplitVector<char> *gapStyle = nullptr;
 	bool readOnly;
 	bool utf8Substance;
 	Scintilla::LineEndType utf8LineEnds;
@@ -89,18 +143,21 @@ private:
 
 	std::unique_ptr<ILineVector> plv;
 
+	// Held after scanning line ends in parallel so later scans reuse its threads
+	std::shared_ptr<ThreadPool> lineEndPool;
+
 	bool UTF8LineEndOverlaps(Sci::Position position) const noexcept;
 	bool UTF8IsCharacterBoundary(Sci::Position position) const;
 	void ResetLineEnds();
 	void RecalculateIndexLineStarts(Sci::Line lineFirst, Sci::Line lineLast);
 	bool MaintainingLineCharacterIndex() const noexcept;
 	/// Actions without undo
-	void BasicInsertString(Sci::Position position, const char *s, Sci::Position insertLength);
+	void BasicInsertString(Sci::Position position, const char *s, Sci::Position insertLength, bool reference=false);
 	void BasicDeleteChars(Sci::Position position, Sci::Position deleteLength);
 
 public:
 
-	CellBuffer(bool hasStyles_, bool largeDocument_);
+	CellBuffer(bool hasStyles_, bool largeDocument_, TextStorage storage_=TextStorage::gap, bool linesTree_=false);
 	// Deleted so CellBuffer objects can not be copied.
 	CellBuffer(const CellBuffer &) = delete;
 	CellBuffer(CellBuffer &&) = delete;
@@ -117,7 +174,8 @@ public:
 	const char *BufferPointer();
 	const char *RangePointer(Sci::Position position, Sci::Position rangeLength) noexcept;
 	Sci::Position GapPosition() const noexcept;
-	SplitView AllView() const noexcept;
+	const char *SegmentAt(Sci::Position position, Sci::Position &segmentStart, Sci::Position &segmentLength) const noexcept;
+	SegmentedView AllView() const noexcept;
 
 	Sci::Position Length() const noexcept;
 	void Allocate(Sci::Position newSize);
@@ -137,8 +195,14 @@ public:
 	Sci::Line LineFromPosition(Sci::Position pos) const noexcept;
 	Sci::Line LineFromPositionIndex(Sci::Position pos, Scintilla::LineCharacterIndexType lineCharacterIndex) const noexcept;
 	void InsertLine(Sci::Line line, Sci::Position position, bool lineStart);
+	/// When loading into an empty buffer, finding line ends can wait until all the text is present
+	/// and then be performed in parallel. Until ResolveLineEnds is called, line information is invalid.
+	void DeferLineEnds() noexcept;
+	void ResolveLineEnds();
 	void RemoveLine(Sci::Line line);
-	const char *InsertString(Sci::Position position, const char *s, Sci::Position insertLength, bool &startSequence);
+	/// When reference is true, text storage that supports it refers to s instead of copying it
+	/// so s must remain valid and unchanged for the life of the CellBuffer.
+	const char *InsertString(Sci::Position position, const char *s, Sci::Position insertLength, bool &startSequence, bool reference=false);
 
 	/// Setting styles for positions outside the range of the buffer is safe and has no effect.
 	/// @return true if the style of a character is changed.
@@ -150,6 +214,8 @@ public:
 	bool IsReadOnly() const noexcept;
 	void SetReadOnly(bool set) noexcept;
 	bool IsLarge() const noexcept;
+	bool IsLinesTree() const noexcept;
+	TextStorage Storage() const noexcept;
 	bool HasStyles() const noexcept;
 
 	/// The save point is a marker in the undo stack where the container has stated that
@@ -22,6 +22,7 @@
 #include "UniqueString.h"
 #include "SplitVector.h"
 #include "Partitioning.h"
+#include "TreePartitioning.h"
 #include "RunStyles.h"
 #include "SparseVector.h"
 #include "ContractionState.h"
@@ -30,14 +31,14 @@ using namespace Scintilla::Internal;
 
 namespace {
 
-template <typename LINE>
+template <typename LINE, typename PARTITIONING>
 class ContractionState final : public IContractionState {
 	// These contain 1 element for every document line.
-	std::unique_ptr<RunStyles<LINE, char>> visible;
-	std::unique_ptr<RunStyles<LINE, char>> expanded;
-	std::unique_ptr<RunStyles<LINE, int>> heights;
+	std::unique_ptr<RunStyles<LINE, char, PARTITIONING>> visible;
+	std::unique_ptr<RunStyles<LINE, char, PARTITIONING>> expanded;
+	std::unique_ptr<RunStyles<LINE, int, PARTITIONING>> heights;
 	std::unique_ptr<SparseVector<UniqueString>> foldDisplayTexts;
-	std::unique_ptr<Partitioning<LINE>> displayLines;
+	std::unique_ptr<PARTITIONING> displayLines;
 	LINE linesInDocument;
 
 	void EnsureData();
@@ -91,24 +92,24 @@ public:
 	void Check() const noexcept;
 };
 
-template <typename LINE>
-ContractionState<LINE>::ContractionState() noexcept : linesInDocument(1) {
+template <typename LINE, typename PARTITIONING>
+ContractionState<LINE, PARTITIONING>::ContractionState() noexcept : linesInDocument(1) {
 }
 
-template <typename LINE>
-void ContractionState<LINE>::EnsureData() {
+template <typename LINE, typename PARTITIONING>
+void ContractionState<LINE, PARTITIONING>::EnsureData() {
 	if (OneToOne()) {
-		visible = std::make_unique<RunStyles<LINE, char>>();
-		expanded = std::make_unique<RunStyles<LINE, char>>();
-		heights = std::make_unique<RunStyles<LINE, int>>();
+		visible = std::make_unique<RunStyles<LINE, char, PARTITIONING>>();
+		expanded = std::make_unique<RunStyles<LINE, char, PARTITIONING>>();
+		heights = std::make_unique<RunStyles<LINE, int, PARTITIONING>>();
 		foldDisplayTexts = std::make_unique<SparseVector<UniqueString>>();
-		displayLines = std::make_unique<Partitioning<LINE>>(4);
+		displayLines = std::make_unique<PARTITIONING>(4);
 		InsertLines(0, linesInDocument);
 	}
 }
 
-template <typename LINE>
-void ContractionState<LINE>::InsertLine(Sci::Line lineDoc) {
+template <typename LINE, typename PARTITIONING>
+void ContractionState<LINE, PARTITIONING>::InsertLine(Sci::Line lineDoc) {
 	if (OneToOne()) {
 		linesInDocument++;
 	} else {
@@ -127,8 +128,8 @@ void ContractionState<LINE>::InsertLine(Sci::Line lineDoc) {
 	}
 }
 
-template <typename LINE>
-void ContractionState<LINE>::DeleteLine(Sci::Line lineDoc) {
+template <typename LINE, typename PARTITIONING>
+void ContractionState<LINE, PARTITIONING>::DeleteLine(Sci::Line lineDoc) {
 	if (OneToOne()) {
 		linesInDocument--;
 	} else {
@@ -144,8 +145,8 @@ void ContractionState<LINE>::DeleteLine(Sci::Line lineDoc) {
 	}
 }
 
-template <typename LINE>
-void ContractionState<LINE>::Clear() noexcept {
+template <typename LINE, typename PARTITIONING>
+void ContractionState<LINE, PARTITIONING>::Clear() noexcept {
 	visible.reset();
 	expanded.reset();
 	heights.reset();
@@ -154,8 +155,8 @@ void ContractionState<LINE>::Clear() noexcept {
 	linesInDocument = 1;
 }
 
-template <typename LINE>
-Sci::Line ContractionState<LINE>::LinesInDoc() const noexcept {
+template <typename LINE, typename PARTITIONING>
+Sci::Line ContractionState<LINE, PARTITIONING>::LinesInDoc() const noexcept {
 	if (OneToOne()) {
 		return linesInDocument;
 	} else {
@@ -163,8 +164,8 @@ Sci::Line ContractionState<LINE>::LinesInDoc() const noexcept {
 	}
 }
 
-template <typename LINE>
-Sci::Line ContractionState<LINE>::LinesDisplayed() const noexcept {
+template <typename LINE, typename PARTITIONING>
+Sci::Line ContractionState<LINE, PARTITIONING>::LinesDisplayed() const noexcept {
 	if (OneToOne()) {
 		return linesInDocument;
 	} else {
@@ -172,8 +173,8 @@ Sci::Line ContractionState<LINE>::LinesDisplayed() const noexcept {
 	}
 }
 
-template <typename LINE>
-Sci::Line ContractionState<LINE>::DisplayFromDoc(Sci::Line lineDoc) const noexcept {
+template <typename LINE, typename PARTITIONING>
+Sci::Line ContractionState<LINE, PARTITIONING>::DisplayFromDoc(Sci::Line lineDoc) const noexcept {
 	if (OneToOne()) {
 		return (lineDoc <= linesInDocument) ? lineDoc : linesInDocument;
 	} else {
@@ -183,13 +184,13 @@ Sci::Line ContractionState<LINE>::DisplayFromDoc(Sci::Line lineDoc) const noexce
 	}
 }
 
-template <typename LINE>
-Sci::Line ContractionState<LINE>::DisplayLastFromDoc(Sci::Line lineDoc) const noexcept {
+template <typename LINE, typename PARTITIONING>
+Sci::Line ContractionState<LINE, PARTITIONING>::DisplayLastFromDoc(Sci::Line lineDoc) const noexcept {
 	return DisplayFromDoc(lineDoc) + GetHeight(lineDoc) - 1;
 }
 
-template <typename LINE>
-Sci::Line ContractionState<LINE>::DocFromDisplay(Sci::Line lineDisplay) const noexcept {
+template <typename LINE, typename PARTITIONING>
+Sci::Line ContractionState<LINE, PARTITIONING>::DocFromDisplay(Sci::Line lineDisplay) const noexcept {
 	if (OneToOne()) {
 		return lineDisplay;
 	} else {
@@ -205,8 +206,8 @@ Sci::Line ContractionState<LINE>::DocFromDisplay(Sci::Line lineDisplay) const no
 	}
 }
 
-template <typename LINE>
-void ContractionState<LINE>::InsertLines(Sci::Line lineDoc, Sci::Line lineCount) {
+template <typename LINE, typename PARTITIONING>
+void ContractionState<LINE, PARTITIONING>::InsertLines(Sci::Line lineDoc, Sci::Line lineCount) {
 	if (OneToOne()) {
 		linesInDocument += line_cast(lineCount);
 	} else {
@@ -217,8 +218,8 @@ void ContractionState<LINE>::InsertLines(Sci::Line lineDoc, Sci::Line lineCount)
 	Check();
 }
 
-template <typename LINE>
-void ContractionState<LINE>::DeleteLines(Sci::Line lineDoc, Sci::Line lineCount) {
+template <typename LINE, typename PARTITIONING>
+void ContractionState<LINE, PARTITIONING>::DeleteLines(Sci::Line lineDoc, Sci::Line lineCount) {
 	if (OneToOne()) {
 		linesInDocument -= line_cast(lineCount);
 	} else {
@@ -229,8 +230,8 @@ void ContractionState<LINE>::DeleteLines(Sci::Line lineDoc, Sci::Line lineCount)
 	Check();
 }
 
-template <typename LINE>
-bool ContractionState<LINE>::GetVisible(Sci::Line lineDoc) const noexcept {
+template <typename LINE, typename PARTITIONING>
+bool ContractionState<LINE, PARTITIONING>::GetVisible(Sci::Line lineDoc) const noexcept {
 	if (OneToOne()) {
 		return true;
 	} else {
@@ -240,8 +241,8 @@ bool ContractionState<LINE>::GetVisible(Sci::Line lineDoc) const noexcept {
 	}
 }
 
-template <typename LINE>
-bool ContractionState<LINE>::SetVisible(Sci::Line lineDocStart, Sci::Line lineDocEnd, bool isVisible) {
+template <typename LINE, typename PARTITIONING>
+bool ContractionState<LINE, PARTITIONING>::SetVisible(Sci::Line lineDocStart, Sci::Line lineDocEnd, bool isVisible) {
 	if (OneToOne() && isVisible) {
 		return false;
 	} else {
@@ -269,8 +270,8 @@ bool ContractionState<LINE>::SetVisible(Sci::Line lineDocStart, Sci::Line lineDo
 	}
 }
 
-template <typename LINE>
-bool ContractionState<LINE>::HiddenLines() const noexcept {
+template <typename LINE, typename PARTITIONING>
+bool ContractionState<LINE, PARTITIONING>::HiddenLines() const noexcept {
 	if (OneToOne()) {
 		return false;
 	} else {
@@ -278,14 +279,14 @@ bool ContractionState<LINE>::HiddenLines() const noexcept {
 	}
 }
 
-template <typename LINE>
-const char *ContractionState<LINE>::GetFoldDisplayText(Sci::Line lineDoc) const noexcept {
+template <typename LINE, typename PARTITIONING>
+const char *ContractionState<LINE, PARTITIONING>::GetFoldDisplayText(Sci::Line lineDoc) const noexcept {
 	Check();
 	return foldDisplayTexts->ValueAt(lineDoc).get();
 }
 
-template <typename LINE>
-bool ContractionState<LINE>::SetFoldDisplayText(Sci::Line lineDoc, const char *text) {
+template <typename LINE, typename PARTITIONING>
+bool ContractionState<LINE, PARTITIONING>::SetFoldDisplayText(Sci::Line lineDoc, const char *text) {
 	EnsureData();
 	const char *foldText = foldDisplayTexts->ValueAt(lineDoc).get();
 	if (!foldText || !text || 0 != strcmp(text, foldText)) {
@@ -299,8 +300,8 @@ bool ContractionState<LINE>::SetFoldDisplayText(Sci::Line lineDoc, const char *t
 	}
 }
 
-template <typename LINE>
-bool ContractionState<LINE>::GetExpanded(Sci::Line lineDoc) const noexcept {
+template <typename LINE, typename PARTITIONING>
+bool ContractionState<LINE, PARTITIONING>::GetExpanded(Sci::Line lineDoc) const noexcept {
 	if (OneToOne()) {
 		return true;
 	} else {
@@ -309,8 +310,8 @@ bool ContractionState<LINE>::GetExpanded(Sci::Line lineDoc) const noexcept {
 	}
 }
 
-template <typename LINE>
-bool ContractionState<LINE>::SetExpanded(Sci::Line lineDoc, bool isExpanded) {
+template <typename LINE, typename PARTITIONING>
+bool ContractionState<LINE, PARTITIONING>::SetExpanded(Sci::Line lineDoc, bool isExpanded) {
 	if (OneToOne() && isExpanded) {
 		return false;
 	} else {
@@ -326,8 +327,8 @@ bool ContractionState<LINE>::SetExpanded(Sci::Line lineDoc, bool isExpanded) {
 	}
 }
 
-template <typename LINE>
-bool ContractionState<LINE>::ExpandAll() {
+template <typename LINE, typename PARTITIONING>
+bool ContractionState<LINE, PARTITIONING>::ExpandAll() {
 	if (OneToOne()) {
 		return false;
 	} else {
@@ -338,8 +339,8 @@ bool ContractionState<LINE>::ExpandAll() {
 	}
 }
 
-template <typename LINE>
-Sci::Line ContractionState<LINE>::ContractedNext(Sci::Line lineDocStart) const noexcept {
+template <typename LINE, typename PARTITIONING>
+Sci::Line ContractionState<LINE, PARTITIONING>::ContractedNext(Sci::Line lineDocStart) const noexcept {
 	if (OneToOne()) {
 		return -1;
 	} else {
@@ -356,8 +357,8 @@ Sci::Line ContractionState<LINE>::ContractedNext(Sci::Line lineDocStart) const n
 	}
 }
 
-template <typename LINE>
-int ContractionState<LINE>::GetHeight(Sci::Line lineDoc) const noexcept {
+template <typename LINE, typename PARTITIONING>
+int ContractionState<LINE, PARTITIONING>::GetHeight(Sci::Line lineDoc) const noexcept {
 	if (OneToOne()) {
 		return 1;
 	} else {
@@ -367,8 +368,8 @@ int ContractionState<LINE>::GetHeight(Sci::Line lineDoc) const noexcept {
 
 // Set the number of display lines needed for this line.
 // Return true if this is a change.
-template <typename LINE>
-bool ContractionState<LINE>::SetHeight(Sci::Line lineDoc, int height) {
+template <typename LINE, typename PARTITIONING>
+bool ContractionState<LINE, PARTITIONING>::SetHeight(Sci::Line lineDoc, int height) {
 	if (OneToOne() && (height == 1)) {
 		return false;
 	} else if (lineDoc < LinesInDoc()) {
@@ -389,8 +390,8 @@ bool ContractionState<LINE>::SetHeight(Sci::Line lineDoc, int height) {
 	}
 }
 
-template <typename LINE>
-void ContractionState<LINE>::ShowAll() noexcept {
+template <typename LINE, typename PARTITIONING>
+void ContractionState<LINE, PARTITIONING>::ShowAll() noexcept {
 	const LINE lines = line_cast(LinesInDoc());
 	Clear();
 	linesInDocument = lines;
@@ -398,8 +399,8 @@ void ContractionState<LINE>::ShowAll() noexcept {
 
 // Debugging checks
 
-template <typename LINE>
-void ContractionState<LINE>::Check() const noexcept {
+template <typename LINE, typename PARTITIONING>
+void ContractionState<LINE, PARTITIONING>::Check() const noexcept {
 #ifdef CHECK_CORRECTNESS
 	for (Sci::Line vline = 0; vline < LinesDisplayed(); vline++) {
 		const Sci::Line lineDoc = DocFromDisplay(vline);
@@ -423,11 +424,17 @@ void ContractionState<LINE>::Check() const noexcept {
 
 namespace Scintilla::Internal {
 
-std::unique_ptr<IContractionState> ContractionStateCreate(bool largeDocument) {
+std::unique_ptr<IContractionState> ContractionStateCreate(bool largeDocument, bool linesTree) {
+	if (linesTree) {
+		if (largeDocument)
+			return std::make_unique<ContractionState<Sci::Line, TreePartitioning<Sci::Line>>>();
+		else
+			return std::make_unique<ContractionState<int, TreePartitioning<int>>>();
+	}
 	if (largeDocument)
-		return std::make_unique<ContractionState<Sci::Line>>();
+		return std::make_unique<ContractionState<Sci::Line, Partitioning<Sci::Line>>>();
 	else
-		return std::make_unique<ContractionState<int>>();
+		return std::make_unique<ContractionState<int, Partitioning<int>>>();
 }
 
 }
@@ -45,7 +45,7 @@ public:
 	virtual void ShowAll() noexcept=0;
 };
 
-std::unique_ptr<IContractionState> ContractionStateCreate(bool largeDocument);
+std::unique_ptr<IContractionState> ContractionStateCreate(bool largeDocument, bool linesTree=false);
 
 }
 
@@ -13,6 +13,7 @@
 #include <cmath>
 
 #include <stdexcept>
+#include <exception>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -20,12 +21,25 @@
 #include <forward_list>
 #include <optional>
 #include <algorithm>
+#include <functional>
 #include <memory>
 #include <chrono>
 
 #ifndef NO_CXX11_REGEX
 #include <regex>
 #endif
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SCI_SEARCH_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
 
 #include "ScintillaTypes.h"
 #include "ILoader.h"
@@ -46,8 +60,10 @@
 #include "CaseFolder.h"
 #include "Document.h"
 #include "RESearch.h"
+#include "LinearRegex.h"
 #include "UniConversion.h"
 #include "ElapsedPeriod.h"
+#include "ThreadPool.h"
 
 using namespace Scintilla;
 using namespace Scintilla::Internal;
@@ -143,8 +159,21 @@ CharacterExtracted::CharacterExtracted(const unsigned char *charBytes, size_t wi
 	}
 }
 
+namespace {
+
+TextStorage StorageFromOptions(DocumentOption options) noexcept {
+	if (FlagSet(options, DocumentOption::TextMapped))
+		return TextStorage::mapped;
+	if (FlagSet(options, DocumentOption::TextRope))
+		return TextStorage::rope;
+	return TextStorage::gap;
+}
+
+}
+
 Document::Document(DocumentOption options) :
-	cb(!FlagSet(options, DocumentOption::StylesNone), FlagSet(options, DocumentOption::TextLarge)),
+	cb(!FlagSet(options, DocumentOption::StylesNone), FlagSet(options, DocumentOption::TextLarge),
+		StorageFromOptions(options), FlagSet(options, DocumentOption::LinesTree)),
 	durationStyleOneByte(0.000001, 0.0000001, 0.00001) {
 	refCount = 0;
 #ifdef _WIN32
@@ -1337,7 +1366,7 @@ bool Document::DeleteChars(Sci::Position pos, Sci::Position len) {
 /**
  * Insert a string with a length.
  */
-Sci::Position Document::InsertString(Sci::Position position, const char *s, Sci::Position insertLength) {
+Sci::Position Document::InsertString(Sci::Position position, const char *s, Sci::Position insertLength, bool reference) {
 	if (insertLength <= 0) {
 		return 0;
 	}
@@ -1368,7 +1397,8 @@ Sci::Position Document::InsertString(Sci::Position position, const char *s, Sci:
 	const Sci::Line prevLinesTotal = LinesTotal();
 	const bool startSavePoint = cb.IsSavePoint();
 	bool startSequence = false;
-	const char *text = cb.InsertString(position, s, insertLength, startSequence);
+	// Can not refer to a changed insertion as it is temporary
+	const char *text = cb.InsertString(position, s, insertLength, startSequence, reference && !insertionSet);
 	if (startSavePoint && cb.IsCollectingUndo())
 		NotifySavePoint(false);
 	ModifiedAt(position);
@@ -1397,7 +1427,12 @@ void Document::ChangeInsertion(const char *s, Sci::Position length) {
 int SCI_METHOD Document::AddData(const char *data, Sci_Position length) {
 	try {
 		const Sci::Position position = Length();
-		InsertString(position, data, length);
+		if (position == 0) {
+			// Find line ends for the whole document after loading
+			cb.DeferLineEnds();
+		}
+		// Mapped documents refer to the loaded data, which the container keeps valid, instead of copying it
+		InsertString(position, data, length, cb.Storage() == TextStorage::mapped);
 	} catch (std::bad_alloc &) {
 		return static_cast<int>(Status::BadAlloc);
 	} catch (...) {
@@ -1411,6 +1446,11 @@ IDocumentEditable *Document::AsDocumentEditable() noexcept {
 }
 
 void *SCI_METHOD Document::ConvertToDocument() {
+	try {
+		cb.ResolveLineEnds();
+	} catch (...) {
+		return nullptr;
+	}
 	return AsDocumentEditable();
 }
 
@@ -1757,6 +1797,11 @@ void Document::ConvertLineEnds(EndOfLine eolModeSet) {
 	UndoGroup ug(this);
 
 	for (Sci::Position pos = 0; pos < Length(); pos++) {
+		// Skip quickly to next CR or LF. View is recreated as modifications invalidate it.
+		pos = cb.AllView().FindLineEndByte(pos, Length() - pos, false);
+		if (pos < 0) {
+			break;
+		}
 		const char ch = cb.CharAt(pos);
 		if (ch == '\r') {
 			if (cb.CharAt(pos + 1) == '\n') {
@@ -1798,6 +1843,9 @@ std::string_view Document::EOLString() const noexcept {
 
 DocumentOption Document::Options() const noexcept {
 	return (IsLarge() ? DocumentOption::TextLarge : DocumentOption::Default) |
+		(cb.Storage() == TextStorage::rope ? DocumentOption::TextRope : DocumentOption::Default) |
+		(cb.Storage() == TextStorage::mapped ? DocumentOption::TextMapped : DocumentOption::Default) |
+		(cb.IsLinesTree() ? DocumentOption::LinesTree : DocumentOption::Default) |
 		(cb.HasStyles() ? DocumentOption::Default : DocumentOption::StylesNone);
 }
 
@@ -2109,28 +2157,10 @@ CharacterExtracted Document::ExtractCharacter(Sci::Position position) const noex
 
 namespace {
 
-// Equivalent of memchr over the split view
-ptrdiff_t SplitFindChar(const SplitView &view, size_t start, size_t length, int ch) noexcept {
-	size_t range1Length = 0;
-	if (start < view.length1) {
-		range1Length = std::min(length, view.length1 - start);
-		const char *match = static_cast<const char *>(memchr(view.segment1 + start, ch, range1Length));
-		if (match) {
-			return match - view.segment1;
-		}
-		start += range1Length;
-	}
-	const char *match2 = static_cast<const char *>(memchr(view.segment2 + start, ch, length - range1Length));
-	if (match2) {
-		return match2 - view.segment2;
-	}
-	return -1;
-}
-
-// Equivalent of memcmp over the split view
+// Equivalent of memcmp over the segmented view
 // This does not call memcmp as search texts are commonly too short to overcome the
 // call overhead.
-bool SplitMatch(const SplitView &view, size_t start, std::string_view text) noexcept {
+bool SegmentMatch(SegmentedView &view, Sci::Position start, std::string_view text) noexcept {
 	for (size_t i = 0; i < text.length(); i++) {
 		if (view.CharAt(i + start) != text[i]) {
 			return false;
@@ -2139,6 +2169,205 @@ bool SplitMatch(const SplitView &view, size_t start, std::string_view text) noex
 	return true;
 }
 
+#if defined(SCI_SEARCH_SSE2)
+
+int FirstSetBit(unsigned int mask) noexcept {
+#if defined(_MSC_VER)
+	unsigned long index = 0;
+	_BitScanForward(&index, mask);
+	return static_cast<int>(index);
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+#endif
+
+// Is text made only of ASCII without upper case letters so it can be the folded pattern of FastSearch
+bool IsFoldedASCII(std::string_view text) noexcept {
+	return std::all_of(text.begin(), text.end(), [](char ch) noexcept {
+		return UTF8IsAscii(ch) && !IsUpperCase(ch);
+	});
+}
+
+// Position of the first byte from position to end that is not ASCII, or end when there is none
+Sci::Position FindNonASCII(const char *origin, Sci::Position position, Sci::Position end) noexcept {
+#if defined(SCI_SEARCH_SSE2)
+	// High bits of 16 bytes at a time
+	while ((end - position) >= 16) {
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(origin + position));
+		const unsigned int mask = _mm_movemask_epi8(chunk);
+		if (mask) {
+			return position + FirstSetBit(mask);
+		}
+		position += 16;
+	}
+#endif
+	while ((position < end) && UTF8IsAscii(origin[position])) {
+		position++;
+	}
+	return position;
+}
+
+/**
+ * A search string prepared for finding in contiguous text.
+ * Bytes match exactly or, when folding, ASCII letters match either case so the pattern
+ * must be lower case.
+ * Short patterns check 16 candidates at once by their first and last bytes with SSE2 and
+ * other patterns skip through the text with a Boyer-Moore-Horspool table.
+ */
+class FastSearch {
+	std::string_view pattern;
+	bool foldASCII;
+	std::array<size_t, 256> shifts {};
+	static constexpr size_t filterMaximum = 32;
+	bool ByteMatches(char ch, size_t index) const noexcept {
+		return (foldASCII ? MakeLowerCase(ch) : ch) == pattern[index];
+	}
+	bool Matches(const char *s, size_t first, size_t last) const noexcept {
+		for (size_t i = first; i < last; i++) {
+			if (!ByteMatches(s[i], i)) {
+				return false;
+			}
+		}
+		return true;
+	}
+	bool UseFilter() const noexcept {
+#if defined(SCI_SEARCH_SSE2)
+		return pattern.length() < filterMaximum;
+#else
+		return false;
+#endif
+	}
+public:
+	FastSearch(std::string_view pattern_, bool foldASCII_) noexcept : pattern(pattern_), foldASCII(foldASCII_) {
+		if (!UseFilter()) {
+			const size_t m = pattern.length();
+			shifts.fill(m);
+			// Indexed by text bytes so both cases of folded letters are entered
+			for (size_t i = 0; i + 1 < m; i++) {
+				const unsigned char ch = pattern[i];
+				shifts[ch] = m - 1 - i;
+				if (foldASCII && IsLowerCase(ch)) {
+					shifts[MakeUpperCase(ch)] = m - 1 - i;
+				}
+			}
+		}
+	}
+	size_t Length() const noexcept {
+		return pattern.length();
+	}
+	bool FoldASCII() const noexcept {
+		return foldASCII;
+	}
+	// Find the first match starting from first to before last, returning last when there is no match.
+	// The text must be readable up to last + Length() - 1.
+	const char *Find(const char *first, const char *last) const noexcept {
+		const size_t m = pattern.length();
+		const char *s = first;
+#if defined(SCI_SEARCH_SSE2)
+		if (UseFilter()) {
+			// Setting bit 5 makes ASCII letters lower case
+			const unsigned char chFirst = pattern.front();
+			const unsigned char chLast = pattern.back();
+			const __m128i foldFirst = _mm_set1_epi8((foldASCII && IsLowerCase(chFirst)) ? 0x20 : 0);
+			const __m128i foldLast = _mm_set1_epi8((foldASCII && IsLowerCase(chLast)) ? 0x20 : 0);
+			const __m128i firsts = _mm_set1_epi8(static_cast<char>(chFirst));
+			const __m128i lasts = _mm_set1_epi8(static_cast<char>(chLast));
+			while ((last - s) >= 16) {
+				const __m128i startChunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+				const __m128i endChunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + m - 1));
+				const __m128i candidates = _mm_and_si128(
+					_mm_cmpeq_epi8(_mm_or_si128(startChunk, foldFirst), firsts),
+					_mm_cmpeq_epi8(_mm_or_si128(endChunk, foldLast), lasts));
+				unsigned int mask = _mm_movemask_epi8(candidates);
+				while (mask) {
+					const char *candidate = s + FirstSetBit(mask);
+					if (Matches(candidate, 1, m - 1)) {
+						return candidate;
+					}
+					mask &= mask - 1;
+				}
+				s += 16;
+			}
+			for (; s < last; s++) {
+				if (Matches(s, 0, m)) {
+					return s;
+				}
+			}
+			return last;
+		}
+#endif
+		while (s < last) {
+			const unsigned char chLast = s[m - 1];
+			if (ByteMatches(chLast, m - 1) && Matches(s, 0, m - 1)) {
+				return s;
+			}
+			s += shifts[chLast];
+		}
+		return last;
+	}
+};
+
+// Limits scans for non-ASCII bytes so that finding many matches does not scan a large segment for each
+constexpr Sci::Position asciiScanBlock = 0x1000;
+
+/**
+ * Search forward from position through the segments of view with fastSearch.
+ * Candidate positions before endCertain whose text is contiguous and, when folding, ASCII
+ * are matches of fastSearch.Length() when fastSearch finds them, so are reported as exact.
+ * Positions where the text crosses a segment boundary or includes a non-ASCII byte along with
+ * positions from endCertain to endAll are reported as not exact for found to check.
+ * @return the first position where found returns true or -1.
+ */
+template <typename Found>
+Sci::Position SearchSegments(SegmentedView &view, const FastSearch &fastSearch, Sci::Position position,
+	Sci::Position endCertain, Sci::Position endAll, Found found) {
+	const Sci::Position m = fastSearch.Length();
+	while (position < endAll) {
+		Sci::Position segmentStart = 0;
+		Sci::Position segmentEnd = 0;
+		const char *origin = view.Segment(position, segmentStart, segmentEnd);
+		if (!origin) {
+			break;
+		}
+		// Positions from position to endFast can be checked by fastSearch
+		Sci::Position endFast = std::min(endCertain, segmentEnd - m + 1);
+		// Positions from endFast to endChecked are checked by found
+		Sci::Position endChecked = segmentEnd;
+		if (fastSearch.FoldASCII()) {
+			const Sci::Position endScan = std::min(segmentEnd, position + std::max(asciiScanBlock, m * 2));
+			const Sci::Position nonASCII = FindNonASCII(origin, position, endScan);
+			if (nonASCII < endScan) {
+				endFast = std::min(endFast, nonASCII - m + 1);
+				endChecked = nonASCII + 1;
+			} else if (endScan < segmentEnd) {
+				endChecked = endScan - m + 1;
+				endFast = std::min(endFast, endChecked);
+			}
+		}
+		endChecked = std::min(endChecked, endAll);
+		if (position < endFast) {
+			const char *match = fastSearch.Find(origin + position, origin + endFast);
+			if (match < origin + endFast) {
+				position = match - origin;
+				if (found(position, true)) {
+					return position;
+				}
+				position++;
+				continue;
+			}
+			position = endFast;
+		}
+		for (; position < endChecked; position++) {
+			if (found(position, false)) {
+				return position;
+			}
+		}
+	}
+	return -1;
+}
+
 }
 
 /**
@@ -2177,31 +2406,27 @@ Sci::Position Document::FindText(Sci::Position minPos, Sci::Position maxPos, con
 			// Back all of a character
 			pos = NextPosition(pos, increment);
 		}
-		const SplitView cbView = cb.AllView();
+		SegmentedView cbView = cb.AllView();
 		if (caseSensitive) {
 			const Sci::Position endSearch = (startPos <= endPos) ? endPos - lengthFind + 1 : endPos;
 			const unsigned char charStartSearch =  search[0];
 			if (forward && ((0 == dbcsCodePage) || (CpUtf8 == dbcsCodePage && !UTF8IsTrailByte(charStartSearch)))) {
 				// This is a fast case where there is no need to test byte values to iterate
-				// so becomes the equivalent of a memchr+memcmp loop.
+				// so searches memory directly.
 				// UTF-8 search will not be self-synchronizing when starts with trail byte
-				const std::string_view suffix(search + 1, lengthFind - 1);
-				while (pos < endSearch) {
-					pos = SplitFindChar(cbView, pos, limitPos - pos, charStartSearch);
-					if (pos < 0) {
-						break;
-					}
-					if (SplitMatch(cbView, pos + 1, suffix) && MatchesWordOptions(word, wordStart, pos, lengthFind)) {
-						return pos;
-					}
-					pos++;
-				}
+				const std::string_view pattern(search, lengthFind);
+				const FastSearch fastSearch(pattern, false);
+				return SearchSegments(cbView, fastSearch, pos, endSearch, endSearch,
+					[&](Sci::Position position, bool exact) {
+					return (exact || SegmentMatch(cbView, position, pattern)) &&
+						MatchesWordOptions(word, wordStart, position, lengthFind);
+				});
 			} else {
 				while (forward ? (pos < endSearch) : (pos >= endSearch)) {
 					const unsigned char leadByte = cbView.CharAt(pos);
 					if (leadByte == charStartSearch) {
 						bool found = (pos + lengthFind) <= limitPos;
-						// SplitMatch could be called here but it is slower with g++ -O2
+						// SegmentMatch could be called here but it is slower with g++ -O2
 						for (int indexSearch = 1; (indexSearch < lengthFind) && found; indexSearch++) {
 							found = cbView.CharAt(pos + indexSearch) == search[indexSearch];
 						}
@@ -2227,9 +2452,9 @@ Sci::Position Document::FindText(Sci::Position minPos, Sci::Position maxPos, con
 			std::vector<char> searchThing((lengthFind+1) * UTF8MaxBytes * maxFoldingExpansion + 1);
 			const size_t lenSearch =
 				pcf->Fold(&searchThing[0], searchThing.size(), search, lengthFind);
-			while (forward ? (pos < endPos) : (pos >= endPos)) {
-				int widthFirstCharacter = 1;
-				Sci::Position posIndexDocument = pos;
+			// Length of the match at pos or -1 with the width of the character at pos
+			auto matchAt = [&](Sci::Position start, int &widthFirstCharacter) -> Sci::Position {
+				Sci::Position posIndexDocument = start;
 				size_t indexSearch = 0;
 				bool characterMatches = true;
 				while (indexSearch < lenSearch) {
@@ -2268,10 +2493,43 @@ Sci::Position Document::FindText(Sci::Position minPos, Sci::Position maxPos, con
 					indexSearch += lenFlat;
 				}
 				if (characterMatches && (indexSearch == lenSearch)) {
-					if (MatchesWordOptions(word, wordStart, pos, posIndexDocument - pos)) {
-						*length = posIndexDocument - pos;
-						return pos;
+					return posIndexDocument - start;
+				}
+				return -1;
+			};
+			const std::string_view folded(searchThing.data(), lenSearch);
+			if (forward && IsFoldedASCII(folded)) {
+				// Runs of ASCII text are searched directly and matching them needs no folding.
+				// Positions near other characters use the complete matching.
+				const FastSearch fastSearch(folded, true);
+				Sci::Position lengthMatch = lenSearch;
+				const Sci::Position posMatch = SearchSegments(cbView, fastSearch, pos, limitPos - lenSearch + 1, endPos,
+					[&](Sci::Position position, bool exact) {
+					if (exact) {
+						lengthMatch = lenSearch;
+					} else {
+						if (UTF8IsTrailByte(cbView.CharAt(position))) {
+							return false;
+						}
+						int widthFirstCharacter = 1;
+						lengthMatch = matchAt(position, widthFirstCharacter);
+						if (lengthMatch < 0) {
+							return false;
+						}
 					}
+					return MatchesWordOptions(word, wordStart, position, lengthMatch);
+				});
+				if (posMatch >= 0) {
+					*length = lengthMatch;
+				}
+				return posMatch;
+			}
+			while (forward ? (pos < endPos) : (pos >= endPos)) {
+				int widthFirstCharacter = 1;
+				const Sci::Position lengthMatch = matchAt(pos, widthFirstCharacter);
+				if ((lengthMatch >= 0) && MatchesWordOptions(word, wordStart, pos, lengthMatch)) {
+					*length = lengthMatch;
+					return pos;
 				}
 				if (forward) {
 					pos += widthFirstCharacter;
@@ -2340,10 +2598,10 @@ Sci::Position Document::FindText(Sci::Position minPos, Sci::Position maxPos, con
 			const Sci::Position endSearch = (startPos <= endPos) ? endPos - lengthFind + 1 : endPos;
 			std::vector<char> searchThing(lengthFind + 1);
 			pcf->Fold(&searchThing[0], searchThing.size(), search, lengthFind);
-			while (forward ? (pos < endSearch) : (pos >= endSearch)) {
-				bool found = (pos + lengthFind) <= limitPos;
+			auto matchAt = [&](Sci::Position start) -> bool {
+				bool found = (start + lengthFind) <= limitPos;
 				for (int indexSearch = 0; (indexSearch < lengthFind) && found; indexSearch++) {
-					const char ch = cbView.CharAt(pos + indexSearch);
+					const char ch = cbView.CharAt(start + indexSearch);
 					const char chTest = searchThing[indexSearch];
 					if (UTF8IsAscii(ch)) {
 						found = chTest == MakeLowerCase(ch);
@@ -2353,7 +2611,20 @@ Sci::Position Document::FindText(Sci::Position minPos, Sci::Position maxPos, con
 						found = folded[0] == chTest;
 					}
 				}
-				if (found && MatchesWordOptions(word, wordStart, pos, lengthFind)) {
+				return found;
+			};
+			const std::string_view folded(searchThing.data(), lengthFind);
+			if (forward && IsFoldedASCII(folded)) {
+				// Runs of ASCII text are searched directly and other bytes use the fold table
+				const FastSearch fastSearch(folded, true);
+				return SearchSegments(cbView, fastSearch, pos, endSearch, endSearch,
+					[&](Sci::Position position, bool exact) {
+					return (exact || matchAt(position)) &&
+						MatchesWordOptions(word, wordStart, position, lengthFind);
+				});
+			}
+			while (forward ? (pos < endSearch) : (pos >= endSearch)) {
+				if (matchAt(pos) && MatchesWordOptions(word, wordStart, pos, lengthFind)) {
 					return pos;
 				}
 				pos += increment;
@@ -2364,6 +2635,231 @@ Sci::Position Document::FindText(Sci::Position minPos, Sci::Position maxPos, con
 	return -1;
 }
 
+/**
+ * Find every match of search from minPos to maxPos, appending them to matches in document order.
+ * Matches do not overlap as each search starts at the end of the previous match.
+ */
+void Document::FindAll(Sci::Position minPos, Sci::Position maxPos, const char *search, FindOption flags,
+	Sci::Position length, std::vector<Range> &matches) {
+	if (length <= 0)
+		return;
+	const Sci::Position startPos = std::min(minPos, maxPos);
+	const Sci::Position endPos = std::max(minPos, maxPos);
+	if (FlagSet(flags, FindOption::RegExp)) {
+		if (!regex)
+			regex = std::unique_ptr<RegexSearchBase>(CreateRegexSearch(&charClass));
+		regex->FindAll(this, startPos, endPos, search, FlagSet(flags, FindOption::MatchCase),
+			FlagSet(flags, FindOption::WholeWord), FlagSet(flags, FindOption::WordStart), flags, length, matches);
+		return;
+	}
+	Sci::Position pos = startPos;
+	while (pos < endPos) {
+		Sci::Position lengthFound = length;
+		const Sci::Position found = FindText(pos, endPos, search, flags, &lengthFound);
+		if (found < 0)
+			break;
+		matches.emplace_back(found, found + lengthFound);
+		pos = found + lengthFound;
+	}
+}
+
+namespace {
+
+// Parallel searches divide their range into chunks with sizes between these limits.
+// Several chunks for each thread balance the work and allow finding the first match to
+// stop soon after it is found.
+constexpr Sci::Position searchChunkMinimum = 0x40000;
+constexpr Sci::Position searchChunkMaximum = 0x1000000;
+constexpr size_t searchChunksPerThread = 4;
+
+// Positions dividing startPos..endPos into chunks, including both ends.
+// Regular expressions only match within a line so their chunks start at line starts,
+// otherwise chunks start at character boundaries.
+std::vector<Sci::Position> SearchChunks(const Document *doc, Sci::Position startPos, Sci::Position endPos,
+	size_t threads, bool lines) {
+	const Sci::Position chunkSize = std::clamp<Sci::Position>(
+		(endPos - startPos) / static_cast<Sci::Position>(threads * searchChunksPerThread),
+		searchChunkMinimum, searchChunkMaximum);
+	std::vector<Sci::Position> boundaries { startPos };
+	for (Sci::Position pos = startPos + chunkSize; pos < endPos; pos += chunkSize) {
+		const Sci::Position boundary = lines ?
+			doc->LineStart(doc->SciLineFromPosition(pos) + 1) :
+			doc->MovePositionOutsideChar(pos, 1, false);
+		if ((boundary > boundaries.back()) && (boundary < endPos)) {
+			boundaries.push_back(boundary);
+		}
+	}
+	boundaries.push_back(endPos);
+	return boundaries;
+}
+
+// Each chunk is searched past its end so that matches starting inside it are found whole.
+// The overlap is the longest text that could match less one byte or, for regular expressions,
+// up to the end of the line before the next chunk.
+Sci::Position ChunkSearchEnd(const Document *doc, const std::vector<Sci::Position> &boundaries, size_t chunk,
+	Sci::Position overlap, bool lines) {
+	const Sci::Position chunkEnd = boundaries[chunk + 1];
+	if (chunk + 2 == boundaries.size()) {
+		return chunkEnd;
+	}
+	if (lines) {
+		return std::max(boundaries[chunk], doc->LineEnd(doc->SciLineFromPosition(chunkEnd) - 1));
+	}
+	return std::min(chunkEnd + overlap, boundaries.back());
+}
+
+// Case folders for DBCS code pages are provided by platform layers and may hold scratch
+// storage so those searches are not divided between threads.
+bool CanSearchInParallel(const Document *doc, FindOption flags) noexcept {
+	return FlagSet(flags, FindOption::MatchCase) || FlagSet(flags, FindOption::RegExp) ||
+		(doc->dbcsCodePage == 0) || (doc->dbcsCodePage == CpUtf8);
+}
+
+Sci::Position SearchOverlap(const Document *doc, FindOption flags, Sci::Position lengthFind) noexcept {
+	if (FlagSet(flags, FindOption::MatchCase) || !doc->dbcsCodePage) {
+		return lengthFind - 1;
+	}
+	// Case folding may match more bytes of the document than are in the search string
+	constexpr Sci::Position maxFoldingExpansion = 4;
+	return lengthFind * UTF8MaxBytes * maxFoldingExpansion;
+}
+
+}
+
+/**
+ * Find the first match like FindText but divide a long forward search into chunks
+ * searched by up to threads participants from pool. Backward and short searches, and
+ * those that can not be divided, are performed by FindText on this thread.
+ */
+Sci::Position Document::FindTextParallel(ThreadPool &pool, size_t threads, Sci::Position minPos, Sci::Position maxPos,
+	const char *search, FindOption flags, Sci::Position *length) {
+	if ((threads <= 1) || (*length <= 0) || (minPos > maxPos) || (maxPos - minPos < searchChunkMinimum * 2) ||
+		!CanSearchInParallel(this, flags)) {
+		return FindText(minPos, maxPos, search, flags, length);
+	}
+	const bool caseSensitive = FlagSet(flags, FindOption::MatchCase);
+	const bool word = FlagSet(flags, FindOption::WholeWord);
+	const bool wordStart = FlagSet(flags, FindOption::WordStart);
+	const bool regExp = FlagSet(flags, FindOption::RegExp);
+	const Sci::Position startPos = MovePositionOutsideChar(minPos, 1, false);
+	const Sci::Position endPos = MovePositionOutsideChar(maxPos, 1, false);
+	const std::vector<Sci::Position> boundaries = SearchChunks(this, startPos, endPos, threads, regExp);
+	const size_t chunks = boundaries.size() - 1;
+	const Sci::Position overlap = SearchOverlap(this, flags, *length);
+
+	// Each participant needs its own regular expression as it holds the state of a search
+	std::vector<std::unique_ptr<RegexSearchBase>> regexes(threads);
+	std::vector<Range> found(chunks);
+	std::atomic<size_t> nextChunk = 0;
+	std::atomic<size_t> chunkFound = chunks;
+	pool.Run(threads, [&](size_t participant) {
+		// Chunks after one with a match need not be searched
+		for (size_t chunk = nextChunk.fetch_add(1); chunk < chunkFound.load(); chunk = nextChunk.fetch_add(1)) {
+			const Sci::Position searchEnd = ChunkSearchEnd(this, boundaries, chunk, overlap, regExp);
+			Sci::Position lengthFound = *length;
+			Sci::Position pos = -1;
+			if (regExp) {
+				if (!regexes[participant]) {
+					regexes[participant].reset(CreateRegexSearch(&charClass));
+				}
+				pos = regexes[participant]->FindText(this, boundaries[chunk], searchEnd, search,
+					caseSensitive, word, wordStart, flags, &lengthFound);
+			} else {
+				pos = FindText(boundaries[chunk], searchEnd, search, flags, &lengthFound);
+			}
+			if ((pos >= 0) && (pos < boundaries[chunk + 1])) {
+				found[chunk] = Range(pos, pos + lengthFound);
+				size_t current = chunkFound.load();
+				while ((chunk < current) && !chunkFound.compare_exchange_weak(current, chunk)) {
+				}
+			}
+		}
+	});
+
+	const size_t chunk = chunkFound.load();
+	if (chunk >= chunks) {
+		return -1;
+	}
+	if (regExp) {
+		// Search the line of the match again with the document's expression so that
+		// its tagged sections are available for substitution.
+		const Sci::Position lineStart = std::max(boundaries[chunk], LineStart(SciLineFromPosition(found[chunk].start)));
+		return FindText(lineStart, ChunkSearchEnd(this, boundaries, chunk, overlap, regExp), search, flags, length);
+	}
+	*length = found[chunk].Length();
+	return found[chunk].start;
+}
+
+/**
+ * Find every match like FindAll but divide a long search into chunks searched by up to
+ * threads participants from pool. Matches that continue into the next chunk may hide or
+ * overlap matches found by that chunk so its matches are corrected by searching again from
+ * the end of the last match until agreeing with that chunk.
+ */
+void Document::FindAllParallel(ThreadPool &pool, size_t threads, Sci::Position minPos, Sci::Position maxPos,
+	const char *search, FindOption flags, Sci::Position length, std::vector<Range> &matches) {
+	const Sci::Position startPos = MovePositionOutsideChar(std::min(minPos, maxPos), 1, false);
+	const Sci::Position endPos = MovePositionOutsideChar(std::max(minPos, maxPos), 1, false);
+	if ((threads <= 1) || (length <= 0) || (endPos - startPos < searchChunkMinimum * 2) ||
+		!CanSearchInParallel(this, flags)) {
+		FindAll(minPos, maxPos, search, flags, length, matches);
+		return;
+	}
+	const bool caseSensitive = FlagSet(flags, FindOption::MatchCase);
+	const bool word = FlagSet(flags, FindOption::WholeWord);
+	const bool wordStart = FlagSet(flags, FindOption::WordStart);
+	const bool regExp = FlagSet(flags, FindOption::RegExp);
+	const std::vector<Sci::Position> boundaries = SearchChunks(this, startPos, endPos, threads, regExp);
+	const size_t chunks = boundaries.size() - 1;
+	const Sci::Position overlap = SearchOverlap(this, flags, length);
+
+	std::vector<std::unique_ptr<RegexSearchBase>> regexes(threads);
+	std::vector<std::vector<Range>> found(chunks);
+	std::atomic<size_t> nextChunk = 0;
+	pool.Run(threads, [&](size_t participant) {
+		for (size_t chunk = nextChunk.fetch_add(1); chunk < chunks; chunk = nextChunk.fetch_add(1)) {
+			const Sci::Position searchEnd = ChunkSearchEnd(this, boundaries, chunk, overlap, regExp);
+			std::vector<Range> &chunkMatches = found[chunk];
+			if (regExp) {
+				if (!regexes[participant]) {
+					regexes[participant].reset(CreateRegexSearch(&charClass));
+				}
+				regexes[participant]->FindAll(this, boundaries[chunk], searchEnd, search,
+					caseSensitive, word, wordStart, flags, length, chunkMatches);
+			} else {
+				FindAll(boundaries[chunk], searchEnd, search, flags, length, chunkMatches);
+				// Matches starting in the overlap belong to the next chunk
+				while (!chunkMatches.empty() && (chunkMatches.back().start >= boundaries[chunk + 1])) {
+					chunkMatches.pop_back();
+				}
+			}
+		}
+	});
+
+	for (size_t chunk = 0; chunk < chunks; chunk++) {
+		const std::vector<Range> &chunkMatches = found[chunk];
+		std::vector<Range>::const_iterator it = chunkMatches.begin();
+		while (!matches.empty() && (matches.back().end > boundaries[chunk])) {
+			const Sci::Position resume = matches.back().end;
+			while ((it != chunkMatches.end()) && (it->start < resume)) {
+				++it;
+			}
+			Sci::Position lengthFound = length;
+			const Sci::Position pos = FindText(resume, ChunkSearchEnd(this, boundaries, chunk, overlap, regExp),
+				search, flags, &lengthFound);
+			if ((pos < 0) || (pos >= boundaries[chunk + 1])) {
+				it = chunkMatches.end();
+				break;
+			}
+			if ((it != chunkMatches.end()) && (pos == it->start)) {
+				break;
+			}
+			matches.emplace_back(pos, pos + lengthFound);
+		}
+		matches.insert(matches.end(), it, chunkMatches.end());
+	}
+}
+
 const char *Document::SubstituteByPosition(const char *text, Sci::Position *length) {
 	if (regex)
 		return regex->SubstituteByPosition(this, text, length);
@@ -2649,6 +3145,25 @@ void SCI_METHOD Document::DecorationFillRange(Sci_Position position, int value,
 	}
 }
 
+// Fill many ranges with an indicator value, notifying once for the extent of the changes.
+void Document::DecorationFillRanges(const std::vector<Range> &ranges, int value) {
+	Sci::Position changeStart = Length();
+	Sci::Position changeEnd = 0;
+	for (const Range &range : ranges) {
+		const FillResult<Sci::Position> fr = decorations->FillRange(
+			range.start, value, range.Length());
+		if (fr.changed) {
+			changeStart = std::min(changeStart, fr.position);
+			changeEnd = std::max(changeEnd, fr.position + fr.fillLength);
+		}
+	}
+	if (changeStart < changeEnd) {
+		const DocModification mh(ModificationFlags::ChangeIndicator | ModificationFlags::User,
+							changeStart, changeEnd - changeStart);
+		NotifyModified(mh);
+	}
+}
+
 bool Document::AddWatcher(DocWatcher *watcher, void *userData) {
 	const WatcherWithUserData wwud(watcher, userData);
 	std::vector<WatcherWithUserData>::iterator it =
@@ -2862,19 +3377,92 @@ Sci::Position Document::BraceMatch(Sci::Position position, Sci::Position /*maxRe
 /**
  * Implementation of RegexSearchBase for the default built-in regular expression engine
  */
+void RegexSearchBase::FindAll(Document *doc, Sci::Position minPos, Sci::Position maxPos, const char *s,
+                        bool caseSensitive, bool word, bool wordStart, FindOption flags, Sci::Position length,
+                        std::vector<Range> &matches) {
+	Sci::Position pos = minPos;
+	while (pos <= maxPos) {
+		Sci::Position lengthFound = length;
+		const Sci::Position found = FindText(doc, pos, maxPos, s, caseSensitive, word, wordStart, flags, &lengthFound);
+		if (found < 0)
+			break;
+		matches.emplace_back(found, found + lengthFound);
+		pos = found + lengthFound;
+		if (lengthFound == 0) {
+			// Empty match so continue from the next character
+			if (pos >= maxPos)
+				break;
+			pos = doc->NextPosition(pos, 1);
+		}
+	}
+}
+
+namespace {
+
+/**
+ * Holds the most recently used compiled patterns so repeated searches with the same
+ * pattern and options do not compile it again.
+ * The key combines the options and the pattern text.
+ */
+template <typename Compiled>
+class PatternCache {
+	struct Entry {
+		std::string key;
+		Compiled compiled;
+	};
+	// Most recently used first
+	std::vector<Entry> entries;
+public:
+	static constexpr size_t capacity = 8;
+	Compiled *Find(std::string_view key) {
+		const auto it = std::find_if(entries.begin(), entries.end(), [key](const Entry &entry) noexcept {
+			return entry.key == key;
+		});
+		if (it == entries.end()) {
+			return nullptr;
+		}
+		std::rotate(entries.begin(), it, it + 1);
+		return &entries.front().compiled;
+	}
+	Compiled &Add(std::string_view key, Compiled &&compiled) {
+		if (entries.size() >= capacity) {
+			entries.pop_back();
+		}
+		entries.insert(entries.begin(), Entry{ std::string(key), std::move(compiled) });
+		return entries.front().compiled;
+	}
+};
+
+}
+
 class BuiltinRegex : public RegexSearchBase {
 public:
-	explicit BuiltinRegex(CharClassify *charClassTable) : search(charClassTable) {}
+	explicit BuiltinRegex(CharClassify *charClassTable) : charClass(charClassTable), search(charClassTable) {}
 
 	Sci::Position FindText(Document *doc, Sci::Position minPos, Sci::Position maxPos, const char *s,
                         bool caseSensitive, bool word, bool wordStart, FindOption flags,
                         Sci::Position *length) override;
 
+	void FindAll(Document *doc, Sci::Position minPos, Sci::Position maxPos, const char *s,
+                        bool caseSensitive, bool word, bool wordStart, FindOption flags, Sci::Position length,
+                        std::vector<Range> &matches) override;
+
 	const char *SubstituteByPosition(Document *doc, const char *text, Sci::Position *length) override;
 
 private:
+	CharClassify *charClass;
 	RESearch search;
 	std::string substituted;
+	PatternCache<RESearch> searchCache;
+#ifndef NO_CXX11_REGEX
+	PatternCache<std::regex> regexCache;
+	PatternCache<std::wregex> wregexCache;
+#endif
+	// Created when first used by a search with FindOption::LinearRegEx
+	std::unique_ptr<LinearRegex> linear;
+	bool lastLinear = false;
+	LinearRegex &Linear();
+	const char *Compile(const char *s, Sci::Position length, bool caseSensitive, bool posix);
 };
 
 namespace {
@@ -3216,33 +3804,73 @@ bool MatchOnLines(const Document *doc, const Regex &regexp, const RESearchRange
 	return matched;
 }
 
+template<typename Iterator, typename Regex>
+void FindAllOnLines(const Document *doc, const Regex &regexp, const RESearchRange &resr, std::vector<Range> &matches) {
+	for (Sci::Line line = resr.lineRangeStart; line != resr.lineRangeBreak; line += resr.increment) {
+		const Sci::Position lineStartPos = doc->LineStart(line);
+		const Sci::Position lineEndPos = doc->LineEnd(line);
+		const Range lineRange = resr.LineRange(line, lineStartPos, lineEndPos);
+		Iterator itStart(doc, lineRange.start);
+		Iterator itEnd(doc, lineRange.end);
+		const std::regex_constants::match_flag_type flagsMatch = MatchFlags(doc, lineRange.start, lineRange.end, lineStartPos, lineEndPos);
+		std::regex_iterator<Iterator> it(itStart, itEnd, regexp, flagsMatch);
+		for (const std::regex_iterator<Iterator> last; it != last; ++it) {
+			matches.emplace_back((*it)[0].first.Pos(), (*it)[0].second.PosRoundUp());
+		}
+	}
+}
+
+std::regex::flag_type Cxx11RegexFlags(bool caseSensitive) noexcept {
+	std::regex::flag_type flagsRe = std::regex::ECMAScript;
+	// Flags that appear to have no effect:
+	// | std::regex::collate | std::regex::extended;
+	if (!caseSensitive)
+		flagsRe = flagsRe | std::regex::icase;
+
+#if defined(REGEX_MULTILINE) && !defined(_MSC_VER)
+	flagsRe = flagsRe | std::regex::multiline;
+#endif
+	return flagsRe;
+}
+
+void AssignPattern(std::regex &regexp, const char *s, std::regex::flag_type flagsRe) {
+	regexp.assign(s, flagsRe);
+}
+
+void AssignPattern(std::wregex &regexp, const char *s, std::regex::flag_type flagsRe) {
+	regexp.assign(WStringFromUTF8(s), flagsRe);
+}
+
+// Find the expression for s in cache or compile it and add it to cache.
+// Compilation failures throw std::regex_error and are not cached.
+template <typename Regex>
+const Regex &CompiledRegex(PatternCache<Regex> &cache, const char *s, bool caseSensitive) {
+	std::string key(1, caseSensitive ? 'c' : 'i');
+	key.append(s);
+	if (const Regex *cached = cache.Find(key)) {
+		return *cached;
+	}
+	Regex regexp;
+	AssignPattern(regexp, s, Cxx11RegexFlags(caseSensitive));
+	return cache.Add(key, std::move(regexp));
+}
+
 Sci::Position Cxx11RegexFindText(const Document *doc, Sci::Position minPos, Sci::Position maxPos, const char *s,
-	bool caseSensitive, Sci::Position *length, RESearch &search) {
+	bool caseSensitive, Sci::Position *length, RESearch &search,
+	PatternCache<std::regex> &regexCache, PatternCache<std::wregex> &wregexCache) {
 	const RESearchRange resr(doc, minPos, maxPos);
 	try {
 		//ElapsedPeriod ep;
-		std::regex::flag_type flagsRe = std::regex::ECMAScript;
-		// Flags that appear to have no effect:
-		// | std::regex::collate | std::regex::extended;
-		if (!caseSensitive)
-			flagsRe = flagsRe | std::regex::icase;
-
-#if defined(REGEX_MULTILINE) && !defined(_MSC_VER)
-		flagsRe = flagsRe | std::regex::multiline;
-#endif
 
 		// Clear the RESearch so can fill in matches
 		search.Clear();
 
 		bool matched = false;
 		if (CpUtf8 == doc->dbcsCodePage) {
-			const std::wstring ws = WStringFromUTF8(s);
-			std::wregex regexp;
-			regexp.assign(ws, flagsRe);
+			const std::wregex &regexp = CompiledRegex(wregexCache, s, caseSensitive);
 			matched = MatchOnLines<UTF8Iterator>(doc, regexp, resr, search);
 		} else {
-			std::regex regexp;
-			regexp.assign(s, flagsRe);
+			const std::regex &regexp = CompiledRegex(regexCache, s, caseSensitive);
 			matched = MatchOnLines<ByteIterator>(doc, regexp, resr, search);
 		}
 
@@ -3266,18 +3894,74 @@ Sci::Position Cxx11RegexFindText(const Document *doc, Sci::Position minPos, Sci:
 	}
 }
 
+void Cxx11RegexFindAll(const Document *doc, Sci::Position minPos, Sci::Position maxPos, const char *s,
+	bool caseSensitive, std::vector<Range> &matches,
+	PatternCache<std::regex> &regexCache, PatternCache<std::wregex> &wregexCache) {
+	const RESearchRange resr(doc, minPos, maxPos);
+	try {
+		// The expression is compiled once for all lines
+		if (CpUtf8 == doc->dbcsCodePage) {
+			const std::wregex &regexp = CompiledRegex(wregexCache, s, caseSensitive);
+			FindAllOnLines<UTF8Iterator>(doc, regexp, resr, matches);
+		} else {
+			const std::regex &regexp = CompiledRegex(regexCache, s, caseSensitive);
+			FindAllOnLines<ByteIterator>(doc, regexp, resr, matches);
+		}
+	} catch (std::regex_error &) {
+		// Failed to create regular expression
+		throw RegexError();
+	} catch (...) {
+		// Failed in some other way so return matches found so far
+	}
+}
+
 #endif
 
 }
 
+/**
+ * Compile s into search, reusing the result of an earlier compilation with the same
+ * options and word characters when it is still cached.
+ */
+const char *BuiltinRegex::Compile(const char *s, Sci::Position length, bool caseSensitive, bool posix) {
+	if (!s || !length) {
+		// Reuses the previous expression
+		return search.Compile(s, length, caseSensitive, posix);
+	}
+	// \w and \W depend on the word characters so they are part of the key
+	constexpr int byteValues = 256;
+	std::string key(2 + byteValues, '\0');
+	key[0] = caseSensitive ? 'c' : 'i';
+	key[1] = posix ? 'p' : 'r';
+	for (int ch = 0; ch < byteValues; ch++) {
+		key[2 + ch] = charClass->IsWord(static_cast<unsigned char>(ch)) ? 'w' : '-';
+	}
+	key.append(s, length);
+	if (const RESearch *cached = searchCache.Find(key)) {
+		search = *cached;
+		return nullptr;
+	}
+	const char *errmsg = search.Compile(s, length, caseSensitive, posix);
+	if (!errmsg) {
+		RESearch compiled = search;
+		searchCache.Add(key, std::move(compiled));
+	}
+	return errmsg;
+}
+
 Sci::Position BuiltinRegex::FindText(Document *doc, Sci::Position minPos, Sci::Position maxPos, const char *s,
                         bool caseSensitive, bool, bool, FindOption flags,
                         Sci::Position *length) {
 
+	lastLinear = FlagSet(flags, FindOption::LinearRegEx);
+	if (lastLinear) {
+		return Linear().FindText(doc, minPos, maxPos, s, caseSensitive, false, false, flags, length);
+	}
+
 #ifndef NO_CXX11_REGEX
 	if (FlagSet(flags, FindOption::Cxx11RegEx)) {
 			return Cxx11RegexFindText(doc, minPos, maxPos, s,
-			caseSensitive, length, search);
+			caseSensitive, length, search, regexCache, wregexCache);
 	}
 #endif
 
@@ -3285,7 +3969,7 @@ Sci::Position BuiltinRegex::FindText(Document *doc, Sci::Position minPos, Sci::P
 
 	const bool posix = FlagSet(flags, FindOption::Posix);
 
-	const char *errmsg = search.Compile(s, *length, caseSensitive, posix);
+	const char *errmsg = Compile(s, *length, caseSensitive, posix);
 	if (errmsg) {
 		return -1;
 	}
@@ -3362,7 +4046,84 @@ Sci::Position BuiltinRegex::FindText(Document *doc, Sci::Position minPos, Sci::P
 	return pos;
 }
 
+void BuiltinRegex::FindAll(Document *doc, Sci::Position minPos, Sci::Position maxPos, const char *s,
+                        bool caseSensitive, bool, bool, FindOption flags, Sci::Position length,
+                        std::vector<Range> &matches) {
+
+	if (FlagSet(flags, FindOption::LinearRegEx)) {
+		Linear().FindAll(doc, minPos, maxPos, s, caseSensitive, false, false, flags, length, matches);
+		return;
+	}
+
+#ifndef NO_CXX11_REGEX
+	if (FlagSet(flags, FindOption::Cxx11RegEx)) {
+		Cxx11RegexFindAll(doc, minPos, maxPos, s, caseSensitive, matches, regexCache, wregexCache);
+		return;
+	}
+#endif
+
+	const RESearchRange resr(doc, minPos, maxPos);
+
+	const bool posix = FlagSet(flags, FindOption::Posix);
+
+	// Compiled once then executed repeatedly along each line
+	const char *errmsg = Compile(s, length, caseSensitive, posix);
+	if (errmsg) {
+		return;
+	}
+	const bool searchforLineStart = s[0] == '^';
+	const char searchEnd = s[length - 1];
+	const char searchEndPrev = (length > 1) ? s[length - 2] : '\0';
+	const bool searchforLineEnd = (searchEnd == '$') && (searchEndPrev != '\\');
+	for (Sci::Line line = resr.lineRangeStart; line != resr.lineRangeBreak; line += resr.increment) {
+		const Sci::Position lineStartPos = doc->LineStart(line);
+		const Sci::Position lineEndPos = doc->LineEnd(line);
+		Sci::Position startOfLine = lineStartPos;
+		Sci::Position endOfLine = lineEndPos;
+		if (line == resr.lineRangeStart) {
+			if ((resr.startPos != startOfLine) && searchforLineStart)
+				continue;	// Can't match start of line if start position after start of line
+			startOfLine = resr.startPos;
+		}
+		if (line == resr.lineRangeEnd) {
+			if ((resr.endPos != endOfLine) && searchforLineEnd)
+				continue;	// Can't match end of line if end position before end of line
+			endOfLine = resr.endPos;
+		}
+
+		const DocumentIndexer di(doc, endOfLine);
+		search.SetLineRange(lineStartPos, lineEndPos);
+		Sci::Position pos = startOfLine;
+		while ((pos <= endOfLine) && search.Execute(di, pos, endOfLine)) {
+			const Sci::Position matchStart = search.bopat[0];
+			const Sci::Position matchEnd = search.eopat[0];
+			matches.emplace_back(matchStart, matchEnd);
+			if (searchforLineStart) {
+				break;	// There can be only one start of a line
+			}
+			pos = matchEnd;
+			if (matchEnd == matchStart) {
+				// Empty match so continue from the next character
+				if (matchEnd >= endOfLine) {
+					break;
+				}
+				pos = doc->NextPosition(pos, 1);
+			}
+		}
+	}
+}
+
+LinearRegex &BuiltinRegex::Linear() {
+	if (!linear) {
+		linear = std::make_unique<LinearRegex>(charClass);
+	}
+	return *linear;
+}
+
 const char *BuiltinRegex::SubstituteByPosition(Document *doc, const char *text, Sci::Position *length) {
+	if (lastLinear) {
+		return Linear().SubstituteByPosition(doc, text, length);
+	}
 	substituted.clear();
 	for (Sci::Position j = 0; j < *length; j++) {
 		if (text[j] == '\\') {
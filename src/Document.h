@@ -17,6 +17,7 @@ class LineMarkers;
 class LineLevels;
 class LineState;
 class LineAnnotation;
+class ThreadPool;
 
 enum class EncodingFamily { eightBit, unicode, dbcs };
 
@@ -103,6 +104,12 @@ public:
 	virtual Sci::Position FindText(Document *doc, Sci::Position minPos, Sci::Position maxPos, const char *s,
                         bool caseSensitive, bool word, bool wordStart, Scintilla::FindOption flags, Sci::Position *length) = 0;
 
+	/// Append every match from minPos to maxPos to matches. Overridden to compile the
+	/// expression just once as the default calls FindText for each match.
+	virtual void FindAll(Document *doc, Sci::Position minPos, Sci::Position maxPos, const char *s,
+                        bool caseSensitive, bool word, bool wordStart, Scintilla::FindOption flags, Sci::Position length,
+                        std::vector<Range> &matches);
+
 	///@return String with the substitutions, must remain valid until the next call or destruction
 	virtual const char *SubstituteByPosition(Document *doc, const char *text, Sci::Position *length) = 0;
 };
@@ -380,7 +387,7 @@ public:
 	void CheckReadOnly();
 	void TrimReplacement(std::string_view &text, Range &range) const noexcept;
 	bool DeleteChars(Sci::Position pos, Sci::Position len);
-	Sci::Position InsertString(Sci::Position position, const char *s, Sci::Position insertLength);
+	Sci::Position InsertString(Sci::Position position, const char *s, Sci::Position insertLength, bool reference=false);
 	Sci::Position InsertString(Sci::Position position, std::string_view sv);
 	void ChangeInsertion(const char *s, Sci::Position length);
 	int SCI_METHOD AddData(const char *data, Sci_Position length) override;
@@ -446,6 +453,7 @@ public:
 	void SetReadOnly(bool set) noexcept { cb.SetReadOnly(set); }
 	bool IsReadOnly() const noexcept { return cb.IsReadOnly(); }
 	bool IsLarge() const noexcept { return cb.IsLarge(); }
+	bool IsLinesTree() const noexcept { return cb.IsLinesTree(); }
 	Scintilla::DocumentOption Options() const noexcept;
 
 	void DelChar(Sci::Position pos);
@@ -498,6 +506,8 @@ public:
 	Sci_Position SCI_METHOD Length() const override { return cb.Length(); }
 	Sci::Position LengthNoExcept() const noexcept { return cb.Length(); }
 	void Allocate(Sci::Position newSize) { cb.Allocate(newSize); }
+	/// Read access to the text for searches that scan it directly.
+	SegmentedView AllView() const noexcept { return cb.AllView(); }
 
 	CharacterExtracted ExtractCharacter(Sci::Position position) const noexcept;
 
@@ -509,6 +519,12 @@ public:
 	bool HasCaseFolder() const noexcept;
 	void SetCaseFolder(std::unique_ptr<CaseFolder> pcf_) noexcept;
 	Sci::Position FindText(Sci::Position minPos, Sci::Position maxPos, const char *search, Scintilla::FindOption flags, Sci::Position *length);
+	void FindAll(Sci::Position minPos, Sci::Position maxPos, const char *search, Scintilla::FindOption flags, Sci::Position length,
+		std::vector<Range> &matches);
+	Sci::Position FindTextParallel(ThreadPool &pool, size_t threads, Sci::Position minPos, Sci::Position maxPos,
+		const char *search, Scintilla::FindOption flags, Sci::Position *length);
+	void FindAllParallel(ThreadPool &pool, size_t threads, Sci::Position minPos, Sci::Position maxPos,
+		const char *search, Scintilla::FindOption flags, Sci::Position length, std::vector<Range> &matches);
 	const char *SubstituteByPosition(const char *text, Sci::Position *length);
 	Scintilla::LineCharacterIndexType LineCharacterIndex() const noexcept;
 	void AllocateLineCharacterIndex(Scintilla::LineCharacterIndexType lineCharacterIndex);
@@ -531,6 +547,7 @@ public:
 	void IncrementStyleClock() noexcept;
 	void SCI_METHOD DecorationSetCurrentIndicator(int indicator) override;
 	void SCI_METHOD DecorationFillRange(Sci_Position position, int value, Sci_Position fillLength) override;
+	void DecorationFillRanges(const std::vector<Range> &ranges, int value);
 	LexInterface *GetLexInterface() const noexcept;
 	void SetLexInterface(std::unique_ptr<LexInterface> pLexInterface) noexcept;
 
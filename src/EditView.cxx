@@ -14,6 +14,7 @@
 #include <cmath>
 
 #include <stdexcept>
+#include <exception>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -23,11 +24,13 @@
 #include <optional>
 #include <algorithm>
 #include <iterator>
+#include <functional>
 #include <memory>
 #include <chrono>
 #include <atomic>
+#include <mutex>
 #include <thread>
-#include <future>
+#include <condition_variable>
 
 #include "ScintillaTypes.h"
 #include "ScintillaMessages.h"
@@ -65,6 +68,7 @@
 #include "MarginView.h"
 #include "EditView.h"
 #include "ElapsedPeriod.h"
+#include "ThreadPool.h"
 
 using namespace Scintilla;
 using namespace Scintilla::Internal;
@@ -180,10 +184,93 @@ void DrawStyledText(Surface *surface, const ViewStyle &vs, int styleOffset, PRec
 
 }
 
+void LineBitmapCache::Clear() noexcept {
+	entries.clear();
+}
+
+// Forget the drawing of all lines but keep pixmaps for reuse.
+void LineBitmapCache::Invalidate() noexcept {
+	for (Entry &entry : entries) {
+		entry.lineDoc = -1;
+	}
+}
+
+void LineBitmapCache::InvalidateLines(Sci::Line lineDocStart, Sci::Line lineDocEnd) noexcept {
+	for (Entry &entry : entries) {
+		if ((entry.lineDoc >= lineDocStart) && (entry.lineDoc < lineDocEnd)) {
+			entry.lineDoc = -1;
+		}
+	}
+}
+
+// Each paint may retain up to capacity lines with those least recently painted reused first.
+void LineBitmapCache::StartPaint(size_t capacity_) noexcept {
+	capacity = capacity_;
+	paintSequence++;
+}
+
+LineBitmapCache::Entry *LineBitmapCache::Find(Sci::Line lineDoc, int subLine, size_t key, int xStart, int width, int height) noexcept {
+	for (Entry &entry : entries) {
+		if ((entry.lineDoc == lineDoc) && (entry.subLine == subLine)) {
+			if ((entry.key == key) && (entry.xStart == xStart) && (entry.width == width) && (entry.height == height)) {
+				entry.lastUsed = paintSequence;
+				return &entry;
+			}
+			entry.lineDoc = -1;
+			return nullptr;
+		}
+	}
+	return nullptr;
+}
+
+LineBitmapCache::Entry *LineBitmapCache::Allocate(Surface *surfaceWindow, Sci::Line lineDoc, int subLine, size_t key, int xStart, int width, int height) {
+	Entry *slot = nullptr;
+	if (entries.size() < capacity) {
+		// Prefer reusing an invalid entry to creating a new pixmap
+		for (Entry &entry : entries) {
+			if ((entry.lineDoc < 0) && (entry.width == width) && (entry.height == height)) {
+				slot = &entry;
+				break;
+			}
+		}
+		if (!slot) {
+			slot = &entries.emplace_back();
+		}
+	} else {
+		// Reuse an invalid entry else the least recently painted
+		for (Entry &entry : entries) {
+			if (entry.lineDoc < 0) {
+				slot = &entry;
+				break;
+			}
+			if ((entry.lastUsed != paintSequence) && (!slot || (entry.lastUsed < slot->lastUsed))) {
+				slot = &entry;
+			}
+		}
+		if (!slot) {
+			// All entries used in this paint
+			return nullptr;
+		}
+	}
+	if (!slot->pixmap || (slot->width != width) || (slot->height != height)) {
+		slot->pixmap = surfaceWindow->AllocatePixMap(width, height);
+	}
+	slot->lineDoc = lineDoc;
+	slot->subLine = subLine;
+	slot->key = key;
+	slot->xStart = xStart;
+	slot->width = width;
+	slot->height = height;
+	slot->lineWidth = 0;
+	slot->lastUsed = paintSequence;
+	return slot;
+}
+
 EditView::EditView() {
 	tabWidthMinimumPixels = 2; // needed for calculating tab stops for fractional proportional fonts
 	drawOverstrikeCaret = true;
 	bufferedDraw = true;
+	retainedDraw = false;
 	phasesDraw = PhasesDraw::Two;
 	lineWidthMaxSeen = 0;
 	additionalCaretsBlink = true;
@@ -193,6 +280,8 @@ EditView::EditView() {
 	posCache = CreatePositionCache();
 	posCache->SetSize(0x400);
 	maxLayoutThreads = 1;
+	layoutPool = std::make_unique<ThreadPool>();
+	lazyLayoutLength = 0;
 	tabArrowHeight = 4;
 	customDrawTabArrow = nullptr;
 	customDrawWrapMarker = nullptr;
@@ -220,6 +309,10 @@ bool EditView::LinesOverlap() const noexcept {
 
 void EditView::SetLayoutThreads(unsigned int threads) noexcept {
 	maxLayoutThreads = std::clamp(threads, 1U, std::thread::hardware_concurrency());
+	if (layoutPool->Threads() > maxLayoutThreads) {
+		// Workers are started again as needed
+		layoutPool->Stop();
+	}
 }
 
 unsigned int EditView::GetLayoutThreads() const noexcept {
@@ -271,6 +364,7 @@ void EditView::LinesAddedOrRemoved(Sci::Line lineOfPos, Sci::Line linesAdded) {
 }
 
 void EditView::DropGraphics() noexcept {
+	lineBitmaps.Clear();
 	pixmapLine.reset();
 	pixmapIndentGuide.reset();
 	pixmapIndentGuideHighlight.reset();
@@ -388,6 +482,179 @@ void LayoutSegments(IPositionCache *pCache,
 	}
 }
 
+// Fill in relative positions for segments from average character widths without measuring.
+void EstimateSegments(const ViewStyle &vstyle, LineLayout *ll, const std::vector<TextSegment> &segments,
+	const Document *pdoc) {
+	const EncodingFamily encodingFamily = pdoc->CodePageFamily();
+	for (const TextSegment &ts : segments) {
+		const Style &style = vstyle.styles[ll->styles[ts.start]];
+		XYPOSITION *positions = &ll->positions[ts.start + 1];
+		if (style.visible) {
+			if (ts.representation) {
+				XYPOSITION representationWidth = 0.0;
+				if (ll->chars[ts.start] != '\t') {
+					representationWidth = vstyle.controlCharWidth;
+					if (representationWidth <= 0.0) {
+						representationWidth = static_cast<XYPOSITION>(ts.representation->stringRep.length()) *
+							vstyle.styles[StyleControlChar].aveCharWidth;
+						if (FlagSet(ts.representation->appearance, RepresentationAppearance::Blob)) {
+							representationWidth += vstyle.ctrlCharPadding;
+						}
+					}
+				}
+				std::fill(positions, positions + ts.length, representationWidth);
+			} else {
+				// Each byte of a character is positioned at the end of the character
+				XYPOSITION x = 0.0;
+				int i = 0;
+				while (i < ts.length) {
+					const char *chars = &ll->chars[ts.start + i];
+					int charWidth = 1;
+					if (!UTF8IsAscii(chars[0]) && (encodingFamily != EncodingFamily::eightBit)) {
+						const size_t remaining = ts.length - i;
+						charWidth = (encodingFamily == EncodingFamily::unicode) ?
+							UTF8DrawBytes(chars, remaining) :
+							pdoc->DBCSDrawBytes(std::string_view(chars, remaining));
+					}
+					x += (chars[0] == ' ') ? style.spaceWidth : style.aveCharWidth;
+					std::fill(positions + i, positions + i + charWidth, x);
+					i += charWidth;
+				}
+			}
+		} else if (style.invisibleRepresentation[0]) {
+			const std::string_view text = style.invisibleRepresentation;
+			const XYPOSITION representationWidth = static_cast<XYPOSITION>(text.length()) * style.aveCharWidth;
+			std::fill(positions, positions + ts.length, representationWidth);
+		}
+	}
+}
+
+/**
+* Copy of the previous layout of a long line so that, after an edit, segments
+* outside the changed text can take their widths from it instead of being measured.
+*/
+class PreviousLayout {
+	std::vector<char> chars;
+	std::vector<unsigned char> styles;
+	std::vector<XYPOSITION> positions;
+	std::vector<int> segmentStarts;
+	int length;
+	int lengthNew = 0;
+	int prefix = 0;	// Bytes at start unchanged by edit
+	int suffix = 0;	// Bytes at end unchanged by edit
+public:
+	explicit PreviousLayout(LineLayout *ll) :
+		chars(ll->chars, ll->chars + ll->numCharsInLine),
+		styles(ll->styles, ll->styles + ll->numCharsInLine),
+		positions(ll->positions, ll->positions + ll->numCharsInLine + 1),
+		segmentStarts(std::move(ll->segmentStarts)),
+		length(ll->numCharsInLine) {
+	}
+
+	// Find the extent of the edit by comparing the new text and styles with the previous.
+	void Compare(const LineLayout *ll, int numCharsInLine) noexcept {
+		lengthNew = numCharsInLine;
+		const int common = std::min(length, lengthNew);
+		while ((prefix < common) &&
+			(chars[prefix] == ll->chars[prefix]) && (styles[prefix] == ll->styles[prefix])) {
+			prefix++;
+		}
+		while ((suffix < common - prefix) &&
+			(chars[length - 1 - suffix] == ll->chars[lengthNew - 1 - suffix]) &&
+			(styles[length - 1 - suffix] == ll->styles[lengthNew - 1 - suffix])) {
+			suffix++;
+		}
+	}
+
+	// When ts matches a previous segment with unchanged text, copy its relative positions.
+	bool Reuse(const TextSegment &ts, LineLayout *ll) const noexcept {
+		if (ts.representation && (ll->chars[ts.start] == '\t')) {
+			// Tab widths depend on position so are always calculated
+			return false;
+		}
+		int start = ts.start;
+		if (ts.end() > prefix) {
+			if (ts.start < lengthNew - suffix) {
+				return false;
+			}
+			start = ts.start - lengthNew + length;
+		}
+		const std::vector<int>::const_iterator it = std::lower_bound(segmentStarts.begin(), segmentStarts.end(), start);
+		if ((it == segmentStarts.end()) || (*it != start) || ((it + 1) == segmentStarts.end())) {
+			// Last segment not reused as it may include an offset for italics
+			return false;
+		}
+		if (*(it + 1) != start + ts.length) {
+			return false;
+		}
+		for (int i = 1; i <= ts.length; i++) {
+			ll->positions[ts.start + i] = positions[start + i] - positions[start];
+		}
+		return true;
+	}
+};
+
+}
+
+// Find relative positions of everything except for tabs, dividing long lines between threads.
+void EditView::MeasureSegments(const EditModel &model, Surface *surface, const ViewStyle &vstyle,
+	LineLayout *ll, const std::vector<TextSegment> &segments, bool callerMultiThreaded) {
+	if (segments.empty()) {
+		return;
+	}
+
+	const int lengthMeasure = segments.back().end() - segments.front().start;
+	const size_t threadsForLength = std::max(1, lengthMeasure / bytesPerLayoutThread);
+	size_t threads = std::min<size_t>({ segments.size(), threadsForLength, maxLayoutThreads });
+	if (!surface->SupportsFeature(Supports::ThreadSafeMeasureWidths) || callerMultiThreaded) {
+		threads = 1;
+	}
+
+	std::atomic<uint32_t> nextIndex = 0;
+
+	const bool textUnicode = CpUtf8 == model.pdoc->dbcsCodePage;
+	const bool multiThreaded = threads > 1;
+	const bool multiThreadedContext = multiThreaded || callerMultiThreaded;
+	IPositionCache *pCache = posCache.get();
+
+	// If only 1 thread needed then use the main thread, else use pool workers as well
+	layoutPool->Run(threads,
+		[pCache, surface, &vstyle, &ll, &segments, &nextIndex, textUnicode, multiThreadedContext](size_t) {
+		LayoutSegments(pCache, surface, vstyle, ll, segments, nextIndex, textUnicode, multiThreadedContext);
+	});
+}
+
+// Accumulate absolute positions from relative positions within segments and expand tabs.
+void EditView::AccumulatePositions(Sci::Line line, const ViewStyle &vstyle, LineLayout *ll,
+	const std::vector<TextSegment> &segments) const {
+	XYPOSITION xPosition = 0.0;
+	size_t iByte = 0;
+	ll->positions[iByte++] = xPosition;
+	for (const TextSegment &ts : segments) {
+		if (vstyle.styles[ll->styles[ts.start]].visible &&
+			ts.representation &&
+			(ll->chars[ts.start] == '\t')) {
+			// Simple visible tab, go to next tab stop
+			const XYPOSITION startTab = ll->positions[ts.start];
+			const XYPOSITION nextTab = NextTabstopPos(line, startTab, vstyle.tabWidth);
+			xPosition += nextTab - startTab;
+		}
+		const XYPOSITION xBeginSegment = xPosition;
+		for (int i = 0; i < ts.length; i++) {
+			xPosition = ll->positions[iByte] + xBeginSegment;
+			ll->positions[iByte++] = xPosition;
+		}
+	}
+
+	if (!segments.empty()) {
+		// Not quite the same as before which would effectively ignore trailing invisible segments
+		const TextSegment &ts = segments.back();
+		const bool lastSegItalics = (!ts.representation) && ((ll->chars[ts.end() - 1] != ' ') && vstyle.styles[ll->styles[ts.start]].italic);
+		// Small hack to make lines that end with italics not cut off the edge of the last character
+		if (lastSegItalics) {
+			ll->positions[ts.end()] += vstyle.lastSegItalicsOffset;
+		}
+	}
 }
 
 /**
@@ -409,7 +676,17 @@ void EditView::LayoutLine(const EditModel &model, Surface *surface, const ViewSt
 	}
 	// Hard to cope when too narrow, so just assume there is space
 	width = std::max(width, 20);
-
+	const int widthWrap = width;
+	const bool lazyLayout = (lazyLayoutLength > 0) && ((posLineEnd - posLineStart) > lazyLayoutLength);
+
+	// Only a layout made with the current view style may be partly reused
+	const bool previousReusable = (ll->validity == LineLayout::ValidLevel::checkTextAndStyle) &&
+		!ll->segmentStarts.empty() && !lazyLayout;
+	if ((ll->validity == LineLayout::ValidLevel::checkTextAndStyle) && lazyLayout) {
+		if (!UpdateLazyLayout(model, surface, vstyle, ll, width, callerMultiThreaded)) {
+			ll->validity = LineLayout::ValidLevel::invalid;
+		}
+	}
 	if (ll->validity == LineLayout::ValidLevel::checkTextAndStyle) {
 		Sci::Position lineLength = posLineEnd - posLineStart;
 		if (!vstyle.viewEOL) {
@@ -454,10 +731,16 @@ void EditView::LayoutLine(const EditModel &model, Surface *surface, const ViewSt
 			ll->edgeColumn = -1;
 		}
 
+		std::optional<PreviousLayout> previous;
+		if (previousReusable) {
+			previous.emplace(ll);
+		}
+		ll->segmentStarts.clear();
+
 		// Fill base line layout
 		const int lineLength = static_cast<int>(posLineEnd - posLineStart);
-		model.pdoc->GetCharRange(ll->chars.get(), posLineStart, lineLength);
-		model.pdoc->GetStyleRange(ll->styles.get(), posLineStart, lineLength);
+		model.pdoc->GetCharRange(ll->chars, posLineStart, lineLength);
+		model.pdoc->GetStyleRange(ll->styles, posLineStart, lineLength);
 		const int numCharsBeforeEOL = static_cast<int>(model.pdoc->LineEnd(line) - posLineStart);
 		const int numCharsInLine = (vstyle.viewEOL) ? lineLength : numCharsBeforeEOL;
 		const unsigned char styleByteLast = (lineLength > 0) ? ll->styles[lineLength - 1] : 0;
@@ -477,7 +760,6 @@ void EditView::LayoutLine(const EditModel &model, Surface *surface, const ViewSt
 		// Layout the line, determining the position of each character,
 		// with an extra element at the end for the end of the line.
 		ll->positions[0] = 0;
-		bool lastSegItalics = false;
 
 		std::vector<TextSegment> segments;
 		BreakFinder bfLayout(ll, nullptr, Range(0, numCharsInLine), posLineStart, 0, BreakFinder::BreakFor::Text, model.pdoc, model.reprs.get(), nullptr);
@@ -487,116 +769,510 @@ void EditView::LayoutLine(const EditModel &model, Surface *surface, const ViewSt
 
 		ll->ClearPositions();
 
-		if (!segments.empty()) {
-
-			const size_t threadsForLength = std::max(1, numCharsInLine / bytesPerLayoutThread);
-			size_t threads = std::min<size_t>({ segments.size(), threadsForLength, maxLayoutThreads });
-			if (!surface->SupportsFeature(Supports::ThreadSafeMeasureWidths) || callerMultiThreaded) {
-				threads = 1;
+		if (lazyLayout) {
+			// Measuring is deferred until the chunks around the caret and visible area are known
+			ll->chunksMeasured.assign(numCharsInLine / bytesPerLayoutChunk + 1, false);
+			EstimateSegments(vstyle, ll, segments, model.pdoc);
+		} else {
+			ll->chunksMeasured.clear();
+			// Segments not reused from previous layout
+			std::vector<TextSegment> segmentsChanged;
+			if (previous) {
+				previous->Compare(ll, numCharsInLine);
+				for (const TextSegment &ts : segments) {
+					if (!previous->Reuse(ts, ll)) {
+						segmentsChanged.push_back(ts);
+					}
+				}
 			}
+			MeasureSegments(model, surface, vstyle, ll, previous ? segmentsChanged : segments, callerMultiThreaded);
+		}
 
-			std::atomic<uint32_t> nextIndex = 0;
+		AccumulatePositions(line, vstyle, ll, segments);
 
-			const bool textUnicode = CpUtf8 == model.pdoc->dbcsCodePage;
-			const bool multiThreaded = threads > 1;
-			const bool multiThreadedContext = multiThreaded || callerMultiThreaded;
-			IPositionCache *pCache = posCache.get();
+		if ((numCharsInLine >= bytesIncrementalLayout) || lazyLayout) {
+			for (const TextSegment &ts : segments) {
+				ll->segmentStarts.push_back(ts.start);
+			}
+		}
+		ll->numCharsInLine = numCharsInLine;
+		ll->numCharsBeforeEOL = numCharsBeforeEOL;
+		ll->validity = LineLayout::ValidLevel::positions;
+	}
+	// Each pass after the first follows measuring at least one more chunk of a lazily laid out
+	// line so there can be no more passes than chunks.
+	int linesEstimated = 0;
+	for (size_t pass = 0; pass <= ll->chunksMeasured.size(); pass++) {
+		if ((ll->validity == LineLayout::ValidLevel::positions) || (ll->widthLine != widthWrap)) {
+			width = widthWrap;
+			ll->widthLine = width;
+			if (width == LineLayout::wrapWidthInfinite) {
+				ll->lines = 1;
+			} else if (width > ll->positions[ll->numCharsInLine]) {
+				// Simple common case where line does not need wrapping.
+				ll->lines = 1;
+			} else {
+				if (FlagSet(vstyle.wrap.visualFlags, WrapVisualFlag::End)) {
+					width -= static_cast<int>(vstyle.aveCharWidth); // take into account the space for end wrap mark
+				}
+				XYPOSITION wrapAddIndent = 0; // This will be added to initial indent of line
+				switch (vstyle.wrap.indentMode) {
+				case WrapIndentMode::Fixed:
+					wrapAddIndent = vstyle.wrap.visualStartIndent * vstyle.aveCharWidth;
+					break;
+				case WrapIndentMode::Indent:
+					wrapAddIndent = model.pdoc->IndentSize() * vstyle.spaceWidth;
+					break;
+				case WrapIndentMode::DeepIndent:
+					wrapAddIndent = model.pdoc->IndentSize() * 2 * vstyle.spaceWidth;
+					break;
+				default:	// No additional indent for WrapIndentMode::Fixed
+					break;
+				}
+				ll->wrapIndent = wrapAddIndent;
+				if (vstyle.wrap.indentMode != WrapIndentMode::Fixed) {
+					for (int i = 0; i < ll->numCharsInLine; i++) {
+						if (!IsSpaceOrTab(ll->chars[i])) {
+							ll->wrapIndent += ll->positions[i]; // Add line indent
+							break;
+						}
+					}
+				}
+				// Check for text width minimum
+				if (ll->wrapIndent > width - static_cast<int>(vstyle.aveCharWidth) * 15)
+					ll->wrapIndent = wrapAddIndent;
+				// Check for wrapIndent minimum
+				if ((FlagSet(vstyle.wrap.visualFlags, WrapVisualFlag::Start)) && (ll->wrapIndent < vstyle.aveCharWidth))
+					ll->wrapIndent = vstyle.aveCharWidth; // Indent to show start visual
+				ll->WrapLine(model.pdoc, posLineStart, vstyle.wrap.state, width);
+			}
+			ll->validity = LineLayout::ValidLevel::lines;
+		}
+		if (pass == 0) {
+			linesEstimated = ll->lines;
+		}
+		if (ll->chunksMeasured.empty() || !MeasureChunksInView(model, surface, vstyle, ll, callerMultiThreaded)) {
+			break;
+		}
+		// Wrap again with the measured widths which may bring further chunks into view
+		ll->validity = LineLayout::ValidLevel::positions;
+	}
+	if ((ll->lines != linesEstimated) && !callerMultiThreaded) {
+		// The owner's height for this line came from fewer measured chunks
+		linesRemeasured.push_back(line);
+	}
+}
 
-			// If only 1 thread needed then use the main thread, else spin up multiple
-			const std::launch policy = (multiThreaded) ? std::launch::async : std::launch::deferred;
+/**
+* For a line laid out lazily, measure the chunks containing the main caret and anchor and
+* those in view, replacing their estimated widths and moving the text after them.
+* Chunks start at the first segment at or after each multiple of bytesPerLayoutChunk.
+* Returns true when any chunk was measured.
+*/
+bool EditView::MeasureChunksInView(const EditModel &model, Surface *surface, const ViewStyle &vstyle,
+	LineLayout *ll, bool callerMultiThreaded) {
+	const Sci::Line line = ll->LineNumber();
+	const Sci::Position posLineStart = model.pdoc->LineStart(line);
+	const int numCharsInLine = ll->numCharsInLine;
 
-			std::vector<std::future<void>> futures;
-			for (size_t th = 0; th < threads; th++) {
-				// Find relative positions of everything except for tabs
-				std::future<void> fut = std::async(policy,
-					[pCache, surface, &vstyle, &ll, &segments, &nextIndex, textUnicode, multiThreadedContext]() {
-					LayoutSegments(pCache, surface, vstyle, ll, segments, nextIndex, textUnicode, multiThreadedContext);
-				});
-				futures.push_back(std::move(fut));
-			}
-			for (const std::future<void> &f : futures) {
-				f.wait();
+	std::vector<size_t> chunks;
+	auto addRange = [ll, numCharsInLine, &chunks](Sci::Position start, Sci::Position end) {
+		start = std::clamp<Sci::Position>(start, 0, numCharsInLine);
+		end = std::clamp<Sci::Position>(end, start, numCharsInLine);
+		for (size_t chunk = start / bytesPerLayoutChunk; chunk <= static_cast<size_t>(end / bytesPerLayoutChunk); chunk++) {
+			if (!ll->chunksMeasured[chunk]) {
+				chunks.push_back(chunk);
 			}
 		}
+	};
+
+	const SelectionRange &rangeMain = model.sel.RangeMain();
+	for (const Sci::Position position : { rangeMain.caret.Position(), rangeMain.anchor.Position() }) {
+		const Sci::Position posInLine = position - posLineStart;
+		if ((posInLine >= 0) && (posInLine <= numCharsInLine)) {
+			addRange(posInLine, posInLine);
+		}
+	}
+
+	// Sublines of this line in view
+	const Sci::Line lineDisplay = model.pcs->DisplayFromDoc(line);
+	const Sci::Line topLine = model.TopLineOfMain();
+	const Sci::Line subLineFirst = std::max<Sci::Line>(topLine - lineDisplay, 0);
+	const Sci::Line subLineEnd = std::min<Sci::Line>(topLine + model.LinesOnScreen() + 1 - lineDisplay, ll->lines);
+	if (subLineFirst < subLineEnd) {
+		if (ll->lines == 1) {
+			// Text from the horizontal scroll position to a chunk beyond which is wider than a view
+			const int start = ll->FindBefore(model.xOffset, Range(0, numCharsInLine));
+			addRange(start, start + bytesPerLayoutChunk);
+		} else {
+			addRange(ll->LineStart(static_cast<int>(subLineFirst)), ll->LineStart(static_cast<int>(subLineEnd)));
+		}
+	}
+
+	if (chunks.empty()) {
+		return false;
+	}
+	std::sort(chunks.begin(), chunks.end());
+	chunks.erase(std::unique(chunks.begin(), chunks.end()), chunks.end());
+
+	// Segment again each chunk then measure them all together
+	std::vector<int> &segmentStarts = ll->segmentStarts;
+	std::vector<Range> ranges;
+	std::vector<XYPOSITION> endsPrevious;
+	std::vector<TextSegment> segments;
+	for (const size_t chunk : chunks) {
+		ll->chunksMeasured[chunk] = true;
+		const std::vector<int>::const_iterator itStart = std::lower_bound(segmentStarts.begin(), segmentStarts.end(),
+			static_cast<int>(chunk * bytesPerLayoutChunk));
+		const std::vector<int>::const_iterator itEnd = std::lower_bound(itStart, segmentStarts.cend(),
+			static_cast<int>((chunk + 1) * bytesPerLayoutChunk));
+		if (itStart == itEnd) {
+			continue;
+		}
+		const int start = *itStart;
+		const int end = (itEnd == segmentStarts.end()) ? numCharsInLine : *itEnd;
+		ranges.emplace_back(start, end);
+		endsPrevious.push_back(ll->positions[end]);
+		BreakFinder bfLayout(ll, nullptr, Range(start, end), posLineStart, 0, BreakFinder::BreakFor::Text, model.pdoc, model.reprs.get(), nullptr);
+		while (bfLayout.More()) {
+			segments.push_back(bfLayout.Next());
+		}
+		std::fill(&ll->positions[start + 1], &ll->positions[end + 1], 0.0f);
+	}
+	if (ranges.empty()) {
+		return false;
+	}
+	MeasureSegments(model, surface, vstyle, ll, segments, callerMultiThreaded);
 
-		// Accumulate absolute positions from relative positions within segments and expand tabs
-		XYPOSITION xPosition = 0.0;
-		size_t iByte = 0;
-		ll->positions[iByte++] = xPosition;
-		for (const TextSegment &ts : segments) {
-			if (vstyle.styles[ll->styles[ts.start]].visible &&
-				ts.representation &&
-				(ll->chars[ts.start] == '\t')) {
-				// Simple visible tab, go to next tab stop
-				const XYPOSITION startTab = ll->positions[ts.start];
-				const XYPOSITION nextTab = NextTabstopPos(line, startTab, vstyle.tabWidth);
-				xPosition += nextTab - startTab;
+	// Replace the segment starts in the measured chunks with those just found
+	std::vector<int> startsUpdated;
+	startsUpdated.reserve(segmentStarts.size());
+	size_t iSegment = 0;
+	size_t iRange = 0;
+	for (const int start : segmentStarts) {
+		while ((iRange < ranges.size()) && (start >= ranges[iRange].end)) {
+			iRange++;
+		}
+		if ((iRange < ranges.size()) && (start >= ranges[iRange].start)) {
+			while ((iSegment < segments.size()) && (segments[iSegment].start < ranges[iRange].end)) {
+				startsUpdated.push_back(segments[iSegment++].start);
 			}
-			const XYPOSITION xBeginSegment = xPosition;
-			for (int i = 0; i < ts.length; i++) {
-				xPosition = ll->positions[iByte] + xBeginSegment;
-				ll->positions[iByte++] = xPosition;
+		} else {
+			startsUpdated.push_back(start);
+		}
+	}
+	segmentStarts = std::move(startsUpdated);
+
+	// Recalculate absolute positions from the first measured chunk, combining the measured
+	// relative positions with those of other segments derived from their previous positions.
+	const Representation *reprTab = model.reprs->GetRepresentation(std::string_view("\t", 1));
+	XYPOSITION xPosition = ll->positions[ranges.front().start];
+	XYPOSITION xPrevious = xPosition;
+	iRange = 0;
+	for (std::vector<int>::const_iterator it = std::lower_bound(segmentStarts.cbegin(), segmentStarts.cend(), static_cast<int>(ranges.front().start));
+		it != segmentStarts.cend(); ++it) {
+		const int start = *it;
+		const int end = ((it + 1) == segmentStarts.cend()) ? numCharsInLine : *(it + 1);
+		while ((iRange < ranges.size()) && (start >= ranges[iRange].end)) {
+			iRange++;
+		}
+		const bool measured = (iRange < ranges.size()) && (start >= ranges[iRange].start);
+		const bool tab = reprTab && (end == start + 1) && (ll->chars[start] == '\t') &&
+			vstyle.styles[ll->styles[start]].visible;
+		XYPOSITION xBeginSegment = xPosition;
+		if (tab) {
+			xBeginSegment = NextTabstopPos(line, xPosition, vstyle.tabWidth);
+		}
+		const XYPOSITION xPreviousBegin = xPrevious;
+		for (int i = start + 1; i <= end; i++) {
+			XYPOSITION relative = 0.0;
+			if (measured) {
+				relative = ll->positions[i];
+			} else {
+				if (!tab) {
+					relative = ll->positions[i] - xPreviousBegin;
+				}
+				xPrevious = ll->positions[i];
 			}
+			ll->positions[i] = xBeginSegment + relative;
 		}
-
-		if (!segments.empty()) {
-			// Not quite the same as before which would effectively ignore trailing invisible segments
-			const TextSegment &ts = segments.back();
-			lastSegItalics = (!ts.representation) && ((ll->chars[ts.end() - 1] != ' ') && vstyle.styles[ll->styles[ts.start]].italic);
+		if (measured && (end == ranges[iRange].end)) {
+			xPrevious = endsPrevious[iRange];
 		}
+		xPosition = ll->positions[end];
+	}
 
-		// Small hack to make lines that end with italics not cut off the edge of the last character
-		if (lastSegItalics) {
-			ll->positions[numCharsInLine] += vstyle.lastSegItalicsOffset;
+	const TextSegment &tsLast = segments.back();
+	if ((tsLast.end() == numCharsInLine) && (!tsLast.representation) && (ll->chars[tsLast.end() - 1] != ' ') &&
+		vstyle.styles[ll->styles[tsLast.start]].italic) {
+		// Measured last segment, so add offset for italics as done by AccumulatePositions
+		ll->positions[numCharsInLine] += vstyle.lastSegItalicsOffset;
+	}
+	return true;
+}
+
+/**
+* For a line laid out lazily, update the layout after an edit without segmenting and estimating
+* the whole line again. The extent of the edit is found by comparing the document with the layout.
+* Only the segments around the changed text are found again and measured, or estimated when
+* longer than a chunk. The text, positions, segments, and measured chunks after them are moved.
+* Returns false when there is no lazy layout to update so the line must be laid out again.
+*/
+bool EditView::UpdateLazyLayout(const EditModel &model, Surface *surface, const ViewStyle &vstyle,
+	LineLayout *ll, int width, bool callerMultiThreaded) {
+	if (ll->chunksMeasured.empty() || ll->segmentStarts.empty() || vstyle.someStylesForceCase) {
+		// Forced case depends on the previous character so is not updated
+		return false;
+	}
+	const Sci::Line line = ll->LineNumber();
+	const Sci::Position posLineStart = model.pdoc->LineStart(line);
+	const Sci::Position posLineEnd = std::min(model.pdoc->LineStart(line + 1), posLineStart + ll->maxLineLength);
+	const int lineLength = static_cast<int>(posLineEnd - posLineStart);
+	const int numCharsBeforeEOL = static_cast<int>(model.pdoc->LineEnd(line) - posLineStart);
+	const int lengthOld = ll->numCharsInLine;
+	const int lengthNew = (vstyle.viewEOL) ? lineLength : numCharsBeforeEOL;
+	const int common = std::min(lengthOld, lengthNew);
+
+	// Find bytes at start and end unchanged by the edit, comparing a block at a time
+	constexpr int blockCompare = 1024;
+	char charsDoc[blockCompare];
+	unsigned char stylesDoc[blockCompare];
+	int prefix = 0;
+	while (prefix < common) {
+		const int lengthBlock = std::min(blockCompare, common - prefix);
+		model.pdoc->GetCharRange(charsDoc, posLineStart + prefix, lengthBlock);
+		model.pdoc->GetStyleRange(stylesDoc, posLineStart + prefix, lengthBlock);
+		if ((std::memcmp(charsDoc, &ll->chars[prefix], lengthBlock) == 0) &&
+			(std::memcmp(stylesDoc, &ll->styles[prefix], lengthBlock) == 0)) {
+			prefix += lengthBlock;
+		} else {
+			int i = 0;
+			while ((charsDoc[i] == ll->chars[prefix + i]) && (stylesDoc[i] == ll->styles[prefix + i])) {
+				i++;
+			}
+			prefix += i;
+			break;
 		}
-		ll->numCharsInLine = numCharsInLine;
-		ll->numCharsBeforeEOL = numCharsBeforeEOL;
-		ll->validity = LineLayout::ValidLevel::positions;
 	}
-	if ((ll->validity == LineLayout::ValidLevel::positions) || (ll->widthLine != width)) {
-		ll->widthLine = width;
-		if (width == LineLayout::wrapWidthInfinite) {
-			ll->lines = 1;
-		} else if (width > ll->positions[ll->numCharsInLine]) {
-			// Simple common case where line does not need wrapping.
-			ll->lines = 1;
+	int suffix = 0;
+	while (suffix < common - prefix) {
+		const int lengthBlock = std::min(blockCompare, common - prefix - suffix);
+		const int startOld = lengthOld - suffix - lengthBlock;
+		model.pdoc->GetCharRange(charsDoc, posLineStart + lengthNew - suffix - lengthBlock, lengthBlock);
+		model.pdoc->GetStyleRange(stylesDoc, posLineStart + lengthNew - suffix - lengthBlock, lengthBlock);
+		if ((std::memcmp(charsDoc, &ll->chars[startOld], lengthBlock) == 0) &&
+			(std::memcmp(stylesDoc, &ll->styles[startOld], lengthBlock) == 0)) {
+			suffix += lengthBlock;
 		} else {
-			if (FlagSet(vstyle.wrap.visualFlags, WrapVisualFlag::End)) {
-				width -= static_cast<int>(vstyle.aveCharWidth); // take into account the space for end wrap mark
+			int i = lengthBlock - 1;
+			while ((charsDoc[i] == ll->chars[startOld + i]) && (stylesDoc[i] == ll->styles[startOld + i])) {
+				i--;
 			}
-			XYPOSITION wrapAddIndent = 0; // This will be added to initial indent of line
-			switch (vstyle.wrap.indentMode) {
-			case WrapIndentMode::Fixed:
-				wrapAddIndent = vstyle.wrap.visualStartIndent * vstyle.aveCharWidth;
-				break;
-			case WrapIndentMode::Indent:
-				wrapAddIndent = model.pdoc->IndentSize() * vstyle.spaceWidth;
-				break;
-			case WrapIndentMode::DeepIndent:
-				wrapAddIndent = model.pdoc->IndentSize() * 2 * vstyle.spaceWidth;
-				break;
-			default:	// No additional indent for WrapIndentMode::Fixed
+			suffix += lengthBlock - 1 - i;
+			break;
+		}
+	}
+
+	const unsigned char styleByteLast = (lineLength > 0) ?
+		static_cast<unsigned char>(model.pdoc->StyleIndexAt(posLineEnd - 1)) : 0;
+	ll->numCharsBeforeEOL = numCharsBeforeEOL;
+	if ((lengthNew == lengthOld) && (prefix == common)) {
+		ll->styles[lengthNew] = styleByteLast;	// For eolFilled
+		ll->validity = (ll->widthLine != width) ? LineLayout::ValidLevel::positions : LineLayout::ValidLevel::lines;
+		return true;
+	}
+
+	// Segments are found again from the last segment starting before the edit to the first
+	// starting after it so characters next to the changed text are segmented with it.
+	std::vector<int> &segmentStarts = ll->segmentStarts;
+	const std::vector<int>::iterator itBefore = std::lower_bound(segmentStarts.begin(), segmentStarts.end(), std::max(prefix, 1)) - 1;
+	const int suffixOld = lengthOld - suffix;
+	const std::vector<int>::iterator itAfter = std::upper_bound(itBefore, segmentStarts.end(), suffixOld);
+	const int start = *itBefore;
+	const int endOld = (itAfter == segmentStarts.end()) ? lengthOld : *itAfter;
+	const int delta = lengthNew - lengthOld;
+	const int end = endOld + delta;
+
+	// Move the text after the edit and the positions after the segments found again then
+	// retrieve the changed text
+	const XYPOSITION xEndOld = ll->positions[endOld];
+	if (delta > 0) {
+		std::move_backward(&ll->chars[suffixOld], &ll->chars[lengthOld], &ll->chars[lengthNew]);
+		std::move_backward(&ll->styles[suffixOld], &ll->styles[lengthOld], &ll->styles[lengthNew]);
+		std::move_backward(&ll->positions[endOld + 1], &ll->positions[lengthOld + 1], &ll->positions[lengthNew + 1]);
+	} else if (delta < 0) {
+		std::move(&ll->chars[suffixOld], &ll->chars[lengthOld], &ll->chars[suffixOld + delta]);
+		std::move(&ll->styles[suffixOld], &ll->styles[lengthOld], &ll->styles[suffixOld + delta]);
+		std::move(&ll->positions[endOld + 1], &ll->positions[lengthOld + 1], &ll->positions[end + 1]);
+	}
+	const int lengthChanged = lengthNew - suffix - prefix;
+	model.pdoc->GetCharRange(&ll->chars[prefix], posLineStart + prefix, lengthChanged);
+	model.pdoc->GetStyleRange(&ll->styles[prefix], posLineStart + prefix, lengthChanged);
+	ll->chars[lengthNew] = 0;
+	ll->styles[lengthNew] = styleByteLast;	// For eolFilled
+	ll->numCharsInLine = lengthNew;
+	ll->xHighlightGuide = 0;
+	ll->widthLine = LineLayout::wrapWidthInfinite;
+	ll->lines = 1;
+	if (vstyle.edgeState == EdgeVisualStyle::Background) {
+		Sci::Position edgePosition = model.pdoc->FindColumn(line, vstyle.theEdge.column);
+		if (edgePosition >= posLineStart) {
+			edgePosition -= posLineStart;
+		}
+		ll->edgeColumn = static_cast<int>(edgePosition);
+	}
+
+	std::vector<TextSegment> segments;
+	BreakFinder bfLayout(ll, nullptr, Range(start, end), posLineStart, 0, BreakFinder::BreakFor::Text, model.pdoc, model.reprs.get(), nullptr);
+	while (bfLayout.More()) {
+		segments.push_back(bfLayout.Next());
+	}
+	std::fill(&ll->positions[start + 1], &ll->positions[end + 1], 0.0f);
+	// Text much longer than a typed or deleted word is estimated as when first laid out
+	const bool measure = (end - start) <= bytesPerLayoutChunk;
+	if (measure) {
+		MeasureSegments(model, surface, vstyle, ll, segments, callerMultiThreaded);
+	} else {
+		EstimateSegments(vstyle, ll, segments, model.pdoc);
+	}
+
+	// A chunk remains measured when all the text moved into it was measured
+	const std::vector<bool> chunksOld = std::move(ll->chunksMeasured);
+	auto measuredOld = [&chunksOld](int startRange, int endRange) {
+		for (int chunk = startRange / bytesPerLayoutChunk; (startRange < endRange) && (chunk <= (endRange - 1) / bytesPerLayoutChunk); chunk++) {
+			if (!chunksOld[chunk]) {
+				return false;
+			}
+		}
+		return true;
+	};
+	ll->chunksMeasured.assign(lengthNew / bytesPerLayoutChunk + 1, false);
+	for (size_t chunk = 0; chunk < ll->chunksMeasured.size(); chunk++) {
+		const int startChunk = static_cast<int>(chunk * bytesPerLayoutChunk);
+		const int endChunk = std::min(startChunk + bytesPerLayoutChunk, lengthNew + 1);
+		ll->chunksMeasured[chunk] = measuredOld(startChunk, std::min(endChunk, start)) &&
+			(measure || (std::max(startChunk, start) >= std::min(endChunk, end))) &&
+			measuredOld(std::max(startChunk, end) - delta, endChunk - delta);
+	}
+
+	// Replace the segment starts around the edit with those just found
+	std::transform(itAfter, segmentStarts.end(), itAfter, [delta](int segmentStart) noexcept {
+		return segmentStart + delta;
+	});
+	const std::vector<int>::iterator itInsert = segmentStarts.erase(itBefore, itAfter);
+	std::vector<int> startsFound;
+	for (const TextSegment &ts : segments) {
+		startsFound.push_back(ts.start);
+	}
+	segmentStarts.insert(itInsert, startsFound.begin(), startsFound.end());
+
+	// Absolute positions for the segments found, then those after them are moved by the change
+	// in width except for tabs which go to the next tab stop.
+	XYPOSITION xPosition = ll->positions[start];
+	for (const TextSegment &ts : segments) {
+		if (vstyle.styles[ll->styles[ts.start]].visible &&
+			ts.representation &&
+			(ll->chars[ts.start] == '\t')) {
+			xPosition = NextTabstopPos(line, xPosition, vstyle.tabWidth);
+		}
+		const XYPOSITION xBeginSegment = xPosition;
+		for (int i = ts.start + 1; i <= ts.end(); i++) {
+			ll->positions[i] += xBeginSegment;
+		}
+		xPosition = ll->positions[ts.end()];
+	}
+	const TextSegment &tsLast = segments.back();
+	if ((tsLast.end() == lengthNew) && (!tsLast.representation) && (ll->chars[tsLast.end() - 1] != ' ') &&
+		vstyle.styles[ll->styles[tsLast.start]].italic) {
+		// Last segment found again, so add offset for italics as done by AccumulatePositions
+		ll->positions[lengthNew] += vstyle.lastSegItalicsOffset;
+	}
+	const Representation *reprTab = model.reprs->GetRepresentation(std::string_view("\t", 1));
+	XYPOSITION xPrevious = xEndOld;
+	for (std::vector<int>::const_iterator it = std::lower_bound(segmentStarts.cbegin(), segmentStarts.cend(), end);
+		it != segmentStarts.cend(); ++it) {
+		if (xPosition == xPrevious) {
+			// The rest of the line begins where it did before the edit so is unchanged
+			break;
+		}
+		const int startSegment = *it;
+		const int endSegment = ((it + 1) == segmentStarts.cend()) ? lengthNew : *(it + 1);
+		const bool tab = reprTab && (endSegment == startSegment + 1) && (ll->chars[startSegment] == '\t') &&
+			vstyle.styles[ll->styles[startSegment]].visible;
+		const XYPOSITION xPreviousEnd = ll->positions[endSegment];
+		if (tab) {
+			const XYPOSITION nextTab = NextTabstopPos(line, xPosition, vstyle.tabWidth);
+			if (nextTab == NextTabstopPos(line, xPrevious, vstyle.tabWidth)) {
+				// Reaches the same tab stop as before the edit so the rest of the line is unchanged
 				break;
 			}
-			ll->wrapIndent = wrapAddIndent;
-			if (vstyle.wrap.indentMode != WrapIndentMode::Fixed) {
-				for (int i = 0; i < ll->numCharsInLine; i++) {
-					if (!IsSpaceOrTab(ll->chars[i])) {
-						ll->wrapIndent += ll->positions[i]; // Add line indent
-						break;
-					}
+			std::fill(&ll->positions[startSegment + 1], &ll->positions[endSegment + 1], nextTab);
+		} else {
+			const XYPOSITION shift = xPosition - xPrevious;
+			for (int i = startSegment + 1; i <= endSegment; i++) {
+				ll->positions[i] += shift;
+			}
+		}
+		xPrevious = xPreviousEnd;
+		xPosition = ll->positions[endSegment];
+	}
+
+	ll->validity = LineLayout::ValidLevel::positions;
+	return true;
+}
+
+// Lay out the short lines in a range of visible lines that have no checked layout on multiple
+// threads so they are measured together instead of one at a time as they are drawn.
+// Only useful when the layout cache can hold each line so their layouts are found when drawing.
+// Lines with linesCopied[visibleLine - visibleStart] set will be copied from retained bitmaps so are skipped.
+void EditView::LayoutVisibleLines(const EditModel &model, Surface *surface, const ViewStyle &vstyle,
+	Sci::Line visibleStart, Sci::Line visibleEnd, const std::vector<bool> &linesCopied) {
+	if ((maxLayoutThreads <= 1) || (llc.GetLevel() < LineCache::Page) ||
+		!surface->SupportsFeature(Supports::ThreadSafeMeasureWidths)) {
+		return;
+	}
+
+	// Retrieving layouts modifies the layout cache so is performed before starting threads
+	std::vector<std::shared_ptr<LineLayout>> layouts;
+	visibleEnd = std::min(visibleEnd, model.pcs->LinesDisplayed());
+	Sci::Line lineDocPrevious = -1;
+	for (Sci::Line visibleLine = visibleStart; visibleLine < visibleEnd; visibleLine++) {
+		const size_t index = visibleLine - visibleStart;
+		if ((index < linesCopied.size()) && linesCopied[index]) {
+			continue;
+		}
+		const Sci::Line lineDoc = model.pcs->DocFromDisplay(visibleLine);
+		if (lineDoc != lineDocPrevious) {
+			lineDocPrevious = lineDoc;
+			// Long lines are laid out when drawn as LayoutLine divides them between threads
+			if (model.pdoc->LineRange(lineDoc).Length() < bytesPerLayoutThread) {
+				std::shared_ptr<LineLayout> ll = RetrieveLineLayout(lineDoc, model);
+				// Layouts to be checked against the document are checked on the threads
+				if (ll->validity <= LineLayout::ValidLevel::checkTextAndStyle) {
+					layouts.push_back(std::move(ll));
 				}
 			}
-			// Check for text width minimum
-			if (ll->wrapIndent > width - static_cast<int>(vstyle.aveCharWidth) * 15)
-				ll->wrapIndent = wrapAddIndent;
-			// Check for wrapIndent minimum
-			if ((FlagSet(vstyle.wrap.visualFlags, WrapVisualFlag::Start)) && (ll->wrapIndent < vstyle.aveCharWidth))
-				ll->wrapIndent = vstyle.aveCharWidth; // Indent to show start visual
-			ll->WrapLine(model.pdoc, posLineStart, vstyle.wrap.state, width);
 		}
-		ll->validity = LineLayout::ValidLevel::lines;
 	}
+
+	// A cache entry may have been reused for a later line so ensure each layout is only laid out once
+	std::sort(layouts.begin(), layouts.end());
+	layouts.erase(std::unique(layouts.begin(), layouts.end()), layouts.end());
+	if (layouts.size() < 2) {
+		return;
+	}
+
+	const size_t threads = std::min<size_t>(layouts.size(), maxLayoutThreads);
+	std::atomic<size_t> nextIndex = 0;
+	layoutPool->Run(threads, [&](size_t) {
+		while (true) {
+			const size_t i = nextIndex.fetch_add(1, std::memory_order_acq_rel);
+			if (i >= layouts.size()) {
+				break;
+			}
+			LayoutLine(model, surface, vstyle, layouts[i].get(), model.wrapWidth, true);
+		}
+	});
 }
 
 // Fill the LineLayout bidirectional data fields according to each char style
@@ -2476,6 +3152,70 @@ void EditView::DrawLine(Surface *surface, const EditModel &model, const ViewStyl
 	}
 }
 
+namespace {
+
+constexpr size_t HashCombine(size_t hash, size_t value) noexcept {
+	return hash ^ (value + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+}
+
+bool PositionInRange(Sci::Position position, Range range) noexcept {
+	return (position >= range.start) && (position <= range.end);
+}
+
+// Hash the state that changes how a line is drawn without the line being invalidated:
+// selections, carets, brace highlights, hotspot, and hover indicator.
+size_t RetainedKey(const EditModel &model, const EditView &view, Range rangeLine, Sci::Line lineDoc,
+	Sci::Line lineCaret, int caretOffset) {
+	size_t key = 0;
+	bool selected = false;
+	for (size_t r = 0; r < model.sel.Count(); r++) {
+		const SelectionRange &range = model.sel.Range(r);
+		if ((range.Start().Position() <= rangeLine.end) && (range.End().Position() >= rangeLine.start)) {
+			selected = true;
+			key = HashCombine(key, r == model.sel.Main());
+			key = HashCombine(key, range.caret.Position());
+			key = HashCombine(key, range.caret.VirtualSpace());
+			key = HashCombine(key, range.anchor.Position());
+			key = HashCombine(key, range.anchor.VirtualSpace());
+		}
+	}
+	if (selected || (lineDoc == lineCaret)) {
+		key = HashCombine(key, static_cast<size_t>(model.sel.selType));
+		key = HashCombine(key, model.caret.active);
+		key = HashCombine(key, model.caret.on);
+		key = HashCombine(key, model.hasFocus);
+		key = HashCombine(key, model.primarySelection);
+		key = HashCombine(key, model.inOverstrike);
+		key = HashCombine(key, view.additionalCaretsVisible);
+		key = HashCombine(key, view.imeCaretBlockOverride);
+	}
+	if (lineDoc == lineCaret) {
+		key = HashCombine(key, caretOffset);
+	}
+	if (model.posDrag.IsValid() && PositionInRange(model.posDrag.Position(), rangeLine)) {
+		key = HashCombine(key, model.posDrag.Position());
+	}
+	// Brace highlights and the highlighted indentation guide span the lines between the braces
+	const Sci::Position braceFirst = (model.braces[1] >= 0) ? std::min(model.braces[0], model.braces[1]) : model.braces[0];
+	const Sci::Position braceLast = std::max(model.braces[0], model.braces[1]);
+	if ((braceFirst >= 0) && (braceFirst <= rangeLine.end) && (braceLast >= rangeLine.start)) {
+		key = HashCombine(key, model.braces[0]);
+		key = HashCombine(key, model.braces[1]);
+		key = HashCombine(key, model.bracesMatchStyle);
+		key = HashCombine(key, model.highlightGuideColumn);
+	}
+	if (model.hotspot.Valid() && (model.hotspot.start <= rangeLine.end) && (model.hotspot.end >= rangeLine.start)) {
+		key = HashCombine(key, model.hotspot.start);
+		key = HashCombine(key, model.hotspot.end);
+	}
+	if (PositionInRange(model.hoverIndicatorPos, rangeLine)) {
+		key = HashCombine(key, model.hoverIndicatorPos);
+	}
+	return key;
+}
+
+}
+
 void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, const ViewStyle &vsDraw,
 	PRectangle rcArea, PRectangle rcClient) {
 	// Allow text at start of line to overlap 1 pixel into the margin as this displays
@@ -2530,6 +3270,34 @@ void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, const V
 
 		Sci::Line lineDocPrevious = -1;	// Used to avoid laying out one document line multiple times
 		std::shared_ptr<LineLayout> ll;
+		const bool retain = retainedDraw && bufferedDraw;
+		const int widthPixmap = static_cast<int>(rcClient.Width());
+		if (retain) {
+			// Keep enough lines to scroll back and forth by a page
+			const size_t linesInClient = static_cast<size_t>(rcClient.Height() / vsDraw.lineHeight) + 1;
+			lineBitmaps.StartPaint(linesInClient * 2);
+		}
+
+		// Measure the lines needing layout together before drawing them one at a time
+		const Sci::Line linesToPaint = (static_cast<Sci::Line>(rcArea.bottom) - 1) / vsDraw.lineHeight - screenLinePaintFirst + 1;
+		const Sci::Line visibleLinePaintFirst = model.TopLineOfMain() + screenLinePaintFirst;
+		const Sci::Line visibleLinePaintEnd = std::min(visibleLinePaintFirst + linesToPaint, model.pcs->LinesDisplayed());
+		std::vector<bool> linesCopied;
+		if (retain) {
+			// Lines with retained bitmaps are copied so do not need layout
+			for (Sci::Line visibleLine = visibleLinePaintFirst; visibleLine < visibleLinePaintEnd; visibleLine++) {
+				const Sci::Line lineDoc = model.pcs->DocFromDisplay(visibleLine);
+				const int subLine = static_cast<int>(visibleLine - model.pcs->DisplayFromDoc(lineDoc));
+				const Range rangeLine(model.pdoc->LineStart(lineDoc), model.pdoc->LineStart(lineDoc + 1));
+				const size_t key = RetainedKey(model, *this, rangeLine, lineDoc, lineCaret, caretOffset);
+				linesCopied.push_back(lineBitmaps.Find(lineDoc, subLine, key, xStart, widthPixmap, vsDraw.lineHeight) != nullptr);
+			}
+		}
+		LayoutVisibleLines(model, surface, vsDraw, visibleLinePaintFirst, visibleLinePaintEnd, linesCopied);
+#if defined(TIME_PAINTING)
+		durLayout += epWhole.Duration();
+#endif
+
 		std::vector<DrawPhase> phases;
 		if ((phasesDraw == PhasesDraw::Multiple) && !bufferedDraw) {
 			for (DrawPhase phase = DrawPhase::back; phase <= DrawPhase::carets; phase = static_cast<DrawPhase>(static_cast<int>(phase) * 2)) {
@@ -2552,20 +3320,46 @@ void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, const V
 				const Sci::Line lineStartSet = model.pcs->DisplayFromDoc(lineDoc);
 				const int subLine = static_cast<int>(visibleLine - lineStartSet);
 
+				const Point from = Point::FromInts(vsDraw.textStart - leftTextOverlap, 0);
+				const PRectangle rcCopyArea = PRectangle::FromInts(vsDraw.textStart - leftTextOverlap, yposScreen,
+					static_cast<int>(rcClient.right - vsDraw.rightMarginWidth),
+					yposScreen + vsDraw.lineHeight);
+
+				// A line drawn in an earlier paint and unchanged since is copied without layout or drawing.
+				Surface *surfaceLine = surface;
+				LineBitmapCache::Entry *retained = nullptr;
+				bool copied = false;
+				if (retain) {
+					const Range rangeLine(model.pdoc->LineStart(lineDoc), model.pdoc->LineStart(lineDoc + 1));
+					const size_t key = RetainedKey(model, *this, rangeLine, lineDoc, lineCaret, caretOffset);
+					const LineBitmapCache::Entry *found = lineBitmaps.Find(lineDoc, subLine, key, xStart, widthPixmap, vsDraw.lineHeight);
+					if (found) {
+						surfaceWindow->Copy(rcCopyArea, from, *found->pixmap);
+						lineWidthMaxSeen = std::max(lineWidthMaxSeen, found->lineWidth);
+						copied = true;
+					} else {
+						retained = lineBitmaps.Allocate(surfaceWindow, lineDoc, subLine, key, xStart, widthPixmap, vsDraw.lineHeight);
+						if (retained) {
+							surfaceLine = retained->pixmap.get();
+							surfaceLine->SetMode(model.CurrentSurfaceMode());
+						}
+					}
+				}
+
 				// Copy this line and its styles from the document into local arrays
 				// and determine the x position at which each character starts.
 #if defined(TIME_PAINTING)
 				ElapsedPeriod ep;
 #endif
-				if (lineDoc != lineDocPrevious) {
+				if (!copied && (lineDoc != lineDocPrevious)) {
 					ll = RetrieveLineLayout(lineDoc, model);
-					LayoutLine(model, surface, vsDraw, ll.get(), model.wrapWidth);
+					LayoutLine(model, surfaceLine, vsDraw, ll.get(), model.wrapWidth);
 					lineDocPrevious = lineDoc;
 				}
 #if defined(TIME_PAINTING)
 				durLayout += ep.Duration(true);
 #endif
-				if (ll) {
+				if (ll && !copied) {
 					ll->containsCaret = vsDraw.selection.visible && (lineDoc == lineCaret)
 						&& (ll->lines == 1 || !vsDraw.caretLine.subLine || ll->InLine(caretOffset, subLine));
 
@@ -2585,7 +3379,7 @@ void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, const V
 						PRectangle rcSpacer = rcLine;
 						rcSpacer.right = rcSpacer.left;
 						rcSpacer.left -= 1;
-						surface->FillRectangleAligned(rcSpacer, Fill(vsDraw.styles[StyleDefault].back));
+						surfaceLine->FillRectangleAligned(rcSpacer, Fill(vsDraw.styles[StyleDefault].back));
 					}
 
 					if (model.BidirectionalEnabled()) {
@@ -2593,7 +3387,7 @@ void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, const V
 						UpdateBidiData(model, vsDraw, ll.get());
 					}
 
-					DrawLine(surface, model, vsDraw, ll.get(), lineDoc, visibleLine, xStart, rcLine, subLine, phase);
+					DrawLine(surfaceLine, model, vsDraw, ll.get(), lineDoc, visibleLine, xStart, rcLine, subLine, phase);
 #if defined(TIME_PAINTING)
 					durPaint += ep.Duration(true);
 #endif
@@ -2601,27 +3395,29 @@ void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, const V
 					ll->RestoreBracesHighlight(rangeLine, model.braces, bracesIgnoreStyle);
 
 					if (FlagSet(phase, DrawPhase::foldLines)) {
-						DrawFoldLines(surface, model, vsDraw, ll.get(), lineDoc, rcLine, subLine);
+						DrawFoldLines(surfaceLine, model, vsDraw, ll.get(), lineDoc, rcLine, subLine);
 					}
 
 					if (FlagSet(phase, DrawPhase::carets)) {
-						DrawCarets(surface, model, vsDraw, ll.get(), lineDoc, xStart, rcLine, subLine);
+						DrawCarets(surfaceLine, model, vsDraw, ll.get(), lineDoc, xStart, rcLine, subLine);
 					}
 
 					if (bufferedDraw) {
-						const Point from = Point::FromInts(vsDraw.textStart - leftTextOverlap, 0);
-						const PRectangle rcCopyArea = PRectangle::FromInts(vsDraw.textStart - leftTextOverlap, yposScreen,
-							static_cast<int>(rcClient.right - vsDraw.rightMarginWidth),
-							yposScreen + vsDraw.lineHeight);
-						pixmapLine->FlushDrawing();
-						surfaceWindow->Copy(rcCopyArea, from, *pixmapLine);
+						surfaceLine->FlushDrawing();
+						surfaceWindow->Copy(rcCopyArea, from, *surfaceLine);
 					}
 
 					lineWidthMaxSeen = std::max(
 						lineWidthMaxSeen, static_cast<int>(ll->positions[ll->numCharsInLine]));
+					if (retained) {
+						retained->lineWidth = static_cast<int>(ll->positions[ll->numCharsInLine]);
+					}
 #if defined(TIME_PAINTING)
 					durCopy += ep.Duration(true);
 #endif
+				} else if (retained) {
+					// Nothing drawn so do not reuse
+					retained->lineDoc = -1;
 				}
 
 				if (!bufferedDraw) {
@@ -45,6 +45,39 @@ typedef void (*DrawTabArrowFn)(Surface *surface, PRectangle rcTab, int ymid,
 	const ViewStyle &vsDraw, Stroke stroke);
 
 class LineTabstops;
+class ThreadPool;
+
+/**
+* Retains the drawing of lines in buffered mode so unchanged lines can be copied to the
+* window instead of being drawn again when scrolling or when other lines change.
+* Entries are invalidated by the owner when a line's content changes. Selection, caret,
+* and hover state are compared through a key computed each time the line is painted.
+*/
+class LineBitmapCache {
+public:
+	struct Entry {
+		Sci::Line lineDoc = -1;
+		int subLine = 0;
+		size_t key = 0;
+		int xStart = 0;
+		int width = 0;
+		int height = 0;
+		int lineWidth = 0;
+		unsigned int lastUsed = 0;
+		std::unique_ptr<Surface> pixmap;
+	};
+private:
+	std::vector<Entry> entries;
+	size_t capacity = 0;
+	unsigned int paintSequence = 0;
+public:
+	void Clear() noexcept;
+	void Invalidate() noexcept;
+	void InvalidateLines(Sci::Line lineDocStart, Sci::Line lineDocEnd) noexcept;
+	void StartPaint(size_t capacity_) noexcept;
+	Entry *Find(Sci::Line lineDoc, int subLine, size_t key, int xStart, int width, int height) noexcept;
+	Entry *Allocate(Surface *surfaceWindow, Sci::Line lineDoc, int subLine, size_t key, int xStart, int width, int height);
+};
 
 /**
 * EditView draws the main text area.
@@ -60,6 +93,9 @@ public:
 	/** In bufferedDraw mode, graphics operations are drawn to a pixmap and then copied to
 	* the screen. This avoids flashing but is about 30% slower. */
 	bool bufferedDraw;
+	/** In retainedDraw mode, which requires bufferedDraw, the pixmap of each line is kept
+	* in lineBitmaps and copied to the screen again while the line is unchanged. */
+	bool retainedDraw;
 	/** In phasesTwo mode, drawing is performed in two phases, first the background
 	* and then the foreground. This avoids chopping off characters that overlap the next run.
 	* In multiPhaseDraw mode, drawing is performed in multiple phases with each phase drawing
@@ -77,12 +113,24 @@ public:
 	std::unique_ptr<Surface> pixmapLine;
 	std::unique_ptr<Surface> pixmapIndentGuide;
 	std::unique_ptr<Surface> pixmapIndentGuideHighlight;
+	LineBitmapCache lineBitmaps;
 
 	LineLayoutCache llc;
 	std::unique_ptr<IPositionCache> posCache;
 
 	unsigned int maxLayoutThreads;
+	std::unique_ptr<ThreadPool> layoutPool;
 	static constexpr int bytesPerLayoutThread = 1000;
+	// Lines at least this long only remeasure segments changed by an edit.
+	static constexpr int bytesIncrementalLayout = 1000;
+	// Lines longer than lazyLayoutLength have their widths estimated and only the chunks
+	// around the caret and the visible area are measured. 0 turns this off.
+	Sci::Position lazyLayoutLength;
+	static constexpr int bytesPerLayoutChunk = 4096;
+	// Lines laid out lazily that wrapped to a different number of sublines after more chunks
+	// were measured, so their heights need updating by the owner. Only single-threaded
+	// callers of LayoutLine add to this.
+	std::vector<Sci::Line> linesRemeasured;
 
 	int tabArrowHeight; // draw arrow heads this many pixels above/below line midpoint
 	/** Some platforms, notably PLAT_CURSES, do not support Scintilla's native
@@ -118,8 +166,18 @@ public:
 	void RefreshPixMaps(Surface *surfaceWindow, const ViewStyle &vsDraw);
 
 	std::shared_ptr<LineLayout> RetrieveLineLayout(Sci::Line lineNumber, const EditModel &model);
+	void MeasureSegments(const EditModel &model, Surface *surface, const ViewStyle &vstyle,
+		LineLayout *ll, const std::vector<TextSegment> &segments, bool callerMultiThreaded);
+	void AccumulatePositions(Sci::Line line, const ViewStyle &vstyle, LineLayout *ll,
+		const std::vector<TextSegment> &segments) const;
+	bool MeasureChunksInView(const EditModel &model, Surface *surface, const ViewStyle &vstyle,
+		LineLayout *ll, bool callerMultiThreaded);
+	bool UpdateLazyLayout(const EditModel &model, Surface *surface, const ViewStyle &vstyle,
+		LineLayout *ll, int width, bool callerMultiThreaded);
 	void LayoutLine(const EditModel &model, Surface *surface, const ViewStyle &vstyle,
 		LineLayout *ll, int width, bool callerMultiThreaded=false);
+	void LayoutVisibleLines(const EditModel &model, Surface *surface, const ViewStyle &vstyle,
+		Sci::Line visibleStart, Sci::Line visibleEnd, const std::vector<bool> &linesCopied={});
 
 	static void UpdateBidiData(const EditModel &model, const ViewStyle &vstyle, LineLayout *ll);
 
@@ -14,6 +14,7 @@
 #include <cmath>
 
 #include <stdexcept>
+#include <exception>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -23,12 +24,13 @@
 #include <optional>
 #include <algorithm>
 #include <iterator>
+#include <functional>
 #include <memory>
 #include <chrono>
 #include <atomic>
 #include <mutex>
 #include <thread>
-#include <future>
+#include <condition_variable>
 
 #include "ScintillaTypes.h"
 #include "ScintillaMessages.h"
@@ -68,6 +70,8 @@
 #include "EditView.h"
 #include "Editor.h"
 #include "ElapsedPeriod.h"
+#include "ThreadPool.h"
+#include "BackgroundWrap.h"
 
 using namespace Scintilla;
 using namespace Scintilla::Internal;
@@ -178,6 +182,7 @@ Editor::Editor() : durationWrapOneByte(0.000001, 0.00000001, 0.00001) {
 
 	targetRange = SelectionSegment();
 	searchFlags = FindOption::None;
+	searchThreads = 1;
 
 	topLine = 0;
 	posTopLine = 0;
@@ -191,6 +196,7 @@ Editor::Editor() : durationWrapOneByte(0.000001, 0.00000001, 0.00001) {
 	paintAbandonedByStyling = false;
 	paintingAllText = false;
 	willRedrawAll = false;
+	redrawForScroll = false;
 	idleStyling = IdleStyling::None;
 	needIdleStyling = false;
 
@@ -203,6 +209,7 @@ Editor::Editor() : durationWrapOneByte(0.000001, 0.00000001, 0.00001) {
 	foldAutomatic = AutomaticFold::None;
 
 	convertPastes = true;
+	wrapRemainingNotified = 0;
 
 	SetRepresentations();
 }
@@ -231,6 +238,9 @@ void Editor::InvalidateStyleData() noexcept {
 	DropGraphics();
 	view.llc.Invalidate(LineLayout::ValidLevel::invalid);
 	view.posCache->Clear();
+	if (backgroundWrap) {
+		backgroundWrap->DropGraphics();
+	}
 }
 
 void Editor::InvalidateStyleRedraw() {
@@ -426,8 +436,24 @@ bool Editor::AbandonPaint() {
 	return paintState == PaintState::abandoned;
 }
 
+// Lines retained by the view must be drawn again as they have changed.
+void Editor::InvalidateRetained() noexcept {
+	if (!redrawForScroll) {
+		view.lineBitmaps.Invalidate();
+	}
+}
+
+void Editor::InvalidateRetained(PRectangle rc) {
+	if (rc.bottom > rc.top) {
+		const Sci::Line displayFirst = topLine + static_cast<Sci::Line>(std::max<XYPOSITION>(rc.top, 0) / vs.lineHeight);
+		const Sci::Line displayLast = topLine + static_cast<Sci::Line>(std::max<XYPOSITION>(rc.bottom - 1, 0) / vs.lineHeight);
+		view.lineBitmaps.InvalidateLines(pcs->DocFromDisplay(displayFirst), pcs->DocFromDisplay(displayLast) + 1);
+	}
+}
+
 void Editor::RedrawRect(PRectangle rc) {
 	//Platform::DebugPrintf("Redraw %0d,%0d - %0d,%0d\n", rc.left, rc.top, rc.right, rc.bottom);
+	InvalidateRetained(rc);
 
 	// Clip the redraw rectangle into the client area
 	const PRectangle rcClient = GetClientRectangle();
@@ -450,6 +476,7 @@ void Editor::DiscardOverdraw() {
 }
 
 void Editor::Redraw() {
+	InvalidateRetained();
 	if (redrawPendingText) {
 		return;
 	}
@@ -937,11 +964,13 @@ void Editor::ScrollTo(Sci::Line line, bool moveThumb) {
 		StyleAreaBounded(GetClientRectangle(), true);
 #ifndef UNDER_CE
 		// Perform redraw rather than scroll if many lines would be redrawn anyway.
+		redrawForScroll = true;
 		if (performBlit) {
 			ScrollText(linesToMove);
 		} else {
 			Redraw();
 		}
+		redrawForScroll = false;
 		willRedrawAll = false;
 #else
 		Redraw();
@@ -1386,7 +1415,9 @@ void Editor::SetXYScroll(XYScrollPosition newXY) {
 			}
 			SetHorizontalScrollPos();
 		}
+		redrawForScroll = true;
 		Redraw();
+		redrawForScroll = false;
 		UpdateSystemCaret();
 	}
 }
@@ -1461,6 +1492,9 @@ void Editor::NeedWrapping(Sci::Line docLineStart, Sci::Line docLineEnd) {
 	if (wrapPending.AddRange(docLineStart, docLineEnd)) {
 		view.llc.Invalidate(LineLayout::ValidLevel::positions);
 	}
+	if (backgroundWrap) {
+		backgroundWrap->NeedWrapping(docLineStart, docLineEnd);
+	}
 	// Wrap lines during idle.
 	if (Wrapping() && wrapPending.NeedsWrap()) {
 		SetIdle(true);
@@ -1480,6 +1514,29 @@ bool Editor::WrapOneLine(Surface *surface, Sci::Line lineToWrap) {
 	return pcs->SetHeight(lineToWrap, linesWrapped);
 }
 
+// Lines laid out lazily may wrap to a different number of sublines once more of their text
+// is measured, such as when painting scrolls another part into view, so update their heights.
+// Return true if any height changed.
+bool Editor::WrapLinesRemeasured(Surface *surface) {
+	std::vector<Sci::Line> lines;
+	std::swap(lines, view.linesRemeasured);
+	if (!Wrapping()) {
+		return false;
+	}
+	std::sort(lines.begin(), lines.end());
+	lines.erase(std::unique(lines.begin(), lines.end()), lines.end());
+	bool heightChanged = false;
+	for (const Sci::Line line : lines) {
+		if ((line < pdoc->LinesTotal()) && WrapOneLine(surface, line)) {
+			heightChanged = true;
+		}
+	}
+	if (heightChanged) {
+		SetScrollBars();
+	}
+	return heightChanged;
+}
+
 namespace {
 
 // Lines less than lengthToMultiThread are laid out in blocks in parallel.
@@ -1506,9 +1563,6 @@ bool Editor::WrapBlock(Surface *surface, Sci::Line lineToWrap, Sci::Line lineToW
 
 	// Wrap all the short lines in multiple threads
 
-	// If only 1 thread needed then use the main thread, else spin up multiple
-	const std::launch policy = multiThreaded ? std::launch::async : std::launch::deferred;
-
 	std::atomic<size_t> nextIndex = 0;
 
 	// Lines that are less likely to be re-examined should not be read from or written to the cache.
@@ -1522,39 +1576,38 @@ bool Editor::WrapBlock(Surface *surface, Sci::Line lineToWrap, Sci::Line lineToW
 	// Protect the line layout cache from being accessed from multiple threads simultaneously
 	std::mutex mutexRetrieve;
 
-	std::vector<std::future<void>> futures;
-	for (size_t th = 0; th < threads; th++) {
-		std::future<void> fut = std::async(policy,
-			[=, &surface, &nextIndex, &linesAfterWrap, &mutexRetrieve]() {
-			// llTemporary is reused for non-significant lines, avoiding allocation costs.
-			std::shared_ptr<LineLayout> llTemporary = std::make_shared<LineLayout>(-1, 200);
-			while (true) {
-				const size_t i = nextIndex.fetch_add(1, std::memory_order_acq_rel);
-				if (i >= linesBeingWrapped) {
-					break;
-				}
-				const Sci::Line lineNumber = lineToWrap + i;
-				const Range rangeLine = pdoc->LineRange(lineNumber);
-				const Sci::Position lengthLine = rangeLine.Length();
-				if (lengthLine < lengthToMultiThread) {
-					std::shared_ptr<LineLayout> ll;
-					if (significantLines.LineMayCache(lineNumber)) {
-						std::lock_guard<std::mutex> guard(mutexRetrieve);
-						ll = view.RetrieveLineLayout(lineNumber, *this);
-					} else {
-						ll = llTemporary;
-						ll->ReSet(lineNumber, lengthLine);
-					}
-					view.LayoutLine(*this, surface, vs, ll.get(), wrapWidth, multiThreaded);
-					linesAfterWrap[i] = ll->lines;
+	// Each thread reuses a layout for non-significant lines, avoiding allocation costs.
+	// These are kept between calls as they only hold short lines.
+	while (wrapLayouts.size() < threads) {
+		wrapLayouts.push_back(std::make_shared<LineLayout>(-1, 200));
+	}
+
+	// If only 1 thread needed then use the main thread, else use pool workers as well
+	view.layoutPool->Run(threads,
+		[=, &surface, &nextIndex, &linesAfterWrap, &mutexRetrieve](size_t thread) {
+		const std::shared_ptr<LineLayout> &llTemporary = wrapLayouts[thread];
+		while (true) {
+			const size_t i = nextIndex.fetch_add(1, std::memory_order_acq_rel);
+			if (i >= linesBeingWrapped) {
+				break;
+			}
+			const Sci::Line lineNumber = lineToWrap + i;
+			const Range rangeLine = pdoc->LineRange(lineNumber);
+			const Sci::Position lengthLine = rangeLine.Length();
+			if (lengthLine < lengthToMultiThread) {
+				std::shared_ptr<LineLayout> ll;
+				if (significantLines.LineMayCache(lineNumber)) {
+					std::lock_guard<std::mutex> guard(mutexRetrieve);
+					ll = view.RetrieveLineLayout(lineNumber, *this);
+				} else {
+					ll = llTemporary;
+					ll->ReSet(lineNumber, lengthLine);
 				}
+				view.LayoutLine(*this, surface, vs, ll.get(), wrapWidth, multiThreaded);
+				linesAfterWrap[i] = ll->lines;
 			}
-		});
-		futures.push_back(std::move(fut));
-	}
-	for (const std::future<void> &f : futures) {
-		f.wait();
-	}
+		}
+	});
 	// End of multiple threads
 
 	// Multiply duration by number of threads to produce (near) equivalence to duration if single threaded
@@ -1604,6 +1657,65 @@ bool Editor::WrapBlock(Surface *surface, Sci::Line lineToWrap, Sci::Line lineToW
 	return wrapsDone > 0;
 }
 
+// Background wrapping lays out a copy of the text so is only possible when the copy
+// would lay out the same as the document: multiple threads, thread-safe measurement,
+// no per-line tab stops, only the default line ends, and no bidirectional layout.
+// The measurement surface is created once and kept by backgroundWrap until style data is invalidated.
+bool Editor::CanWrapInBackground() {
+	if ((view.GetLayoutThreads() <= 1) || view.ldTabstops || BidirectionalEnabled() ||
+		(pdoc->GetLineEndTypesActive() != LineEndType::Default)) {
+		return false;
+	}
+	if (!backgroundWrap) {
+		backgroundWrap = std::make_unique<BackgroundWrap>();
+	}
+	if (!backgroundWrap->HasSurface()) {
+		backgroundWrap->SetSurface(CreateMeasurementSurface());
+	}
+	return backgroundWrap->ThreadSafeMeasure();
+}
+
+// Apply the results of a block wrapped on a worker thread when they are available then
+// start wrapping the next block.
+// Return true if wrapping occurred.
+bool Editor::WrapBackground(Sci::Line lineToWrap, Sci::Line lineToWrapEnd) {
+	if (!backgroundWrap) {
+		backgroundWrap = std::make_unique<BackgroundWrap>();
+	}
+	BackgroundWrap &bw = *backgroundWrap;
+	if (bw.Running()) {
+		// Briefly wait so that short blocks are applied in the current idle call
+		constexpr double secondsWait = 0.002;
+		if (!bw.Finished(secondsWait)) {
+			return false;
+		}
+		if (!bw.stale && !bw.failed && (bw.width == wrapWidth) && (bw.lineEnd <= pdoc->LinesTotal())) {
+			size_t wrapsDone = 0;
+			const size_t linesBeingWrapped = bw.linesAfterWrap.size();
+			for (size_t i = 0; i < linesBeingWrapped; i++) {
+				const Sci::Line lineNumber = bw.lineStart + i;
+				int linesWrapped = bw.linesAfterWrap[i];
+				if (vs.annotationVisible != AnnotationVisible::Hidden) {
+					linesWrapped += pdoc->AnnotationLines(lineNumber);
+				}
+				if (pcs->SetHeight(lineNumber, linesWrapped)) {
+					wrapsDone++;
+				}
+				wrapPending.Wrapped(lineNumber);
+			}
+			durationWrapOneByte.AddSample(bw.positionEnd - pdoc->LineStart(bw.lineStart), bw.duration);
+			// Lines to wrap next are chosen in a later idle call as this block may have changed them
+			return wrapsDone > 0;
+		}
+	}
+	if (!bw.HasSurface()) {
+		// Style data invalidated since CanWrapInBackground so try again in a later idle call
+		return false;
+	}
+	bw.Start(pdoc, view, vs, *reprs, wrapWidth, lineToWrap, lineToWrapEnd);
+	return false;
+}
+
 // Perform  wrapping for a subset of the lines needing wrapping.
 // wsAll: wrap all lines which need wrapping in this single call
 // wsVisible: wrap currently visible lines
@@ -1625,6 +1737,7 @@ bool Editor::WrapLines(WrapScope ws) {
 			wrapOccurred = true;
 		}
 		wrapPending.Reset();
+		backgroundWrap.reset();
 
 	} else if (wrapPending.NeedsWrap()) {
 		wrapPending.start = std::min(wrapPending.start, pdoc->LinesTotal());
@@ -1635,6 +1748,7 @@ bool Editor::WrapLines(WrapScope ws) {
 		// Decide where to start wrapping
 		Sci::Line lineToWrap = wrapPending.start;
 		Sci::Line lineToWrapEnd = std::min(wrapPending.end, pdoc->LinesTotal());
+		bool background = false;
 		const Sci::Line lineDocTop = pcs->DocFromDisplay(topLine);
 		const Sci::Line subLineTop = topLine - pcs->DisplayFromDoc(lineDocTop);
 		if (ws == WrapScope::wsVisible) {
@@ -1661,12 +1775,20 @@ bool Editor::WrapLines(WrapScope ws) {
 				return false;
 			}
 		} else if (ws == WrapScope::wsIdle) {
+			// Continue from lines wrapped around the view so it settles first.
+			lineToWrap = wrapPending.Next(lineDocTop, LinesOnScreen(), pdoc->LinesTotal());
+			background = CanWrapInBackground();
 			// Try to keep time taken by wrapping reasonable so interaction remains smooth.
-			constexpr double secondsAllowed = 0.01;
-			const size_t actionsInAllowedTime = std::clamp<Sci::Line>(
-				durationWrapOneByte.ActionsInAllowedTime(secondsAllowed),
-				0x200, 0x20000);
+			// Wrapping in the background does not delay interaction so larger blocks are used.
+			const double secondsAllowed = background ? 0.1 : 0.01;
+			const size_t actionsInAllowedTime = background ?
+				std::clamp<Sci::Line>(durationWrapOneByte.ActionsInAllowedTime(secondsAllowed), 0x2000, 0x200000) :
+				std::clamp<Sci::Line>(durationWrapOneByte.ActionsInAllowedTime(secondsAllowed), 0x200, 0x20000);
 			lineToWrapEnd = pdoc->LineFromPositionAfter(lineToWrap, actionsInAllowedTime);
+			if (lineToWrap < wrapPending.wrappedStart) {
+				// Stop before lines already wrapped
+				lineToWrapEnd = std::min(lineToWrapEnd, wrapPending.wrappedStart);
+			}
 		}
 		const Sci::Line lineEndNeedWrap = std::min(wrapPending.end, pdoc->LinesTotal());
 		lineToWrapEnd = std::min(lineToWrapEnd, lineEndNeedWrap);
@@ -1685,7 +1807,11 @@ bool Editor::WrapLines(WrapScope ws) {
 			if (surface) {
 //Platform::DebugPrintf("Wraplines: scope=%0d need=%0d..%0d perform=%0d..%0d\n", ws, wrapPending.start, wrapPending.end, lineToWrap, lineToWrapEnd);
 
-				wrapOccurred = WrapBlock(surface, lineToWrap, lineToWrapEnd);
+				if (background) {
+					wrapOccurred = WrapBackground(lineToWrap, lineToWrapEnd);
+				} else {
+					wrapOccurred = WrapBlock(surface, lineToWrap, lineToWrapEnd);
+				}
 
 				goodTopLine = pcs->DisplayFromDoc(lineDocTop) + std::min(
 					subLineTop, static_cast<Sci::Line>(pcs->GetHeight(lineDocTop)-1));
@@ -1695,6 +1821,7 @@ bool Editor::WrapLines(WrapScope ws) {
 		// If wrapping is done, bring it to resting position
 		if (wrapPending.start >= lineEndNeedWrap) {
 			wrapPending.Reset();
+			backgroundWrap.reset();
 		}
 	}
 
@@ -1704,6 +1831,10 @@ bool Editor::WrapLines(WrapScope ws) {
 		SetVerticalScrollPos();
 	}
 
+	if (ws != WrapScope::wsVisible) {
+		NotifyWrapProgress();
+	}
+
 	return wrapOccurred;
 }
 
@@ -1848,6 +1979,13 @@ void Editor::Paint(Surface *surfaceWindow, PRectangle rcArea) {
 		}
 		RefreshPixMaps(surfaceWindow);	// In case pixmaps invalidated by scrollbar change
 	}
+	// Lines measured further since they were wrapped, such as by caret movement.
+	if (WrapLinesRemeasured(surfaceWindow)) {
+		if (AbandonPaint()) {
+			return;
+		}
+		RefreshPixMaps(surfaceWindow);
+	}
 
 	if (!marginView.pixmapSelPattern->Initialised()) {
 		// When Direct2D is used, pixmap creation may fail with D2DERR_RECREATE_TARGET so
@@ -1894,6 +2032,10 @@ void Editor::Paint(Surface *surfaceWindow, PRectangle rcArea) {
 	}
 
 	view.PaintText(surfaceWindow, *this, vs, rcArea, rcClient);
+	if (WrapLinesRemeasured(surfaceWindow)) {
+		// Painting measured more of some lines so they now wrap differently
+		Redraw();
+	}
 
 	if (horizontalScrollBarVisible && trackLineWidth && (view.lineWidthMaxSeen > scrollWidth)) {
 		scrollWidth = view.lineWidthMaxSeen;
@@ -2617,6 +2759,18 @@ void Editor::NotifyZoom() {
 	NotifyParent(scn);
 }
 
+// Report the number of lines still to be wrapped when it changes.
+void Editor::NotifyWrapProgress() {
+	const Sci::Line remaining = wrapPending.Remaining(pdoc->LinesTotal());
+	if (remaining != wrapRemainingNotified) {
+		wrapRemainingNotified = remaining;
+		NotificationData scn = {};
+		scn.nmhdr.code = Notification::WrapProgress;
+		scn.line = remaining;
+		NotifyParent(scn);
+	}
+}
+
 // Notifications from document
 void Editor::NotifyModifyAttempt(Document *, void *) {
 	//Platform::DebugPrintf("** Modify Attempt\n");
@@ -2633,6 +2787,13 @@ void Editor::CheckModificationForWrap(DocModification mh) {
 		view.llc.Invalidate(LineLayout::ValidLevel::checkTextAndStyle);
 		const Sci::Line lineDoc = pdoc->SciLineFromPosition(mh.position);
 		const Sci::Line lines = std::max(static_cast<Sci::Line>(0), mh.linesAdded);
+		if (backgroundWrap) {
+			backgroundWrap->Modified(mh.position);
+		}
+		if ((mh.linesAdded != 0) && (lineDoc < wrapPending.wrappedEnd)) {
+			// Lines wrapped out of order have moved
+			wrapPending.ForgetWrapped();
+		}
 		if (Wrapping()) {
 			NeedWrapping(lineDoc, lineDoc + lines + 1);
 		}
@@ -2671,6 +2832,24 @@ constexpr Sci::Position MovePositionForDeletion(Sci::Position position, Sci::Pos
 
 void Editor::NotifyModified(Document *, DocModification mh, void *) {
 	ContainerNeedsUpdate(Update::Content);
+	// Lines retained by the view must be drawn again when their contents change
+	if (FlagSet(mh.modificationType, ModificationFlags::InsertText | ModificationFlags::DeleteText |
+		ModificationFlags::ChangeStyle | ModificationFlags::ChangeIndicator | ModificationFlags::LexerState)) {
+		if (mh.linesAdded == 0) {
+			view.lineBitmaps.InvalidateLines(pdoc->SciLineFromPosition(mh.position),
+				pdoc->SciLineFromPosition(mh.position + mh.length) + 1);
+		} else {
+			view.lineBitmaps.Invalidate();
+		}
+	}
+	if (FlagSet(mh.modificationType, ModificationFlags::ChangeMarker | ModificationFlags::ChangeFold |
+		ModificationFlags::ChangeLineState)) {
+		view.lineBitmaps.InvalidateLines(mh.line - 1, mh.line + 2);
+	}
+	if (FlagSet(mh.modificationType, ModificationFlags::ChangeAnnotation | ModificationFlags::ChangeEOLAnnotation |
+		ModificationFlags::ChangeTabStops)) {
+		view.lineBitmaps.Invalidate();
+	}
 	if (paintState == PaintState::painting) {
 		CheckForChangeOutsidePaint(Range(mh.position, mh.position + mh.length));
 	}
@@ -4155,7 +4334,7 @@ Sci::Position Editor::FindText(
 	if (!pdoc->HasCaseFolder())
 		pdoc->SetCaseFolder(CaseFolderForEncoding());
 	try {
-		const Sci::Position pos = pdoc->FindText(
+		const Sci::Position pos = pdoc->FindTextParallel(*view.layoutPool, searchThreads,
 			static_cast<Sci::Position>(ft->chrg.cpMin),
 			static_cast<Sci::Position>(ft->chrg.cpMax),
 			ft->lpstrText,
@@ -4186,7 +4365,7 @@ Sci::Position Editor::FindTextFull(
 	if (!pdoc->HasCaseFolder())
 		pdoc->SetCaseFolder(CaseFolderForEncoding());
 	try {
-		const Sci::Position pos = pdoc->FindText(
+		const Sci::Position pos = pdoc->FindTextParallel(*view.layoutPool, searchThreads,
 			ft->chrg.cpMin,
 			ft->chrg.cpMax,
 			ft->lpstrText,
@@ -4236,7 +4415,7 @@ Sci::Position Editor::SearchText(
 		pdoc->SetCaseFolder(CaseFolderForEncoding());
 	try {
 		if (iMessage == Message::SearchNext) {
-			pos = pdoc->FindText(searchAnchor, pdoc->Length(), txt,
+			pos = pdoc->FindTextParallel(*view.layoutPool, searchThreads, searchAnchor, pdoc->Length(), txt,
 					static_cast<FindOption>(wParam),
 					&lengthFound);
 		} else {
@@ -4282,7 +4461,8 @@ Sci::Position Editor::SearchInTarget(const char *text, Sci::Position length) {
 	if (!pdoc->HasCaseFolder())
 		pdoc->SetCaseFolder(CaseFolderForEncoding());
 	try {
-		const Sci::Position pos = pdoc->FindText(targetRange.start.Position(), targetRange.end.Position(), text,
+		const Sci::Position pos = pdoc->FindTextParallel(*view.layoutPool, searchThreads,
+				targetRange.start.Position(), targetRange.end.Position(), text,
 				searchFlags,
 				&lengthFound);
 		if (pos != -1) {
@@ -4296,6 +4476,21 @@ Sci::Position Editor::SearchInTarget(const char *text, Sci::Position length) {
 	}
 }
 
+Sci::Position Editor::SearchAllInTarget(const char *text, Sci::Position length) {
+	if (!pdoc->HasCaseFolder())
+		pdoc->SetCaseFolder(CaseFolderForEncoding());
+	searchAllMatches.clear();
+	try {
+		pdoc->FindAllParallel(*view.layoutPool, searchThreads, targetRange.start.Position(), targetRange.end.Position(),
+			text, searchFlags, length, searchAllMatches);
+		return searchAllMatches.size();
+	} catch (RegexError &) {
+		searchAllMatches.clear();
+		errorStatus = Status::RegEx;
+		return -1;
+	}
+}
+
 void Editor::GoToLine(Sci::Line lineNo) {
 	if (lineNo > pdoc->LinesTotal())
 		lineNo = pdoc->LinesTotal();
@@ -5371,6 +5566,9 @@ bool Editor::PaintContainsMargin() {
 }
 
 void Editor::CheckForChangeOutsidePaint(Range r) {
+	if (r.Valid()) {
+		view.lineBitmaps.InvalidateLines(pdoc->SciLineFromPosition(r.First()), pdoc->SciLineFromPosition(r.Last()) + 1);
+	}
 	if (paintState == PaintState::painting && !paintingAllText) {
 		//Platform::DebugPrintf("Checking range in paint %d-%d\n", r.start, r.end);
 		if (!r.Valid())
@@ -5446,7 +5644,7 @@ void Editor::SetDocPointer(Document *document) {
 		pdoc = document;
 	}
 	pdoc->AddRef();
-	pcs = ContractionStateCreate(pdoc->IsLarge());
+	pcs = ContractionStateCreate(pdoc->IsLarge(), pdoc->IsLinesTree());
 
 	// Ensure all positions within document
 	sel.Clear();
@@ -6439,6 +6637,30 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		PLATFORM_ASSERT(lParam);
 		return SearchInTarget(ConstCharPtrFromSPtr(lParam), PositionFromUPtr(wParam));
 
+	case Message::SearchAllInTarget:
+		PLATFORM_ASSERT(lParam);
+		return SearchAllInTarget(ConstCharPtrFromSPtr(lParam), PositionFromUPtr(wParam));
+
+	case Message::GetSearchAllRanges: {
+			if (lParam == 0) {
+				return searchAllMatches.size();
+			}
+			const size_t count = std::min(searchAllMatches.size(), static_cast<size_t>(wParam));
+			Sci::Position *ranges = static_cast<Sci::Position *>(PtrFromSPtr(lParam));
+			for (size_t i = 0; i < count; i++) {
+				ranges[i * 2] = searchAllMatches[i].start;
+				ranges[i * 2 + 1] = searchAllMatches[i].end;
+			}
+			return count;
+		}
+
+	case Message::IndicatorFillAllInTarget: {
+			PLATFORM_ASSERT(lParam);
+			const Sci::Position matches = SearchAllInTarget(ConstCharPtrFromSPtr(lParam), PositionFromUPtr(wParam));
+			pdoc->DecorationFillRanges(searchAllMatches, pdoc->decorations->GetCurrentValue());
+			return matches;
+		}
+
 	case Message::SetSearchFlags:
 		searchFlags = static_cast<FindOption>(wParam);
 		break;
@@ -6446,6 +6668,13 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 	case Message::GetSearchFlags:
 		return static_cast<sptr_t>(searchFlags);
 
+	case Message::SetSearchThreads:
+		searchThreads = std::clamp(static_cast<unsigned int>(wParam), 1U, std::thread::hardware_concurrency());
+		break;
+
+	case Message::GetSearchThreads:
+		return searchThreads;
+
 	case Message::GetTag:
 		return GetTag(CharPtrFromSPtr(lParam), static_cast<int>(wParam));
 
@@ -6968,6 +7197,15 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 	case Message::GetBufferedDraw:
 		return view.bufferedDraw;
 
+	case Message::SetRetainedDraw:
+		view.retainedDraw = wParam != 0;
+		view.lineBitmaps.Clear();
+		Redraw();
+		break;
+
+	case Message::GetRetainedDraw:
+		return view.retainedDraw;
+
 #ifdef INCLUDE_DEPRECATED_FEATURES
 	case SCI_GETTWOPHASEDRAW:
 		return view.phasesDraw == EditView::phasesTwo;
@@ -7152,7 +7390,7 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		return static_cast<sptr_t>(vs.wrap.indentMode);
 
 	case Message::SetLayoutCache:
-		if (static_cast<LineCache>(wParam) <= LineCache::Document) {
+		if (static_cast<LineCache>(wParam) <= LineCache::DocumentBounded) {
 			view.llc.SetLevel(static_cast<LineCache>(wParam));
 		}
 		break;
@@ -7160,6 +7398,16 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 	case Message::GetLayoutCache:
 		return static_cast<sptr_t>(view.llc.GetLevel());
 
+	case Message::SetLayoutCacheMemoryLimit:
+		view.llc.SetMemoryLimit(wParam);
+		break;
+
+	case Message::GetLayoutCacheMemoryLimit:
+		return view.llc.GetMemoryLimit();
+
+	case Message::GetLayoutCacheMemory:
+		return view.llc.MemoryUse();
+
 	case Message::SetPositionCache:
 		view.posCache->SetSize(wParam);
 		break;
@@ -7167,6 +7415,27 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 	case Message::GetPositionCache:
 		return view.posCache->GetSize();
 
+	case Message::SetPositionCacheKeyLength:
+		view.posCache->SetKeyLength(wParam);
+		break;
+
+	case Message::GetPositionCacheKeyLength:
+		return view.posCache->GetKeyLength();
+
+	case Message::SetPositionCacheAssociativity:
+		view.posCache->SetAssociativity(wParam);
+		break;
+
+	case Message::GetPositionCacheAssociativity:
+		return view.posCache->GetAssociativity();
+
+	case Message::GetPositionCacheStatistic:
+		return view.posCache->Statistic(static_cast<PositionCacheStatistic>(wParam));
+
+	case Message::GetShapedTextCacheStatistic:
+		// Implemented by platform layers that cache shaped text
+		return 0;
+
 	case Message::SetLayoutThreads:
 		view.SetLayoutThreads(static_cast<unsigned int>(wParam));
 		break;
@@ -7174,6 +7443,16 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 	case Message::GetLayoutThreads:
 		return view.GetLayoutThreads();
 
+	case Message::SetLazyLayoutLength:
+		if (view.lazyLayoutLength != PositionFromUPtr(wParam)) {
+			view.lazyLayoutLength = PositionFromUPtr(wParam);
+			InvalidateStyleRedraw();
+		}
+		break;
+
+	case Message::GetLazyLayoutLength:
+		return view.lazyLayoutLength;
+
 	case Message::SetScrollWidth:
 		PLATFORM_ASSERT(wParam > 0);
 		if ((wParam > 0) && (wParam != static_cast<unsigned int>(scrollWidth))) {
@@ -8330,7 +8609,7 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 			Document *doc = new Document(static_cast<DocumentOption>(lParam));
 			doc->AddRef();
 			doc->Allocate(PositionFromUPtr(wParam));
-			pcs = ContractionStateCreate(pdoc->IsLarge());
+			pcs = ContractionStateCreate(pdoc->IsLarge(), pdoc->IsLinesTree());
 			return SPtrFromPtr(doc->AsDocumentEditable());
 		}
 
@@ -8350,7 +8629,7 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 			doc->AddRef();
 			doc->Allocate(PositionFromUPtr(wParam));
 			doc->SetUndoCollection(false);
-			pcs = ContractionStateCreate(pdoc->IsLarge());
+			pcs = ContractionStateCreate(pdoc->IsLarge(), pdoc->IsLinesTree());
 			return reinterpret_cast<sptr_t>(static_cast<ILoader *>(doc));
 		}
 
@@ -115,21 +115,73 @@ struct WrapPending {
 	enum { lineLarge = 0x7ffffff };
 	Sci::Line start;	// When there are wraps pending, will be in document range
 	Sci::Line end;	// May be lineLarge to indicate all of document after start
+	// Lines inside start..end already wrapped out of order, commonly those shown after scrolling.
+	// These are skipped when start reaches them.
+	Sci::Line wrappedStart;
+	Sci::Line wrappedEnd;
 	WrapPending() noexcept {
 		start = lineLarge;
 		end = lineLarge;
+		wrappedStart = lineLarge;
+		wrappedEnd = lineLarge;
 	}
 	void Reset() noexcept {
 		start = lineLarge;
 		end = lineLarge;
+		ForgetWrapped();
+	}
+	void ForgetWrapped() noexcept {
+		wrappedStart = lineLarge;
+		wrappedEnd = lineLarge;
+	}
+	bool HasWrapped() const noexcept {
+		return wrappedStart < wrappedEnd;
 	}
 	void Wrapped(Sci::Line line) noexcept {
-		if (start == line)
+		if (start == line) {
 			start++;
+			if (start == wrappedStart) {
+				start = wrappedEnd;
+				ForgetWrapped();
+			}
+		} else if ((line > start) && (line < end)) {
+			if (!HasWrapped()) {
+				wrappedStart = line;
+				wrappedEnd = line + 1;
+			} else if (line == wrappedEnd) {
+				wrappedEnd++;
+			} else if (line + 1 == wrappedStart) {
+				wrappedStart--;
+			}
+		}
 	}
 	bool NeedsWrap() const noexcept {
 		return start < end;
 	}
+	bool NeedsWrap(Sci::Line line) const noexcept {
+		return (line >= start) && (line < end) && !((line >= wrappedStart) && (line < wrappedEnd));
+	}
+	// Number of lines still to be wrapped in a document with linesTotal lines.
+	Sci::Line Remaining(Sci::Line linesTotal) const noexcept {
+		const Sci::Line endDocument = std::min<Sci::Line>(end, linesTotal);
+		Sci::Line remaining = std::max<Sci::Line>(endDocument - start, 0);
+		if (HasWrapped()) {
+			remaining -= std::max<Sci::Line>(std::min(wrappedEnd, endDocument) - wrappedStart, 0);
+		}
+		return std::max<Sci::Line>(remaining, 0);
+	}
+	// Choose where idle wrapping continues: after lines already wrapped out of order as
+	// those are near the view, else near lineNear, else from start.
+	Sci::Line Next(Sci::Line lineNear, Sci::Line around, Sci::Line linesTotal) const noexcept {
+		const Sci::Line endDocument = std::min<Sci::Line>(end, linesTotal);
+		if (HasWrapped()) {
+			return (wrappedEnd < endDocument) ? wrappedEnd : start;
+		}
+		if (NeedsWrap(lineNear) && (lineNear < endDocument)) {
+			return std::max(start, lineNear - around);
+		}
+		return start;
+	}
 	bool AddRange(Sci::Line lineStart, Sci::Line lineEnd) noexcept {
 		const bool neededWrap = NeedsWrap();
 		bool changed = false;
@@ -141,6 +193,20 @@ struct WrapPending {
 			end = lineEnd;
 			changed = true;
 		}
+		if (!neededWrap) {
+			ForgetWrapped();
+		} else if ((lineStart < wrappedEnd) && (lineEnd > wrappedStart)) {
+			// Range splits lines wrapped out of order so keep the larger part still wrapped
+			const Sci::Line wrappedBefore = lineStart - wrappedStart;
+			const Sci::Line wrappedAfter = wrappedEnd - lineEnd;
+			if ((wrappedBefore <= 0) && (wrappedAfter <= 0)) {
+				ForgetWrapped();
+			} else if (wrappedBefore >= wrappedAfter) {
+				wrappedEnd = lineStart;
+			} else {
+				wrappedStart = lineEnd;
+			}
+		}
 		return changed;
 	}
 };
@@ -178,6 +244,8 @@ constexpr XYScrollOptions operator|(XYScrollOptions a, XYScrollOptions b) noexce
 	return static_cast<XYScrollOptions>(static_cast<int>(a) | static_cast<int>(b));
 }
 
+class BackgroundWrap;
+
 /**
  */
 class Editor : public EditModel, public DocWatcher {
@@ -250,6 +318,8 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	Sci::Position wordSelectInitialCaretPos;
 	SelectionSegment targetRange;
 	Scintilla::FindOption searchFlags;
+	std::vector<Range> searchAllMatches;
+	unsigned int searchThreads;
 	Sci::Line topLine;
 	Sci::Position posTopLine;
 	Sci::Position lengthForEncode;
@@ -261,6 +331,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	PRectangle rcPaint;
 	bool paintingAllText;
 	bool willRedrawAll;
+	bool redrawForScroll;	// Redraw only moves lines so retained lines remain valid
 	WorkNeeded workNeeded;
 	Scintilla::IdleStyling idleStyling;
 	bool needIdleStyling;
@@ -283,6 +354,11 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	// Wrapping support
 	WrapPending wrapPending;
 	ActionDuration durationWrapOneByte;
+	// Layouts of lines not worth caching, one for each wrapping thread
+	std::vector<std::shared_ptr<LineLayout>> wrapLayouts;
+	// Wraps blocks of lines on a worker thread when idle
+	std::unique_ptr<BackgroundWrap> backgroundWrap;
+	Sci::Line wrapRemainingNotified;
 
 	bool convertPastes;
 
@@ -328,6 +404,8 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	void SetTopLine(Sci::Line topLineNew);
 
 	virtual bool AbandonPaint();
+	void InvalidateRetained() noexcept;
+	void InvalidateRetained(PRectangle rc);
 	virtual void RedrawRect(PRectangle rc);
 	virtual void DiscardOverdraw();
 	virtual void Redraw();
@@ -401,7 +479,10 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	bool Wrapping() const noexcept;
 	void NeedWrapping(Sci::Line docLineStart=0, Sci::Line docLineEnd=WrapPending::lineLarge);
 	bool WrapOneLine(Surface *surface, Sci::Line lineToWrap);
+	bool WrapLinesRemeasured(Surface *surface);
 	bool WrapBlock(Surface *surface, Sci::Line lineToWrap, Sci::Line lineToWrapEnd);
+	bool CanWrapInBackground();
+	bool WrapBackground(Sci::Line lineToWrap, Sci::Line lineToWrapEnd);
 	enum class WrapScope {wsAll, wsVisible, wsIdle};
 	bool WrapLines(WrapScope ws);
 	void LinesJoin();
@@ -469,6 +550,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	void NotifyNeedShown(Sci::Position pos, Sci::Position len);
 	void NotifyDwelling(Point pt, bool state);
 	void NotifyZoom();
+	void NotifyWrapProgress();
 
 	void NotifyModifyAttempt(Document *document, void *userData) override;
 	void NotifySavePoint(Document *document, void *userData, bool atSavePoint) override;
@@ -515,6 +597,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	void SearchAnchor() noexcept;
 	Sci::Position SearchText(Scintilla::Message iMessage, Scintilla::uptr_t wParam, Scintilla::sptr_t lParam);
 	Sci::Position SearchInTarget(const char *text, Sci::Position length);
+	Sci::Position SearchAllInTarget(const char *text, Sci::Position length);
 	void GoToLine(Sci::Line lineNo);
 
 	virtual void CopyToClipboard(const SelectionText &selectedText) = 0;
@@ -0,0 +1,1622 @@
+// Scintilla source code edit control
+/** @file LinearRegex.cxx
+ ** Regular expression search that takes time linear in the length of the text.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+// The expression is parsed into a tree which is compiled into two programs for a
+// nondeterministic automaton: one that matches forwards and records the positions of groups
+// and one that matches the reversed expression backwards.
+// The programs are run as lazily built deterministic automata where each state is the set of
+// program positions that are active after reading some text. Each state records for each byte
+// the state that follows so, once built, a state costs one table lookup per byte of text.
+// Bytes that are treated the same by every part of the program share one column of the table.
+// Text is read a segment at a time from the document so there is no call per byte.
+// Only when the expression contains groups is the nondeterministic program simulated
+// over the matched text to find the groups.
+
+#include <cstddef>
+#include <cstdlib>
+#include <cassert>
+#include <cstring>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <map>
+#include <forward_list>
+#include <optional>
+#include <algorithm>
+#include <memory>
+
+#include "ScintillaTypes.h"
+#include "ILoader.h"
+#include "ILexer.h"
+
+#include "Debugging.h"
+
+#include "CharacterType.h"
+#include "CharacterCategoryMap.h"
+#include "Position.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "CellBuffer.h"
+#include "PerLine.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+#include "LinearRegex.h"
+#include "UniConversion.h"
+
+using namespace Scintilla;
+using namespace Scintilla::Internal;
+
+namespace {
+
+// Limits to stop expressions using too much memory or stack.
+constexpr int repeatLimit = 1000;
+constexpr int nestingLimit = 1000;
+constexpr size_t instructionLimit = 0x10000;
+// States kept by each automaton before they are discarded and built again.
+constexpr size_t stateLimit = 0x1000;
+
+constexpr int unbounded = -1;
+
+using ByteSet = std::array<bool, 256>;
+
+// Inclusive range of characters. Characters are code points for UTF-8, lead byte * 256 +
+// trail byte for double byte characters in DBCS and otherwise bytes.
+struct Interval {
+	int first;
+	int last;
+};
+using Intervals = std::vector<Interval>;
+
+// The kind of character on one side of a position for checking assertions.
+enum class Side : unsigned char { Edge, CR, LF, Word, Other };
+
+enum class Assertion { LineStart, LineEnd, WordBoundary, NotWordBoundary, WordStart, WordEnd };
+
+bool AssertionHolds(Assertion assertion, Side before, Side after) noexcept {
+	const bool wordBefore = before == Side::Word;
+	const bool wordAfter = after == Side::Word;
+	switch (assertion) {
+	case Assertion::LineStart:
+		return (before == Side::Edge) || (before == Side::LF) || ((before == Side::CR) && (after != Side::LF));
+	case Assertion::LineEnd:
+		return (after == Side::Edge) || (after == Side::CR) || ((after == Side::LF) && (before != Side::CR));
+	case Assertion::WordBoundary:
+		return wordBefore != wordAfter;
+	case Assertion::NotWordBoundary:
+		return wordBefore == wordAfter;
+	case Assertion::WordStart:
+		return !wordBefore && wordAfter;
+	case Assertion::WordEnd:
+		return wordBefore && !wordAfter;
+	}
+	return false;
+}
+
+enum class Op : unsigned char { Bytes, Split, Jump, Save, Assert, Match };
+
+// Bytes: consume a byte in sets[x]. Split: continue at x, preferred, and y. Jump: continue at x.
+// Save: record position in slot x. Assert: check Assertion x.
+struct Instruction {
+	Op op;
+	int x;
+	int y;
+};
+using Code = std::vector<Instruction>;
+
+// Options that affect how the expression is compiled.
+struct Encoding {
+	int codePage = 0;
+	bool caseSensitive = true;
+	ByteSet wordBytes {};
+	ByteSet leadBytes {};
+	bool UTF8() const noexcept {
+		return codePage == CpUtf8;
+	}
+	bool DBCS() const noexcept {
+		return codePage && !UTF8();
+	}
+	int MaxCharacter() const noexcept {
+		return UTF8() ? 0x10FFFF : (DBCS() ? 0xFFFF : 0xFF);
+	}
+	// Greatest character encoded as one byte
+	int MaxSingle() const noexcept {
+		return UTF8() ? 0x7F : 0xFF;
+	}
+};
+
+}
+
+namespace Scintilla::Internal {
+
+struct RegexProgram {
+	std::vector<ByteSet> sets;
+	Code forward;
+	Code reversed;
+	// Number of tags including the whole match as tag 0
+	int tags = 1;
+	bool dbcs = false;
+	ByteSet leadBytes {};
+	std::array<Side, 256> sides {};
+	// Bytes in the same class are treated identically by sets and assertions
+	std::array<unsigned char, 256> byteClasses {};
+	int classes = 0;
+
+	Side SideOf(unsigned char ch) const noexcept {
+		return sides[ch];
+	}
+};
+
+}
+
+namespace {
+
+enum class NodeKind { Empty, Bytes, Sequence, Alternation, Repetition, Group, Assert };
+
+struct Node {
+	NodeKind kind = NodeKind::Empty;
+	int value = 0;	// Set index, tag, or assertion
+	int minimum = 0;
+	int maximum = 0;
+	std::vector<Node> children;
+	explicit Node(NodeKind kind_=NodeKind::Empty, int value_=0) noexcept : kind(kind_), value(value_) {
+	}
+};
+
+[[noreturn]] void Fail() {
+	throw RegexError();
+}
+
+constexpr int HexValue(char ch) noexcept {
+	if (IsADigit(ch)) {
+		return ch - '0';
+	}
+	return MakeLowerCase(ch) - 'a' + 10;
+}
+
+Intervals Normalized(Intervals intervals) {
+	std::sort(intervals.begin(), intervals.end(), [](const Interval &a, const Interval &b) noexcept {
+		return a.first < b.first;
+	});
+	Intervals merged;
+	for (const Interval &interval : intervals) {
+		if (!merged.empty() && (interval.first <= merged.back().last + 1)) {
+			merged.back().last = std::max(merged.back().last, interval.last);
+		} else {
+			merged.push_back(interval);
+		}
+	}
+	return merged;
+}
+
+// Intervals must be normalized.
+Intervals Complemented(const Intervals &intervals, int maxCharacter) {
+	Intervals complement;
+	int next = 0;
+	for (const Interval &interval : intervals) {
+		if (interval.first > next) {
+			complement.push_back({ next, interval.first - 1 });
+		}
+		next = interval.last + 1;
+	}
+	if (next <= maxCharacter) {
+		complement.push_back({ next, maxCharacter });
+	}
+	return complement;
+}
+
+// Intervals must be normalized.
+Intervals Subtracted(const Intervals &intervals, Interval removed) {
+	Intervals remaining;
+	for (const Interval &interval : intervals) {
+		if ((interval.last < removed.first) || (interval.first > removed.last)) {
+			remaining.push_back(interval);
+			continue;
+		}
+		if (interval.first < removed.first) {
+			remaining.push_back({ interval.first, removed.first - 1 });
+		}
+		if (interval.last > removed.last) {
+			remaining.push_back({ removed.last + 1, interval.last });
+		}
+	}
+	return remaining;
+}
+
+// Case insensitivity only applies to ASCII letters.
+Intervals WithCaseVariants(const Intervals &intervals) {
+	Intervals variants = intervals;
+	for (const Interval &interval : intervals) {
+		const int lowerFirst = std::max(interval.first, static_cast<int>('a'));
+		const int lowerLast = std::min(interval.last, static_cast<int>('z'));
+		if (lowerFirst <= lowerLast) {
+			variants.push_back({ lowerFirst - 'a' + 'A', lowerLast - 'a' + 'A' });
+		}
+		const int upperFirst = std::max(interval.first, static_cast<int>('A'));
+		const int upperLast = std::min(interval.last, static_cast<int>('Z'));
+		if (upperFirst <= upperLast) {
+			variants.push_back({ upperFirst - 'A' + 'a', upperLast - 'A' + 'a' });
+		}
+	}
+	return variants;
+}
+
+struct ByteRange {
+	unsigned char first;
+	unsigned char last;
+};
+using ByteSequence = std::vector<ByteRange>;
+
+// Split a range of code points into sequences of byte ranges that match exactly the
+// UTF-8 encodings of that range.
+void SplitUTF8(int first, int last, std::vector<ByteSequence> &sequences) {
+	if (first > last) {
+		return;
+	}
+	// Divide where the length of the encoding changes
+	for (const int boundary : { 0x7F, 0x7FF, 0xFFFF }) {
+		if ((first <= boundary) && (boundary < last)) {
+			SplitUTF8(first, boundary, sequences);
+			SplitUTF8(boundary + 1, last, sequences);
+			return;
+		}
+	}
+	// Divide until all but one byte are shared or cover their whole continuation range
+	for (int i = 1; i < UTF8MaxBytes; i++) {
+		const int mask = (1 << (6 * i)) - 1;
+		if ((first & ~mask) != (last & ~mask)) {
+			if ((first & mask) != 0) {
+				SplitUTF8(first, first | mask, sequences);
+				SplitUTF8((first | mask) + 1, last, sequences);
+				return;
+			}
+			if ((last & mask) != mask) {
+				SplitUTF8(first, (last & ~mask) - 1, sequences);
+				SplitUTF8(last & ~mask, last, sequences);
+				return;
+			}
+		}
+	}
+	char encodedFirst[UTF8MaxBytes + 1] {};
+	char encodedLast[UTF8MaxBytes + 1] {};
+	UTF8FromUTF32Character(first, encodedFirst);
+	UTF8FromUTF32Character(last, encodedLast);
+	const int width = UTF8BytesOfLead[static_cast<unsigned char>(encodedFirst[0])];
+	ByteSequence sequence;
+	for (int i = 0; i < width; i++) {
+		sequence.push_back({ static_cast<unsigned char>(encodedFirst[i]), static_cast<unsigned char>(encodedLast[i]) });
+	}
+	sequences.push_back(sequence);
+}
+
+/**
+ * Parses an extended regular expression into a tree of Nodes.
+ * Sets of bytes are added to the program as they are found.
+ */
+class Parser {
+	std::string_view pattern;
+	size_t position = 0;
+	int nesting = 0;
+	const Encoding &encoding;
+	RegexProgram &program;
+
+	bool AtEnd() const noexcept {
+		return position >= pattern.length();
+	}
+	char Peek() const noexcept {
+		return AtEnd() ? '\0' : pattern[position];
+	}
+
+	Node Alternation();
+	Node Sequence();
+	Node Atom();
+	Node Escape();
+	Node Bracket();
+	bool Quantifier(int &minimum, int &maximum);
+	int Count();
+	int Character();
+	int EscapedCharacter();
+	Intervals Shorthand(char letter) const;
+	Node BytesNode(const ByteSet &bytes);
+	Node Class(Intervals intervals, bool negated=false);
+public:
+	Parser(std::string_view pattern_, const Encoding &encoding_, RegexProgram &program_) noexcept :
+		pattern(pattern_), encoding(encoding_), program(program_) {
+	}
+	Node Parse();
+};
+
+Node Parser::Parse() {
+	Node root = Alternation();
+	if (!AtEnd()) {
+		// Unbalanced ')'
+		Fail();
+	}
+	return root;
+}
+
+Node Parser::Alternation() {
+	Node alternation(NodeKind::Alternation);
+	alternation.children.push_back(Sequence());
+	while (Peek() == '|') {
+		position++;
+		alternation.children.push_back(Sequence());
+	}
+	if (alternation.children.size() == 1) {
+		return std::move(alternation.children.front());
+	}
+	return alternation;
+}
+
+Node Parser::Sequence() {
+	Node sequence(NodeKind::Sequence);
+	while (!AtEnd() && (Peek() != '|') && (Peek() != ')')) {
+		Node atom = Atom();
+		int minimum = 0;
+		int maximum = 0;
+		while (Quantifier(minimum, maximum)) {
+			Node repetition(NodeKind::Repetition);
+			repetition.minimum = minimum;
+			repetition.maximum = maximum;
+			repetition.children.push_back(std::move(atom));
+			atom = std::move(repetition);
+		}
+		sequence.children.push_back(std::move(atom));
+	}
+	return sequence;
+}
+
+Node Parser::Atom() {
+	switch (Peek()) {
+	case '(': {
+			position++;
+			nesting++;
+			if (nesting > nestingLimit) {
+				Fail();
+			}
+			int tag = 0;
+			if (pattern.substr(position, 2) == "?:") {
+				position += 2;
+			} else if (program.tags < LinearRegex::maxTag) {
+				tag = program.tags++;
+			}
+			Node group(NodeKind::Group, tag);
+			group.children.push_back(Alternation());
+			if (Peek() != ')') {
+				Fail();
+			}
+			position++;
+			nesting--;
+			return group;
+		}
+	case '*':
+	case '+':
+	case '?':
+		// Nothing to repeat
+		Fail();
+	case '^':
+		position++;
+		return Node(NodeKind::Assert, static_cast<int>(Assertion::LineStart));
+	case '$':
+		position++;
+		return Node(NodeKind::Assert, static_cast<int>(Assertion::LineEnd));
+	case '.':
+		position++;
+		return Class({}, true);
+	case '[':
+		return Bracket();
+	case '\\':
+		position++;
+		return Escape();
+	default: {
+			const int ch = Character();
+			return Class({ { ch, ch } });
+		}
+	}
+}
+
+Node Parser::Escape() {
+	if (AtEnd()) {
+		return Class({ { '\\', '\\' } });
+	}
+	const char letter = Peek();
+	switch (letter) {
+	case 'b':
+		position++;
+		return Node(NodeKind::Assert, static_cast<int>(Assertion::WordBoundary));
+	case 'B':
+		position++;
+		return Node(NodeKind::Assert, static_cast<int>(Assertion::NotWordBoundary));
+	case '<':
+		position++;
+		return Node(NodeKind::Assert, static_cast<int>(Assertion::WordStart));
+	case '>':
+		position++;
+		return Node(NodeKind::Assert, static_cast<int>(Assertion::WordEnd));
+	case 'd':
+	case 'D':
+	case 's':
+	case 'S':
+	case 'w':
+	case 'W':
+		position++;
+		return Class(Shorthand(letter));
+	default:
+		if (letter >= '1' && letter <= '9') {
+			// Back references can not be matched in linear time
+			Fail();
+		}
+		const int ch = EscapedCharacter();
+		return Class({ { ch, ch } });
+	}
+}
+
+Node Parser::Bracket() {
+	position++;	// '['
+	bool negated = false;
+	if (Peek() == '^') {
+		negated = true;
+		position++;
+	}
+	Intervals intervals;
+	bool first = true;
+	while (true) {
+		if (AtEnd()) {
+			Fail();
+		}
+		if ((Peek() == ']') && !first) {
+			position++;
+			break;
+		}
+		first = false;
+		int low = 0;
+		if (Peek() == '\\') {
+			position++;
+			if (AtEnd()) {
+				Fail();
+			}
+			const char letter = Peek();
+			if (std::strchr("dDsSwW", letter)) {
+				position++;
+				const Intervals shorthand = Shorthand(letter);
+				intervals.insert(intervals.end(), shorthand.begin(), shorthand.end());
+				continue;
+			}
+			if (letter == 'b') {
+				position++;
+				low = '\b';
+			} else {
+				low = EscapedCharacter();
+			}
+		} else {
+			low = Character();
+		}
+		int high = low;
+		if ((Peek() == '-') && (position + 1 < pattern.length()) && (pattern[position + 1] != ']')) {
+			position++;
+			if (Peek() == '\\') {
+				position++;
+				if (AtEnd()) {
+					Fail();
+				}
+				high = EscapedCharacter();
+			} else {
+				high = Character();
+			}
+			if (high < low) {
+				Fail();
+			}
+		}
+		intervals.push_back({ low, high });
+	}
+	return Class(intervals, negated);
+}
+
+bool Parser::Quantifier(int &minimum, int &maximum) {
+	switch (Peek()) {
+	case '*':
+		position++;
+		minimum = 0;
+		maximum = unbounded;
+		return true;
+	case '+':
+		position++;
+		minimum = 1;
+		maximum = unbounded;
+		return true;
+	case '?':
+		position++;
+		minimum = 0;
+		maximum = 1;
+		return true;
+	case '{':
+		// '{' not followed by a count is literal
+		if ((position + 1 >= pattern.length()) || !IsADigit(pattern[position + 1])) {
+			return false;
+		}
+		position++;
+		minimum = Count();
+		maximum = minimum;
+		if (Peek() == ',') {
+			position++;
+			maximum = (Peek() == '}') ? unbounded : Count();
+		}
+		if (Peek() != '}') {
+			Fail();
+		}
+		position++;
+		if ((maximum != unbounded) && (maximum < minimum)) {
+			Fail();
+		}
+		return true;
+	default:
+		return false;
+	}
+}
+
+int Parser::Count() {
+	if (!IsADigit(Peek())) {
+		Fail();
+	}
+	int count = 0;
+	while (IsADigit(Peek())) {
+		count = count * 10 + (Peek() - '0');
+		if (count > repeatLimit) {
+			Fail();
+		}
+		position++;
+	}
+	return count;
+}
+
+int Parser::Character() {
+	const unsigned char lead = pattern[position];
+	if (encoding.UTF8() && !UTF8IsAscii(lead)) {
+		const int classified = UTF8Classify(pattern.substr(position));
+		if (classified & UTF8MaskInvalid) {
+			Fail();
+		}
+		const int character = UnicodeFromUTF8(reinterpret_cast<const unsigned char *>(pattern.data() + position));
+		position += classified & UTF8MaskWidth;
+		return character;
+	}
+	if (encoding.DBCS() && encoding.leadBytes[lead] && (position + 1 < pattern.length())) {
+		const unsigned char trail = pattern[position + 1];
+		position += 2;
+		return (lead << 8) | trail;
+	}
+	position++;
+	return lead;
+}
+
+int Parser::EscapedCharacter() {
+	const char letter = Peek();
+	switch (letter) {
+	case 'a':
+		position++;
+		return '\a';
+	case 'f':
+		position++;
+		return '\f';
+	case 'n':
+		position++;
+		return '\n';
+	case 'r':
+		position++;
+		return '\r';
+	case 't':
+		position++;
+		return '\t';
+	case 'v':
+		position++;
+		return '\v';
+	case 'x':
+		if ((position + 2 < pattern.length()) && IsADigit(pattern[position + 1], 16) && IsADigit(pattern[position + 2], 16)) {
+			const int value = HexValue(pattern[position + 1]) * 16 + HexValue(pattern[position + 2]);
+			position += 3;
+			return value;
+		}
+		position++;
+		return 'x';
+	default:
+		return Character();
+	}
+}
+
+Intervals Parser::Shorthand(char letter) const {
+	Intervals intervals;
+	switch (MakeLowerCase(letter)) {
+	case 'd':
+		intervals.push_back({ '0', '9' });
+		break;
+	case 's':
+		intervals.push_back({ '\t', '\r' });
+		intervals.push_back({ ' ', ' ' });
+		break;
+	default:
+		// 'w' includes all non-ASCII characters in Unicode and DBCS
+		for (int ch = 0; ch <= encoding.MaxSingle(); ch++) {
+			if (encoding.wordBytes[ch] && !(encoding.DBCS() && encoding.leadBytes[ch])) {
+				intervals.push_back({ ch, ch });
+			}
+		}
+		if (encoding.UTF8()) {
+			intervals.push_back({ 0x80, encoding.MaxCharacter() });
+		} else if (encoding.DBCS()) {
+			intervals.push_back({ 0x100, encoding.MaxCharacter() });
+		}
+		break;
+	}
+	if (IsUpperCase(letter)) {
+		return Complemented(Normalized(intervals), encoding.MaxCharacter());
+	}
+	return intervals;
+}
+
+Node Parser::BytesNode(const ByteSet &bytes) {
+	program.sets.push_back(bytes);
+	return Node(NodeKind::Bytes, static_cast<int>(program.sets.size() - 1));
+}
+
+// Builds a node that matches any one character in intervals as bytes in the document encoding.
+// Line ends are never matched and, for UTF-8, neither are surrogates.
+Node Parser::Class(Intervals intervals, bool negated) {
+	if (!encoding.caseSensitive) {
+		intervals = WithCaseVariants(intervals);
+	}
+	intervals = Normalized(intervals);
+	if (negated) {
+		intervals = Complemented(intervals, encoding.MaxCharacter());
+	}
+	intervals = Subtracted(intervals, { '\n', '\n' });
+	intervals = Subtracted(intervals, { '\r', '\r' });
+	if (encoding.UTF8()) {
+		intervals = Subtracted(intervals, { 0xD800, 0xDFFF });
+	}
+
+	Node alternation(NodeKind::Alternation);
+	ByteSet singles {};
+	bool anySingle = false;
+	for (const Interval &interval : intervals) {
+		const int lastSingle = std::min(interval.last, encoding.MaxSingle());
+		for (int ch = interval.first; ch <= lastSingle; ch++) {
+			if (!(encoding.DBCS() && encoding.leadBytes[ch])) {
+				singles[ch] = true;
+				anySingle = true;
+			}
+		}
+	}
+	if (anySingle) {
+		alternation.children.push_back(BytesNode(singles));
+	}
+
+	if (encoding.UTF8()) {
+		std::vector<ByteSequence> sequences;
+		for (const Interval &interval : intervals) {
+			SplitUTF8(std::max(interval.first, 0x80), interval.last, sequences);
+		}
+		for (const ByteSequence &sequence : sequences) {
+			Node bytes(NodeKind::Sequence);
+			for (const ByteRange &range : sequence) {
+				ByteSet set {};
+				std::fill(set.begin() + range.first, set.begin() + range.last + 1, true);
+				bytes.children.push_back(BytesNode(set));
+			}
+			alternation.children.push_back(std::move(bytes));
+		}
+	} else if (encoding.DBCS()) {
+		// Lead bytes grouped by the range of trail bytes that follow them
+		std::map<std::pair<int, int>, ByteSet> leadsOfTrails;
+		for (const Interval &interval : intervals) {
+			const int first = std::max(interval.first, 0x100);
+			for (int lead = first >> 8; lead <= (interval.last >> 8); lead++) {
+				if (encoding.leadBytes[lead]) {
+					const int trailFirst = (lead == (first >> 8)) ? (first & 0xFF) : 0;
+					const int trailLast = (lead == (interval.last >> 8)) ? (interval.last & 0xFF) : 0xFF;
+					leadsOfTrails[{ trailFirst, trailLast }][lead] = true;
+				}
+			}
+		}
+		for (const auto &[trails, leads] : leadsOfTrails) {
+			ByteSet trailSet {};
+			std::fill(trailSet.begin() + trails.first, trailSet.begin() + trails.second + 1, true);
+			Node bytes(NodeKind::Sequence);
+			bytes.children.push_back(BytesNode(leads));
+			bytes.children.push_back(BytesNode(trailSet));
+			alternation.children.push_back(std::move(bytes));
+		}
+	}
+
+	if (alternation.children.empty()) {
+		// Can never match
+		return BytesNode(ByteSet {});
+	}
+	if (alternation.children.size() == 1) {
+		return std::move(alternation.children.front());
+	}
+	return alternation;
+}
+
+/**
+ * Appends the instructions for node to code. When reversed, sequences are emitted in
+ * reverse order and groups are not saved.
+ */
+void Emit(const Node &node, Code &code, bool reversed) {
+	if (code.size() > instructionLimit) {
+		Fail();
+	}
+	switch (node.kind) {
+	case NodeKind::Empty:
+		break;
+	case NodeKind::Bytes:
+		code.push_back({ Op::Bytes, node.value, 0 });
+		break;
+	case NodeKind::Sequence:
+		if (reversed) {
+			for (auto it = node.children.rbegin(); it != node.children.rend(); ++it) {
+				Emit(*it, code, reversed);
+			}
+		} else {
+			for (const Node &child : node.children) {
+				Emit(child, code, reversed);
+			}
+		}
+		break;
+	case NodeKind::Alternation: {
+			std::vector<size_t> jumps;
+			for (size_t i = 0; i < node.children.size(); i++) {
+				if (i + 1 < node.children.size()) {
+					const size_t split = code.size();
+					code.push_back({ Op::Split, static_cast<int>(split + 1), 0 });
+					Emit(node.children[i], code, reversed);
+					jumps.push_back(code.size());
+					code.push_back({ Op::Jump, 0, 0 });
+					code[split].y = static_cast<int>(code.size());
+				} else {
+					Emit(node.children[i], code, reversed);
+				}
+			}
+			for (const size_t jump : jumps) {
+				code[jump].x = static_cast<int>(code.size());
+			}
+		}
+		break;
+	case NodeKind::Repetition: {
+			const Node &child = node.children.front();
+			for (int i = 0; i < node.minimum; i++) {
+				Emit(child, code, reversed);
+			}
+			if (node.maximum == unbounded) {
+				const size_t split = code.size();
+				code.push_back({ Op::Split, static_cast<int>(split + 1), 0 });
+				Emit(child, code, reversed);
+				code.push_back({ Op::Jump, static_cast<int>(split), 0 });
+				code[split].y = static_cast<int>(code.size());
+			} else {
+				std::vector<size_t> splits;
+				for (int i = node.minimum; i < node.maximum; i++) {
+					splits.push_back(code.size());
+					code.push_back({ Op::Split, static_cast<int>(code.size() + 1), 0 });
+					Emit(child, code, reversed);
+				}
+				for (const size_t split : splits) {
+					code[split].y = static_cast<int>(code.size());
+				}
+			}
+		}
+		break;
+	case NodeKind::Group:
+		if (!reversed && node.value) {
+			code.push_back({ Op::Save, node.value * 2, 0 });
+		}
+		Emit(node.children.front(), code, reversed);
+		if (!reversed && node.value) {
+			code.push_back({ Op::Save, node.value * 2 + 1, 0 });
+		}
+		break;
+	case NodeKind::Assert:
+		code.push_back({ Op::Assert, node.value, 0 });
+		break;
+	}
+}
+
+// Bytes share a class when they have the same side and lead byte status and are members
+// of the same sets.
+void ClassifyBytes(RegexProgram &program) {
+	std::map<std::string, int> classOfSignature;
+	for (int ch = 0; ch < 256; ch++) {
+		std::string signature;
+		signature.push_back(static_cast<char>(program.sides[ch]));
+		signature.push_back(program.leadBytes[ch] ? '1' : '0');
+		for (const ByteSet &set : program.sets) {
+			signature.push_back(set[ch] ? '1' : '0');
+		}
+		const auto [it, inserted] = classOfSignature.emplace(signature, static_cast<int>(classOfSignature.size()));
+		program.byteClasses[ch] = static_cast<unsigned char>(it->second);
+	}
+	program.classes = static_cast<int>(classOfSignature.size());
+}
+
+Side SideAt(const RegexProgram &program, SegmentedView &view, Sci::Position position) noexcept {
+	if ((position < 0) || (position >= view.Length())) {
+		return Side::Edge;
+	}
+	return program.SideOf(view.CharAt(position));
+}
+
+}
+
+namespace Scintilla::Internal {
+
+/**
+ * Runs a program as a deterministic automaton, building states as they are reached.
+ * A state holds the program positions waiting to consume a byte, grouped by the position
+ * where their match started with earlier starts first.
+ * Reaching a match in one group ends all later groups, so the first match found is leftmost
+ * and continuing until the automaton dies finds the longest match from that start.
+ */
+class LazyDFA {
+	struct State {
+		// Groups of program positions each terminated by -1
+		std::vector<int> threads;
+		// Kind of the byte before the current position
+		Side before = Side::Edge;
+		// Between the bytes of a DBCS character
+		bool trail = false;
+		// Matches may still start at following positions
+		bool starting = false;
+	};
+	const RegexProgram &program;
+	const Code &code;
+	bool reverse;
+	std::vector<State> states;
+	// For each state and byte class, the following state * 2 + 1 if a match ends before
+	// the byte, or -1 when not yet found
+	std::vector<int> transitions;
+	std::map<std::string, int> stateOfKey;
+	size_t flushes = 0;
+	// Avoid visiting program positions more than once in each step
+	std::vector<unsigned int> closureMarks;
+	std::vector<unsigned int> threadMarks;
+	unsigned int generation = 0;
+	std::vector<int> stack;
+	std::vector<int> consumers;
+
+	void NextGeneration() noexcept;
+	bool Closure(int pc, Side before, Side after);
+	int AddState(State &&state);
+	void Flush();
+	int Compute(int state, unsigned char ch, bool &matched);
+public:
+	static constexpr int deadState = 0;
+
+	LazyDFA(const RegexProgram &program_, bool reverse_);
+
+	// Returns the first state at a position where the byte before is before.
+	int Start(Side before, bool starting);
+
+	// Returns the state after reading ch and sets matched when a match ended before ch.
+	int Next(int state, unsigned char ch, bool &matched) {
+		const int transition = transitions[state * program.classes + program.byteClasses[ch]];
+		if (transition >= 0) {
+			matched = transition & 1;
+			return transition >> 1;
+		}
+		return Compute(state, ch, matched);
+	}
+
+	// Does a match end at the current position when followed by after?
+	bool MatchesBefore(int state, Side after);
+};
+
+}
+
+LazyDFA::LazyDFA(const RegexProgram &program_, bool reverse_) :
+	program(program_), code(reverse_ ? program_.reversed : program_.forward), reverse(reverse_),
+	closureMarks(code.size()), threadMarks(code.size()) {
+	Flush();
+}
+
+void LazyDFA::NextGeneration() noexcept {
+	generation++;
+	if (generation == 0) {
+		std::fill(closureMarks.begin(), closureMarks.end(), 0);
+		std::fill(threadMarks.begin(), threadMarks.end(), 0);
+		generation = 1;
+	}
+}
+
+// Follow the instructions that do not consume bytes from pc, adding those that do to consumers.
+// Returns true if a match is reached.
+bool LazyDFA::Closure(int pc, Side before, Side after) {
+	if (reverse) {
+		std::swap(before, after);
+	}
+	bool matched = false;
+	stack.push_back(pc);
+	while (!stack.empty()) {
+		const int current = stack.back();
+		stack.pop_back();
+		if (closureMarks[current] == generation) {
+			continue;
+		}
+		closureMarks[current] = generation;
+		const Instruction &instruction = code[current];
+		switch (instruction.op) {
+		case Op::Bytes:
+			consumers.push_back(current);
+			break;
+		case Op::Split:
+			stack.push_back(instruction.y);
+			stack.push_back(instruction.x);
+			break;
+		case Op::Jump:
+			stack.push_back(instruction.x);
+			break;
+		case Op::Save:
+			stack.push_back(current + 1);
+			break;
+		case Op::Assert:
+			if (AssertionHolds(static_cast<Assertion>(instruction.x), before, after)) {
+				stack.push_back(current + 1);
+			}
+			break;
+		case Op::Match:
+			matched = true;
+			break;
+		}
+	}
+	return matched;
+}
+
+int LazyDFA::AddState(State &&state) {
+	if (state.threads.empty() && !state.starting) {
+		return deadState;
+	}
+	std::string key;
+	key.push_back(static_cast<char>(state.before));
+	key.push_back(state.trail ? '1' : '0');
+	key.push_back(state.starting ? '1' : '0');
+	for (const int thread : state.threads) {
+		key.append(reinterpret_cast<const char *>(&thread), sizeof(thread));
+	}
+	const auto it = stateOfKey.find(key);
+	if (it != stateOfKey.end()) {
+		return it->second;
+	}
+	if (states.size() >= stateLimit) {
+		Flush();
+	}
+	const int index = static_cast<int>(states.size());
+	states.push_back(std::move(state));
+	transitions.resize(transitions.size() + program.classes, -1);
+	stateOfKey[key] = index;
+	return index;
+}
+
+void LazyDFA::Flush() {
+	states.clear();
+	transitions.clear();
+	stateOfKey.clear();
+	flushes++;
+	// Dead state transitions to itself
+	states.emplace_back();
+	transitions.resize(program.classes, deadState * 2);
+}
+
+int LazyDFA::Compute(int state, unsigned char ch, bool &matched) {
+	// Copy as adding states may discard the source
+	const State source = states[state];
+	const size_t flushesBefore = flushes;
+	NextGeneration();
+	const Side after = source.trail ? Side::Word : program.SideOf(ch);
+	State target;
+	target.starting = source.starting;
+	matched = false;
+	bool groupMatched = false;
+	for (const int thread : source.threads) {
+		if (thread >= 0) {
+			groupMatched = Closure(thread, source.before, after) || groupMatched;
+			continue;
+		}
+		const size_t groupStart = target.threads.size();
+		for (const int consumer : consumers) {
+			if (program.sets[code[consumer].x][ch]) {
+				const int successor = consumer + 1;
+				if (threadMarks[successor] != generation) {
+					threadMarks[successor] = generation;
+					target.threads.push_back(successor);
+				}
+			}
+		}
+		consumers.clear();
+		if (target.threads.size() > groupStart) {
+			std::sort(target.threads.begin() + groupStart, target.threads.end());
+			target.threads.push_back(-1);
+		}
+		if (groupMatched) {
+			// Later starts can not be leftmost
+			matched = true;
+			target.starting = false;
+			break;
+		}
+	}
+	const bool lead = program.dbcs && !reverse && !source.trail && program.leadBytes[ch];
+	target.trail = lead;
+	target.before = (source.trail || lead) ? Side::Word : program.SideOf(ch);
+	if (target.starting && !target.trail) {
+		target.threads.push_back(0);
+		target.threads.push_back(-1);
+	}
+	const int next = AddState(std::move(target));
+	if (flushes == flushesBefore) {
+		transitions[state * program.classes + program.byteClasses[ch]] = next * 2 + (matched ? 1 : 0);
+	}
+	return next;
+}
+
+int LazyDFA::Start(Side before, bool starting) {
+	State state;
+	state.threads = { 0, -1 };
+	state.before = before;
+	state.starting = starting;
+	return AddState(std::move(state));
+}
+
+bool LazyDFA::MatchesBefore(int state, Side after) {
+	const State &current = states[state];
+	if (current.trail) {
+		return false;
+	}
+	NextGeneration();
+	bool matched = false;
+	for (const int thread : current.threads) {
+		if ((thread >= 0) && Closure(thread, current.before, after)) {
+			matched = true;
+			break;
+		}
+	}
+	consumers.clear();
+	return matched;
+}
+
+namespace {
+
+using Saves = std::array<Sci::Position, LinearRegex::maxTag * 2>;
+
+struct Thread {
+	int pc;
+	Saves saves;
+};
+
+/**
+ * Simulates the forward program over text known to match from start to end to find the
+ * positions of groups with the same priorities as a backtracking search.
+ */
+class CaptureFinder {
+	const RegexProgram &program;
+	const Code &code;
+	std::vector<Sci::Position> marks;
+	std::vector<Thread> stack;
+
+	void Add(std::vector<Thread> &threads, const Thread &thread, Sci::Position position, Side before, Side after) {
+		stack.push_back(thread);
+		while (!stack.empty()) {
+			Thread current = stack.back();
+			stack.pop_back();
+			if (marks[current.pc] == position) {
+				continue;
+			}
+			marks[current.pc] = position;
+			const Instruction &instruction = code[current.pc];
+			switch (instruction.op) {
+			case Op::Bytes:
+			case Op::Match:
+				threads.push_back(current);
+				break;
+			case Op::Split:
+				stack.push_back({ instruction.y, current.saves });
+				stack.push_back({ instruction.x, current.saves });
+				break;
+			case Op::Jump:
+				stack.push_back({ instruction.x, current.saves });
+				break;
+			case Op::Save:
+				current.saves[instruction.x] = position;
+				current.pc++;
+				stack.push_back(current);
+				break;
+			case Op::Assert:
+				if (AssertionHolds(static_cast<Assertion>(instruction.x), before, after)) {
+					current.pc++;
+					stack.push_back(current);
+				}
+				break;
+			}
+		}
+	}
+public:
+	explicit CaptureFinder(const RegexProgram &program_) :
+		program(program_), code(program_.forward), marks(code.size(), -1) {
+	}
+
+	std::optional<Saves> Find(SegmentedView &view, Sci::Position start, Sci::Position end) {
+		std::vector<Thread> current;
+		std::vector<Thread> next;
+		Thread initial { 0, {} };
+		initial.saves.fill(-1);
+		Add(current, initial, start, SideAt(program, view, start - 1), SideAt(program, view, start));
+		for (Sci::Position position = start; position < end; position++) {
+			const unsigned char ch = view.CharAt(position);
+			const Side before = program.SideOf(ch);
+			const Side after = SideAt(program, view, position + 1);
+			next.clear();
+			for (const Thread &thread : current) {
+				const Instruction &instruction = code[thread.pc];
+				if ((instruction.op == Op::Bytes) && program.sets[instruction.x][ch]) {
+					Add(next, { thread.pc + 1, thread.saves }, position + 1, before, after);
+				}
+			}
+			std::swap(current, next);
+		}
+		for (const Thread &thread : current) {
+			if (code[thread.pc].op == Op::Match) {
+				return thread.saves;
+			}
+		}
+		return {};
+	}
+};
+
+struct Ending {
+	int pc;
+	Sci::Position end;
+};
+
+/**
+ * Simulates the reversed program backwards over a range to find the end of the longest match
+ * starting at each position in time proportional to the length of the range.
+ * Threads are kept in order of decreasing end so, when several reach the same instruction,
+ * only the one with the furthest end continues.
+ */
+class EndFinder {
+	const RegexProgram &program;
+	const Code &code;
+	std::vector<Sci::Position> marks;
+	std::vector<Ending> stack;
+
+	Side Before(const std::vector<bool> &boundaries, SegmentedView &view, Sci::Position start, Sci::Position position) const noexcept {
+		// The byte before the end of a double byte character is a trail byte
+		if ((position > start) && !boundaries[position - start - 1]) {
+			return Side::Word;
+		}
+		return SideAt(program, view, position - 1);
+	}
+
+	void Add(std::vector<Ending> &threads, const Ending &ending, Sci::Position position, Side before, Side after) {
+		stack.push_back(ending);
+		while (!stack.empty()) {
+			const Ending current = stack.back();
+			stack.pop_back();
+			if (marks[current.pc] == position) {
+				continue;
+			}
+			marks[current.pc] = position;
+			const Instruction &instruction = code[current.pc];
+			switch (instruction.op) {
+			case Op::Bytes:
+			case Op::Match:
+				threads.push_back(current);
+				break;
+			case Op::Split:
+				stack.push_back({ instruction.y, current.end });
+				stack.push_back({ instruction.x, current.end });
+				break;
+			case Op::Jump:
+				stack.push_back({ instruction.x, current.end });
+				break;
+			case Op::Save:
+				stack.push_back({ current.pc + 1, current.end });
+				break;
+			case Op::Assert:
+				if (AssertionHolds(static_cast<Assertion>(instruction.x), before, after)) {
+					stack.push_back({ current.pc + 1, current.end });
+				}
+				break;
+			}
+		}
+	}
+public:
+	explicit EndFinder(const RegexProgram &program_) :
+		program(program_), code(program_.reversed), marks(code.size(), -1) {
+	}
+
+	// Returns, for each position from start to end, the end of the longest match in the range
+	// starting there or -1.
+	std::vector<Sci::Position> Find(const Document *doc, SegmentedView &view, Sci::Position start, Sci::Position end) {
+		// Matches only start and end between characters
+		std::vector<bool> boundaries(end - start + 1, !program.dbcs);
+		if (program.dbcs) {
+			for (Sci::Position position = start; position < end; position = doc->NextPosition(position, 1)) {
+				boundaries[position - start] = true;
+			}
+			boundaries[end - start] = true;
+		}
+		std::vector<Sci::Position> ends(end - start + 1, -1);
+		std::vector<Ending> current;
+		std::vector<Ending> next;
+		for (Sci::Position position = end; position >= start; position--) {
+			if (boundaries[position - start]) {
+				// Added last as its end is before those of all other threads
+				Add(current, { 0, position }, position, Before(boundaries, view, start, position), SideAt(program, view, position));
+				for (const Ending &thread : current) {
+					if (code[thread.pc].op == Op::Match) {
+						ends[position - start] = thread.end;
+						break;
+					}
+				}
+			}
+			if (position == start) {
+				break;
+			}
+			const unsigned char ch = view.CharAt(position - 1);
+			const Side before = Before(boundaries, view, start, position - 1);
+			next.clear();
+			for (const Ending &thread : current) {
+				const Instruction &instruction = code[thread.pc];
+				if ((instruction.op == Op::Bytes) && program.sets[instruction.x][ch]) {
+					Add(next, { thread.pc + 1, thread.end }, position - 1, before, program.SideOf(ch));
+				}
+			}
+			std::swap(current, next);
+		}
+		return ends;
+	}
+};
+
+}
+
+LinearRegex::LinearRegex(CharClassify *charClassTable) : charClass(charClassTable) {
+	bopat.fill(-1);
+	eopat.fill(-1);
+}
+
+LinearRegex::~LinearRegex() = default;
+
+void LinearRegex::Compile(const Document *doc, const char *s, Sci::Position length, bool caseSensitive) {
+	Encoding encoding;
+	encoding.codePage = doc->dbcsCodePage;
+	encoding.caseSensitive = caseSensitive;
+	for (int ch = 0; ch < 256; ch++) {
+		encoding.wordBytes[ch] = charClass->IsWord(static_cast<unsigned char>(ch));
+		encoding.leadBytes[ch] = encoding.DBCS() && doc->IsDBCSLeadByteNoExcept(static_cast<char>(ch));
+	}
+
+	std::string keyCompile = std::to_string(encoding.codePage);
+	keyCompile.push_back(caseSensitive ? 'C' : 'c');
+	for (const bool word : encoding.wordBytes) {
+		keyCompile.push_back(word ? '1' : '0');
+	}
+	keyCompile.append(s, length);
+	if (program && (keyCompile == key)) {
+		return;
+	}
+
+	std::unique_ptr<RegexProgram> programNew = std::make_unique<RegexProgram>();
+	Parser parser(std::string_view(s, length), encoding, *programNew);
+	const Node root = parser.Parse();
+	Emit(root, programNew->forward, false);
+	programNew->forward.push_back({ Op::Match, 0, 0 });
+	Emit(root, programNew->reversed, true);
+	programNew->reversed.push_back({ Op::Match, 0, 0 });
+	programNew->dbcs = encoding.DBCS();
+	programNew->leadBytes = encoding.leadBytes;
+	for (int ch = 0; ch < 256; ch++) {
+		if (ch == '\r') {
+			programNew->sides[ch] = Side::CR;
+		} else if (ch == '\n') {
+			programNew->sides[ch] = Side::LF;
+		} else if ((encoding.UTF8() && !UTF8IsAscii(static_cast<unsigned char>(ch))) ||
+			encoding.leadBytes[ch] || encoding.wordBytes[ch]) {
+			programNew->sides[ch] = Side::Word;
+		} else {
+			programNew->sides[ch] = Side::Other;
+		}
+	}
+	ClassifyBytes(*programNew);
+
+	forward = std::make_unique<LazyDFA>(*programNew, false);
+	backward = std::make_unique<LazyDFA>(*programNew, true);
+	program = std::move(programNew);
+	key = keyCompile;
+}
+
+// Find the leftmost-longest match in [start, end) setting bopat and eopat.
+bool LinearRegex::Search(const Document *doc, SegmentedView &view, Sci::Position start, Sci::Position end, bool captures) {
+	const Side beforeStart = SideAt(*program, view, start - 1);
+
+	// Find the end of the match by scanning forwards until the automaton dies
+	Sci::Position matchEnd = -1;
+	int state = forward->Start(beforeStart, true);
+	Sci::Position position = start;
+	while ((position < end) && (state != LazyDFA::deadState)) {
+		Sci::Position segmentStart = 0;
+		Sci::Position segmentEnd = 0;
+		const char *origin = view.Segment(position, segmentStart, segmentEnd);
+		if (!origin) {
+			break;
+		}
+		const Sci::Position runEnd = std::min(end, segmentEnd);
+		const Sci::Position runStart = position;
+		while (position < runEnd) {
+			bool matched = false;
+			state = forward->Next(state, static_cast<unsigned char>(origin[position]), matched);
+			if (matched) {
+				matchEnd = position;
+			}
+			if (state == LazyDFA::deadState) {
+				break;
+			}
+			position++;
+		}
+		scanned += position - runStart;
+	}
+	if ((state != LazyDFA::deadState) && (position >= end) && forward->MatchesBefore(state, SideAt(*program, view, end))) {
+		matchEnd = end;
+	}
+	if (matchEnd < 0) {
+		return false;
+	}
+
+	// Find the start by scanning the reversed expression backwards from the end
+	Sci::Position matchStart = -1;
+	state = backward->Start(SideAt(*program, view, matchEnd), false);
+	position = matchEnd;
+	while ((position > start) && (state != LazyDFA::deadState)) {
+		Sci::Position segmentStart = 0;
+		Sci::Position segmentEnd = 0;
+		const char *origin = view.Segment(position - 1, segmentStart, segmentEnd);
+		if (!origin) {
+			break;
+		}
+		const Sci::Position runStart = std::max(start, segmentStart);
+		while (position > runStart) {
+			bool matched = false;
+			state = backward->Next(state, static_cast<unsigned char>(origin[position - 1]), matched);
+			// Trail bytes of DBCS characters may resemble the start of a match
+			if (matched && (!program->dbcs || (doc->MovePositionOutsideChar(position, 1, false) == position))) {
+				matchStart = position;
+			}
+			if (state == LazyDFA::deadState) {
+				break;
+			}
+			position--;
+		}
+	}
+	if ((state != LazyDFA::deadState) && (position <= start) && backward->MatchesBefore(state, beforeStart)) {
+		matchStart = start;
+	}
+	if (matchStart < 0) {
+		return false;
+	}
+
+	bopat.fill(-1);
+	eopat.fill(-1);
+	bopat[0] = matchStart;
+	eopat[0] = matchEnd;
+	if (captures && (program->tags > 1)) {
+		CaptureFinder finder(*program);
+		const std::optional<Saves> saves = finder.Find(view, matchStart, matchEnd);
+		if (saves) {
+			for (int tag = 1; tag < program->tags; tag++) {
+				const Sci::Position tagStart = (*saves)[tag * 2];
+				const Sci::Position tagEnd = (*saves)[tag * 2 + 1];
+				if ((tagStart >= 0) && (tagEnd >= tagStart)) {
+					bopat[tag] = tagStart;
+					eopat[tag] = tagEnd;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// Find the start of the match in [start, end) that ends last, taking the earliest start for
+// that end, by scanning the reversed expression backwards from end.
+Sci::Position LinearRegex::SearchBackwards(const Document *doc, SegmentedView &view, Sci::Position start, Sci::Position end) {
+	if (program->dbcs) {
+		// Trail bytes of DBCS characters may resemble the end of a match so find the ends
+		// only at character boundaries
+		EndFinder finder(*program);
+		const std::vector<Sci::Position> ends = finder.Find(doc, view, start, end);
+		const auto itLast = std::max_element(ends.begin(), ends.end());
+		if (*itLast < 0) {
+			return -1;
+		}
+		return start + (itLast - ends.begin());
+	}
+	Sci::Position matchStart = -1;
+	int state = backward->Start(SideAt(*program, view, end), true);
+	Sci::Position position = end;
+	while ((position > start) && (state != LazyDFA::deadState)) {
+		Sci::Position segmentStart = 0;
+		Sci::Position segmentEnd = 0;
+		const char *origin = view.Segment(position - 1, segmentStart, segmentEnd);
+		if (!origin) {
+			break;
+		}
+		const Sci::Position runStart = std::max(start, segmentStart);
+		while (position > runStart) {
+			bool matched = false;
+			state = backward->Next(state, static_cast<unsigned char>(origin[position - 1]), matched);
+			if (matched) {
+				matchStart = position;
+			}
+			if (state == LazyDFA::deadState) {
+				break;
+			}
+			position--;
+		}
+	}
+	if ((state != LazyDFA::deadState) && (position <= start) && backward->MatchesBefore(state, SideAt(*program, view, start - 1))) {
+		matchStart = start;
+	}
+	return matchStart;
+}
+
+// Find the leftmost-longest matches in [start, end) which is within one line from the end of
+// the longest match starting at each position.
+void LinearRegex::FindAllInLine(const Document *doc, SegmentedView &view, Sci::Position start, Sci::Position end, std::vector<Range> &matches) {
+	EndFinder finder(*program);
+	const std::vector<Sci::Position> ends = finder.Find(doc, view, start, end);
+	Sci::Position position = start;
+	while (position <= end) {
+		if (ends[position - start] < 0) {
+			position++;
+			continue;
+		}
+		const Sci::Position matchEnd = ends[position - start];
+		matches.emplace_back(position, matchEnd);
+		if (matchEnd > position) {
+			position = matchEnd;
+		} else if (position < end) {
+			position = doc->NextPosition(position, 1);
+		} else {
+			break;
+		}
+	}
+}
+
+Sci::Position LinearRegex::FindText(Document *doc, Sci::Position minPos, Sci::Position maxPos, const char *s,
+                        bool caseSensitive, bool, bool, FindOption, Sci::Position *length) {
+	Compile(doc, s, *length, caseSensitive);
+	SegmentedView view = doc->AllView();
+
+	// Range endpoints should not be inside DBCS characters or between a CR and LF
+	const Sci::Position startPos = doc->MovePositionOutsideChar(std::min(minPos, maxPos), 1, true);
+	const Sci::Position endPos = doc->MovePositionOutsideChar(std::max(minPos, maxPos), 1, true);
+
+	if (minPos <= maxPos) {
+		if (!Search(doc, view, startPos, endPos, true)) {
+			return -1;
+		}
+	} else {
+		// Find the match that ends last on the last line with a match
+		const Sci::Line lineFirst = doc->SciLineFromPosition(startPos);
+		bool found = false;
+		for (Sci::Line line = doc->SciLineFromPosition(endPos); (line >= lineFirst) && !found; line--) {
+			const Sci::Position lineStart = std::max(startPos, doc->LineStart(line));
+			const Sci::Position lineEnd = std::min(endPos, doc->LineEnd(line));
+			const Sci::Position matchStart = SearchBackwards(doc, view, lineStart, lineEnd);
+			if (matchStart >= 0) {
+				// Search forwards from its start to find its end and groups
+				found = Search(doc, view, matchStart, lineEnd, true);
+			}
+		}
+		if (!found) {
+			return -1;
+		}
+	}
+	*length = eopat[0] - bopat[0];
+	return bopat[0];
+}
+
+void LinearRegex::FindAll(Document *doc, Sci::Position minPos, Sci::Position maxPos, const char *s,
+                        bool caseSensitive, bool, bool, FindOption, Sci::Position length,
+                        std::vector<Range> &matches) {
+	Compile(doc, s, length, caseSensitive);
+	SegmentedView view = doc->AllView();
+
+	const Sci::Position startPos = doc->MovePositionOutsideChar(std::min(minPos, maxPos), 1, true);
+	const Sci::Position endPos = doc->MovePositionOutsideChar(std::max(minPos, maxPos), 1, true);
+
+	// Each search scans forwards past the end of its match while a longer match is possible
+	// so following searches may read the same text again. When more than twice the range has
+	// been read, find the rest of the matches a line at a time in linear time.
+	const Sci::Position scanLimit = (endPos - startPos) * 2 + 0x1000;
+	scanned = 0;
+	Sci::Position position = startPos;
+	while ((position <= endPos) && (scanned <= scanLimit) && Search(doc, view, position, endPos, false)) {
+		matches.emplace_back(bopat[0], eopat[0]);
+		if (eopat[0] > bopat[0]) {
+			position = eopat[0];
+		} else if (bopat[0] < endPos) {
+			// Empty match so move on to avoid finding it again, not stopping between CR and LF
+			position = doc->MovePositionOutsideChar(doc->NextPosition(bopat[0], 1), 1, true);
+		} else {
+			return;
+		}
+	}
+	if (scanned <= scanLimit) {
+		return;
+	}
+	const Sci::Line lineLast = doc->SciLineFromPosition(endPos);
+	for (Sci::Line line = doc->SciLineFromPosition(position); line <= lineLast; line++) {
+		const Sci::Position lineStart = std::max(position, doc->LineStart(line));
+		const Sci::Position lineEnd = std::min(endPos, doc->LineEnd(line));
+		if (lineStart <= lineEnd) {
+			FindAllInLine(doc, view, lineStart, lineEnd, matches);
+		}
+	}
+}
+
+const char *LinearRegex::SubstituteByPosition(Document *doc, const char *text, Sci::Position *length) {
+	substituted.clear();
+	for (Sci::Position j = 0; j < *length; j++) {
+		if (text[j] == '\\') {
+			const char chNext = text[++j];
+			if (chNext >= '0' && chNext <= '9') {
+				const unsigned int patNum = chNext - '0';
+				const Sci::Position startPos = bopat[patNum];
+				const Sci::Position len = eopat[patNum] - startPos;
+				if (len > 0) {	// Will be null if try for a match that did not occur
+					const size_t size = substituted.length();
+					substituted.resize(size + len);
+					doc->GetCharRange(substituted.data() + size, startPos, len);
+				}
+			} else {
+				switch (chNext) {
+				case 'a':
+					substituted.push_back('\a');
+					break;
+				case 'b':
+					substituted.push_back('\b');
+					break;
+				case 'f':
+					substituted.push_back('\f');
+					break;
+				case 'n':
+					substituted.push_back('\n');
+					break;
+				case 'r':
+					substituted.push_back('\r');
+					break;
+				case 't':
+					substituted.push_back('\t');
+					break;
+				case 'v':
+					substituted.push_back('\v');
+					break;
+				case '\\':
+					substituted.push_back('\\');
+					break;
+				default:
+					substituted.push_back('\\');
+					j--;
+				}
+			}
+		} else {
+			substituted.push_back(text[j]);
+		}
+	}
+	*length = substituted.length();
+	return substituted.c_str();
+}
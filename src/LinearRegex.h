@@ -0,0 +1,71 @@
+// Scintilla source code edit control
+/** @file LinearRegex.h
+ ** Regular expression search that takes time linear in the length of the text.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef LINEARREGEX_H
+#define LINEARREGEX_H
+
+namespace Scintilla::Internal {
+
+struct RegexProgram;
+class LazyDFA;
+
+/**
+ * Regular expression search with time proportional to the length of the text searched
+ * whatever the expression.
+ * Expressions are compiled to a nondeterministic automaton that is run as a deterministic
+ * automaton whose states are built when first reached and kept for following searches.
+ * Matches are leftmost-longest as in POSIX. The start of a match is found by running the
+ * reversed expression backwards from its end and captured groups are found by simulating
+ * the automaton over just the matched text.
+ * Back references are not supported as they can not be matched in linear time.
+ * Matches do not include line ends so, like the other search engines, find matches within lines.
+ */
+class LinearRegex : public RegexSearchBase {
+public:
+	static constexpr int maxTag = 10;
+	using MatchPositions = std::array<Sci::Position, maxTag>;
+
+	explicit LinearRegex(CharClassify *charClassTable);
+	// Deleted so LinearRegex objects can not be copied.
+	LinearRegex(const LinearRegex &) = delete;
+	LinearRegex(LinearRegex &&) = delete;
+	LinearRegex &operator=(const LinearRegex &) = delete;
+	LinearRegex &operator=(LinearRegex &&) = delete;
+	~LinearRegex() override;
+
+	Sci::Position FindText(Document *doc, Sci::Position minPos, Sci::Position maxPos, const char *s,
+                        bool caseSensitive, bool word, bool wordStart, Scintilla::FindOption flags,
+                        Sci::Position *length) override;
+
+	void FindAll(Document *doc, Sci::Position minPos, Sci::Position maxPos, const char *s,
+                        bool caseSensitive, bool word, bool wordStart, Scintilla::FindOption flags, Sci::Position length,
+                        std::vector<Range> &matches) override;
+
+	const char *SubstituteByPosition(Document *doc, const char *text, Sci::Position *length) override;
+
+	MatchPositions bopat;
+	MatchPositions eopat;
+
+private:
+	CharClassify *charClass;
+	// Options and pattern that program was compiled from
+	std::string key;
+	std::unique_ptr<RegexProgram> program;
+	std::unique_ptr<LazyDFA> forward;
+	std::unique_ptr<LazyDFA> backward;
+	std::string substituted;
+	// Bytes read by forward scans since last reset
+	Sci::Position scanned = 0;
+
+	void Compile(const Document *doc, const char *s, Sci::Position length, bool caseSensitive);
+	bool Search(const Document *doc, SegmentedView &view, Sci::Position start, Sci::Position end, bool captures);
+	Sci::Position SearchBackwards(const Document *doc, SegmentedView &view, Sci::Position start, Sci::Position end);
+	void FindAllInLine(const Document *doc, SegmentedView &view, Sci::Position start, Sci::Position end, std::vector<Range> &matches);
+};
+
+}
+
+#endif
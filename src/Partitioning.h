@@ -26,30 +26,28 @@ private:
 	T stepLength;
 	SplitVector<T> body;
 
-	// Deleted so SplitVectorWithRangeAdd objects can not be copied.
+	// Return index of last value <= key or 0 if all values > key.
+	// Chooses each half with a conditional move rather than an unpredictable branch.
+	// The first probes of every search are the same few values so stay in cache. A sampled
+	// top-level index, maintained over insertions and removals, was slower than this search.
+	static ptrdiff_t LastNotAbove(const T *values, ptrdiff_t length, T key) noexcept {
+		const T *base = values;
+		while (length > 1) {
+			const ptrdiff_t half = length / 2;
+#if defined(__GNUC__)
+			// Both possible next probes are fetched so the cache miss overlaps this comparison
+			__builtin_prefetch(base + half / 2);
+			__builtin_prefetch(base + half + half / 2);
+#endif
+			base = (base[half] <= key) ? base + half : base;
+			length -= half;
+		}
+		return base - values;
+	}
+
 	void RangeAddDelta(T start, T end, T delta) noexcept {
 		// end is 1 past end, so end-start is number of elements to change
-		const ptrdiff_t position = start;
-		ptrdiff_t i = 0;
-		const ptrdiff_t rangeLength = end - position;
-		ptrdiff_t range1Length = rangeLength;
-		const ptrdiff_t part1Left = body.GapPosition() - position;
-		if (range1Length > part1Left)
-			range1Length = part1Left;
-		T *writer = &body[position];
-		while (i < range1Length) {
-			*writer += delta;
-			writer++;
-			i++;
-		}
-		if (i < rangeLength) {
-			T *writer2 = &body[position + i];
-			while (i < rangeLength) {
-				*writer2 += delta;
-				writer2++;
-				i++;
-			}
-		}
+		body.RangeAddDelta(start, end - start, delta);
 	}
 
 	// Move step forward
@@ -178,20 +176,32 @@ public:
 			return 0;
 		if (pos >= (PositionFromPartition(Partitions())))
 			return Partitions() - 1;
+		// Narrow to a range that is on one side of both the step and the gap so that it
+		// can be searched directly in memory without adjusting each value.
+		// Values after the step are compared with the position before the step was added.
 		T lower = 0;
 		T upper = Partitions();
-		do {
-			const T middle = (upper + lower + 1) / 2; 	// Round high
-			T posMiddle = body.ValueAt(middle);
-			if (middle > stepPartition)
-				posMiddle += stepLength;
-			if (pos < posMiddle) {
-				upper = middle - 1;
+		T key = pos;
+		if (stepPartition < upper) {
+			if (pos < body.ValueAt(stepPartition + 1) + stepLength) {
+				upper = stepPartition;
 			} else {
-				lower = middle;
+				lower = stepPartition + 1;
+				key = pos - stepLength;
 			}
-		} while (lower < upper);
-		return lower;
+		}
+		ptrdiff_t segmentStart = 0;
+		ptrdiff_t segmentLength = 0;
+		const T *segment = body.SegmentAt(upper, segmentStart, segmentLength);
+		if (segmentStart > lower) {
+			if (segment[0] <= key) {
+				lower = static_cast<T>(segmentStart);
+			} else {
+				upper = static_cast<T>(segmentStart - 1);
+				segment = body.SegmentAt(lower, segmentStart, segmentLength);
+			}
+		}
+		return lower + static_cast<T>(LastNotAbove(segment + lower - segmentStart, upper - lower + 1, key));
 	}
 
 	void DeleteAll() {
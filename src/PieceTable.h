@@ -0,0 +1,399 @@
+// Scintilla source code edit control
+/** @file PieceTable.h
+ ** Sequence of pieces that refer to read-only memory or to text added by editing.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef PIECETABLE_H
+#define PIECETABLE_H
+
+namespace Scintilla::Internal {
+
+/**
+ * A piece table holds its contents as a sequence of pieces where each piece is a pointer
+ * to a contiguous run of elements.
+ * Pieces may refer to memory owned by the container, such as a memory-mapped file, which
+ * is never written to or copied. Elements inserted by editing are appended to blocks owned
+ * by the piece table and are never moved so pointers into them remain valid.
+ * Blocks that no piece refers to any more are released when further blocks are needed.
+ * Piece boundaries are held in a Partitioning so finding the piece for a position is a
+ * binary search.
+ * There is always at least one piece: an empty table has a single empty piece.
+ */
+template <typename T>
+class PieceTable {
+	Partitioning<ptrdiff_t> starts;
+	SplitVector<const T *> pieces;	/// One element for each partition in starts
+	struct Block {
+		std::unique_ptr<T[]> elements;
+		ptrdiff_t size;
+	};
+	std::vector<Block> blocks;	/// Storage for elements added by editing
+	ptrdiff_t blockUsed;	/// Elements used in the last block
+	ptrdiff_t blockSize;	/// Allocation size of the last block
+	ptrdiff_t growSize;
+	size_t blocksRetained;	/// Blocks remaining after unused blocks were last released
+	T empty;	/// Returned as the result of out-of-bounds access.
+
+	ptrdiff_t PieceStart(ptrdiff_t piece) const noexcept {
+		return starts.PositionFromPartition(piece);
+	}
+
+	/// Release the blocks that no piece refers to.
+	/// Every piece is examined so this is only performed when the number of blocks has doubled
+	/// since the last release, spreading the cost over the allocations made in between.
+	void ReleaseUnusedBlocks() {
+		if (blocks.size() < std::max<size_t>(2, blocksRetained * 2)) {
+			return;
+		}
+		// Blocks ordered by address so the block holding each piece is found with a binary search
+		std::vector<size_t> order(blocks.size());
+		for (size_t block = 0; block < blocks.size(); block++) {
+			order[block] = block;
+		}
+		const std::less<const T *> before;
+		std::sort(order.begin(), order.end(), [this, &before](size_t a, size_t b) noexcept {
+			return before(blocks[a].elements.get(), blocks[b].elements.get());
+		});
+		std::vector<bool> used(blocks.size());
+		for (ptrdiff_t piece = 0; piece < pieces.Length(); piece++) {
+			const T *text = pieces.ValueAt(piece);
+			const auto it = std::upper_bound(order.begin(), order.end(), text, [this, &before](const T *t, size_t block) noexcept {
+				return before(t, blocks[block].elements.get());
+			});
+			if (it != order.begin()) {
+				const Block &holder = blocks[*(it - 1)];
+				// Pieces referring to memory owned by the container are not in any block
+				if (before(text, holder.elements.get() + holder.size)) {
+					used[*(it - 1)] = true;
+				}
+			}
+		}
+		size_t retained = 0;
+		for (size_t block = 0; block < blocks.size(); block++) {
+			if (used[block]) {
+				blocks[retained++] = std::move(blocks[block]);
+			}
+		}
+		blocks.resize(retained);
+		blocksRetained = retained;
+	}
+
+	/// Allocate space for elements which will not move. Consecutive allocations are
+	/// adjacent when they fit in the current block so typing extends a single piece.
+	T *Allocate(ptrdiff_t allocateLength) {
+		if (blocks.empty() || (blockUsed + allocateLength > blockSize)) {
+			ReleaseUnusedBlocks();
+			const ptrdiff_t size = std::max(growSize, allocateLength);
+			blocks.push_back(Block{ std::make_unique<T[]>(size), size });
+			blockSize = size;
+			blockUsed = 0;
+		}
+		T *allocation = blocks.back().elements.get() + blockUsed;
+		blockUsed += allocateLength;
+		return allocation;
+	}
+
+	/// Ensure there is a piece boundary at position and return the piece that starts there.
+	/// Returns the number of pieces when position is at the end.
+	ptrdiff_t SplitPiece(ptrdiff_t position) {
+		if (position >= Length()) {
+			return starts.Partitions();
+		}
+		ptrdiff_t piece = starts.PartitionFromPosition(position);
+		const ptrdiff_t pieceStart = PieceStart(piece);
+		if (pieceStart < position) {
+			const T *text = pieces.ValueAt(piece) + (position - pieceStart);
+			piece++;
+			pieces.Insert(piece, text);
+			try {
+				starts.InsertPartition(piece, position);
+			} catch (...) {
+				// Keep pieces and starts matching
+				pieces.Delete(piece);
+				throw;
+			}
+		}
+		return piece;
+	}
+
+	/// Merge piece with its predecessor when the predecessor's text continues into it.
+	void JoinPiece(ptrdiff_t piece) {
+		if ((piece > 0) && (piece < starts.Partitions())) {
+			const ptrdiff_t before = piece - 1;
+			const ptrdiff_t lengthBefore = PieceStart(piece) - PieceStart(before);
+			if (pieces.ValueAt(before) + lengthBefore == pieces.ValueAt(piece)) {
+				starts.RemovePartition(piece);
+				pieces.Delete(piece);
+			}
+		}
+	}
+
+	/// Insert a piece referring to text which must remain valid.
+	void InsertPiece(ptrdiff_t position, const T *text, ptrdiff_t insertLength) {
+		if (Length() == 0) {
+			pieces.SetValueAt(0, text);
+			starts.InsertText(0, insertLength);
+			return;
+		}
+		if (position > 0) {
+			const ptrdiff_t before = starts.PartitionFromPosition(position - 1);
+			const ptrdiff_t beforeStart = PieceStart(before);
+			if ((PieceStart(before + 1) == position) &&
+				(pieces.ValueAt(before) + (position - beforeStart) == text)) {
+				// Continues the previous piece, as happens when typing, so just extend it
+				starts.InsertText(before, insertLength);
+				return;
+			}
+		}
+		const ptrdiff_t piece = SplitPiece(position);
+		starts.InsertPartition(piece, position);
+		pieces.Insert(piece, text);
+		starts.InsertText(piece, insertLength);
+	}
+
+	/// Replace a range with a single piece containing a copy of that range so the range is contiguous.
+	const T *Coalesce(ptrdiff_t position, ptrdiff_t rangeLength) {
+		T *text = Allocate(rangeLength);
+		GetRange(text, position, rangeLength);
+		RemoveRange(position, rangeLength);
+		InsertPiece(position, text, rangeLength);
+		return text;
+	}
+
+	/// Reset to a single empty piece without releasing added text.
+	void ClearPieces() {
+		starts.DeleteAll();
+		pieces.DeleteAll();
+		pieces.Insert(0, nullptr);
+	}
+
+	void RemoveRange(ptrdiff_t position, ptrdiff_t deleteLength) {
+		if ((position == 0) && (deleteLength == Length())) {
+			ClearPieces();
+			return;
+		}
+		const ptrdiff_t pieceFirst = SplitPiece(position);
+		const ptrdiff_t pieceEnd = SplitPiece(position + deleteLength);
+		starts.InsertText(pieceFirst, -deleteLength);
+		for (ptrdiff_t piece = pieceFirst; piece < pieceEnd; piece++) {
+			starts.RemovePartition(pieceFirst);
+		}
+		pieces.DeleteRange(pieceFirst, pieceEnd - pieceFirst);
+		JoinPiece(pieceFirst);
+	}
+
+	/// Replace elements without moving them, for SetValueAt and FillRange.
+	/// Since pieces may refer to read-only memory, a new piece is created.
+	/// If an exception is thrown, the contents are unchanged.
+	void Replace(ptrdiff_t position, ptrdiff_t replaceLength, T v) {
+		T *text = Allocate(replaceLength);
+		std::fill(text, text + replaceLength, v);
+		const ptrdiff_t pieceFirst = SplitPiece(position);
+		const ptrdiff_t pieceEnd = SplitPiece(position + replaceLength);
+		// Only removals, which do not allocate, follow so the replacement can not fail part way
+		pieces.SetValueAt(pieceFirst, text);
+		for (ptrdiff_t piece = pieceFirst + 1; piece < pieceEnd; piece++) {
+			starts.RemovePartition(pieceFirst + 1);
+		}
+		pieces.DeleteRange(pieceFirst + 1, pieceEnd - pieceFirst - 1);
+		JoinPiece(pieceFirst);
+	}
+
+public:
+	/// Construct a piece table.
+	explicit PieceTable(ptrdiff_t growSize_=0x10000) :
+		blockUsed(0), blockSize(0), growSize(growSize_), blocksRetained(0), empty() {
+		pieces.Insert(0, nullptr);
+	}
+
+	/// Retrieve the length of the sequence.
+	ptrdiff_t Length() const noexcept {
+		return starts.PositionFromPartition(starts.Partitions());
+	}
+
+	/// Storage is allocated as needed so there is nothing to do.
+	void ReAllocate(ptrdiff_t) noexcept {
+	}
+
+	/// Retrieve the element at a particular position.
+	/// Retrieving positions outside the range of the sequence returns empty or 0.
+	const T &ValueAt(ptrdiff_t position) const noexcept {
+		if ((position < 0) || (position >= Length())) {
+			return empty;
+		}
+		const ptrdiff_t piece = starts.PartitionFromPosition(position);
+		return pieces.ValueAt(piece)[position - PieceStart(piece)];
+	}
+
+	/// Set the element at a particular position.
+	/// Setting positions outside the range of the sequence performs no assignment
+	/// but asserts in debug builds.
+	void SetValueAt(ptrdiff_t position, T v) noexcept {
+		PLATFORM_ASSERT((position >= 0) && (position < Length()));
+		FillRange(position, 1, v);
+	}
+
+	/// Set a range of elements to a value.
+	/// @return true if any element changed, false when unchanged because memory could not be allocated.
+	bool FillRange(ptrdiff_t position, ptrdiff_t fillLength, T v) noexcept {
+		if ((position < 0) || (fillLength <= 0) || ((position + fillLength) > Length())) {
+			return false;
+		}
+		for (ptrdiff_t i = position; i < position + fillLength; i++) {
+			if (ValueAt(i) != v) {
+				try {
+					Replace(position, fillLength, v);
+				} catch (...) {
+					// Replace leaves the contents unchanged when it fails
+					return false;
+				}
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/// Insert a number of elements into the sequence setting their value.
+	void InsertValue(ptrdiff_t position, ptrdiff_t insertLength, T v) {
+		PLATFORM_ASSERT((position >= 0) && (position <= Length()));
+		if ((insertLength > 0) && (position >= 0) && (position <= Length())) {
+			T *text = Allocate(insertLength);
+			std::fill(text, text + insertLength, v);
+			InsertPiece(position, text, insertLength);
+		}
+	}
+
+	/// Insert a copy of elements from an array.
+	void InsertFromArray(ptrdiff_t positionToInsert, const T s[], ptrdiff_t positionFrom, ptrdiff_t insertLength) {
+		PLATFORM_ASSERT((positionToInsert >= 0) && (positionToInsert <= Length()));
+		if ((insertLength > 0) && (positionToInsert >= 0) && (positionToInsert <= Length())) {
+			T *text = Allocate(insertLength);
+			std::copy(s + positionFrom, s + positionFrom + insertLength, text);
+			InsertPiece(positionToInsert, text, insertLength);
+		}
+	}
+
+	/// Insert elements by referring to them instead of copying them.
+	/// The caller must ensure the elements remain valid and unchanged for the life of the piece table.
+	void InsertReference(ptrdiff_t positionToInsert, const T s[], ptrdiff_t insertLength) {
+		PLATFORM_ASSERT((positionToInsert >= 0) && (positionToInsert <= Length()));
+		if ((insertLength > 0) && (positionToInsert >= 0) && (positionToInsert <= Length())) {
+			InsertPiece(positionToInsert, s, insertLength);
+		}
+	}
+
+	/// Delete a range from the sequence.
+	/// Deleting positions outside the current range fails.
+	void DeleteRange(ptrdiff_t position, ptrdiff_t deleteLength) {
+		PLATFORM_ASSERT((position >= 0) && (position + deleteLength <= Length()));
+		if ((position < 0) || (deleteLength <= 0) || ((position + deleteLength) > Length())) {
+			return;
+		}
+		RemoveRange(position, deleteLength);
+	}
+
+	/// Delete all the contents and release added text.
+	void DeleteAll() {
+		ClearPieces();
+		blocks.clear();
+		blockUsed = 0;
+		blockSize = 0;
+		blocksRetained = 0;
+	}
+
+	/// Retrieve a range of elements into an array
+	void GetRange(T *buffer, ptrdiff_t position, ptrdiff_t retrieveLength) const {
+		const ptrdiff_t end = position + retrieveLength;
+		while (position < end) {
+			const ptrdiff_t piece = starts.PartitionFromPosition(position);
+			const ptrdiff_t pieceStart = PieceStart(piece);
+			const ptrdiff_t endCopy = std::min(PieceStart(piece + 1), end);
+			const T *text = pieces.ValueAt(piece);
+			std::copy(text + position - pieceStart, text + endCopy - pieceStart, buffer);
+			buffer += endCopy - position;
+			position = endCopy;
+		}
+	}
+
+	/// Copy all the contents into one block and return a pointer to the first element.
+	/// Also ensures there is an empty element beyond logical end in case its
+	/// passed to a function expecting a NUL terminated string.
+	/// This gives up the memory savings of referring to external memory.
+	const T *BufferPointer() {
+		const ptrdiff_t length = Length();
+		if ((starts.Partitions() == 1) && !blocks.empty() && (pieces.ValueAt(0) == blocks.back().elements.get()) &&
+			(blockUsed == length) && (blockSize > length)) {
+			// Already flat with room for a terminator
+			blocks.back().elements[length] = T();
+			return blocks.back().elements.get();
+		}
+		std::unique_ptr<T[]> flat = std::make_unique<T[]>(length + 1);
+		GetRange(flat.get(), 0, length);
+		DeleteAll();
+		blocks.push_back(Block{ std::move(flat), length + 1 });
+		blockSize = length + 1;
+		blockUsed = length;
+		InsertPiece(0, blocks.back().elements.get(), length);
+		return blocks.back().elements.get();
+	}
+
+	/// Return a pointer to a range of elements, first copying the range if it
+	/// spans more than one piece.
+	const T *RangePointer(ptrdiff_t position, ptrdiff_t rangeLength) {
+		if ((position < 0) || (rangeLength < 0) || ((position + rangeLength) > Length())) {
+			return nullptr;
+		}
+		const ptrdiff_t piece = starts.PartitionFromPosition(position);
+		const ptrdiff_t pieceStart = PieceStart(piece);
+		if ((position + rangeLength) <= PieceStart(piece + 1)) {
+			return pieces.ValueAt(piece) + (position - pieceStart);
+		}
+		return Coalesce(position, rangeLength);
+	}
+
+	/// Return a pointer to the piece containing position along with the range of positions in that piece.
+	const T *SegmentAt(ptrdiff_t position, ptrdiff_t &segmentStart, ptrdiff_t &segmentLength) const noexcept {
+		const ptrdiff_t piece = starts.PartitionFromPosition(position);
+		segmentStart = PieceStart(piece);
+		segmentLength = PieceStart(piece + 1) - segmentStart;
+		return pieces.ValueAt(piece);
+	}
+
+	/// There is no gap so report the end of the first piece as that is the
+	/// extent that can be accessed directly from the start.
+	ptrdiff_t GapPosition() const noexcept {
+		return PieceStart(1);
+	}
+
+	ptrdiff_t Pieces() const noexcept {
+		return starts.Partitions();
+	}
+
+	size_t Blocks() const noexcept {
+		return blocks.size();
+	}
+
+	void Check() const {
+#ifdef CHECK_CORRECTNESS
+		starts.Check();
+		if (pieces.Length() != starts.Partitions()) {
+			throw std::runtime_error("PieceTable: Pieces and partitions mismatch.");
+		}
+		if (Length() > 0) {
+			for (ptrdiff_t piece = 0; piece < starts.Partitions(); piece++) {
+				if (PieceStart(piece) >= PieceStart(piece + 1)) {
+					throw std::runtime_error("PieceTable: Empty piece.");
+				}
+				if (!pieces.ValueAt(piece)) {
+					throw std::runtime_error("PieceTable: Piece without text.");
+				}
+			}
+		}
+#endif
+	}
+};
+
+}
+
+#endif
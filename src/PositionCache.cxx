@@ -64,6 +64,8 @@ void BidiData::Resize(size_t maxLineLength_) {
 }
 
 LineLayout::LineLayout(Sci::Line lineNumber_, int maxLineLength_) :
+	arenaSize(0),
+	lineStarts(nullptr),
 	lenLineStarts(0),
 	lineNumber(lineNumber_),
 	maxLineLength(-1),
@@ -74,6 +76,9 @@ LineLayout::LineLayout(Sci::Line lineNumber_, int maxLineLength_) :
 	highlightColumn(false),
 	containsCaret(false),
 	edgeColumn(0),
+	chars(nullptr),
+	styles(nullptr),
+	positions(nullptr),
 	bracePreviousStyles{},
 	widthLine(wrapWidthInfinite),
 	lines(1),
@@ -85,27 +90,78 @@ LineLayout::~LineLayout() {
 	Free();
 }
 
+namespace {
+
+// Reused layouts grow by half again so that slightly longer lines do not each reallocate.
+constexpr int lengthGrowthLimit = 0x40000000;
+
+int GrownLength(int length, int lengthRequired) noexcept {
+	if ((length > 0) && (length < lengthGrowthLimit)) {
+		return std::max(lengthRequired, length + length / 2);
+	}
+	return lengthRequired;
+}
+
+}
+
+void LineLayout::Allocate(int maxLineLength_, int lenLineStarts_, bool preserve) {
+	const size_t lineAllocation = maxLineLength_ + 1;
+	// Extra position allocated as sometimes the Windows
+	// GetTextExtentExPoint API writes an extra element.
+	// Positions are first so are aligned, then line starts, then bytes.
+	const size_t bytesPositions = (lineAllocation + 1) * sizeof(XYPOSITION);
+	const size_t bytesLineStarts = lenLineStarts_ * sizeof(int);
+	const size_t size = bytesPositions + bytesLineStarts + 2 * lineAllocation;
+	std::unique_ptr<char[]> arenaNew = std::make_unique<char[]>(size);
+	XYPOSITION *positionsNew = reinterpret_cast<XYPOSITION *>(arenaNew.get());
+	int *lineStartsNew = lenLineStarts_ ? reinterpret_cast<int *>(arenaNew.get() + bytesPositions) : nullptr;
+	char *charsNew = arenaNew.get() + bytesPositions + bytesLineStarts;
+	unsigned char *stylesNew = reinterpret_cast<unsigned char *>(charsNew + lineAllocation);
+	if (preserve && arena) {
+		const size_t lengthKept = std::min(maxLineLength, maxLineLength_) + 1;
+		std::copy(positions, positions + lengthKept + 1, positionsNew);
+		if (lineStarts && lineStartsNew) {
+			std::copy(lineStarts, lineStarts + std::min(lenLineStarts, lenLineStarts_), lineStartsNew);
+		}
+		std::copy(chars, chars + lengthKept, charsNew);
+		std::copy(styles, styles + lengthKept, stylesNew);
+	}
+	arena = std::move(arenaNew);
+	arenaSize = size;
+	positions = positionsNew;
+	lineStarts = lineStartsNew;
+	lenLineStarts = lenLineStarts_;
+	chars = charsNew;
+	styles = stylesNew;
+}
+
 void LineLayout::Resize(int maxLineLength_) {
 	if (maxLineLength_ > maxLineLength) {
-		Free();
-		const size_t lineAllocation = maxLineLength_ + 1;
-		chars = std::make_unique<char[]>(lineAllocation);
-		styles = std::make_unique<unsigned char []>(lineAllocation);
-		// Extra position allocated as sometimes the Windows
-		// GetTextExtentExPoint API writes an extra element.
-		positions = std::make_unique<XYPOSITION []>(lineAllocation + 1);
+		const int lengthAllocate = GrownLength(maxLineLength, maxLineLength_);
+		// Contents are kept so a layout may be grown for an edited line then updated incrementally
+		Allocate(lengthAllocate, lenLineStarts, true);
 		if (bidiData) {
-			bidiData->Resize(maxLineLength_);
+			bidiData->Resize(lengthAllocate);
 		}
 
-		maxLineLength = maxLineLength_;
+		maxLineLength = lengthAllocate;
 	}
 }
 
 void LineLayout::ReSet(Sci::Line lineNumber_, Sci::Position maxLineLength_) {
 	lineNumber = lineNumber_;
 	Resize(static_cast<int>(maxLineLength_));
+	numCharsInLine = 0;
+	numCharsBeforeEOL = 0;
+	xHighlightGuide = 0;
+	highlightColumn = false;
+	containsCaret = false;
+	edgeColumn = 0;
+	widthLine = wrapWidthInfinite;
 	lines = 0;
+	wrapIndent = 0;
+	segmentStarts.clear();
+	chunksMeasured.clear();
 	Invalidate(ValidLevel::invalid);
 }
 
@@ -117,12 +173,17 @@ void LineLayout::EnsureBidiData() {
 }
 
 void LineLayout::Free() noexcept {
-	chars.reset();
-	styles.reset();
-	positions.reset();
-	lineStarts.reset();
+	arena.reset();
+	arenaSize = 0;
+	chars = nullptr;
+	styles = nullptr;
+	positions = nullptr;
+	lineStarts = nullptr;
 	lenLineStarts = 0;
+	maxLineLength = -1;
 	bidiData.reset();
+	segmentStarts.clear();
+	chunksMeasured.clear();
 }
 
 void LineLayout::ClearPositions() {
@@ -142,6 +203,17 @@ bool LineLayout::CanHold(Sci::Line lineDoc, int lineLength_) const noexcept {
 	return (lineNumber == lineDoc) && (lineLength_ <= maxLineLength);
 }
 
+// Approximate bytes allocated for this layout.
+size_t LineLayout::MemoryUse() const noexcept {
+	size_t bytes = sizeof(LineLayout) + arenaSize + segmentStarts.capacity() * sizeof(int);
+	if (bidiData) {
+		bytes += sizeof(BidiData) +
+			bidiData->stylesFonts.capacity() * sizeof(std::shared_ptr<Font>) +
+			bidiData->widthReprs.capacity() * sizeof(XYPOSITION);
+	}
+	return bytes;
+}
+
 int LineLayout::LineStart(int line) const noexcept {
 	if (line <= 0) {
 		return 0;
@@ -203,13 +275,9 @@ int LineLayout::SubLineFromPosition(int posInLine, PointEnd pe) const noexcept {
 void LineLayout::AddLineStart(Sci::Position start) {
 	lines++;
 	if (lines >= lenLineStarts) {
-		const int newMaxLines = lines + 20;
-		std::unique_ptr<int[]> newLineStarts = std::make_unique<int[]>(newMaxLines);
-		if (lenLineStarts) {
-			std::copy(lineStarts.get(), lineStarts.get() + lenLineStarts, newLineStarts.get());
-		}
-		lineStarts = std::move(newLineStarts);
-		lenLineStarts = newMaxLines;
+		// Reallocates the whole arena so grow geometrically
+		const int newMaxLines = std::max(lines + 20, lenLineStarts * 2);
+		Allocate(maxLineLength, newMaxLines, true);
 	}
 	lineStarts[lines] = static_cast<int>(start);
 }
@@ -469,9 +537,21 @@ bool SignificantLines::LineMayCache(Sci::Line line) const noexcept {
 	}
 }
 
+namespace {
+
+constexpr size_t memoryLimitDefault = 0x4000000;
+
+// Enough spare layouts to hold those discarded when scrolling by a page.
+// Layouts of long lines are not kept as they use too much memory.
+constexpr size_t sparesMaximum = 100;
+constexpr int spareLengthMaximum = 1000;
+
+}
+
 LineLayoutCache::LineLayoutCache() :
 	level(LineCache::None),
-	maxValidity(LineLayout::ValidLevel::invalid), styleClock(-1) {
+	maxValidity(LineLayout::ValidLevel::invalid), styleClock(-1),
+	memoryLimit(memoryLimitDefault), memoryUse(0), clockHand(0) {
 }
 
 LineLayoutCache::~LineLayoutCache() = default;
@@ -505,11 +585,46 @@ size_t LineLayoutCache::EntryForLine(Sci::Line line) const noexcept {
 		return 1 + (line % (cache.size() - 1));
 	case LineCache::Document:
 		return line;
+	case LineCache::DocumentBounded:
+		return 0;
 	}
 	return 0;
 }
 
+std::shared_ptr<LineLayout> LineLayoutCache::Create(Sci::Line lineNumber, int maxChars) {
+	if (spares.empty()) {
+		return std::make_shared<LineLayout>(lineNumber, maxChars);
+	}
+	std::shared_ptr<LineLayout> ll = std::move(spares.back());
+	spares.pop_back();
+	ll->ReSet(lineNumber, maxChars);
+	return ll;
+}
+
+// Ensure ll can hold lineNumber, growing it in place when it is already for that line
+// so its contents may be reused by incremental layout.
+void LineLayoutCache::Renew(std::shared_ptr<LineLayout> &ll, Sci::Line lineNumber, int maxChars) {
+	if (ll && (ll.use_count() == 1) && (ll->LineNumber() == lineNumber)) {
+		ll->Resize(maxChars);
+	} else {
+		Recycle(ll);
+		ll = Create(lineNumber, maxChars);
+	}
+}
+
+// Keep a layout that is leaving the cache for reuse if no one else is using it.
+void LineLayoutCache::Recycle(std::shared_ptr<LineLayout> &ll) {
+	if (ll && (ll.use_count() == 1) && (ll->maxLineLength <= spareLengthMaximum) && (spares.size() < sparesMaximum)) {
+		spares.push_back(std::move(ll));
+	}
+	ll.reset();
+}
+
 void LineLayoutCache::AllocateForLevel(Sci::Line linesOnScreen, Sci::Line linesInDoc) {
+	if (level == LineCache::DocumentBounded) {
+		// Grows as needed in RetrieveBounded
+		return;
+	}
 	size_t lengthForLevel = 0;
 	if (level == LineCache::Caret) {
 		lengthForLevel = 1;
@@ -521,6 +636,9 @@ void LineLayoutCache::AllocateForLevel(Sci::Line linesOnScreen, Sci::Line linesI
 
 	if (lengthForLevel != cache.size()) {
 		maxValidity = LineLayout::ValidLevel::lines;
+		for (size_t i = lengthForLevel; i < cache.size(); i++) {
+			Recycle(cache[i]);
+		}
 		cache.resize(lengthForLevel);
 		// Cache::none -> no entries
 		// Cache::caret -> 1 entry can take any line
@@ -536,7 +654,7 @@ void LineLayoutCache::AllocateForLevel(Sci::Line linesOnScreen, Sci::Line linesI
 						if (cache[posForLine]) {
 							if (EntryForLine(cache[posForLine]->LineNumber()) == posForLine) {
 								// [posForLine] already holds line that is in correct place
-								cache[i].reset();	// This line has nowhere to go so reset it.
+								Recycle(cache[i]);	// This line has nowhere to go so reset it.
 							} else {
 								std::swap(cache[i], cache[posForLine]);
 								increment = 0;
@@ -562,9 +680,88 @@ void LineLayoutCache::AllocateForLevel(Sci::Line linesOnScreen, Sci::Line linesI
 	PLATFORM_ASSERT(cache.size() == lengthForLevel);
 }
 
+void LineLayoutCache::ClearBounded() noexcept {
+	memoryUse = 0;
+	slotOfLine.clear();
+	slotMemory.clear();
+	slotReferenced.clear();
+	slotsFree.clear();
+	clockHand = 0;
+}
+
+// Update memoryUse as the layout in slot may have been replaced or grown since last counted.
+void LineLayoutCache::AccountSlot(size_t slot) noexcept {
+	const size_t bytes = cache[slot] ? cache[slot]->MemoryUse() : 0;
+	memoryUse = memoryUse - slotMemory[slot] + bytes;
+	slotMemory[slot] = bytes;
+}
+
+void LineLayoutCache::EvictSlot(size_t slot) {
+	// Layouts may still be used by callers as they are shared.
+	slotOfLine.erase(cache[slot]->LineNumber());
+	memoryUse -= slotMemory[slot];
+	slotMemory[slot] = 0;
+	slotReferenced[slot] = false;
+	Recycle(cache[slot]);
+	slotsFree.push_back(slot);
+}
+
+// Remove layouts until there is space for bytes more, giving recently retrieved
+// layouts a second chance. A single layout larger than the limit is allowed.
+void LineLayoutCache::EvictFor(size_t bytes, size_t slotKeep) {
+	size_t examined = 0;
+	while ((memoryUse + bytes > memoryLimit) && (examined < 2 * cache.size())) {
+		if (clockHand >= cache.size()) {
+			clockHand = 0;
+		}
+		const size_t slot = clockHand++;
+		examined++;
+		if (cache[slot] && (slot != slotKeep)) {
+			if (slotReferenced[slot]) {
+				slotReferenced[slot] = false;
+			} else {
+				EvictSlot(slot);
+			}
+		}
+	}
+}
+
+std::shared_ptr<LineLayout> LineLayoutCache::RetrieveBounded(Sci::Line lineNumber, int maxChars) {
+	const std::map<Sci::Line, size_t>::const_iterator it = slotOfLine.find(lineNumber);
+	if (it != slotOfLine.end()) {
+		const size_t slot = it->second;
+		if (!cache[slot]->CanHold(lineNumber, maxChars)) {
+			Renew(cache[slot], lineNumber, maxChars);
+		}
+		slotReferenced[slot] = true;
+		AccountSlot(slot);
+		EvictFor(0, slot);
+		return cache[slot];
+	}
+
+	std::shared_ptr<LineLayout> ll = Create(lineNumber, maxChars);
+	EvictFor(ll->MemoryUse(), cache.size());
+	size_t slot = cache.size();
+	if (slotsFree.empty()) {
+		cache.push_back(ll);
+		slotMemory.push_back(0);
+		slotReferenced.push_back(true);
+	} else {
+		slot = slotsFree.back();
+		slotsFree.pop_back();
+		cache[slot] = ll;
+		slotReferenced[slot] = true;
+	}
+	slotOfLine[lineNumber] = slot;
+	AccountSlot(slot);
+	return ll;
+}
+
 void LineLayoutCache::Deallocate() noexcept {
 	maxValidity = LineLayout::ValidLevel::invalid;
 	cache.clear();
+	spares.clear();
+	ClearBounded();
 }
 
 void LineLayoutCache::Invalidate(LineLayout::ValidLevel validity_) noexcept {
@@ -583,9 +780,31 @@ void LineLayoutCache::SetLevel(LineCache level_) noexcept {
 		level = level_;
 		maxValidity = LineLayout::ValidLevel::invalid;
 		cache.clear();
+		spares.clear();
+		ClearBounded();
 	}
 }
 
+void LineLayoutCache::SetMemoryLimit(size_t memoryLimit_) {
+	memoryLimit = memoryLimit_;
+	if (level == LineCache::DocumentBounded) {
+		EvictFor(0, cache.size());
+	}
+}
+
+size_t LineLayoutCache::MemoryUse() const noexcept {
+	size_t bytes = cache.capacity() * sizeof(std::shared_ptr<LineLayout>);
+	for (const std::shared_ptr<LineLayout> &ll : cache) {
+		if (ll) {
+			bytes += ll->MemoryUse();
+		}
+	}
+	for (const std::shared_ptr<LineLayout> &ll : spares) {
+		bytes += ll->MemoryUse();
+	}
+	return bytes;
+}
+
 std::shared_ptr<LineLayout> LineLayoutCache::Retrieve(Sci::Line lineNumber, Sci::Line lineCaret, int maxChars, int styleClock_,
                                       Sci::Line linesOnScreen, Sci::Line linesInDoc) {
 	AllocateForLevel(linesOnScreen, linesInDoc);
@@ -594,6 +813,9 @@ std::shared_ptr<LineLayout> LineLayoutCache::Retrieve(Sci::Line lineNumber, Sci:
 		styleClock = styleClock_;
 	}
 	maxValidity = LineLayout::ValidLevel::lines;
+	if (level == LineCache::DocumentBounded) {
+		return RetrieveBounded(lineNumber, maxChars);
+	}
 	size_t pos = 0;
 	if (level == LineCache::Page) {
 		// If first entry is this line then just reuse it.
@@ -625,10 +847,10 @@ std::shared_ptr<LineLayout> LineLayoutCache::Retrieve(Sci::Line lineNumber, Sci:
 
 	if (pos < cache.size()) {
 		if (cache[pos] && !cache[pos]->CanHold(lineNumber, maxChars)) {
-			cache[pos].reset();
+			Renew(cache[pos], lineNumber, maxChars);
 		}
 		if (!cache[pos]) {
-			cache[pos] = std::make_shared<LineLayout>(lineNumber, maxChars);
+			cache[pos] = Create(lineNumber, maxChars);
 		}
 #ifdef CHECK_LLC
 		// Expensive check that there is only one entry for any line number
@@ -987,34 +1209,62 @@ bool BreakFinder::More() const noexcept {
 	return (subBreak >= 0) || (nextBreak < lineRange.end);
 }
 
-class PositionCacheEntry {
-	uint16_t styleNumber;
-	uint16_t len;
-	uint16_t clock;
-	bool unicode;
-	std::unique_ptr<XYPOSITION[]> positions;
-public:
-	PositionCacheEntry() noexcept;
-	// Copy constructor not currently used, but needed for being element in std::vector.
-	PositionCacheEntry(const PositionCacheEntry &);
-	PositionCacheEntry(PositionCacheEntry &&) noexcept = default;
-	// Deleted so PositionCacheEntry objects can not be assigned.
-	void operator=(const PositionCacheEntry &) = delete;
-	void operator=(PositionCacheEntry &&) = delete;
-	~PositionCacheEntry();
-	void Set(unsigned int styleNumber_, bool unicode_, std::string_view sv, const XYPOSITION *positions_, uint16_t clock_);
-	void Clear() noexcept;
-	bool Retrieve(unsigned int styleNumber_, bool unicode_, std::string_view sv, XYPOSITION *positions_) const noexcept;
-	static size_t Hash(unsigned int styleNumber_, bool unicode_, std::string_view sv) noexcept;
-	bool NewerThan(const PositionCacheEntry &other) const noexcept;
-	void ResetClock() noexcept;
+namespace {
+
+// Describes the text held in one entry of the position cache.
+// The text and its positions are stored in the cache's arenas.
+struct PositionCacheEntry {
+	uint16_t styleNumber = 0;
+	uint16_t len = 0;
+	uint16_t clock = 0;	// 0 when entry is empty
+	bool unicode = false;
+	bool Matches(unsigned int styleNumber_, bool unicode_, std::string_view sv, const char *text) const noexcept {
+		return (clock != 0) && (styleNumber == styleNumber_) && (unicode == unicode_) &&
+			(len == sv.length()) && (memcmp(text, sv.data(), sv.length()) == 0);
+	}
+};
+
+size_t HashText(unsigned int styleNumber, bool unicode, std::string_view sv) noexcept {
+	const size_t h1 = std::hash<std::string_view>{}(sv);
+	const size_t h2 = std::hash<unsigned int>{}(styleNumber);
+	return h1 ^ (h2 << 1) ^ static_cast<size_t>(unicode);
+}
+
+// The sets of entries are divided into shards, each with its own lock and clock, so that
+// layout threads rarely wait for each other. Set s is in shard s % shardCount.
+struct PositionCacheShard {
+	std::mutex mutex;
+	uint16_t clock = 0;
+	bool allClear = true;
+	size_t hits = 0;
+	size_t misses = 0;
+	size_t evictions = 0;
 };
 
+// Enough shards that several layout threads seldom contend for the same one.
+constexpr size_t shardsMaximum = 64;
+
+constexpr size_t keyLengthDefault = 30;
+constexpr size_t keyLengthMaximum = 1000;
+constexpr size_t waysDefault = 2;
+constexpr size_t waysMaximum = 64;
+
+}
+
+// Set associative cache of text widths. All text and positions are held in two arenas
+// allocated when the cache is sized so storing an entry does not allocate.
 class PositionCache : public IPositionCache {
+	size_t size = 0;
+	size_t keyLength = keyLengthDefault;
+	size_t ways = waysDefault;
+	size_t sets = 0;
 	std::vector<PositionCacheEntry> pces;
-	std::mutex mutex;
-	uint16_t clock;
-	bool allClear;
+	std::vector<char> texts;	// keyLength bytes for each entry
+	std::vector<XYPOSITION> widths;	// keyLength positions for each entry
+	std::unique_ptr<PositionCacheShard[]> shards;
+	size_t shardCount = 0;
+	void Allocate();
+	void ResetClocks(size_t shard) noexcept;
 public:
 	PositionCache();
 	// Deleted so LineAnnotation objects can not be copied.
@@ -1027,102 +1277,107 @@ public:
 	void Clear() noexcept override;
 	void SetSize(size_t size_) override;
 	size_t GetSize() const noexcept override;
+	void SetKeyLength(size_t keyLength_) override;
+	size_t GetKeyLength() const noexcept override;
+	void SetAssociativity(size_t ways_) override;
+	size_t GetAssociativity() const noexcept override;
+	size_t Statistic(PositionCacheStatistic statistic) const noexcept override;
 	void MeasureWidths(Surface *surface, const ViewStyle &vstyle, unsigned int styleNumber,
 		bool unicode, std::string_view sv, XYPOSITION *positions, bool needsLocking) override;
 };
 
-PositionCacheEntry::PositionCacheEntry() noexcept :
-	styleNumber(0), len(0), clock(0), unicode(false) {
+PositionCache::PositionCache() {
+	Allocate();
 }
 
-// Copy constructor not currently used, but needed for being element in std::vector.
-PositionCacheEntry::PositionCacheEntry(const PositionCacheEntry &other) :
-	styleNumber(other.styleNumber), len(other.len), clock(other.clock), unicode(other.unicode) {
-	if (other.positions) {
-		const size_t lenData = len + (len / sizeof(XYPOSITION)) + 1;
-		positions = std::make_unique<XYPOSITION[]>(lenData);
-		memcpy(positions.get(), other.positions.get(), lenData * sizeof(XYPOSITION));
+void PositionCache::Allocate() {
+	// Release old arenas before allocating new ones
+	pces = {};
+	texts = {};
+	widths = {};
+	sets = size / ways;
+	if ((size > 0) && (sets == 0)) {
+		sets = 1;
 	}
-}
-
-void PositionCacheEntry::Set(unsigned int styleNumber_, bool unicode_, std::string_view sv,
-	const XYPOSITION *positions_, uint16_t clock_) {
-	Clear();
-	styleNumber = static_cast<uint16_t>(styleNumber_);
-	len = static_cast<uint16_t>(sv.length());
-	clock = clock_;
-	unicode = unicode_;
-	if (sv.data() && positions_) {
-		positions = std::make_unique<XYPOSITION[]>(len + (len / sizeof(XYPOSITION)) + 1);
-		for (unsigned int i=0; i<len; i++) {
-			positions[i] = positions_[i];
+	const size_t entries = sets * ways;
+	pces.resize(entries);
+	texts.resize(entries * keyLength);
+	widths.resize(entries * keyLength);
+	shardCount = std::clamp<size_t>(sets / 8, 1, shardsMaximum);
+	shards = std::make_unique<PositionCacheShard[]>(shardCount);
+}
+
+void PositionCache::ResetClocks(size_t shard) noexcept {
+	// Since there are only 16 bits for the clock, wrap it round and
+	// reset all entries in the shard so none get stuck with a high clock.
+	for (size_t set = shard; set < sets; set += shardCount) {
+		for (size_t entry = set * ways; entry < (set + 1) * ways; entry++) {
+			if (pces[entry].clock > 0) {
+				pces[entry].clock = 1;
+			}
 		}
-		memcpy(&positions[len], sv.data(), sv.length());
 	}
 }
 
-PositionCacheEntry::~PositionCacheEntry() {
-	Clear();
-}
-
-void PositionCacheEntry::Clear() noexcept {
-	positions.reset();
-	styleNumber = 0;
-	len = 0;
-	clock = 0;
-}
-
-bool PositionCacheEntry::Retrieve(unsigned int styleNumber_, bool unicode_, std::string_view sv, XYPOSITION *positions_) const noexcept {
-	if ((styleNumber == styleNumber_) && (unicode == unicode_) && (len == sv.length()) &&
-		(memcmp(&positions[len], sv.data(), sv.length())== 0)) {
-		for (unsigned int i=0; i<len; i++) {
-			positions_[i] = positions[i];
+void PositionCache::Clear() noexcept {
+	for (size_t shard = 0; shard < shardCount; shard++) {
+		PositionCacheShard &pcs = shards[shard];
+		if (!pcs.allClear) {
+			for (size_t set = shard; set < sets; set += shardCount) {
+				for (size_t entry = set * ways; entry < (set + 1) * ways; entry++) {
+					pces[entry] = PositionCacheEntry();
+				}
+			}
 		}
-		return true;
-	} else {
-		return false;
+		pcs.clock = 0;
+		pcs.allClear = true;
 	}
 }
 
-size_t PositionCacheEntry::Hash(unsigned int styleNumber_, bool unicode_, std::string_view sv) noexcept {
-	const size_t h1 = std::hash<std::string_view>{}(sv);
-	const size_t h2 = std::hash<unsigned int>{}(styleNumber_);
-	return h1 ^ (h2 << 1) ^ static_cast<size_t>(unicode_);
+void PositionCache::SetSize(size_t size_) {
+	size = size_;
+	Allocate();
 }
 
-bool PositionCacheEntry::NewerThan(const PositionCacheEntry &other) const noexcept {
-	return clock > other.clock;
+size_t PositionCache::GetSize() const noexcept {
+	return size;
 }
 
-void PositionCacheEntry::ResetClock() noexcept {
-	if (clock > 0) {
-		clock = 1;
-	}
+void PositionCache::SetKeyLength(size_t keyLength_) {
+	keyLength = std::clamp<size_t>(keyLength_, 1, keyLengthMaximum);
+	Allocate();
 }
 
-PositionCache::PositionCache() {
-	clock = 1;
-	pces.resize(0x400);
-	allClear = true;
+size_t PositionCache::GetKeyLength() const noexcept {
+	return keyLength;
 }
 
-void PositionCache::Clear() noexcept {
-	if (!allClear) {
-		for (PositionCacheEntry &pce : pces) {
-			pce.Clear();
-		}
-	}
-	clock = 1;
-	allClear = true;
+void PositionCache::SetAssociativity(size_t ways_) {
+	ways = std::clamp<size_t>(ways_, 1, waysMaximum);
+	Allocate();
 }
 
-void PositionCache::SetSize(size_t size_) {
-	Clear();
-	pces.resize(size_);
+size_t PositionCache::GetAssociativity() const noexcept {
+	return ways;
 }
 
-size_t PositionCache::GetSize() const noexcept {
-	return pces.size();
+size_t PositionCache::Statistic(PositionCacheStatistic statistic) const noexcept {
+	size_t total = 0;
+	for (size_t shard = 0; shard < shardCount; shard++) {
+		const PositionCacheShard &pcs = shards[shard];
+		switch (statistic) {
+		case PositionCacheStatistic::Hits:
+			total += pcs.hits;
+			break;
+		case PositionCacheStatistic::Misses:
+			total += pcs.misses;
+			break;
+		case PositionCacheStatistic::Evictions:
+			total += pcs.evictions;
+			break;
+		}
+	}
+	return total;
 }
 
 void PositionCache::MeasureWidths(Surface *surface, const ViewStyle &vstyle, unsigned int styleNumber,
@@ -1137,30 +1392,46 @@ void PositionCache::MeasureWidths(Surface *surface, const ViewStyle &vstyle, uns
 			return;
 		}
 	}
+	if (style.asciiWidths) {
+		if (AllGraphicASCII(sv)) {
+			// Sum the widths of each character, avoiding measuring with the platform
+			const XYPOSITION *characterWidths = style.asciiWidths->data();
+			XYPOSITION position = 0;
+			for (size_t i = 0; i < sv.length(); i++) {
+				position += characterWidths[static_cast<unsigned char>(sv[i])];
+				positions[i] = position;
+			}
+			return;
+		}
+	}
 
-	size_t probe = pces.size();	// Out of bounds
-	if ((!pces.empty()) && (sv.length() < 30)) {
+	PositionCacheShard *pcs = nullptr;
+	size_t slot = 0;
+	if ((sets > 0) && !sv.empty() && (sv.length() <= keyLength)) {
 		// Only store short strings in the cache so it doesn't churn with
 		// long comments with only a single comment.
 
-		// Two way associative: try two probe positions.
-		const size_t hashValue = PositionCacheEntry::Hash(styleNumber, unicode, sv);
-		probe = hashValue % pces.size();
-		std::unique_lock<std::mutex> guard(mutex, std::defer_lock);
+		// Look in each entry of the text's set.
+		const size_t hashValue = HashText(styleNumber, unicode, sv);
+		const size_t set = hashValue % sets;
+		pcs = &shards[set % shardCount];
+		std::unique_lock<std::mutex> guard(pcs->mutex, std::defer_lock);
 		if (needsLocking) {
 			guard.lock();
 		}
-		if (pces[probe].Retrieve(styleNumber, unicode, sv, positions)) {
-			return;
-		}
-		const size_t probe2 = (hashValue * 37) % pces.size();
-		if (pces[probe2].Retrieve(styleNumber, unicode, sv, positions)) {
-			return;
-		}
-		// Not found. Choose the oldest of the two slots to replace
-		if (pces[probe].NewerThan(pces[probe2])) {
-			probe = probe2;
+		slot = set * ways;
+		for (size_t entry = set * ways; entry < (set + 1) * ways; entry++) {
+			if (pces[entry].Matches(styleNumber, unicode, sv, &texts[entry * keyLength])) {
+				std::copy_n(&widths[entry * keyLength], sv.length(), positions);
+				pcs->hits++;
+				return;
+			}
+			// Choose the oldest entry to replace
+			if (pces[entry].clock < pces[slot].clock) {
+				slot = entry;
+			}
 		}
+		pcs->misses++;
 	}
 
 	const Font *fontStyle = style.font.get();
@@ -1169,23 +1440,28 @@ void PositionCache::MeasureWidths(Surface *surface, const ViewStyle &vstyle, uns
 	} else {
 		surface->MeasureWidths(fontStyle, sv, positions);
 	}
-	if (probe < pces.size()) {
+	if (pcs) {
 		// Store into cache
-		std::unique_lock<std::mutex> guard(mutex, std::defer_lock);
+		std::unique_lock<std::mutex> guard(pcs->mutex, std::defer_lock);
 		if (needsLocking) {
 			guard.lock();
 		}
-		clock++;
-		if (clock > 60000) {
-			// Since there are only 16 bits for the clock, wrap it round and
-			// reset all cache entries so none get stuck with a high clock.
-			for (PositionCacheEntry &pce : pces) {
-				pce.ResetClock();
-			}
-			clock = 2;
+		pcs->clock++;
+		if (pcs->clock > 60000) {
+			ResetClocks(pcs - shards.get());
+			pcs->clock = 2;
+		}
+		pcs->allClear = false;
+		PositionCacheEntry &pce = pces[slot];
+		if (pce.clock != 0) {
+			pcs->evictions++;
 		}
-		allClear = false;
-		pces[probe].Set(styleNumber, unicode, sv, positions, clock);
+		pce.styleNumber = static_cast<uint16_t>(styleNumber);
+		pce.len = static_cast<uint16_t>(sv.length());
+		pce.clock = pcs->clock;
+		pce.unicode = unicode;
+		memcpy(&texts[slot * keyLength], sv.data(), sv.length());
+		std::copy_n(positions, sv.length(), &widths[slot * keyLength]);
 	}
 }
 
@@ -48,10 +48,15 @@ public:
  */
 class LineLayout {
 private:
-	std::unique_ptr<int []>lineStarts;
+	// positions, lineStarts, chars, and styles are placed in a single allocation
+	// which is only replaced when it has to grow.
+	std::unique_ptr<char[]> arena;
+	size_t arenaSize;
+	int *lineStarts;
 	int lenLineStarts;
 	/// Drawing is only performed for @a maxLineLength characters on each line.
 	Sci::Line lineNumber;
+	void Allocate(int maxLineLength_, int lenLineStarts_, bool preserve);
 public:
 	enum { wrapWidthInfinite = 0x7ffffff };
 
@@ -63,13 +68,21 @@ public:
 	bool highlightColumn;
 	bool containsCaret;
 	int edgeColumn;
-	std::unique_ptr<char[]> chars;
-	std::unique_ptr<unsigned char[]> styles;
-	std::unique_ptr<XYPOSITION[]> positions;
+	char *chars;
+	unsigned char *styles;
+	XYPOSITION *positions;
 	unsigned char bracePreviousStyles[2];
 
 	std::unique_ptr<BidiData> bidiData;
 
+	// Starts of the segments measured for long lines so that segments
+	// unchanged by an edit can be reused.
+	std::vector<int> segmentStarts;
+
+	// For lines laid out lazily, whether each chunk of the line has been measured.
+	// Positions in chunks not measured are estimated. Empty when the whole line is measured.
+	std::vector<bool> chunksMeasured;
+
 	// Wrapped line support
 	int widthLine;
 	int lines;
@@ -90,6 +103,7 @@ public:
 	void Invalidate(ValidLevel validity_) noexcept;
 	Sci::Line LineNumber() const noexcept;
 	bool CanHold(Sci::Line lineDoc, int lineLength_) const noexcept;
+	size_t MemoryUse() const noexcept;
 	int LineStart(int line) const noexcept;
 	int LineLength(int line) const noexcept;
 	enum class Scope { visibleOnly, includeEnd };
@@ -158,8 +172,28 @@ private:
 	std::vector<std::shared_ptr<LineLayout>>cache;
 	LineLayout::ValidLevel maxValidity;
 	int styleClock;
+	// For LineCache::DocumentBounded, entries are found through slotOfLine and,
+	// when memoryLimit would be exceeded, unreferenced entries are found by a
+	// clock hand sweeping over cache and removed.
+	size_t memoryLimit;
+	size_t memoryUse;
+	std::map<Sci::Line, size_t> slotOfLine;
+	std::vector<size_t> slotMemory;
+	std::vector<bool> slotReferenced;
+	std::vector<size_t> slotsFree;
+	size_t clockHand;
+	// Layouts removed from cache that may be reused to avoid allocating.
+	std::vector<std::shared_ptr<LineLayout>> spares;
 	size_t EntryForLine(Sci::Line line) const noexcept;
+	std::shared_ptr<LineLayout> Create(Sci::Line lineNumber, int maxChars);
+	void Recycle(std::shared_ptr<LineLayout> &ll);
+	void Renew(std::shared_ptr<LineLayout> &ll, Sci::Line lineNumber, int maxChars);
 	void AllocateForLevel(Sci::Line linesOnScreen, Sci::Line linesInDoc);
+	void ClearBounded() noexcept;
+	void AccountSlot(size_t slot) noexcept;
+	void EvictSlot(size_t slot);
+	void EvictFor(size_t bytes, size_t slotKeep);
+	std::shared_ptr<LineLayout> RetrieveBounded(Sci::Line lineNumber, int maxChars);
 public:
 	LineLayoutCache();
 	// Deleted so LineLayoutCache objects can not be copied.
@@ -172,6 +206,9 @@ public:
 	void Invalidate(LineLayout::ValidLevel validity_) noexcept;
 	void SetLevel(Scintilla::LineCache level_) noexcept;
 	Scintilla::LineCache GetLevel() const noexcept { return level; }
+	void SetMemoryLimit(size_t memoryLimit_);
+	size_t GetMemoryLimit() const noexcept { return memoryLimit; }
+	size_t MemoryUse() const noexcept;
 	std::shared_ptr<LineLayout> Retrieve(Sci::Line lineNumber, Sci::Line lineCaret, int maxChars, int styleClock_,
 		Sci::Line linesOnScreen, Sci::Line linesInDoc);
 };
@@ -269,6 +306,11 @@ public:
 	virtual void Clear() noexcept = 0;
 	virtual void SetSize(size_t size_) = 0;
 	virtual size_t GetSize() const noexcept = 0;
+	virtual void SetKeyLength(size_t keyLength_) = 0;
+	virtual size_t GetKeyLength() const noexcept = 0;
+	virtual void SetAssociativity(size_t ways_) = 0;
+	virtual size_t GetAssociativity() const noexcept = 0;
+	virtual size_t Statistic(Scintilla::PositionCacheStatistic statistic) const noexcept = 0;
 	virtual void MeasureWidths(Surface *surface, const ViewStyle &vstyle, unsigned int styleNumber,
 		bool unicode, std::string_view sv, XYPOSITION *positions, bool needsLocking) = 0;
 };
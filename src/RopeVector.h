@@ -0,0 +1,513 @@
+// Scintilla source code edit control
+/** @file RopeVector.h
+ ** Data structure for holding large arrays that handle insertions and deletions
+ ** scattered throughout the array efficiently.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef ROPEVECTOR_H
+#define ROPEVECTOR_H
+
+namespace Scintilla::Internal {
+
+/// A RopeVector holds elements in blocks which are the nodes of a balanced binary tree.
+/// The tree is a treap ordered by position with each node recording the number of
+/// elements in its subtree so insertion, deletion and access at any position take
+/// O(log n) time. SplitVector has to move its gap to each modification so scattered
+/// modifications are O(distance between modifications).
+/// The elements of each block are contiguous and can be examined with SegmentAt.
+/// The public interface matches SplitVector so either can be used as the storage of a document.
+template <typename T>
+class RopeVector {
+	struct Node {
+		std::unique_ptr<Node> left;
+		std::unique_ptr<Node> right;
+		std::vector<T> block;	/// May be longer than length to hold a terminating element
+		ptrdiff_t length = 0;	/// Number of elements in block
+		ptrdiff_t total = 0;	/// Number of elements in this subtree
+		unsigned int priority = 0;
+	};
+	using NodePtr = std::unique_ptr<Node>;
+
+	NodePtr root;
+	T empty;	/// Returned as the result of out-of-bounds access.
+	ptrdiff_t blockSize;
+	unsigned int seed;
+
+	static ptrdiff_t Total(const NodePtr &node) noexcept {
+		return node ? node->total : 0;
+	}
+
+	static void Update(Node *node) noexcept {
+		node->total = Total(node->left) + node->length + Total(node->right);
+	}
+
+	unsigned int NextPriority() noexcept {
+		// xorshift32 is good enough to keep the tree balanced and is repeatable
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		return seed;
+	}
+
+	NodePtr NewNode(ptrdiff_t length) {
+		NodePtr node = std::make_unique<Node>();
+		node->block.resize(length);
+		node->length = length;
+		node->total = length;
+		node->priority = NextPriority();
+		return node;
+	}
+
+	/// Join two trees where all positions in a are before those in b.
+	static NodePtr Merge(NodePtr a, NodePtr b) noexcept {
+		if (!a) {
+			return b;
+		}
+		if (!b) {
+			return a;
+		}
+		if (a->priority >= b->priority) {
+			a->right = Merge(std::move(a->right), std::move(b));
+			Update(a.get());
+			return a;
+		}
+		b->left = Merge(std::move(a), std::move(b->left));
+		Update(b.get());
+		return b;
+	}
+
+	/// Divide a tree into elements before position and elements from position onwards.
+	/// A block that straddles position is cut in two.
+	void Split(NodePtr node, ptrdiff_t position, NodePtr &before, NodePtr &after) {
+		if (!node) {
+			before.reset();
+			after.reset();
+			return;
+		}
+		const ptrdiff_t leftTotal = Total(node->left);
+		if (position <= leftTotal) {
+			Split(std::move(node->left), position, before, node->left);
+			Update(node.get());
+			after = std::move(node);
+		} else if (position >= leftTotal + node->length) {
+			Split(std::move(node->right), position - leftTotal - node->length, node->right, after);
+			Update(node.get());
+			before = std::move(node);
+		} else {
+			const ptrdiff_t offset = position - leftTotal;
+			NodePtr tail = NewNode(node->length - offset);
+			std::move(node->block.data() + offset, node->block.data() + node->length, tail->block.data());
+			node->length = offset;
+			node->block.resize(offset);
+			after = Merge(std::move(tail), std::move(node->right));
+			Update(node.get());
+			before = std::move(node);
+		}
+	}
+
+	/// Find the block containing position. When position is at the boundary between
+	/// two blocks, the earlier block is chosen when preferEarlier is set as that is
+	/// the block to append to.
+	Node *Locate(ptrdiff_t position, bool preferEarlier, ptrdiff_t &blockStart) const noexcept {
+		Node *node = root.get();
+		blockStart = 0;
+		while (node) {
+			const ptrdiff_t leftTotal = Total(node->left);
+			const ptrdiff_t offset = position - leftTotal;
+			if ((offset < 0) || (preferEarlier && (offset == 0) && node->left)) {
+				node = node->left.get();
+			} else if ((offset > node->length) || (!preferEarlier && (offset == node->length) && node->right)) {
+				blockStart += leftTotal + node->length;
+				position = offset - node->length;
+				node = node->right.get();
+			} else {
+				blockStart += leftTotal;
+				return node;
+			}
+		}
+		return nullptr;
+	}
+
+	/// Add delta to the totals of each node on the path to position.
+	void AdjustTotals(ptrdiff_t position, bool preferEarlier, ptrdiff_t delta) noexcept {
+		Node *node = root.get();
+		while (node) {
+			node->total += delta;
+			const ptrdiff_t leftTotal = Total(node->left);
+			const ptrdiff_t offset = position - leftTotal;
+			if ((offset < 0) || (preferEarlier && (offset == 0) && node->left)) {
+				node = node->left.get();
+			} else if ((offset > node->length) || (!preferEarlier && (offset == node->length) && node->right)) {
+				position = offset - node->length;
+				node = node->right.get();
+			} else {
+				return;
+			}
+		}
+	}
+
+	/// Build a tree of blocks holding insertLength elements with each block filled by fill.
+	template <typename Fill>
+	NodePtr Build(ptrdiff_t insertLength, Fill fill) {
+		NodePtr tree;
+		ptrdiff_t offset = 0;
+		while (offset < insertLength) {
+			const ptrdiff_t lengthBlock = std::min(blockSize, insertLength - offset);
+			NodePtr node = NewNode(lengthBlock);
+			fill(node->block.data(), offset, lengthBlock);
+			tree = Merge(std::move(tree), std::move(node));
+			offset += lengthBlock;
+		}
+		return tree;
+	}
+
+	/// Replace the range [position, position+rangeLength) with a single block.
+	/// Used to make a range contiguous.
+	Node *Coalesce(ptrdiff_t position, ptrdiff_t rangeLength) {
+		NodePtr before;
+		NodePtr rest;
+		Split(std::move(root), position, before, rest);
+		NodePtr middle;
+		NodePtr after;
+		Split(std::move(rest), rangeLength, middle, after);
+		NodePtr node = NewNode(rangeLength);
+		CopyOut(middle.get(), node->block.data());
+		middle.reset();
+		Node *result = node.get();
+		root = Merge(Merge(std::move(before), std::move(node)), std::move(after));
+		return result;
+	}
+
+	/// Combine the blocks either side of a boundary at position if they are small enough
+	/// to fit in one block. Avoids fragmentation after many small modifications.
+	void JoinAt(ptrdiff_t position) {
+		if ((position <= 0) || (position >= Length())) {
+			return;
+		}
+		ptrdiff_t startEarlier = 0;
+		const Node *earlier = Locate(position, true, startEarlier);
+		ptrdiff_t startLater = 0;
+		const Node *later = Locate(position, false, startLater);
+		if (earlier && later && (earlier != later) && (startLater == position) &&
+			((earlier->length + later->length) <= blockSize)) {
+			Coalesce(startEarlier, earlier->length + later->length);
+		}
+	}
+
+	/// Blocks larger than blockSize are produced by BufferPointer and RangePointer.
+	/// Divide such a block back into normal sized blocks before modifying it.
+	void Rechunk(ptrdiff_t position, bool preferEarlier) {
+		ptrdiff_t blockStart = 0;
+		const Node *node = Locate(position, preferEarlier, blockStart);
+		if (!node || (node->length <= blockSize)) {
+			return;
+		}
+		const ptrdiff_t lengthBlock = node->length;
+		NodePtr before;
+		NodePtr rest;
+		Split(std::move(root), blockStart, before, rest);
+		NodePtr middle;
+		NodePtr after;
+		Split(std::move(rest), lengthBlock, middle, after);
+		const T *source = middle->block.data();
+		NodePtr rebuilt = Build(lengthBlock, [source](T *destination, ptrdiff_t offset, ptrdiff_t count) {
+			std::move(source + offset, source + offset + count, destination);
+		});
+		middle.reset();
+		root = Merge(Merge(std::move(before), std::move(rebuilt)), std::move(after));
+	}
+
+	template <typename Fill>
+	void InsertWith(ptrdiff_t position, ptrdiff_t insertLength, Fill fill) {
+		Rechunk(position, true);
+		ptrdiff_t blockStart = 0;
+		Node *node = Locate(position, true, blockStart);
+		if (node && ((node->length + insertLength) <= blockSize)) {
+			// Common case: fits inside an existing block
+			const ptrdiff_t offset = position - blockStart;
+			node->block.resize(node->length + insertLength);
+			std::move_backward(node->block.data() + offset, node->block.data() + node->length,
+				node->block.data() + node->length + insertLength);
+			fill(node->block.data() + offset, 0, insertLength);
+			node->length += insertLength;
+			AdjustTotals(position, true, insertLength);
+			return;
+		}
+		NodePtr before;
+		NodePtr after;
+		Split(std::move(root), position, before, after);
+		NodePtr middle = Build(insertLength, fill);
+		root = Merge(Merge(std::move(before), std::move(middle)), std::move(after));
+		JoinAt(position);
+		JoinAt(position + insertLength);
+	}
+
+	/// Copy all the elements of a subtree into buffer.
+	static T *CopyOut(const Node *node, T *buffer) {
+		if (node) {
+			buffer = CopyOut(node->left.get(), buffer);
+			buffer = std::copy(node->block.data(), node->block.data() + node->length, buffer);
+			buffer = CopyOut(node->right.get(), buffer);
+		}
+		return buffer;
+	}
+
+	/// Call fn(blockData, offsetInRange, count) for each block overlapping [position, position+rangeLength)
+	/// in position order. Only visits overlapping subtrees so O(log n + blocks).
+	template <typename Visitor>
+	static void Visit(Node *node, ptrdiff_t nodeStart, ptrdiff_t position, ptrdiff_t end, Visitor &fn) {
+		if (!node) {
+			return;
+		}
+		const ptrdiff_t blockStart = nodeStart + Total(node->left);
+		const ptrdiff_t blockEnd = blockStart + node->length;
+		if (position < blockStart) {
+			Visit(node->left.get(), nodeStart, position, end, fn);
+		}
+		if ((position < blockEnd) && (end > blockStart)) {
+			const ptrdiff_t first = std::max(position, blockStart);
+			const ptrdiff_t last = std::min(end, blockEnd);
+			fn(node->block.data() + first - blockStart, first - position, last - first);
+		}
+		if (end > blockEnd) {
+			Visit(node->right.get(), blockEnd, position, end, fn);
+		}
+	}
+
+public:
+	/// Construct an empty rope. Blocks hold up to blockSize_ elements.
+	explicit RopeVector(ptrdiff_t blockSize_=4096) : empty(), blockSize(blockSize_), seed(2463534242U) {
+	}
+
+	ptrdiff_t GetBlockSize() const noexcept {
+		return blockSize;
+	}
+
+	/// Storage is allocated as needed so there is no benefit to preallocating.
+	void ReAllocate(size_t) noexcept {
+	}
+
+	/// Retrieve the element at a particular position.
+	/// Retrieving positions outside the range of the buffer returns empty or 0.
+	const T &ValueAt(ptrdiff_t position) const noexcept {
+		if ((position < 0) || (position >= Length())) {
+			return empty;
+		}
+		ptrdiff_t blockStart = 0;
+		const Node *node = Locate(position, false, blockStart);
+		return node->block[position - blockStart];
+	}
+
+	/// Set the element at a particular position.
+	/// Setting positions outside the range of the buffer performs no assignment
+	/// but asserts in debug builds.
+	template <typename ParamType>
+	void SetValueAt(ptrdiff_t position, ParamType &&v) noexcept {
+		PLATFORM_ASSERT((position >= 0) && (position < Length()));
+		if ((position < 0) || (position >= Length())) {
+			return;
+		}
+		ptrdiff_t blockStart = 0;
+		Node *node = Locate(position, false, blockStart);
+		node->block[position - blockStart] = std::forward<ParamType>(v);
+	}
+
+	/// Retrieve the length of the buffer.
+	ptrdiff_t Length() const noexcept {
+		return Total(root);
+	}
+
+	/// Insert a number of elements into the buffer setting their value.
+	/// Inserting at positions outside the current range fails.
+	void InsertValue(ptrdiff_t position, ptrdiff_t insertLength, T v) {
+		PLATFORM_ASSERT((position >= 0) && (position <= Length()));
+		if ((insertLength <= 0) || (position < 0) || (position > Length())) {
+			return;
+		}
+		InsertWith(position, insertLength, [&v](T *destination, ptrdiff_t, ptrdiff_t count) {
+			std::fill(destination, destination + count, v);
+		});
+	}
+
+	/// Insert text into the buffer from an array.
+	void InsertFromArray(ptrdiff_t positionToInsert, const T s[], ptrdiff_t positionFrom, ptrdiff_t insertLength) {
+		PLATFORM_ASSERT((positionToInsert >= 0) && (positionToInsert <= Length()));
+		if ((insertLength <= 0) || (positionToInsert < 0) || (positionToInsert > Length())) {
+			return;
+		}
+		const T *source = s + positionFrom;
+		InsertWith(positionToInsert, insertLength, [source](T *destination, ptrdiff_t offset, ptrdiff_t count) {
+			std::copy(source + offset, source + offset + count, destination);
+		});
+	}
+
+	/// Delete a range from the buffer.
+	/// Deleting positions outside the current range fails.
+	void DeleteRange(ptrdiff_t position, ptrdiff_t deleteLength) {
+		PLATFORM_ASSERT((position >= 0) && (position + deleteLength <= Length()));
+		if ((position < 0) || ((position + deleteLength) > Length()) || (deleteLength <= 0)) {
+			return;
+		}
+		if ((position == 0) && (deleteLength == Length())) {
+			// Full deallocation returns storage and is faster
+			DeleteAll();
+			return;
+		}
+		Rechunk(position, false);
+		ptrdiff_t blockStart = 0;
+		Node *node = Locate(position, false, blockStart);
+		const ptrdiff_t offset = position - blockStart;
+		if (node && ((offset + deleteLength) < node->length)) {
+			// Common case: within a block and does not empty it
+			std::move(node->block.data() + offset + deleteLength, node->block.data() + node->length,
+				node->block.data() + offset);
+			node->length -= deleteLength;
+			node->block.resize(node->length);
+			AdjustTotals(position, false, -deleteLength);
+		} else {
+			NodePtr before;
+			NodePtr rest;
+			Split(std::move(root), position, before, rest);
+			NodePtr middle;
+			NodePtr after;
+			Split(std::move(rest), deleteLength, middle, after);
+			middle.reset();
+			root = Merge(std::move(before), std::move(after));
+		}
+		JoinAt(position);
+	}
+
+	/// Delete all the buffer contents.
+	void DeleteAll() noexcept {
+		root.reset();
+	}
+
+	/// Retrieve a range of elements into an array
+	void GetRange(T *buffer, ptrdiff_t position, ptrdiff_t retrieveLength) const {
+		auto copier = [buffer](const T *data, ptrdiff_t offset, ptrdiff_t count) {
+			std::copy(data, data + count, buffer + offset);
+		};
+		Visit(root.get(), 0, position, position + retrieveLength, copier);
+	}
+
+	/// Set a range of elements to a value.
+	/// @return true if any element changed.
+	bool FillRange(ptrdiff_t position, ptrdiff_t fillLength, T v) noexcept {
+		bool changed = false;
+		auto filler = [&changed, &v](T *data, ptrdiff_t, ptrdiff_t count) noexcept {
+			for (ptrdiff_t i = 0; i < count; i++) {
+				if (data[i] != v) {
+					data[i] = v;
+					changed = true;
+				}
+			}
+		};
+		Visit(root.get(), 0, position, position + fillLength, filler);
+		return changed;
+	}
+
+	/// Join all the blocks into one and return a pointer to the first element.
+	/// Also ensures there is an empty element beyond logical end in case its
+	/// passed to a function expecting a NUL terminated string.
+	T *BufferPointer() {
+		const ptrdiff_t length = Length();
+		if (!root || root->left || root->right) {
+			NodePtr node = NewNode(length);
+			CopyOut(root.get(), node->block.data());
+			root = std::move(node);
+		}
+		root->block.resize(length + 1);
+		root->block[length] = T();
+		return root->block.data();
+	}
+
+	/// Return a pointer to a range of elements, first joining blocks if
+	/// needed to make that range contiguous.
+	T *RangePointer(ptrdiff_t position, ptrdiff_t rangeLength) {
+		if ((position < 0) || (rangeLength <= 0) || ((position + rangeLength) > Length())) {
+			return nullptr;
+		}
+		ptrdiff_t blockStart = 0;
+		Node *node = Locate(position, false, blockStart);
+		if ((position + rangeLength) > (blockStart + node->length)) {
+			node = Coalesce(position, rangeLength);
+			blockStart = position;
+		}
+		return node->block.data() + position - blockStart;
+	}
+
+	/// Return a pointer to the contiguous block containing position along with the
+	/// range of positions in that block.
+	const T *SegmentAt(ptrdiff_t position, ptrdiff_t &segmentStart, ptrdiff_t &segmentLength) const noexcept {
+		ptrdiff_t blockStart = 0;
+		const Node *node = Locate(position, false, blockStart);
+		if (!node) {
+			segmentStart = 0;
+			segmentLength = 0;
+			return nullptr;
+		}
+		segmentStart = blockStart;
+		segmentLength = node->length;
+		return node->block.data();
+	}
+
+	/// There is no gap but RangePointer calls that do not cross from the first block
+	/// are cheap so return the end of the first block.
+	ptrdiff_t GapPosition() const noexcept {
+		ptrdiff_t segmentStart = 0;
+		ptrdiff_t segmentLength = 0;
+		SegmentAt(0, segmentStart, segmentLength);
+		return segmentLength;
+	}
+
+	/// Number of blocks and depth of tree for checking balance in tests.
+	ptrdiff_t Blocks() const noexcept {
+		ptrdiff_t blocks = 0;
+		auto counter = [&blocks](const T *, ptrdiff_t, ptrdiff_t) noexcept {
+			blocks++;
+		};
+		Visit(root.get(), 0, 0, Length(), counter);
+		return blocks;
+	}
+
+	int Depth() const noexcept {
+		return Depth(root.get());
+	}
+
+	static int Depth(const Node *node) noexcept {
+		if (!node) {
+			return 0;
+		}
+		return 1 + std::max(Depth(node->left.get()), Depth(node->right.get()));
+	}
+
+	void Check() const {
+#ifdef CHECK_CORRECTNESS
+		if (Length() > 0) {
+			Check(root.get());
+		}
+#endif
+	}
+
+	static void Check(const Node *node) {
+		if (node) {
+			Check(node->left.get());
+			Check(node->right.get());
+			if (node->length <= 0) {
+				throw std::runtime_error("RopeVector: Empty block.");
+			}
+			if (node->total != Total(node->left) + node->length + Total(node->right)) {
+				throw std::runtime_error("RopeVector: Inconsistent total.");
+			}
+			if ((node->left && (node->left->priority > node->priority)) ||
+				(node->right && (node->right->priority > node->priority))) {
+				throw std::runtime_error("RopeVector: Heap order violated.");
+			}
+		}
+	}
+};
+
+}
+
+#endif
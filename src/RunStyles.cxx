@@ -24,13 +24,14 @@
 #include "Position.h"
 #include "SplitVector.h"
 #include "Partitioning.h"
+#include "TreePartitioning.h"
 #include "RunStyles.h"
 
 using namespace Scintilla::Internal;
 
 // Find the first run at a position
-template <typename DISTANCE, typename STYLE>
-DISTANCE RunStyles<DISTANCE, STYLE>::RunFromPosition(DISTANCE position) const noexcept {
+template <typename DISTANCE, typename STYLE, typename PARTITIONING>
+DISTANCE RunStyles<DISTANCE, STYLE, PARTITIONING>::RunFromPosition(DISTANCE position) const noexcept {
 	DISTANCE run = starts.PartitionFromPosition(position);
 	// Go to first element with this position
 	while ((run > 0) && (position == starts.PositionFromPartition(run-1))) {
@@ -40,8 +41,8 @@ DISTANCE RunStyles<DISTANCE, STYLE>::RunFromPosition(DISTANCE position) const no
 }
 
 // If there is no run boundary at position, insert one continuing style.
-template <typename DISTANCE, typename STYLE>
-DISTANCE RunStyles<DISTANCE, STYLE>::SplitRun(DISTANCE position) {
+template <typename DISTANCE, typename STYLE, typename PARTITIONING>
+DISTANCE RunStyles<DISTANCE, STYLE, PARTITIONING>::SplitRun(DISTANCE position) {
 	DISTANCE run = RunFromPosition(position);
 	const DISTANCE posRun = starts.PositionFromPartition(run);
 	if (posRun < position) {
@@ -53,14 +54,14 @@ DISTANCE RunStyles<DISTANCE, STYLE>::SplitRun(DISTANCE position) {
 	return run;
 }
 
-template <typename DISTANCE, typename STYLE>
-void RunStyles<DISTANCE, STYLE>::RemoveRun(DISTANCE run) {
+template <typename DISTANCE, typename STYLE, typename PARTITIONING>
+void RunStyles<DISTANCE, STYLE, PARTITIONING>::RemoveRun(DISTANCE run) {
 	starts.RemovePartition(run);
 	styles.DeleteRange(run, 1);
 }
 
-template <typename DISTANCE, typename STYLE>
-void RunStyles<DISTANCE, STYLE>::RemoveRunIfEmpty(DISTANCE run) {
+template <typename DISTANCE, typename STYLE, typename PARTITIONING>
+void RunStyles<DISTANCE, STYLE, PARTITIONING>::RemoveRunIfEmpty(DISTANCE run) {
 	if ((run < starts.Partitions()) && (starts.Partitions() > 1)) {
 		if (starts.PositionFromPartition(run) == starts.PositionFromPartition(run+1)) {
 			RemoveRun(run);
@@ -68,8 +69,8 @@ void RunStyles<DISTANCE, STYLE>::RemoveRunIfEmpty(DISTANCE run) {
 	}
 }
 
-template <typename DISTANCE, typename STYLE>
-void RunStyles<DISTANCE, STYLE>::RemoveRunIfSameAsPrevious(DISTANCE run) {
+template <typename DISTANCE, typename STYLE, typename PARTITIONING>
+void RunStyles<DISTANCE, STYLE, PARTITIONING>::RemoveRunIfSameAsPrevious(DISTANCE run) {
 	if ((run > 0) && (run < starts.Partitions())) {
 		const DISTANCE runBefore = run - 1;
 		if (styles.ValueAt(runBefore) == styles.ValueAt(run)) {
@@ -78,25 +79,25 @@ void RunStyles<DISTANCE, STYLE>::RemoveRunIfSameAsPrevious(DISTANCE run) {
 	}
 }
 
-template <typename DISTANCE, typename STYLE>
-RunStyles<DISTANCE, STYLE>::RunStyles() {
-	starts = Partitioning<DISTANCE>(8);
+template <typename DISTANCE, typename STYLE, typename PARTITIONING>
+RunStyles<DISTANCE, STYLE, PARTITIONING>::RunStyles() {
+	starts = PARTITIONING(8);
 	styles = SplitVector<STYLE>();
 	styles.InsertValue(0, 2, 0);
 }
 
-template <typename DISTANCE, typename STYLE>
-DISTANCE RunStyles<DISTANCE, STYLE>::Length() const noexcept {
+template <typename DISTANCE, typename STYLE, typename PARTITIONING>
+DISTANCE RunStyles<DISTANCE, STYLE, PARTITIONING>::Length() const noexcept {
 	return starts.PositionFromPartition(starts.Partitions());
 }
 
-template <typename DISTANCE, typename STYLE>
-STYLE RunStyles<DISTANCE, STYLE>::ValueAt(DISTANCE position) const noexcept {
+template <typename DISTANCE, typename STYLE, typename PARTITIONING>
+STYLE RunStyles<DISTANCE, STYLE, PARTITIONING>::ValueAt(DISTANCE position) const noexcept {
 	return styles.ValueAt(starts.PartitionFromPosition(position));
 }
 
-template <typename DISTANCE, typename STYLE>
-DISTANCE RunStyles<DISTANCE, STYLE>::FindNextChange(DISTANCE position, DISTANCE end) const noexcept {
+template <typename DISTANCE, typename STYLE, typename PARTITIONING>
+DISTANCE RunStyles<DISTANCE, STYLE, PARTITIONING>::FindNextChange(DISTANCE position, DISTANCE end) const noexcept {
 	const DISTANCE run = starts.PartitionFromPosition(position);
 	if (run < starts.Partitions()) {
 		const DISTANCE runChange = starts.PositionFromPartition(run);
@@ -115,18 +116,18 @@ DISTANCE RunStyles<DISTANCE, STYLE>::FindNextChange(DISTANCE position, DISTANCE
 	}
 }
 
-template <typename DISTANCE, typename STYLE>
-DISTANCE RunStyles<DISTANCE, STYLE>::StartRun(DISTANCE position) const noexcept {
+template <typename DISTANCE, typename STYLE, typename PARTITIONING>
+DISTANCE RunStyles<DISTANCE, STYLE, PARTITIONING>::StartRun(DISTANCE position) const noexcept {
 	return starts.PositionFromPartition(starts.PartitionFromPosition(position));
 }
 
-template <typename DISTANCE, typename STYLE>
-DISTANCE RunStyles<DISTANCE, STYLE>::EndRun(DISTANCE position) const noexcept {
+template <typename DISTANCE, typename STYLE, typename PARTITIONING>
+DISTANCE RunStyles<DISTANCE, STYLE, PARTITIONING>::EndRun(DISTANCE position) const noexcept {
 	return starts.PositionFromPartition(starts.PartitionFromPosition(position) + 1);
 }
 
-template <typename DISTANCE, typename STYLE>
-FillResult<DISTANCE> RunStyles<DISTANCE, STYLE>::FillRange(DISTANCE position, STYLE value, DISTANCE fillLength) {
+template <typename DISTANCE, typename STYLE, typename PARTITIONING>
+FillResult<DISTANCE> RunStyles<DISTANCE, STYLE, PARTITIONING>::FillRange(DISTANCE position, STYLE value, DISTANCE fillLength) {
 	const FillResult<DISTANCE> resultNoChange{false, position, fillLength};
 	if (fillLength <= 0) {
 		return resultNoChange;
@@ -177,13 +178,13 @@ FillResult<DISTANCE> RunStyles<DISTANCE, STYLE>::FillRange(DISTANCE position, ST
 	}
 }
 
-template <typename DISTANCE, typename STYLE>
-void RunStyles<DISTANCE, STYLE>::SetValueAt(DISTANCE position, STYLE value) {
+template <typename DISTANCE, typename STYLE, typename PARTITIONING>
+void RunStyles<DISTANCE, STYLE, PARTITIONING>::SetValueAt(DISTANCE position, STYLE value) {
 	FillRange(position, value, 1);
 }
 
-template <typename DISTANCE, typename STYLE>
-void RunStyles<DISTANCE, STYLE>::InsertSpace(DISTANCE position, DISTANCE insertLength) {
+template <typename DISTANCE, typename STYLE, typename PARTITIONING>
+void RunStyles<DISTANCE, STYLE, PARTITIONING>::InsertSpace(DISTANCE position, DISTANCE insertLength) {
 	DISTANCE runStart = RunFromPosition(position);
 	if (starts.PositionFromPartition(runStart) == position) {
 		STYLE runStyle = ValueAt(position);
@@ -211,15 +212,15 @@ void RunStyles<DISTANCE, STYLE>::InsertSpace(DISTANCE position, DISTANCE insertL
 	}
 }
 
-template <typename DISTANCE, typename STYLE>
-void RunStyles<DISTANCE, STYLE>::DeleteAll() {
-	starts = Partitioning<DISTANCE>(8);
+template <typename DISTANCE, typename STYLE, typename PARTITIONING>
+void RunStyles<DISTANCE, STYLE, PARTITIONING>::DeleteAll() {
+	starts = PARTITIONING(8);
 	styles = SplitVector<STYLE>();
 	styles.InsertValue(0, 2, 0);
 }
 
-template <typename DISTANCE, typename STYLE>
-void RunStyles<DISTANCE, STYLE>::DeleteRange(DISTANCE position, DISTANCE deleteLength) {
+template <typename DISTANCE, typename STYLE, typename PARTITIONING>
+void RunStyles<DISTANCE, STYLE, PARTITIONING>::DeleteRange(DISTANCE position, DISTANCE deleteLength) {
 	DISTANCE end = position + deleteLength;
 	DISTANCE runStart = RunFromPosition(position);
 	DISTANCE runEnd = RunFromPosition(end);
@@ -240,13 +241,13 @@ void RunStyles<DISTANCE, STYLE>::DeleteRange(DISTANCE position, DISTANCE deleteL
 	}
 }
 
-template <typename DISTANCE, typename STYLE>
-DISTANCE RunStyles<DISTANCE, STYLE>::Runs() const noexcept {
+template <typename DISTANCE, typename STYLE, typename PARTITIONING>
+DISTANCE RunStyles<DISTANCE, STYLE, PARTITIONING>::Runs() const noexcept {
 	return starts.Partitions();
 }
 
-template <typename DISTANCE, typename STYLE>
-bool RunStyles<DISTANCE, STYLE>::AllSame() const noexcept {
+template <typename DISTANCE, typename STYLE, typename PARTITIONING>
+bool RunStyles<DISTANCE, STYLE, PARTITIONING>::AllSame() const noexcept {
 	for (DISTANCE run = 1; run < starts.Partitions(); run++) {
 		const DISTANCE runBefore = run - 1;
 		if (styles.ValueAt(run) != styles.ValueAt(runBefore))
@@ -255,13 +256,13 @@ bool RunStyles<DISTANCE, STYLE>::AllSame() const noexcept {
 	return true;
 }
 
-template <typename DISTANCE, typename STYLE>
-bool RunStyles<DISTANCE, STYLE>::AllSameAs(STYLE value) const noexcept {
+template <typename DISTANCE, typename STYLE, typename PARTITIONING>
+bool RunStyles<DISTANCE, STYLE, PARTITIONING>::AllSameAs(STYLE value) const noexcept {
 	return AllSame() && (styles.ValueAt(0) == value);
 }
 
-template <typename DISTANCE, typename STYLE>
-DISTANCE RunStyles<DISTANCE, STYLE>::Find(STYLE value, DISTANCE start) const noexcept {
+template <typename DISTANCE, typename STYLE, typename PARTITIONING>
+DISTANCE RunStyles<DISTANCE, STYLE, PARTITIONING>::Find(STYLE value, DISTANCE start) const noexcept {
 	if (start < Length()) {
 		DISTANCE run = start ? RunFromPosition(start) : 0;
 		if (styles.ValueAt(run) == value)
@@ -276,8 +277,8 @@ DISTANCE RunStyles<DISTANCE, STYLE>::Find(STYLE value, DISTANCE start) const noe
 	return -1;
 }
 
-template <typename DISTANCE, typename STYLE>
-void RunStyles<DISTANCE, STYLE>::Check() const {
+template <typename DISTANCE, typename STYLE, typename PARTITIONING>
+void RunStyles<DISTANCE, STYLE, PARTITIONING>::Check() const {
 	if (Length() < 0) {
 		throw std::runtime_error("RunStyles: Length can not be negative.");
 	}
@@ -311,3 +312,9 @@ template class Scintilla::Internal::RunStyles<int, char>;
 template class Scintilla::Internal::RunStyles<ptrdiff_t, int>;
 template class Scintilla::Internal::RunStyles<ptrdiff_t, char>;
 #endif
+template class Scintilla::Internal::RunStyles<int, int, TreePartitioning<int>>;
+template class Scintilla::Internal::RunStyles<int, char, TreePartitioning<int>>;
+#if (PTRDIFF_MAX != INT_MAX) || defined(__HAIKU__)
+template class Scintilla::Internal::RunStyles<ptrdiff_t, int, TreePartitioning<ptrdiff_t>>;
+template class Scintilla::Internal::RunStyles<ptrdiff_t, char, TreePartitioning<ptrdiff_t>>;
+#endif
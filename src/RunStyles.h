@@ -22,10 +22,11 @@ struct FillResult {
 	DISTANCE fillLength;
 };
 
-template <typename DISTANCE, typename STYLE>
+/// PARTITIONING may be Partitioning or TreePartitioning which is faster for very many runs.
+template <typename DISTANCE, typename STYLE, typename PARTITIONING=Partitioning<DISTANCE>>
 class RunStyles {
 private:
-	Partitioning<DISTANCE> starts;
+	PARTITIONING starts;
 	SplitVector<STYLE> styles;
 	DISTANCE RunFromPosition(DISTANCE position) const noexcept;
 	DISTANCE SplitRun(DISTANCE position);
@@ -0,0 +1,79 @@
+// Scintilla source code edit control
+/** @file SplitVector.cxx
+ ** Vectorized addition of a delta to the elements of a SplitVector.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <cstddef>
+
+#include <stdexcept>
+#include <vector>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SCI_ADD_DELTA_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "Debugging.h"
+
+#include "SplitVector.h"
+
+namespace Scintilla::Internal {
+
+namespace {
+
+// Add delta to 32-bit or 64-bit integers two SSE2 vectors at a time
+template <typename T>
+void AddDeltaVectors(T *values, ptrdiff_t length, T delta) noexcept {
+	static_assert(sizeof(T) == 4 || sizeof(T) == 8);
+	ptrdiff_t i = 0;
+#if defined(SCI_ADD_DELTA_SSE2)
+	constexpr ptrdiff_t step = 2 * 16 / sizeof(T);
+	const ptrdiff_t lengthVectors = length - length % step;
+	if constexpr (sizeof(T) == 4) {
+		const __m128i deltas = _mm_set1_epi32(static_cast<int>(delta));
+		for (; i < lengthVectors; i += step) {
+			__m128i *vectors = reinterpret_cast<__m128i *>(values + i);
+			const __m128i first = _mm_loadu_si128(vectors);
+			const __m128i second = _mm_loadu_si128(vectors + 1);
+			_mm_storeu_si128(vectors, _mm_add_epi32(first, deltas));
+			_mm_storeu_si128(vectors + 1, _mm_add_epi32(second, deltas));
+		}
+	} else {
+		const __m128i deltas = _mm_set1_epi64x(static_cast<long long>(delta));
+		for (; i < lengthVectors; i += step) {
+			__m128i *vectors = reinterpret_cast<__m128i *>(values + i);
+			const __m128i first = _mm_loadu_si128(vectors);
+			const __m128i second = _mm_loadu_si128(vectors + 1);
+			_mm_storeu_si128(vectors, _mm_add_epi64(first, deltas));
+			_mm_storeu_si128(vectors + 1, _mm_add_epi64(second, deltas));
+		}
+	}
+#endif
+	for (; i < length; i++) {
+		values[i] += delta;
+	}
+}
+
+}
+
+// Defined for each signed integer type that may be a Sci::Position or Sci::Line
+// so every SplitVector<int> and SplitVector<ptrdiff_t> links on any target.
+
+template <>
+void AddDelta<int>(int *values, ptrdiff_t length, int delta) noexcept {
+	AddDeltaVectors(values, length, delta);
+}
+
+template <>
+void AddDelta<long>(long *values, ptrdiff_t length, long delta) noexcept {
+	AddDeltaVectors(values, length, delta);
+}
+
+template <>
+void AddDelta<long long>(long long *values, ptrdiff_t length, long long delta) noexcept {
+	AddDeltaVectors(values, length, delta);
+}
+
+}
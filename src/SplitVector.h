@@ -11,6 +11,23 @@
 
 namespace Scintilla::Internal {
 
+/// Add delta to each of length values.
+template <typename T>
+void AddDelta(T *values, ptrdiff_t length, T delta) noexcept {
+	for (ptrdiff_t i = 0; i < length; i++) {
+		values[i] += delta;
+	}
+}
+
+/// This is the hot loop when moving the positions of many lines or runs after an edit
+/// so positions are processed in vectors when available. Implemented in SplitVector.cxx.
+template <>
+void AddDelta<int>(int *values, ptrdiff_t length, int delta) noexcept;
+template <>
+void AddDelta<long>(long *values, ptrdiff_t length, long delta) noexcept;
+template <>
+void AddDelta<long long>(long long *values, ptrdiff_t length, long long delta) noexcept;
+
 template <typename T>
 class SplitVector {
 protected:
@@ -328,6 +345,53 @@ public:
 		}
 	}
 
+	/// Return a pointer to the contiguous part of the buffer, before or after the gap,
+	/// containing position along with the range of positions in that part.
+	const T *SegmentAt(ptrdiff_t position, ptrdiff_t &segmentStart, ptrdiff_t &segmentLength) const noexcept {
+		if (position < part1Length) {
+			segmentStart = 0;
+			segmentLength = part1Length;
+			return body.data();
+		} else {
+			segmentStart = part1Length;
+			segmentLength = lengthBody - part1Length;
+			return body.data() + part1Length + gapLength;
+		}
+	}
+
+	/// Set a range of elements to a value.
+	/// @return true if any element changed.
+	bool FillRange(ptrdiff_t position, ptrdiff_t fillLength, T v) noexcept {
+		PLATFORM_ASSERT((position >= 0) && (position + fillLength <= lengthBody));
+		if ((position < 0) || ((position + fillLength) > lengthBody)) {
+			return false;
+		}
+		bool changed = false;
+		for (ptrdiff_t i = position; i < position + fillLength; i++) {
+			T &element = (*this)[i];
+			if (element != v) {
+				element = v;
+				changed = true;
+			}
+		}
+		return changed;
+	}
+
+	/// Add delta to a range of elements on both sides of the gap.
+	void RangeAddDelta(ptrdiff_t position, ptrdiff_t rangeLength, T delta) noexcept {
+		PLATFORM_ASSERT((position >= 0) && (position + rangeLength <= lengthBody));
+		if ((position < 0) || (rangeLength <= 0) || ((position + rangeLength) > lengthBody)) {
+			return;
+		}
+		const ptrdiff_t range1Length = std::clamp<ptrdiff_t>(part1Length - position, 0, rangeLength);
+		if (range1Length > 0) {
+			AddDelta(body.data() + position, range1Length, delta);
+		}
+		if (range1Length < rangeLength) {
+			AddDelta(body.data() + gapLength + position + range1Length, rangeLength - range1Length, delta);
+		}
+	}
+
 	/// Return the position of the gap within the buffer.
 	ptrdiff_t GapPosition() const noexcept {
 		return part1Length;
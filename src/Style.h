@@ -37,6 +37,9 @@ struct FontMeasurements {
 	XYPOSITION spaceWidth = 1;
 	bool monospaceASCII = false;
 	int sizeZoomed = 2;
+	// Widths of ASCII characters when positions in a run are the sum of the widths
+	// of its characters, so no kerning or ligatures. Otherwise null.
+	std::shared_ptr<const std::vector<XYPOSITION>> asciiWidths;
 };
 
 /**
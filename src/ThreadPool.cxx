@@ -0,0 +1,150 @@
+// Scintilla source code edit control
+/** @file ThreadPool.cxx
+ ** Defines a pool of worker threads that perform tasks with the calling thread.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <cstddef>
+
+#include <stdexcept>
+#include <exception>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "ThreadPool.h"
+
+using namespace Scintilla::Internal;
+
+ThreadPool::ThreadPool() noexcept = default;
+
+ThreadPool::~ThreadPool() {
+	Stop();
+}
+
+void ThreadPool::Work() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		cvStart.wait(lock, [this]() {
+			return stopping || (nextParticipant < participants);
+		});
+		if (stopping) {
+			return;
+		}
+		const size_t participant = nextParticipant++;
+		const std::function<void(size_t)> *taskCurrent = task;
+		lock.unlock();
+		std::exception_ptr exceptionTask;
+		try {
+			(*taskCurrent)(participant);
+		} catch (...) {
+			exceptionTask = std::current_exception();
+		}
+		lock.lock();
+		if (exceptionTask && !exception) {
+			exception = exceptionTask;
+		}
+		finished++;
+		if (finished == participants) {
+			cvFinish.notify_one();
+		}
+	}
+}
+
+// Ensure there are enough workers for threads participants including the caller.
+// Failure to create a thread is not an error as the task can be run by fewer threads.
+void ThreadPool::Start(size_t threads) {
+	try {
+		while (workers.size() + 1 < threads) {
+			workers.emplace_back(&ThreadPool::Work, this);
+		}
+	} catch (const std::system_error &) {
+		// Continue with the workers already started
+	}
+}
+
+void ThreadPool::Stop() noexcept {
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		stopping = true;
+	}
+	cvStart.notify_all();
+	for (std::thread &worker : workers) {
+		try {
+			worker.join();
+		} catch (const std::system_error &) {
+			// Thread already finished
+		}
+	}
+	workers.clear();
+	stopping = false;
+}
+
+size_t ThreadPool::Threads() const noexcept {
+	return workers.size() + 1;
+}
+
+void ThreadPool::Run(size_t threads, const std::function<void(size_t)> &task_) {
+	// Claim the pool in the same critical section that checks it so only one caller
+	// starts workers and hands them a task.
+	bool claimed = false;
+	if (threads > 1) {
+		std::lock_guard<std::mutex> guard(mutex);
+		if (!running) {
+			running = true;
+			claimed = true;
+		}
+	}
+	if (claimed) {
+		Start(threads);
+		if (workers.empty()) {
+			std::lock_guard<std::mutex> guard(mutex);
+			running = false;
+			claimed = false;
+		}
+	}
+	if (!claimed) {
+		// Run on this thread when single threaded, unable to start workers, or
+		// called while a task is running, either from inside it or from another thread.
+		task_(0);
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+	task = &task_;
+	participants = std::min(threads, workers.size() + 1);
+	nextParticipant = 1;
+	finished = 1;
+	lock.unlock();
+	cvStart.notify_all();
+
+	std::exception_ptr exceptionCaller;
+	try {
+		task_(0);
+	} catch (...) {
+		exceptionCaller = std::current_exception();
+	}
+
+	lock.lock();
+	cvFinish.wait(lock, [this]() {
+		return finished == participants;
+	});
+	std::exception_ptr exceptionWorker = exception;
+	exception = nullptr;
+	task = nullptr;
+	participants = 0;
+	nextParticipant = 0;
+	finished = 0;
+	running = false;
+	lock.unlock();
+
+	if (exceptionCaller) {
+		std::rethrow_exception(exceptionCaller);
+	}
+	if (exceptionWorker) {
+		std::rethrow_exception(exceptionWorker);
+	}
+}
@@ -0,0 +1,49 @@
+// Scintilla source code edit control
+/** @file ThreadPool.h
+ ** Defines a pool of worker threads that perform tasks with the calling thread.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+namespace Scintilla::Internal {
+
+/**
+ * Threads are started when first needed then wait for further work instead of
+ * exiting so that repeated parallel layout does not pay for creating threads.
+ * A task is called by up to the requested number of participants, each with a
+ * different index, and index 0 is the calling thread. Tasks share work by taking
+ * items from an atomic counter so results do not depend on how many participate.
+ * Only one task runs at a time: a task started from inside a task runs on its thread.
+ */
+class ThreadPool {
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable cvStart;
+	std::condition_variable cvFinish;
+	const std::function<void(size_t)> *task = nullptr;
+	size_t participants = 0;
+	size_t nextParticipant = 0;
+	size_t finished = 0;
+	bool running = false;
+	bool stopping = false;
+	std::exception_ptr exception;
+	void Work();
+	void Start(size_t threads);
+public:
+	ThreadPool() noexcept;
+	// Deleted so ThreadPool objects can not be copied.
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool(ThreadPool &&) = delete;
+	void operator=(const ThreadPool &) = delete;
+	void operator=(ThreadPool &&) = delete;
+	~ThreadPool();
+	void Stop() noexcept;
+	size_t Threads() const noexcept;
+	void Run(size_t threads, const std::function<void(size_t)> &task_);
+};
+
+}
+
+#endif
@@ -0,0 +1,438 @@
+// Scintilla source code edit control
+/** @file TreePartitioning.h
+ ** Data structure used to partition an interval with logarithmic time updates.
+ ** Used for holding line start positions in documents with very many lines.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef TREEPARTITIONING_H
+#define TREEPARTITIONING_H
+
+namespace Scintilla::Internal {
+
+/// Binary indexed (Fenwick) tree over a sequence of values.
+/// Prefix sums, changing a value, and searching for a prefix sum are logarithmic.
+/// Inserting and removing values needs the tree to be flattened into the plain values,
+/// changed, then rebuilt which is linear.
+
+template <typename T>
+class FenwickTree {
+	// Element 0 is unused so that index arithmetic is simple
+	std::vector<T> tree;
+	size_t highBit = 0;
+
+	static constexpr size_t LowBit(size_t i) noexcept {
+		return i & (~i + 1);
+	}
+	void SetHighBit() noexcept {
+		highBit = 0;
+		if (Length() > 0) {
+			highBit = 1;
+			while (highBit * 2 <= Length())
+				highBit *= 2;
+		}
+	}
+
+public:
+	FenwickTree() : tree(1) {
+	}
+
+	size_t Length() const noexcept {
+		return tree.size() - 1;
+	}
+
+	void Add(size_t index, T delta) noexcept {
+		for (size_t i = index + 1; i < tree.size(); i += LowBit(i)) {
+			tree[i] += delta;
+		}
+	}
+
+	/// Sum of the first count values
+	T Sum(size_t count) const noexcept {
+		T sum = 0;
+		for (size_t i = count; i > 0; i -= LowBit(i)) {
+			sum += tree[i];
+		}
+		return sum;
+	}
+
+	/// Return the largest count with Sum(count) <= value with remainder set to the difference.
+	/// Only valid when no values are negative.
+	size_t Search(T value, T &remainder) const noexcept {
+		size_t count = 0;
+		for (size_t step = highBit; step > 0; step >>= 1) {
+			const size_t next = count + step;
+			if ((next < tree.size()) && (tree[next] <= value)) {
+				count = next;
+				value -= tree[next];
+			}
+		}
+		remainder = value;
+		return count;
+	}
+
+	void PushBack(T value) {
+		const size_t i = tree.size();
+		tree.push_back(value + Sum(i - 1) - Sum(i - LowBit(i)));
+		if (highBit * 2 <= Length())
+			highBit = highBit ? highBit * 2 : 1;
+	}
+
+	/// Convert to plain values which can be modified with Value, Insert, and Erase.
+	void Flatten() noexcept {
+		for (size_t i = Length(); i > 0; i--) {
+			const size_t parent = i + LowBit(i);
+			if (parent < tree.size())
+				tree[parent] -= tree[i];
+		}
+	}
+
+	/// Convert plain values back to a tree.
+	void Build() noexcept {
+		for (size_t i = 1; i < tree.size(); i++) {
+			const size_t parent = i + LowBit(i);
+			if (parent < tree.size())
+				tree[parent] += tree[i];
+		}
+		SetHighBit();
+	}
+
+	T &Value(size_t index) noexcept {
+		return tree[index + 1];
+	}
+
+	template <typename ForwardIt>
+	void Insert(size_t index, ForwardIt first, ForwardIt last) {
+		tree.insert(tree.begin() + index + 1, first, last);
+	}
+
+	void Erase(size_t index) {
+		tree.erase(tree.begin() + index + 1);
+	}
+
+	void Clear() noexcept {
+		tree.resize(1);
+		highBit = 0;
+	}
+};
+
+/// Partitioning with the same interface and behaviour as Partitioning but with
+/// logarithmic time for moving partitions and finding partitions from positions.
+/// Partitioning defers moves with a single step which is fast for edits clustered together
+/// but edits alternating between distant parts of a long document move many positions.
+/// Here positions are held in blocks relative to the start of each block and the block starts
+/// are held as differences in a FenwickTree so moving the partitions after an edit
+/// only changes positions in one block then one logarithmic update.
+/// The number of partitions in each block is held in another FenwickTree so that
+/// PositionFromPartition is logarithmic instead of constant.
+
+template <typename T>
+class TreePartitioning {
+private:
+	static constexpr size_t blockSize = 1024;
+
+	// Each block is non-empty and its first position is 0.
+	std::vector<std::vector<T>> blocks;
+	FenwickTree<ptrdiff_t> counts;
+	FenwickTree<T> starts;
+	ptrdiff_t elements;
+
+	struct Location {
+		size_t block;
+		size_t offset;
+	};
+
+	Location Locate(ptrdiff_t index) const noexcept {
+		ptrdiff_t offset = 0;
+		const size_t block = counts.Search(index, offset);
+		return { block, static_cast<size_t>(offset) };
+	}
+
+	T BlockStart(size_t block) const noexcept {
+		return starts.Sum(block + 1);
+	}
+
+	// Make first position of block 0 by moving the start of the block.
+	void Normalize(size_t block) noexcept {
+		std::vector<T> &values = blocks[block];
+		const T first = values.front();
+		if (first != 0) {
+			AddDelta(values.data(), values.size(), static_cast<T>(-first));
+			starts.Add(block, first);
+			if (block + 1 < blocks.size())
+				starts.Add(block + 1, -first);
+		}
+	}
+
+	// Divide an oversized block into half blocks.
+	void SplitBlock(size_t block) {
+		constexpr size_t halfBlock = blockSize / 2;
+		std::vector<std::vector<T>> pieces;
+		std::vector<T> pieceStarts;
+		std::vector<ptrdiff_t> pieceCounts;
+		std::vector<T> &values = blocks[block];
+		T previous = 0;
+		for (size_t first = halfBlock; first < values.size(); first += halfBlock) {
+			const size_t last = std::min(first + halfBlock, values.size());
+			const T start = values[first];
+			std::vector<T> piece;
+			piece.reserve(blockSize);
+			for (size_t i = first; i < last; i++) {
+				piece.push_back(values[i] - start);
+			}
+			pieceCounts.push_back(piece.size());
+			pieceStarts.push_back(start - previous);
+			pieces.push_back(std::move(piece));
+			previous = start;
+		}
+		values.resize(halfBlock);
+		const bool atEnd = block + 1 == blocks.size();
+		blocks.insert(blocks.begin() + block + 1,
+			std::make_move_iterator(pieces.begin()), std::make_move_iterator(pieces.end()));
+		if (atEnd) {
+			// Common case when loading so avoid linear rebuild
+			counts.Add(block, static_cast<ptrdiff_t>(halfBlock) - counts.Sum(block + 1) + counts.Sum(block));
+			for (size_t i = 0; i < pieces.size(); i++) {
+				counts.PushBack(pieceCounts[i]);
+				starts.PushBack(pieceStarts[i]);
+			}
+		} else {
+			counts.Flatten();
+			starts.Flatten();
+			counts.Value(block) = halfBlock;
+			counts.Insert(block + 1, pieceCounts.begin(), pieceCounts.end());
+			starts.Insert(block + 1, pieceStarts.begin(), pieceStarts.end());
+			starts.Value(block + 1 + pieces.size()) -= previous;
+			counts.Build();
+			starts.Build();
+		}
+	}
+
+	// Append the next block to this block or remove this block if empty.
+	void MergeBlock(size_t block) {
+		counts.Flatten();
+		starts.Flatten();
+		if (blocks[block].empty()) {
+			if (block + 1 < blocks.size())
+				starts.Value(block + 1) += starts.Value(block);
+			blocks.erase(blocks.begin() + block);
+			counts.Erase(block);
+			starts.Erase(block);
+		} else {
+			const size_t next = block + 1;
+			const T offset = starts.Value(next);
+			for (const T value : blocks[next]) {
+				blocks[block].push_back(value + offset);
+			}
+			if (next + 1 < blocks.size())
+				starts.Value(next + 1) += offset;
+			counts.Value(block) += counts.Value(next);
+			blocks.erase(blocks.begin() + next);
+			counts.Erase(next);
+			starts.Erase(next);
+		}
+		counts.Build();
+		starts.Build();
+	}
+
+	template <typename P>
+	void InsertValues(T partition, const P *positions, size_t length) {
+		if (length == 0) {
+			return;
+		}
+		size_t block = blocks.size() - 1;
+		size_t offset = blocks[block].size();
+		if (partition < elements) {
+			const Location location = Locate(partition);
+			block = location.block;
+			offset = location.offset;
+			if ((offset == 0) && (block > 0)) {
+				// Append to previous block so this block's start does not change
+				block--;
+				offset = blocks[block].size();
+			}
+		}
+		const T start = BlockStart(block);
+		std::vector<T> &values = blocks[block];
+		values.insert(values.begin() + offset, length, 0);
+		for (size_t i = 0; i < length; i++) {
+			values[offset + i] = static_cast<T>(positions[i]) - start;
+		}
+		elements += length;
+		counts.Add(block, length);
+		if (offset == 0) {
+			Normalize(block);
+		}
+		if (values.size() > blockSize) {
+			SplitBlock(block);
+		}
+	}
+
+public:
+	explicit TreePartitioning(size_t growSize=8) {
+		blocks.emplace_back();
+		blocks.front().reserve(std::min(growSize, blockSize));
+		DeleteAll();
+	}
+
+	T Partitions() const noexcept {
+		return static_cast<T>(elements - 1);
+	}
+
+	void ReAllocate(ptrdiff_t newSize) {
+		// Reserve only the block list as blocks are allocated as needed
+		blocks.reserve(newSize / (blockSize / 2) + 1);
+	}
+
+	T Length() const noexcept {
+		return BlockStart(blocks.size() - 1) + blocks.back().back();
+	}
+
+	void InsertPartition(T partition, T pos) {
+		InsertValues(partition, &pos, 1);
+	}
+
+	void InsertPartitions(T partition, const T *positions, size_t length) {
+		InsertValues(partition, positions, length);
+	}
+
+	void InsertPartitionsWithCast(T partition, const ptrdiff_t *positions, size_t length) {
+		// Used for 64-bit builds when T is 32-bits
+		InsertValues(partition, positions, length);
+	}
+
+	void SetPartitionStartPosition(T partition, T pos) noexcept {
+		if ((partition < 0) || (partition >= elements)) {
+			return;
+		}
+		const Location location = Locate(partition);
+		blocks[location.block][location.offset] = pos - BlockStart(location.block);
+		if (location.offset == 0) {
+			Normalize(location.block);
+		}
+	}
+
+	void InsertText(T partitionInsert, T delta) noexcept {
+		// Point all the partitions after the insertion point further along in the buffer
+		const ptrdiff_t first = partitionInsert + 1;
+		if ((delta == 0) || (first <= 0) || (first >= elements)) {
+			return;
+		}
+		const Location location = Locate(first);
+		if (location.offset == 0) {
+			starts.Add(location.block, delta);
+		} else {
+			std::vector<T> &values = blocks[location.block];
+			AddDelta(values.data() + location.offset, values.size() - location.offset, delta);
+			if (location.block + 1 < blocks.size())
+				starts.Add(location.block + 1, delta);
+		}
+	}
+
+	void RemovePartition(T partition) {
+		PLATFORM_ASSERT(partition > 0);
+		PLATFORM_ASSERT(partition < elements);
+		const Location location = Locate(partition);
+		std::vector<T> &values = blocks[location.block];
+		values.erase(values.begin() + location.offset);
+		elements--;
+		counts.Add(location.block, -1);
+		if (values.empty()) {
+			MergeBlock(location.block);
+			return;
+		}
+		if (location.offset == 0) {
+			Normalize(location.block);
+		}
+		const size_t next = location.block + 1;
+		if ((values.size() < blockSize / 4) && (next < blocks.size()) &&
+			(values.size() + blocks[next].size() <= blockSize)) {
+			MergeBlock(location.block);
+		}
+	}
+
+	T PositionFromPartition(T partition) const noexcept {
+		PLATFORM_ASSERT(partition >= 0);
+		PLATFORM_ASSERT(partition < elements);
+		if ((partition < 0) || (partition >= elements)) {
+			return 0;
+		}
+		const Location location = Locate(partition);
+		return BlockStart(location.block) + blocks[location.block][location.offset];
+	}
+
+	/// Return value in range [0 .. Partitions() - 1] even for arguments outside interval
+	T PartitionFromPosition(T pos) const noexcept {
+		if (pos >= Length())
+			return Partitions() - 1;
+		T offset = 0;
+		const size_t blocksBefore = starts.Search(pos, offset);
+		if (blocksBefore == 0)
+			return 0;
+		const size_t block = blocksBefore - 1;
+		const std::vector<T> &values = blocks[block];
+		// First value is 0 and offset >= 0 so the result is at least 1 element in
+		const ptrdiff_t index = std::upper_bound(values.begin(), values.end(), offset) - values.begin();
+		return static_cast<T>(counts.Sum(block) + index - 1);
+	}
+
+	void DeleteAll() {
+		blocks.resize(1);
+		blocks.front().clear();
+		blocks.front().push_back(0);	// This value stays 0 for ever
+		blocks.front().push_back(0);	// This is the end of the first partition and will be the start of the second
+		elements = 2;
+		counts.Clear();
+		counts.PushBack(2);
+		starts.Clear();
+		starts.PushBack(0);
+	}
+
+	void Check() const {
+#ifdef CHECK_CORRECTNESS
+		if (Length() < 0) {
+			throw std::runtime_error("TreePartitioning: Length can not be negative.");
+		}
+		if (Partitions() < 1) {
+			throw std::runtime_error("TreePartitioning: Must always have 1 or more partitions.");
+		}
+		if ((counts.Length() != blocks.size()) || (starts.Length() != blocks.size())) {
+			throw std::runtime_error("TreePartitioning: Trees do not match blocks.");
+		}
+		ptrdiff_t total = 0;
+		for (size_t block = 0; block < blocks.size(); block++) {
+			if (blocks[block].empty() || (blocks[block].front() != 0)) {
+				throw std::runtime_error("TreePartitioning: Block not normalized.");
+			}
+			total += blocks[block].size();
+			if (counts.Sum(block + 1) != total) {
+				throw std::runtime_error("TreePartitioning: Block count mismatch.");
+			}
+		}
+		if (total != elements) {
+			throw std::runtime_error("TreePartitioning: Element count mismatch.");
+		}
+		if (Length() == 0) {
+			if ((PositionFromPartition(0) != 0) || (PositionFromPartition(1) != 0)) {
+				throw std::runtime_error("TreePartitioning: Invalid empty partitioning.");
+			}
+		} else {
+			// Positions should be a strictly ascending sequence
+			for (T i = 0; i < Partitions(); i++) {
+				const T pos = PositionFromPartition(i);
+				const T posNext = PositionFromPartition(i+1);
+				if (pos > posNext) {
+					throw std::runtime_error("TreePartitioning: Negative partition.");
+				} else if (pos == posNext) {
+					throw std::runtime_error("TreePartitioning: Empty partition.");
+				}
+			}
+		}
+#endif
+	}
+
+};
+
+}
+
+#endif
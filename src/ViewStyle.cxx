@@ -80,14 +80,36 @@ void FontRealised::Realise(Surface &surface, int zoomLevel, Technology technolog
 	measurements.monospaceCharacterWidth = measurements.aveCharWidth;
 	measurements.spaceWidth = surface.WidthText(font.get(), " ");
 
+	// "Ay", "AV" and "To" are normally strongly kerned and "fi" may be a ligature
+	constexpr size_t kerningProbes = 8;
+	constexpr std::string_view allASCIIGraphic("AyAVTofi"
+	// python: ''.join(chr(ch) for ch in range(32, 127))
+	" !\"#$%&\'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~");
+	std::array<XYPOSITION, allASCIIGraphic.length()> positions {};
+	surface.MeasureWidthsUTF8(font.get(), allASCIIGraphic, positions.data());
+	std::adjacent_difference(positions.begin(), positions.end(), positions.begin());
+
+	// Remember the width of each graphic ASCII character so that runs of these characters
+	// can be laid out by adding widths. Only possible when the probes have the same widths
+	// as those characters measured after other characters.
+	constexpr XYPOSITION additiveWidthEpsilon = 0.0001;
+	const XYPOSITION tolerance = measurements.aveCharWidth * additiveWidthEpsilon;
+	std::vector<XYPOSITION> widths(0x80);
+	for (size_t i = kerningProbes; i < allASCIIGraphic.length(); i++) {
+		widths[static_cast<unsigned char>(allASCIIGraphic[i])] = positions[i];
+	}
+	bool additive = true;
+	for (size_t i = 0; i < kerningProbes; i++) {
+		if (std::abs(widths[static_cast<unsigned char>(allASCIIGraphic[i])] - positions[i]) > tolerance) {
+			additive = false;
+		}
+	}
+	measurements.asciiWidths.reset();
+	if (additive) {
+		measurements.asciiWidths = std::make_shared<const std::vector<XYPOSITION>>(std::move(widths));
+	}
+
 	if (fs.checkMonospaced) {
-		// "Ay" is normally strongly kerned and "fi" may be a ligature
-		constexpr std::string_view allASCIIGraphic("Ayfi"
-		// python: ''.join(chr(ch) for ch in range(32, 127))
-		" !\"#$%&\'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~");
-		std::array<XYPOSITION, allASCIIGraphic.length()> positions {};
-		surface.MeasureWidthsUTF8(font.get(), allASCIIGraphic, positions.data());
-		std::adjacent_difference(positions.begin(), positions.end(), positions.begin());
 		const XYPOSITION maxWidth = *std::max_element(positions.begin(), positions.end());
 		const XYPOSITION minWidth = *std::min_element(positions.begin(), positions.end());
 		const XYPOSITION variance = maxWidth - minWidth;
@@ -1643,6 +1643,70 @@ class TestSearch(unittest.TestCase):
 		self.assertEqual(0, self.ed.FindBytes(0, self.ed.Length, pattern, flags))
 		self.assertEqual(0, self.ed.FindBytes(0, self.ed.Length, pattern, flags))
 
+	def testLinearREFind(self):
+		flags = self.ed.SCFIND_REGEXP | self.ed.SCFIND_LINEARREGEX
+		self.assertEqual(-1, self.ed.FindBytes(0, self.ed.Length, b"b.g", 0))
+		self.assertEqual(2, self.ed.FindBytes(0, self.ed.Length, b"b.g", flags))
+		self.assertEqual(2, self.ed.FindBytes(0, self.ed.Length, rb"\bb.g\b", flags))
+		self.assertEqual(2, self.ed.FindBytes(0, self.ed.Length, rb"\<b.g\>", flags))
+		self.assertEqual(-1, self.ed.FindBytes(0, self.ed.Length, b"b[A-Z]g",
+			flags | self.ed.SCFIND_MATCHCASE))
+		self.assertEqual(2, self.ed.FindBytes(0, self.ed.Length, b"b[a-z]g", flags))
+		self.assertEqual(6, self.ed.FindBytes(0, self.ed.Length, b"b[a-z]*t", flags))
+		self.assertEqual(0, self.ed.FindBytes(0, self.ed.Length, b"^a", flags))
+		self.assertEqual(10, self.ed.FindBytes(0, self.ed.Length, b"\t$", flags))
+		self.assertEqual(0, self.ed.FindBytes(0, self.ed.Length, b"([a]).*\0", flags))
+		# Tags after the ninth are not recorded but still match
+		pattern = b"(.)" * 11
+		self.assertEqual(0, self.ed.FindBytes(0, self.ed.Length, pattern, flags))
+		# Back references are not supported
+		self.assertEqual(-1, self.ed.FindBytes(0, self.ed.Length, rb"(b)\1", flags))
+
+	def testSearchAllInTarget(self):
+		# "a\tbig boat\t"
+		self.ed.TargetWholeDocument()
+		self.ed.SearchFlags = 0
+		searchString = b"b"
+		self.assertEqual(2, self.ed.SearchAllInTarget(len(searchString), searchString))
+		# Target not moved
+		self.assertEqual(self.ed.TargetStart, 0)
+		self.assertEqual(self.ed.TargetEnd, self.ed.Length)
+		self.assertEqual(2, self.ed.GetSearchAllRanges(0, 0))
+		ranges = (ctypes.c_ssize_t * 4)()
+		self.assertEqual(2, self.ed.GetSearchAllRanges(2, ranges))
+		self.assertEqual(list(ranges), [2, 3, 6, 7])
+		self.ed.SearchFlags = self.ed.SCFIND_REGEXP
+		searchString = b"b[a-z]*"
+		self.assertEqual(2, self.ed.SearchAllInTarget(len(searchString), searchString))
+		self.assertEqual(2, self.ed.GetSearchAllRanges(2, ranges))
+		self.assertEqual(list(ranges), [2, 5, 6, 10])
+		self.ed.SearchFlags = self.ed.SCFIND_REGEXP | self.ed.SCFIND_CXX11REGEX
+		self.assertEqual(2, self.ed.SearchAllInTarget(len(searchString), searchString))
+		searchString = b"b("
+		self.assertEqual(-1, self.ed.SearchAllInTarget(len(searchString), searchString))
+		self.assertEqual(0, self.ed.GetSearchAllRanges(0, 0))
+		self.ed.SearchFlags = 0
+
+	def testSearchThreads(self):
+		self.assertEqual(self.ed.SearchThreads, 1)
+		self.ed.SearchThreads = 2
+		self.assertGreaterEqual(self.ed.SearchThreads, 1)
+		self.ed.TargetWholeDocument()
+		self.ed.SearchFlags = 0
+		searchString = b"boat"
+		self.assertEqual(6, self.ed.SearchInTarget(len(searchString), searchString))
+		self.ed.SearchThreads = 1
+
+	def testIndicatorFillAllInTarget(self):
+		self.ed.TargetWholeDocument()
+		self.ed.SearchFlags = 0
+		self.ed.IndicatorCurrent = 3
+		searchString = b"b"
+		self.assertEqual(2, self.ed.IndicatorFillAllInTarget(len(searchString), searchString))
+		values = [self.ed.IndicatorValueAt(3, pos) for pos in range(self.ed.Length)]
+		self.assertEqual(values, [0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 0])
+		self.ed.IndicatorClearRange(0, self.ed.Length)
+
 	def testPhilippeREFind(self):
 		# Requires 1.,72
 		flags = self.ed.SCFIND_REGEXP
@@ -2372,6 +2436,127 @@ class TestTechnology(unittest.TestCase):
 			self.assertEqual(self.ed.GetTechnology(), self.ed.SC_TECHNOLOGY_DEFAULT)
 			self.assertEqual(self.ed.BufferedDraw, True)
 
+	def testRetainedDraw(self):
+		self.assertEqual(self.ed.RetainedDraw, False)
+		self.ed.RetainedDraw = True
+		self.assertEqual(self.ed.RetainedDraw, True)
+		self.ed.RetainedDraw = False
+		self.assertEqual(self.ed.RetainedDraw, False)
+
+class TestPositionCache(unittest.TestCase):
+
+	def setUp(self):
+		self.xite = Xite.xiteFrame
+		self.ed = self.xite.ed
+		self.ed.ClearAll()
+		self.ed.EmptyUndoBuffer()
+
+	def tearDown(self):
+		self.ed.PositionCacheKeyLength = 30
+		self.ed.PositionCacheAssociativity = 2
+		self.ed.PositionCache = 1024
+		self.ed.ClearAll()
+		self.ed.EmptyUndoBuffer()
+
+	def testSettings(self):
+		self.assertEqual(self.ed.PositionCacheKeyLength, 30)
+		self.assertEqual(self.ed.PositionCacheAssociativity, 2)
+		self.ed.PositionCacheKeyLength = 100
+		self.assertEqual(self.ed.PositionCacheKeyLength, 100)
+		self.ed.PositionCacheAssociativity = 8
+		self.assertEqual(self.ed.PositionCacheAssociativity, 8)
+		self.ed.PositionCache = 4096
+		self.assertEqual(self.ed.PositionCache, 4096)
+		# Out of range values are limited
+		self.ed.PositionCacheAssociativity = 0
+		self.assertEqual(self.ed.PositionCacheAssociativity, 1)
+
+	def testStatistics(self):
+		# Resizing restarts the counts
+		self.ed.PositionCache = 1024
+		self.assertEqual(self.ed.GetPositionCacheStatistic(self.ed.SC_POSITIONCACHESTATISTIC_HITS), 0)
+		self.assertEqual(self.ed.GetPositionCacheStatistic(self.ed.SC_POSITIONCACHESTATISTIC_MISSES), 0)
+		self.assertEqual(self.ed.GetPositionCacheStatistic(self.ed.SC_POSITIONCACHESTATISTIC_EVICTIONS), 0)
+		self.ed.LayoutCache = self.ed.SC_CACHE_CARET
+		data = b"x = y + z;\n" * 100
+		self.ed.AddText(len(data), data)
+		self.xite.DoEvents()
+		hits = self.ed.GetPositionCacheStatistic(self.ed.SC_POSITIONCACHESTATISTIC_HITS)
+		misses = self.ed.GetPositionCacheStatistic(self.ed.SC_POSITIONCACHESTATISTIC_MISSES)
+		# The first line laid out measures its text
+		self.assertTrue(misses > 0)
+		# Only the caret line layout is kept so scrolling lays out lines again,
+		# finding their text in the position cache
+		self.ed.LineScroll(0, 1)
+		self.xite.DoEvents()
+		self.assertTrue(self.ed.GetPositionCacheStatistic(self.ed.SC_POSITIONCACHESTATISTIC_HITS) > hits)
+		self.assertEqual(self.ed.GetPositionCacheStatistic(self.ed.SC_POSITIONCACHESTATISTIC_MISSES), misses)
+
+	def testShapedTextStatistics(self):
+		data = b"x = y + z;\n" * 100
+		self.ed.AddText(len(data), data)
+		self.xite.DoEvents()
+		hits = self.ed.GetShapedTextCacheStatistic(self.ed.SC_SHAPEDTEXTCACHESTATISTIC_HITS)
+		misses = self.ed.GetShapedTextCacheStatistic(self.ed.SC_SHAPEDTEXTCACHESTATISTIC_MISSES)
+		if misses == 0:
+			# Platforms that do not cache shaped text return 0 for every statistic
+			self.assertEqual(hits, 0)
+			return
+		# Every line has the same text so it is shaped once and then found in the cache
+		self.assertTrue(hits > 0)
+		# Lines scrolled into view are drawn from the cache
+		self.ed.LineScroll(0, 20)
+		self.xite.DoEvents()
+		hitsScrolled = self.ed.GetShapedTextCacheStatistic(self.ed.SC_SHAPEDTEXTCACHESTATISTIC_HITS)
+		self.assertTrue(hitsScrolled > hits)
+
+class TestLayoutCache(unittest.TestCase):
+
+	def setUp(self):
+		self.xite = Xite.xiteFrame
+		self.ed = self.xite.ed
+		self.ed.ClearAll()
+		self.ed.EmptyUndoBuffer()
+
+	def tearDown(self):
+		self.ed.LayoutCache = self.ed.SC_CACHE_CARET
+		self.ed.LayoutCacheMemoryLimit = 0x4000000
+		self.ed.LazyLayoutLength = 0
+		self.ed.ClearAll()
+		self.ed.EmptyUndoBuffer()
+
+	def testBounded(self):
+		self.ed.LayoutCache = self.ed.SC_CACHE_DOCUMENT_BOUNDED
+		self.assertEqual(self.ed.LayoutCache, self.ed.SC_CACHE_DOCUMENT_BOUNDED)
+		self.assertEqual(self.ed.LayoutCacheMemoryLimit, 0x4000000)
+		self.ed.LayoutCacheMemoryLimit = 100000
+		self.assertEqual(self.ed.LayoutCacheMemoryLimit, 100000)
+		data = b"x = y + z;\n" * 10000
+		self.ed.AddText(len(data), data)
+		self.ed.GotoLine(9999)
+		self.xite.DoEvents()
+		self.assertTrue(self.ed.LayoutCacheMemory > 0)
+		self.ed.GotoLine(0)
+		self.xite.DoEvents()
+		# Layouts beyond the limit are discarded although the cache's own
+		# bookkeeping is counted so memory use may be slightly over the limit
+		self.assertTrue(self.ed.LayoutCacheMemory < 200000)
+
+	def testLazyLayout(self):
+		self.assertEqual(self.ed.LazyLayoutLength, 0)
+		self.ed.LazyLayoutLength = 10000
+		self.assertEqual(self.ed.LazyLayoutLength, 10000)
+		data = b"abc def\tghi " * 10000
+		self.ed.AddText(len(data), data)
+		self.xite.DoEvents()
+		# Positions are consistent whether measured or estimated
+		self.ed.GotoPos(len(data))
+		self.xite.DoEvents()
+		xEnd = self.ed.PointXFromPosition(0, len(data))
+		self.assertTrue(xEnd > self.ed.PointXFromPosition(0, len(data) // 2))
+		self.assertEqual(self.ed.PositionFromPoint(xEnd, self.ed.PointYFromPosition(0, len(data))), len(data))
+		self.ed.LazyLayoutLength = 0
+
 class TestStyleAttributes(unittest.TestCase):
 	""" These tests are just to ensure that the calls set and retrieve values.
 	They do not check the visual appearance of the style attributes.
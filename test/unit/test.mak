@@ -12,6 +12,7 @@ CXXFLAGS = /MP /EHsc /std:c++17 $(OPTIMIZATION) /nologo /D_HAS_AUTO_PTR_ETC=1 /w
 TESTSRC=test*.cxx
 # Files being tested from scintilla/src directory
 TESTEDSRC=\
+ ../../src/BackgroundWrap.cxx \
  ../../src/CaseConvert.cxx \
  ../../src/CaseFolder.cxx \
  ../../src/CellBuffer.cxx \
@@ -19,15 +20,29 @@ TESTEDSRC=\
  ../../src/CharacterCategoryMap.cxx \
  ../../src/CharClassify.cxx \
  ../../src/ContractionState.cxx \
+ ../../src/DBCS.cxx \
  ../../src/Decoration.cxx \
  ../../src/Document.cxx \
+ ../../src/EditModel.cxx \
+ ../../src/EditView.cxx \
  ../../src/Geometry.cxx \
+ ../../src/Indicator.cxx \
+ ../../src/LinearRegex.cxx \
+ ../../src/LineMarker.cxx \
+ ../../src/MarginView.cxx \
  ../../src/PerLine.cxx \
+ ../../src/PositionCache.cxx \
  ../../src/RESearch.cxx \
  ../../src/RunStyles.cxx \
+ ../../src/Selection.cxx \
+ ../../src/SplitVector.cxx \
+ ../../src/Style.cxx \
+ ../../src/ThreadPool.cxx \
  ../../src/UndoHistory.cxx \
  ../../src/UniConversion.cxx \
- ../../src/UniqueString.cxx
+ ../../src/UniqueString.cxx \
+ ../../src/ViewStyle.cxx \
+ ../../src/XPM.cxx
 
 TESTS=$(EXE)
 
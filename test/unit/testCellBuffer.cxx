@@ -241,6 +241,265 @@ TEST_CASE("CellBuffer") {
 
 }
 
+TEST_CASE("CellBufferRope") {
+
+	// Rope storage should behave identically to gap buffer storage
+
+	CellBuffer cbRope(true, false, TextStorage::rope);
+	CellBuffer cbGap(true, false, TextStorage::gap);
+
+	SECTION("Setup") {
+		REQUIRE(cbRope.Storage() == TextStorage::rope);
+		REQUIRE(cbGap.Storage() == TextStorage::gap);
+		REQUIRE(0 == cbRope.Length());
+		REQUIRE(1 == cbRope.Lines());
+	}
+
+	SECTION("MatchesGapBuffer") {
+		// Text larger than a rope block so edits cross block boundaries
+		std::string sLines;
+		for (int line = 0; line < 2000; line++) {
+			sLines += "Line " + std::to_string(line) + ((line % 3) ? "\n" : "\r\n");
+		}
+		bool startSequence = false;
+		cbRope.InsertString(0, sLines.c_str(), sLines.length(), startSequence);
+		cbGap.InsertString(0, sLines.c_str(), sLines.length(), startSequence);
+		unsigned int randomValue = 17;
+		for (int edit = 0; edit < 500; edit++) {
+			randomValue = randomValue * 1103515245 + 12345;
+			const Sci::Position position = (randomValue >> 8) % (cbGap.Length() + 1);
+			if (edit % 3) {
+				constexpr std::string_view sInsert = "ab\ncd\r";
+				cbRope.InsertString(position, sInsert.data(), sInsert.length(), startSequence);
+				cbGap.InsertString(position, sInsert.data(), sInsert.length(), startSequence);
+			} else {
+				const Sci::Position lengthDelete = std::min<Sci::Position>(20, cbGap.Length() - position);
+				cbRope.DeleteChars(position, lengthDelete, startSequence);
+				cbGap.DeleteChars(position, lengthDelete, startSequence);
+			}
+		}
+		REQUIRE(cbGap.Length() == cbRope.Length());
+		REQUIRE(cbGap.Lines() == cbRope.Lines());
+		for (Sci::Line line = 0; line < cbGap.Lines(); line++) {
+			REQUIRE(cbGap.LineStart(line) == cbRope.LineStart(line));
+		}
+		REQUIRE(cbGap.SetStyleFor(100, 300, 2) == cbRope.SetStyleFor(100, 300, 2));
+		for (Sci::Position position = 0; position < cbGap.Length(); position++) {
+			REQUIRE(cbGap.CharAt(position) == cbRope.CharAt(position));
+			REQUIRE(cbGap.StyleAt(position) == cbRope.StyleAt(position));
+		}
+		std::string sRange(5000, '\0');
+		cbGap.GetCharRange(sRange.data(), 1000, 5000);
+		REQUIRE(Equal(cbRope.RangePointer(1000, 5000), sRange));
+
+		// Undo everything
+		while (cbRope.CanUndo()) {
+			const int steps = cbRope.StartUndo();
+			for (int step = 0; step < steps; step++) {
+				cbRope.PerformUndoStep();
+			}
+		}
+		REQUIRE(0 == cbRope.Length());
+		REQUIRE(1 == cbRope.Lines());
+	}
+
+	SECTION("AllView") {
+		constexpr std::string_view sText = "Scintilla";
+		bool startSequence = false;
+		for (int i = 0; i < 1000; i++) {
+			cbRope.InsertString(cbRope.Length(), sText.data(), sText.length(), startSequence);
+		}
+		SegmentedView view = cbRope.AllView();
+		REQUIRE(view.Length() == cbRope.Length());
+		for (Sci::Position position = 0; position < view.Length(); position++) {
+			REQUIRE(sText[position % sText.length()] == view.CharAt(position));
+		}
+		REQUIRE(10 == view.FindChar(9, 100, 'c'));
+		REQUIRE(8992 == view.FindChar(8991, 100, 'c'));
+		REQUIRE(-1 == view.FindChar(2, 5, 'S'));
+	}
+
+}
+
+TEST_CASE("FindLineEndByte") {
+
+	// Check vectorized search against simple loop for all alignments and lengths around vector sizes
+
+	std::string text(200, 'a');
+	for (const bool unicode : { false, true }) {
+		for (const unsigned char lineEnd : { 0x0d, 0x0a, 0x85, 0xa8, 0xa9, 0xa7, 0x0b }) {
+			const bool isLineEnd = (lineEnd == '\r') || (lineEnd == '\n') ||
+				(unicode && ((lineEnd == 0x85) || (lineEnd == 0xa8) || (lineEnd == 0xa9)));
+			for (size_t start = 0; start < 40; start++) {
+				for (size_t offset = 0; offset < 70; offset++) {
+					const size_t length = 100;
+					text[start + offset] = lineEnd;
+					const char *begin = text.c_str() + start;
+					const char *end = begin + length;
+					const char *found = FindLineEndByte(begin, end, unicode);
+					if (isLineEnd) {
+						REQUIRE(found == begin + offset);
+					} else {
+						REQUIRE(found == end);
+					}
+					// Shortened range excludes line end
+					REQUIRE(FindLineEndByte(begin, begin + offset, unicode) == begin + offset);
+					text[start + offset] = 'a';
+				}
+			}
+		}
+	}
+
+	CellBuffer cb(true, false);
+	SECTION("ContainsLineEnd") {
+		REQUIRE(!cb.ContainsLineEnd("abc", 3));
+		REQUIRE(cb.ContainsLineEnd("abc\r", 4));
+		REQUIRE(cb.ContainsLineEnd("\nabc", 4));
+		REQUIRE(!cb.ContainsLineEnd("abc\xe2\x80\xa8", 6));
+		cb.SetLineEndTypes(LineEndType::Unicode);
+		REQUIRE(cb.ContainsLineEnd("abc\xe2\x80\xa8", 6));
+		REQUIRE(cb.ContainsLineEnd("abc\xc2\x85", 5));
+		REQUIRE(!cb.ContainsLineEnd("\x80\xa8", 2));
+		REQUIRE(!cb.ContainsLineEnd("abc\xe2\x81\xa8", 6));
+	}
+
+	SECTION("DeleteLineEnds") {
+		// Deletions with line ends spread out so the skipping is exercised
+		cb.SetLineEndTypes(LineEndType::Unicode);
+		bool startSequence = false;
+		std::string sText;
+		for (int i = 0; i < 20; i++) {
+			sText += std::string(i * 7, 'x') + ((i % 3 == 0) ? "\r\n" : ((i % 3 == 1) ? "\xe2\x80\xa9" : "\n"));
+		}
+		cb.InsertString(0, sText.c_str(), sText.length(), startSequence);
+		const Sci::Line lines = cb.Lines();
+		REQUIRE(21 == lines);
+		// Delete the first byte of a PS so it no longer ends a line
+		const Sci::Position posPS = sText.find("\xe2\x80\xa9");
+		cb.DeleteChars(posPS - 5, 6, startSequence);
+		REQUIRE(20 == cb.Lines());
+		// Delete most of the text
+		cb.DeleteChars(3, cb.Length() - 10, startSequence);
+		Sci::Line linesExpected = 1;
+		for (Sci::Position pos = 0; pos < cb.Length(); pos++) {
+			const unsigned char ch = cb.CharAt(pos);
+			if ((ch == '\n') || ((ch == '\r') && (cb.CharAt(pos + 1) != '\n')) ||
+				((ch == 0xa9) && (static_cast<unsigned char>(cb.CharAt(pos - 1)) == 0x80))) {
+				linesExpected++;
+			}
+		}
+		REQUIRE(linesExpected == cb.Lines());
+	}
+}
+
+TEST_CASE("CellBufferDeferLineEnds") {
+
+	// Loading with deferred line ends should produce the same lines as normal insertion.
+	// Text is large enough to be scanned by multiple threads.
+
+	std::string sLines;
+	unsigned int randomValue = 31;
+	constexpr std::string_view lineEnds[] = { "\n", "\r\n", "\r", "\xc2\x85", "\xe2\x80\xa8", "\xe2\x80\xa9" };
+	while (sLines.length() < 3000000) {
+		randomValue = randomValue * 1103515245 + 12345;
+		sLines.append((randomValue >> 16) % 50, 'x');
+		sLines.append(lineEnds[(randomValue >> 8) % std::size(lineEnds)]);
+	}
+
+	for (const TextStorage storage : { TextStorage::gap, TextStorage::rope }) {
+		for (const LineEndType lineEndType : { LineEndType::Default, LineEndType::Unicode }) {
+			CellBuffer cbNormal(true, false, storage);
+			CellBuffer cbDeferred(true, false, storage);
+			cbNormal.SetLineEndTypes(lineEndType);
+			cbDeferred.SetLineEndTypes(lineEndType);
+			cbNormal.SetUTF8Substance(true);
+			cbDeferred.SetUTF8Substance(true);
+			cbNormal.SetUndoCollection(false);
+			cbDeferred.SetUndoCollection(false);
+			cbDeferred.DeferLineEnds();
+			// Blocks of an odd size so CR LF and multi-byte line ends are split between blocks
+			constexpr size_t blockSize = 65535;
+			bool startSequence = false;
+			for (size_t start = 0; start < sLines.length(); start += blockSize) {
+				const size_t lengthBlock = std::min(blockSize, sLines.length() - start);
+				cbNormal.InsertString(cbNormal.Length(), sLines.c_str() + start, lengthBlock, startSequence);
+				cbDeferred.InsertString(cbDeferred.Length(), sLines.c_str() + start, lengthBlock, startSequence);
+			}
+			cbDeferred.ResolveLineEnds();
+			REQUIRE(cbNormal.Lines() == cbDeferred.Lines());
+			for (Sci::Line line = 0; line <= cbNormal.Lines(); line++) {
+				REQUIRE(cbNormal.LineStart(line) == cbDeferred.LineStart(line));
+			}
+		}
+	}
+}
+
+TEST_CASE("CellBufferLinesTree") {
+
+	// Lines held in TreePartitioning should match lines held in Partitioning after edits
+
+	CellBuffer cbStep(true, false);
+	CellBuffer cbTree(true, false, TextStorage::gap, true);
+	REQUIRE(!cbStep.IsLinesTree());
+	REQUIRE(cbTree.IsLinesTree());
+
+	constexpr std::string_view pieces[] = { "a\n", "bc\r\n", "\n\n\n", "def", "\r" };
+	unsigned int randomValue = 17;
+	for (int i = 0; i < 20000; i++) {
+		randomValue = randomValue * 1103515245 + 12345;
+		const Sci::Position pos = (randomValue >> 8) % (cbStep.Length() + 1);
+		bool startSequence = false;
+		if ((randomValue >> 4) % 3) {
+			const std::string_view piece = pieces[(randomValue >> 20) % std::size(pieces)];
+			cbStep.InsertString(pos, piece.data(), piece.length(), startSequence);
+			cbTree.InsertString(pos, piece.data(), piece.length(), startSequence);
+		} else if (pos < cbStep.Length()) {
+			const Sci::Position len = std::min<Sci::Position>((randomValue >> 24) % 8 + 1, cbStep.Length() - pos);
+			cbStep.DeleteChars(pos, len, startSequence);
+			cbTree.DeleteChars(pos, len, startSequence);
+		}
+	}
+	REQUIRE(cbStep.Lines() == cbTree.Lines());
+	for (Sci::Line line = 0; line <= cbStep.Lines(); line++) {
+		REQUIRE(cbStep.LineStart(line) == cbTree.LineStart(line));
+	}
+	for (Sci::Position pos = 0; pos <= cbStep.Length(); pos++) {
+		REQUIRE(cbStep.LineFromPosition(pos) == cbTree.LineFromPosition(pos));
+	}
+}
+
+TEST_CASE("CellBufferMapped") {
+
+	constexpr std::string_view sMapped = "Two\nLines";
+	CellBuffer cb(true, false, TextStorage::mapped);
+
+	SECTION("Reference") {
+		bool startSequence = false;
+		cb.SetUndoCollection(false);
+		cb.InsertString(0, sMapped.data(), sMapped.length(), startSequence, true);
+		REQUIRE(cb.Storage() == TextStorage::mapped);
+		REQUIRE(2 == cb.Lines());
+		REQUIRE(4 == cb.LineStart(1));
+		REQUIRE(cb.RangePointer(0, sMapped.length()) == sMapped.data());
+		REQUIRE(0 == cb.StyleAt(5));
+		cb.SetUndoCollection(true);
+		cb.InsertString(3, "\nMore", 5, startSequence);
+		REQUIRE(3 == cb.Lines());
+		REQUIRE(Equal(cb.BufferPointer(), "Two\nMore\nLines"));
+		REQUIRE(cb.SetStyleFor(0, 3, 1));
+		REQUIRE(1 == cb.StyleAt(2));
+		REQUIRE(0 == cb.StyleAt(3));
+		unsigned char styles[4] {};
+		cb.GetStyleRange(styles, 1, 3);
+		REQUIRE(1 == styles[0]);
+		REQUIRE(1 == styles[1]);
+		REQUIRE(0 == styles[2]);
+		cb.StartUndo();
+		cb.PerformUndoStep();
+		REQUIRE(Equal(cb.BufferPointer(), sMapped));
+	}
+}
+
 bool Equal(const Action &a, ActionType at, Sci::Position position, std::string_view value) noexcept {
 	// Currently ignores mayCoalesce since this is not set consistently when following
 	// start action implies it.
@@ -203,3 +203,31 @@ TEST_CASE("ContractionState") {
 	}
 
 }
+
+TEST_CASE("ContractionStateLinesTree") {
+
+	// Lines held in TreePartitioning behave the same as with Partitioning
+
+	std::unique_ptr<IContractionState> pcsStep = ContractionStateCreate(false);
+	std::unique_ptr<IContractionState> pcsTree = ContractionStateCreate(false, true);
+
+	for (IContractionState *pcs : { pcsStep.get(), pcsTree.get() }) {
+		pcs->InsertLines(0, 5000);
+		for (Sci::Line line = 10; line < 4900; line += 37) {
+			pcs->SetVisible(line, line + 5, false);
+			pcs->SetHeight(line + 7, 3);
+		}
+		pcs->DeleteLines(100, 2000);
+		pcs->InsertLines(50, 1000);
+		pcs->SetVisible(60, 70, false);
+	}
+	REQUIRE(pcsStep->LinesInDoc() == pcsTree->LinesInDoc());
+	REQUIRE(pcsStep->LinesDisplayed() == pcsTree->LinesDisplayed());
+	for (Sci::Line line = 0; line < pcsStep->LinesInDoc(); line++) {
+		REQUIRE(pcsStep->DisplayFromDoc(line) == pcsTree->DisplayFromDoc(line));
+		REQUIRE(pcsStep->GetVisible(line) == pcsTree->GetVisible(line));
+	}
+	for (Sci::Line lineDisplay = 0; lineDisplay < pcsStep->LinesDisplayed(); lineDisplay++) {
+		REQUIRE(pcsStep->DocFromDisplay(lineDisplay) == pcsTree->DocFromDisplay(lineDisplay));
+	}
+}
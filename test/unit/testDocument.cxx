@@ -5,15 +5,21 @@
 #include <cstddef>
 #include <cstring>
 #include <stdexcept>
+#include <exception>
 #include <string_view>
 #include <vector>
 #include <set>
 #include <optional>
 #include <algorithm>
+#include <functional>
 #include <memory>
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 
 #include "ScintillaTypes.h"
 
@@ -32,6 +38,7 @@
 #include "Decoration.h"
 #include "CaseFolder.h"
 #include "Document.h"
+#include "ThreadPool.h"
 
 #include "catch.hpp"
 
@@ -151,6 +158,16 @@ struct DocPlus {
 		return { location, lengthFinding };
 	}
 
+	std::vector<Match> FindAll(Sci::Position minPos, Sci::Position maxPos, std::string_view needle, FindOption flags) {
+		std::vector<Range> ranges;
+		document.FindAll(minPos, maxPos, needle.data(), flags, needle.length(), ranges);
+		std::vector<Match> found;
+		for (const Range &range : ranges) {
+			found.emplace_back(range.start, range.Length());
+		}
+		return found;
+	}
+
 	std::string Substitute(std::string_view substituteText) {
 		Sci::Position lengthsubstitute = substituteText.length();
 		std::string substituted = document.SubstituteByPosition(substituteText.data(), &lengthsubstitute);
@@ -728,6 +745,660 @@ TEST_CASE("Document") {
 		REQUIRE(substituted == "\ta\n");
 	}
 
+	SECTION("RegexCache") {
+		// Repeated searches reuse compiled expressions so results must follow the options and word characters
+		constexpr std::string_view text = "ab-cd AB-CD ef";
+		DocPlus doc(text, CpUtf8);
+		const Sci::Position docLength = doc.document.Length();
+		for (int repeat = 0; repeat < 2; repeat++) {
+			REQUIRE(doc.FindString(0, docLength, R"(\w+)", rePosix) == Match(0, 2));
+			REQUIRE(doc.FindString(0, docLength, "AB", rePosix | FindOption::MatchCase) == Match(6, 2));
+			REQUIRE(doc.FindString(0, docLength, "AB", rePosix) == Match(0, 2));
+			REQUIRE(doc.Substitute(R"(<\0>)") == "<ab>");
+		}
+		// More expressions than are cached
+		for (int repeat = 0; repeat < 2; repeat++) {
+			for (const char *finding : { "a", "b", "c", "d", "e", "f", "-", " ", "ab", "cd", "ef" }) {
+				const Match match = doc.FindString(0, docLength, finding, rePosix | FindOption::MatchCase);
+				REQUIRE(match.location == static_cast<Sci::Position>(text.find(finding)));
+			}
+		}
+		// \w depends on the word characters
+		constexpr unsigned char hyphen[] = "-";
+		doc.document.SetCharClasses(hyphen, CharacterClass::word);
+		REQUIRE(doc.FindString(0, docLength, R"(\w+)", rePosix) == Match(0, 5));
+		doc.document.SetDefaultCharClasses(true);
+		REQUIRE(doc.FindString(0, docLength, R"(\w+)", rePosix) == Match(0, 2));
+
+		#ifndef NO_CXX11_REGEX
+		for (int repeat = 0; repeat < 2; repeat++) {
+			REQUIRE(doc.FindString(0, docLength, "[a-z]+-", reCxx11 | FindOption::MatchCase) == Match(0, 3));
+			REQUIRE(doc.FindString(0, docLength, "CD", reCxx11 | FindOption::MatchCase) == Match(9, 2));
+			REQUIRE(doc.FindString(0, docLength, "CD", reCxx11) == Match(3, 2));
+			REQUIRE(doc.Substitute(R"(<\0>)") == "<cd>");
+			REQUIRE_THROWS_AS(doc.FindString(0, docLength, "[a", reCxx11), RegexError);
+		}
+		#endif
+	}
+
+}
+
+TEST_CASE("DocumentFindAll") {
+
+	constexpr FindOption rePosix = FindOption::RegExp | FindOption::Posix;
+	constexpr FindOption reCxx11 = FindOption::RegExp | FindOption::Cxx11RegEx;
+
+	SECTION("Plain") {
+		DocPlus doc("ab Ab abc aB aaaa", CpUtf8);
+		const Sci::Position docLength = doc.document.Length();
+		std::vector<Match> expected { {0, 2}, {6, 2} };
+		REQUIRE(doc.FindAll(0, docLength, "ab", FindOption::MatchCase) == expected);
+		expected = { {0, 2}, {3, 2}, {6, 2}, {10, 2} };
+		REQUIRE(doc.FindAll(0, docLength, "ab", FindOption::None) == expected);
+		// Reversed range is searched forwards
+		REQUIRE(doc.FindAll(docLength, 0, "ab", FindOption::None) == expected);
+		expected = { {0, 2}, {3, 2}, {10, 2} };
+		REQUIRE(doc.FindAll(0, docLength, "ab", FindOption::WholeWord) == expected);
+		// Matches do not overlap
+		expected = { {13, 2}, {15, 2} };
+		REQUIRE(doc.FindAll(0, docLength, "aa", FindOption::MatchCase) == expected);
+		REQUIRE(doc.FindAll(0, docLength, "xyz", FindOption::MatchCase).empty());
+	}
+
+	SECTION("RESearch") {
+		DocPlus doc("ab cd ef\r\ngh ij kl", CpUtf8);
+		const Sci::Position docLength = doc.document.Length();
+		std::vector<Match> expected { {0, 2}, {3, 2}, {6, 2}, {10, 2}, {13, 2}, {16, 2} };
+		REQUIRE(doc.FindAll(0, docLength, "[a-z]+", rePosix) == expected);
+		expected = { {0, 0}, {10, 0} };
+		REQUIRE(doc.FindAll(0, docLength, "^", rePosix) == expected);
+		expected = { {10, 0} };
+		REQUIRE(doc.FindAll(1, docLength, "^", rePosix) == expected);
+		expected = { {0, 1}, {10, 1} };
+		REQUIRE(doc.FindAll(0, docLength, "^[a-z]", rePosix) == expected);
+		expected = { {7, 1}, {17, 1} };
+		REQUIRE(doc.FindAll(0, docLength, "[a-z]$", rePosix) == expected);
+		// Empty matches advance by a character. RESearch does not match empty text at line end.
+		expected = { {0, 2}, {2, 0}, {3, 2}, {5, 0}, {6, 2}, {10, 2} };
+		REQUIRE(doc.FindAll(0, 12, "[a-z]*", rePosix) == expected);
+	}
+
+	SECTION("Cxx11RegEx") {
+		#ifndef NO_CXX11_REGEX
+		DocPlus doc("ab cd ef\r\ngh ij kl", CpUtf8);
+		const Sci::Position docLength = doc.document.Length();
+		std::vector<Match> expected { {0, 2}, {3, 2}, {6, 2}, {10, 2}, {13, 2}, {16, 2} };
+		REQUIRE(doc.FindAll(0, docLength, "[a-z]+", reCxx11) == expected);
+		expected = { {0, 1}, {10, 1} };
+		REQUIRE(doc.FindAll(0, docLength, "^[a-z]", reCxx11) == expected);
+		expected = { {13, 2} };
+		REQUIRE(doc.FindAll(11, 15, "\\b[a-z]+\\b", reCxx11) == expected);
+		#endif
+	}
+
+	SECTION("DecorationFillRanges") {
+		DocPlus doc("ab cd ab ef ab", CpUtf8);
+		const Sci::Position docLength = doc.document.Length();
+		std::vector<Range> ranges;
+		doc.document.FindAll(0, docLength, "ab", FindOption::MatchCase, 2, ranges);
+		REQUIRE(ranges.size() == 3);
+		doc.document.decorations->SetCurrentIndicator(8);
+		doc.document.DecorationFillRanges(ranges, 1);
+		for (Sci::Position pos = 0; pos < docLength; pos++) {
+			const int expectedValue = (doc.document.CharAt(pos) == 'a' || doc.document.CharAt(pos) == 'b') ? 1 : 0;
+			REQUIRE(doc.document.decorations->ValueAt(8, pos) == expectedValue);
+		}
+	}
+}
+
+TEST_CASE("DocumentFindParallel") {
+
+	// Searches divided between threads must find the same matches as searching on one thread.
+	// The text is long enough to be divided into several chunks and has runs of 'a' that
+	// produce matches crossing chunk boundaries.
+
+	std::string sText;
+	int value = 127;
+	while (sText.length() < 0x180000) {
+		value = (109 * value + 853) % 4096;
+		sText.append((value % 5 == 0) ? "Stra\xC3\x9F" "e STRASSE " : "word ");
+		sText.append(value % 7, 'a');
+		sText.append((value % 3 == 0) ? "\n" : " ");
+	}
+	sText.append("needle42\n");
+	DocPlus doc(sText, CpUtf8);
+	const Sci::Position docLength = doc.document.Length();
+	ThreadPool pool;
+	constexpr size_t threads = 4;
+
+	SECTION("FindAll") {
+		const std::pair<std::string_view, FindOption> searches[] = {
+			{ "aa", FindOption::MatchCase },
+			{ "aaa", FindOption::None },
+			{ "word", FindOption::WholeWord },
+			{ "str", FindOption::WordStart },
+			{ "strasse", FindOption::None },
+			{ "a+", FindOption::RegExp | FindOption::Posix },
+			{ "^[a-z]", FindOption::RegExp | FindOption::Posix },
+			#ifndef NO_CXX11_REGEX
+			{ "wo[a-z]+", FindOption::RegExp | FindOption::Cxx11RegEx },
+			#endif
+		};
+		for (const auto &[needle, flags] : searches) {
+			std::vector<Range> serial;
+			doc.document.FindAll(0, docLength, needle.data(), flags, needle.length(), serial);
+			std::vector<Range> parallel;
+			doc.document.FindAllParallel(pool, threads, 0, docLength, needle.data(), flags, needle.length(), parallel);
+			REQUIRE(!serial.empty());
+			REQUIRE(serial == parallel);
+		}
+	}
+
+	SECTION("FindText") {
+		const std::pair<std::string_view, FindOption> searches[] = {
+			{ "needle", FindOption::MatchCase },
+			{ "NEEDLE4", FindOption::None },
+			{ "STRASSE", FindOption::MatchCase },
+			{ "absent", FindOption::None },
+		};
+		for (const auto &[needle, flags] : searches) {
+			for (const Sci::Position start : { Sci::Position(0), docLength / 3, docLength - 20 }) {
+				Sci::Position lengthSerial = needle.length();
+				const Sci::Position serial = doc.document.FindText(start, docLength, needle.data(), flags, &lengthSerial);
+				Sci::Position lengthParallel = needle.length();
+				const Sci::Position parallel = doc.document.FindTextParallel(pool, threads, start, docLength,
+					needle.data(), flags, &lengthParallel);
+				REQUIRE(serial == parallel);
+				REQUIRE(lengthSerial == lengthParallel);
+			}
+		}
+
+		// Regular expression tags are available for substitution after a parallel search
+		constexpr std::string_view finding = "\\(needle\\)\\([0-9]+\\)";
+		Sci::Position lengthFinding = finding.length();
+		const Sci::Position pos = doc.document.FindTextParallel(pool, threads, 0, docLength, finding.data(),
+			FindOption::RegExp, &lengthFinding);
+		REQUIRE(pos == docLength - 9);
+		REQUIRE(lengthFinding == 8);
+		REQUIRE(doc.Substitute("\\2-\\1") == "42-needle");
+	}
+}
+
+TEST_CASE("DocumentFindFast") {
+
+	// Forward searches check runs of ASCII text directly and use complete matching near
+	// other characters and where the text crosses the gap.
+
+	// Search forward from just after each match
+	auto findEvery = [](DocPlus &doc, std::string_view needle, FindOption flags) {
+		std::vector<Match> found;
+		const Sci::Position docLength = doc.document.Length();
+		Sci::Position pos = 0;
+		while (pos < docLength) {
+			const Match match = doc.FindString(pos, docLength, needle, flags);
+			if (match.location < 0)
+				break;
+			found.push_back(match);
+			pos = match.location + 1;
+		}
+		return found;
+	};
+
+	SECTION("UTF8") {
+		// Kelvin sign U+212A folds to 'k' but is 3 bytes long
+		DocPlus doc("Kelvin \xE2\x84\xAA" "elvin KELVIN \xC3\xA9kelvin kelvi", CpUtf8);
+		const std::vector<Match> expected { {0, 6}, {7, 8}, {16, 6}, {25, 6} };
+		const std::vector<Match> expectedWord { {0, 6}, {7, 8}, {16, 6} };
+		for (Sci::Position gapPos = 0; gapPos <= doc.document.Length(); gapPos++) {
+			doc.MoveGap(gapPos);
+			REQUIRE(findEvery(doc, "kelvin", FindOption::None) == expected);
+			REQUIRE(findEvery(doc, "KeLvIn", FindOption::None) == expected);
+			REQUIRE(findEvery(doc, "kelvin", FindOption::WholeWord) == expectedWord);
+			REQUIRE(findEvery(doc, "Kelvin", FindOption::MatchCase) == std::vector<Match> { {0, 6} });
+			REQUIRE(findEvery(doc, "vin", FindOption::None).size() == 4);
+			REQUIRE(findEvery(doc, "\xC3\xA9k", FindOption::None) == std::vector<Match> { {23, 3} });
+		}
+	}
+
+	SECTION("Long") {
+		// Patterns of 32 or more bytes skip through the text
+		DocPlus doc("The Quick Brown Fox Jumps Over The Lazy Dog \xC3\xA9 "
+			"the quick brown fox jumps over the lazy dog. THE QUICK BROWN FOX JUMPS OVER THE LAZY DO", CpUtf8);
+		for (Sci::Position gapPos = 0; gapPos <= doc.document.Length(); gapPos += 5) {
+			doc.MoveGap(gapPos);
+			REQUIRE(findEvery(doc, "quick brown fox jumps over the lazy dog", FindOption::None) ==
+				std::vector<Match> { {4, 39}, {51, 39} });
+			REQUIRE(findEvery(doc, "quick brown fox jumps over the lazy dog", FindOption::MatchCase) ==
+				std::vector<Match> { {51, 39} });
+			REQUIRE(findEvery(doc, "Lazy Dog \xC3\xA9 the quick brown fox ju", FindOption::None) ==
+				std::vector<Match> { {35, 34} });
+		}
+	}
+
+	SECTION("Latin1252") {
+		// Non-ASCII bytes are folded by the table
+		DocPlus doc("tru\xc6st TRU\xe6ST trust TRUST", 0);
+		doc.SetSBCSFoldings(foldings1252, std::size(foldings1252));
+		for (Sci::Position gapPos = 0; gapPos <= doc.document.Length(); gapPos++) {
+			doc.MoveGap(gapPos);
+			REQUIRE(findEvery(doc, "trust", FindOption::None) == std::vector<Match> { {14, 5}, {20, 5} });
+			REQUIRE(findEvery(doc, "TRU\xc6ST", FindOption::None) == std::vector<Match> { {0, 6}, {7, 6} });
+			REQUIRE(findEvery(doc, "st", FindOption::None).size() == 4);
+		}
+	}
+
+	SECTION("Every") {
+		// Long enough for several blocks of ASCII checking
+		std::string sText;
+		for (int line = 0; line < 5000; line++) {
+			sText.append("Caf\xC3\xA9 NEEDLE needle Needle ");
+			sText.append(line % 50, 'x');
+			sText.append("\n");
+		}
+		DocPlus doc(sText, CpUtf8);
+		doc.MoveGap(doc.document.Length() / 2 + 3);
+		const std::vector<Match> insensitive = findEvery(doc, "needle", FindOption::None);
+		REQUIRE(insensitive.size() == 15000);
+		REQUIRE(std::all_of(insensitive.begin(), insensitive.end(), [](const Match &match) {
+			return match.length == 6;
+		}));
+		REQUIRE(findEvery(doc, "needle", FindOption::MatchCase).size() == 5000);
+		REQUIRE(findEvery(doc, "\ncaf", FindOption::None).size() == 4999);
+		REQUIRE(findEvery(doc, "\xC3\xA9 NEEDLE NEEDLE NEEDLE", FindOption::None).size() == 5000);
+	}
+}
+
+TEST_CASE("DocumentLinearRegex") {
+
+	constexpr FindOption reLinear = FindOption::RegExp | FindOption::LinearRegEx;
+	constexpr FindOption reLinearCase = reLinear | FindOption::MatchCase;
+
+	SECTION("LeftmostLongest") {
+		DocPlus doc("xx abcd abc ab\n", CpUtf8);
+		const Sci::Position docLength = doc.document.Length();
+		REQUIRE(doc.FindString(0, docLength, "ab|abcd|abc", reLinearCase) == Match(3, 4));
+		REQUIRE(doc.FindString(0, docLength, "b+c*", reLinearCase) == Match(4, 2));
+		REQUIRE(doc.FindString(0, docLength, "ABC", reLinearCase).location == -1);
+		REQUIRE(doc.FindString(0, docLength, "ABC", reLinear) == Match(3, 3));
+		REQUIRE(doc.FindString(0, docLength, "[B-C]{2}", reLinear) == Match(4, 2));
+		REQUIRE(doc.FindString(0, docLength, "c d", reLinearCase).location == -1);
+	}
+
+	SECTION("Groups") {
+		DocPlus doc("key = value;\n", CpUtf8);
+		const Sci::Position docLength = doc.document.Length();
+		REQUIRE(doc.FindString(0, docLength, "(\\w+) = (\\w+)", reLinearCase) == Match(0, 11));
+		REQUIRE(doc.Substitute("\\2 = \\1") == "value = key");
+		// Group that does not take part substitutes nothing
+		REQUIRE(doc.FindString(0, docLength, "(x)?(v\\w*)", reLinearCase) == Match(6, 5));
+		REQUIRE(doc.Substitute("[\\1\\2]\\t") == "[value]\t");
+
+		// Groups take the first alternatives that reach the end of the longest match
+		DocPlus docAlternatives("abcd", CpUtf8);
+		REQUIRE(docAlternatives.FindString(0, 4, "(a|ab)(c|bcd)", reLinearCase) == Match(0, 4));
+		REQUIRE(docAlternatives.Substitute("\\1-\\2") == "a-bcd");
+		REQUIRE(docAlternatives.FindString(0, 4, "(?:ab)+(c)", reLinearCase) == Match(0, 3));
+		REQUIRE(docAlternatives.Substitute("\\0,\\1") == "abc,c");
+	}
+
+	SECTION("Assertions") {
+		DocPlus doc("one two\r\nthree\ntwo\rtwo", CpUtf8);
+		const Sci::Position docLength = doc.document.Length();
+		REQUIRE(doc.FindAll(0, docLength, "^t\\w+", reLinearCase) == std::vector<Match>{ {9, 5}, {15, 3}, {19, 3} });
+		REQUIRE(doc.FindAll(0, docLength, "\\w+$", reLinearCase) == std::vector<Match>{ {4, 3}, {9, 5}, {15, 3}, {19, 3} });
+		REQUIRE(doc.FindAll(0, docLength, "\\<t", reLinearCase) == std::vector<Match>{ {4, 1}, {9, 1}, {15, 1}, {19, 1} });
+		REQUIRE(doc.FindAll(0, docLength, "o\\>", reLinearCase) == std::vector<Match>{ {6, 1}, {17, 1}, {21, 1} });
+		REQUIRE(doc.FindAll(0, docLength, "\\Bo", reLinearCase) == std::vector<Match>{ {6, 1}, {17, 1}, {21, 1} });
+		REQUIRE(doc.FindAll(0, docLength, "\\bt", reLinearCase) == std::vector<Match>{ {4, 1}, {9, 1}, {15, 1}, {19, 1} });
+		// Matches do not extend over line ends
+		REQUIRE(doc.FindAll(0, docLength, ".+", reLinearCase) == std::vector<Match>{ {0, 7}, {9, 5}, {15, 3}, {19, 3} });
+		REQUIRE(doc.FindAll(0, docLength, "[^x]+", reLinearCase) == std::vector<Match>{ {0, 7}, {9, 5}, {15, 3}, {19, 3} });
+		REQUIRE(doc.FindString(0, docLength, "e$", reLinearCase) == Match(13, 1));
+		// Start of search is not the start of a line
+		REQUIRE(doc.FindString(1, docLength, "^\\w", reLinearCase) == Match(9, 1));
+	}
+
+	SECTION("UTF8") {
+		DocPlus doc("caf\xc3\xa9 \xc3\xb1" "and\xc3\xba \xe2\x82\xac" "5", CpUtf8);
+		const Sci::Position docLength = doc.document.Length();
+		REQUIRE(doc.FindString(0, docLength, "f.\\s", reLinearCase) == Match(2, 4));
+		REQUIRE(doc.FindString(0, docLength, "[^a-z ]+", reLinearCase) == Match(3, 2));
+		REQUIRE(doc.FindString(0, docLength, "[\xc3\xa0-\xc3\xbf]", reLinearCase) == Match(3, 2));
+		REQUIRE(doc.FindString(0, docLength, "\\xe9", reLinearCase) == Match(3, 2));
+		REQUIRE(doc.FindString(0, docLength, ".\\d", reLinearCase) == Match(14, 4));
+		REQUIRE(doc.FindAll(0, docLength, "\\w+", reLinearCase) == std::vector<Match>{ {0, 5}, {6, 7}, {14, 4} });
+		REQUIRE(doc.FindString(docLength, 0, "[a-z]+", reLinearCase) == Match(8, 3));
+		REQUIRE(doc.FindString(docLength, 0, "\\b\\w", reLinearCase) == Match(14, 3));
+		// Backwards finds the match that ends last
+		DocPlus docRepeated("aaa", CpUtf8);
+		REQUIRE(docRepeated.FindString(3, 0, "aa", reLinearCase) == Match(1, 2));
+	}
+
+	SECTION("DBCS") {
+		// Shift-JIS character 0x8341 has a trail byte that is also 'A'
+		DocPlus doc("a\x83\x41" "A", 932);
+		const Sci::Position docLength = doc.document.Length();
+		REQUIRE(doc.FindString(0, docLength, "A", reLinearCase) == Match(3, 1));
+		REQUIRE(doc.FindString(0, docLength, "[A-Z]+", reLinearCase) == Match(3, 1));
+		REQUIRE(doc.FindString(docLength, 0, "A+", reLinearCase) == Match(3, 1));
+		REQUIRE(doc.FindString(1, docLength, ".", reLinearCase) == Match(1, 2));
+		REQUIRE(doc.FindString(0, docLength, "\x83\x41", reLinearCase) == Match(1, 2));
+		REQUIRE(doc.FindString(0, docLength, "[\x83\x40-\x83\x45]A", reLinearCase) == Match(1, 3));
+	}
+
+	SECTION("Gap") {
+		DocPlus doc("the quick brown fox jumps\n", CpUtf8);
+		const Sci::Position docLength = doc.document.Length();
+		for (Sci::Position gap = 0; gap <= docLength; gap++) {
+			doc.MoveGap(gap);
+			REQUIRE(doc.FindString(0, docLength, "q\\w+ b\\w+", reLinearCase) == Match(4, 11));
+			REQUIRE(doc.FindString(docLength, 0, "[aeiou]\\w", reLinearCase) == Match(21, 2));
+			REQUIRE(doc.FindAll(0, docLength, "o\\w", reLinearCase) == std::vector<Match>{ {12, 2}, {17, 2} });
+		}
+	}
+
+	SECTION("FindAll") {
+		DocPlus doc("a1 b22 c333\nd4444", CpUtf8);
+		const Sci::Position docLength = doc.document.Length();
+		REQUIRE(doc.FindAll(0, docLength, "\\d+", reLinearCase) == std::vector<Match>{ {1, 1}, {4, 2}, {8, 3}, {13, 4} });
+		DocPlus docEmpty("ab", CpUtf8);
+		REQUIRE(docEmpty.FindAll(0, 2, "x*", reLinearCase) == std::vector<Match>{ {0, 0}, {1, 0}, {2, 0} });
+		// No empty match between CR and LF
+		DocPlus docLines("a\r\nb", CpUtf8);
+		REQUIRE(docLines.FindAll(0, 4, "x*", reLinearCase) == std::vector<Match>{ {0, 0}, {1, 0}, {3, 0}, {4, 0} });
+	}
+
+	SECTION("Linear") {
+		// Nested repetitions take exponential time with backtracking
+		DocPlus doc(std::string(100000, 'a'), CpUtf8);
+		const Sci::Position docLength = doc.document.Length();
+		REQUIRE(doc.FindString(0, docLength, "(a*)*b", reLinearCase).location == -1);
+		REQUIRE(doc.FindString(0, docLength, "(a|aa)+$", reLinearCase) == Match(0, docLength));
+		REQUIRE(doc.Substitute("\\1") == "a");
+		// Each search scans to the end of the line in case 'x' follows
+		REQUIRE(doc.FindString(docLength, 0, "a|a[^x]*x", reLinearCase) == Match(docLength - 1, 1));
+		const std::vector<Match> all = doc.FindAll(0, docLength, "a|a[^x]*x", reLinearCase);
+		REQUIRE(all.size() == static_cast<size_t>(docLength));
+		REQUIRE(all.back() == Match(docLength - 1, 1));
+	}
+
+	SECTION("ManyStates") {
+		// Needs more states than are kept so they are discarded and built again
+		std::string text;
+		unsigned int seed = 1;
+		for (int i = 0; i < 20000; i++) {
+			seed = seed * 1103515245 + 12345;
+			text.push_back(((seed >> 16) & 1) ? 'a' : 'b');
+		}
+		DocPlus doc(text, CpUtf8);
+		const size_t lastA = text.find_last_of('a', text.length() - 13);
+		REQUIRE(doc.FindString(0, doc.document.Length(), "[ab]*a[ab]{12}", reLinearCase) == Match(0, lastA + 13));
+	}
+
+	SECTION("Errors") {
+		DocPlus doc("a{b\n", CpUtf8);
+		const Sci::Position docLength = doc.document.Length();
+		for (const std::string_view pattern : { "(a)\\1", "(a", "a)", "[a", "*a", "a{2,1}", "a{1001}", "\xff" }) {
+			REQUIRE_THROWS_AS(doc.FindString(0, docLength, pattern, reLinear), RegexError);
+		}
+		// '{' without a count is literal
+		REQUIRE(doc.FindString(0, docLength, "a{b", reLinearCase) == Match(0, 3));
+	}
+}
+
+TEST_CASE("ConvertLineEnds") {
+
+	constexpr std::string_view sText = "a\r\nb\rc\nd";
+	DocPlus doc(sText, CpUtf8);
+
+	SECTION("CrLf") {
+		doc.document.ConvertLineEnds(EndOfLine::CrLf);
+		REQUIRE(doc.Contents() == "a\r\nb\r\nc\r\nd");
+	}
+
+	SECTION("Cr") {
+		doc.document.ConvertLineEnds(EndOfLine::Cr);
+		REQUIRE(doc.Contents() == "a\rb\rc\rd");
+	}
+
+	SECTION("Lf") {
+		doc.document.ConvertLineEnds(EndOfLine::Lf);
+		REQUIRE(doc.Contents() == "a\nb\nc\nd");
+		REQUIRE(doc.document.LinesTotal() == 4);
+	}
+}
+
+TEST_CASE("DocumentMapped") {
+
+	// A mapped document refers to the text given to its loader instead of copying it
+
+	const std::string sLoaded = "Line 1\nLine 2\r\nLine 3";
+	Document doc(DocumentOption::TextMapped);
+	doc.AddRef();
+	doc.SetUndoCollection(false);
+
+	SECTION("Load") {
+		ILoader *loader = &doc;
+		REQUIRE(static_cast<int>(Status::Ok) == loader->AddData(sLoaded.c_str(), 7));
+		REQUIRE(static_cast<int>(Status::Ok) == loader->AddData(sLoaded.c_str() + 7, sLoaded.length() - 7));
+		loader->ConvertToDocument();
+		REQUIRE(FlagSet(doc.Options(), DocumentOption::TextMapped));
+		REQUIRE(doc.Length() == static_cast<Sci::Position>(sLoaded.length()));
+		REQUIRE(doc.LinesTotal() == 3);
+		REQUIRE(doc.LineStart(2) == 15);
+		REQUIRE(doc.RangePointer(0, doc.Length()) == sLoaded.c_str());
+
+		doc.SetUndoCollection(true);
+		doc.InsertString(7, "Inserted ", 9);
+		doc.DeleteChars(0, 5);
+		REQUIRE(doc.CharAt(0) == '1');
+		REQUIRE(doc.LinesTotal() == 3);
+		REQUIRE(std::string_view(doc.BufferPointer()) == "1\nInserted Line 2\r\nLine 3");
+		doc.Undo();
+		doc.Undo();
+		REQUIRE(std::string_view(doc.BufferPointer()) == sLoaded);
+		// Loaded text was not changed
+		REQUIRE(sLoaded == "Line 1\nLine 2\r\nLine 3");
+	}
+
+	SECTION("Styles") {
+		doc.InsertString(0, sLoaded.c_str(), sLoaded.length());
+		doc.StartStyling(0);
+		doc.SetStyleFor(4, 2);
+		REQUIRE(doc.StyleAt(3) == 2);
+		REQUIRE(doc.StyleAt(4) == 0);
+		doc.InsertString(1, "ab", 2);
+		REQUIRE(doc.StyleAt(0) == 2);
+		REQUIRE(doc.StyleAt(1) == 0);
+		REQUIRE(doc.StyleAt(5) == 2);
+	}
+}
+
+TEST_CASE("DocumentLinesTree") {
+
+	Document doc(DocumentOption::LinesTree);
+	REQUIRE(doc.IsLinesTree());
+	REQUIRE(FlagSet(doc.Options(), DocumentOption::LinesTree));
+	constexpr std::string_view sText = "a\nbc\r\ndef\rg";
+	doc.InsertString(0, sText);
+	REQUIRE(4 == doc.LinesTotal());
+	REQUIRE(6 == doc.LineStart(2));
+	REQUIRE(2 == doc.SciLineFromPosition(6));
+	doc.DeleteChars(1, 1);
+	REQUIRE(3 == doc.LinesTotal());
+	REQUIRE(0 == doc.SciLineFromPosition(3));
+}
+
+TEST_CASE("LoadBenchmark", "[.benchmark]") {
+
+	// Load 64 MB through ILoader and report throughput for each text storage
+
+	std::string sText;
+	while (sText.length() < 64 * 1024 * 1024) {
+		sText.append("Some text that is a typical length for a line of source code;\n");
+	}
+	const double megaBytes = sText.length() / (1024.0 * 1024.0);
+	constexpr std::pair<DocumentOption, std::string_view> options[] = {
+		{ DocumentOption::Default, "gap" },
+		{ DocumentOption::TextRope, "rope" },
+		{ DocumentOption::TextMapped, "mapped" },
+		{ DocumentOption::LinesTree, "tree" },
+	};
+	for (const auto &[option, name] : options) {
+		Document doc(option | DocumentOption::TextLarge);
+		doc.AddRef();
+		doc.SetUndoCollection(false);
+		Catch::Timer tikka;
+		tikka.start();
+		constexpr size_t blockSize = 128 * 1024;
+		for (size_t start = 0; start < sText.length(); start += blockSize) {
+			REQUIRE(static_cast<int>(Status::Ok) == doc.AddData(sText.c_str() + start, std::min(blockSize, sText.length() - start)));
+		}
+		REQUIRE(doc.ConvertToDocument());
+		const double seconds = tikka.getElapsedNanoseconds() / 1.0e9;
+		REQUIRE(doc.LinesTotal() == std::count(sText.begin(), sText.end(), '\n') + 1);
+		std::cout << "Load " << std::setw(6) << name << std::setw(8) << std::fixed << std::setprecision(0) <<
+			(megaBytes / seconds) << " MB/s" << std::endl;
+	}
+}
+
+TEST_CASE("FindAllBenchmark", "[.benchmark]") {
+
+	// Indicate every match in a 64 MB document with one hit per line, comparing
+	// repeated FindText and DecorationFillRange calls with one FindAll.
+
+	std::string sText;
+	while (sText.length() < 64 * 1024 * 1024) {
+		sText.append("Some text that is a typical length for a line of source code;\n");
+	}
+	constexpr std::string_view needle = "typical";
+	const Sci::Position needleLength = needle.length();
+
+	SECTION("FindText") {
+		DocPlus doc(sText, CpUtf8);
+		const Sci::Position docLength = doc.document.Length();
+		doc.document.decorations->SetCurrentIndicator(8);
+		Catch::Timer tikka;
+		tikka.start();
+		size_t hits = 0;
+		Sci::Position pos = 0;
+		while (pos < docLength) {
+			Sci::Position lengthFound = needleLength;
+			const Sci::Position found = doc.document.FindText(pos, docLength, needle.data(), FindOption::MatchCase, &lengthFound);
+			if (found < 0)
+				break;
+			doc.document.DecorationFillRange(found, 1, lengthFound);
+			hits++;
+			pos = found + lengthFound;
+		}
+		std::cout << "FindText " << hits << " hits in " << tikka.getElapsedMilliseconds() << " milliseconds" << std::endl;
+	}
+
+	SECTION("FindAll") {
+		DocPlus doc(sText, CpUtf8);
+		const Sci::Position docLength = doc.document.Length();
+		doc.document.decorations->SetCurrentIndicator(8);
+		Catch::Timer tikka;
+		tikka.start();
+		std::vector<Range> ranges;
+		doc.document.FindAll(0, docLength, needle.data(), FindOption::MatchCase, needleLength, ranges);
+		doc.document.DecorationFillRanges(ranges, 1);
+		std::cout << "FindAll  " << ranges.size() << " hits in " << tikka.getElapsedMilliseconds() << " milliseconds" << std::endl;
+	}
+}
+
+TEST_CASE("RegexSearchBenchmark", "[.benchmark]") {
+
+	// Search a 10 MB document with the same expression from each previous match, as
+	// repeated SCI_SEARCHINTARGET calls do, so compiling the expression dominates.
+
+	std::string sText;
+	while (sText.length() < 10 * 1024 * 1024) {
+		sText.append("Some text that is a typical length for a line of source code;\n");
+	}
+	DocPlus doc(sText, CpUtf8);
+	const Sci::Position docLength = doc.document.Length();
+	constexpr std::string_view needle = "typ[a-z]+ l[a-z]+";
+	const std::pair<const char *, FindOption> engines[] = {
+		{ "RESearch ", FindOption::RegExp | FindOption::Posix },
+		#ifndef NO_CXX11_REGEX
+		{ "std::regex ", FindOption::RegExp | FindOption::Cxx11RegEx },
+		#endif
+		{ "LinearRegex ", FindOption::RegExp | FindOption::LinearRegEx },
+	};
+	for (const auto &[name, flags] : engines) {
+		Catch::Timer tikka;
+		tikka.start();
+		size_t hits = 0;
+		Sci::Position pos = 0;
+		while (pos < docLength && hits < 10000) {
+			Sci::Position lengthFound = needle.length();
+			const Sci::Position found = doc.document.FindText(pos, docLength, needle.data(), flags, &lengthFound);
+			if (found < 0)
+				break;
+			hits++;
+			pos = found + lengthFound;
+		}
+		REQUIRE(hits == 10000);
+		std::cout << name << hits << " searches in " << tikka.getElapsedMilliseconds() << " milliseconds" << std::endl;
+	}
+}
+
+TEST_CASE("FindFastBenchmark", "[.benchmark]") {
+
+	// Search 64 MB for a string only present at its end with each case option,
+	// for short and long strings and for text with some non-ASCII characters.
+
+	for (const std::string_view line : {
+		"Some text that is a typical length for a line of source code;\n",
+		"Some text with an accented caf\xC3\xA9 in a line of source code;\n" }) {
+		std::string sText;
+		while (sText.length() < 64 * 1024 * 1024) {
+			sText.append(line);
+		}
+		sText.append("needle in a haystack of text\n");
+		DocPlus doc(sText, CpUtf8);
+		const Sci::Position docLength = doc.document.Length();
+		for (const std::string_view needle : { "needle", "needle in a haystack" }) {
+			for (const FindOption flags : { FindOption::MatchCase, FindOption::None }) {
+				Catch::Timer tikka;
+				tikka.start();
+				Sci::Position lengthFound = needle.length();
+				const Sci::Position pos = doc.document.FindText(0, docLength, needle.data(), flags, &lengthFound);
+				REQUIRE(pos == docLength - 29);
+				std::cout << "Find " << needle.length() << " bytes " <<
+					(FlagSet(flags, FindOption::MatchCase) ? "case sensitive   " : "case insensitive ") <<
+					tikka.getElapsedMilliseconds() << " milliseconds" << std::endl;
+			}
+		}
+	}
+}
+
+TEST_CASE("FindParallelBenchmark", "[.benchmark]") {
+
+	// Search 128 MB for a string only present at its end on one thread then on all threads.
+
+	std::string sText;
+	while (sText.length() < 128 * 1024 * 1024) {
+		sText.append("Some text that is a typical length for a line of source code;\n");
+	}
+	sText.append("needle\n");
+	DocPlus doc(sText, CpUtf8);
+	const Sci::Position docLength = doc.document.Length();
+	ThreadPool pool;
+	constexpr std::string_view needle = "NEEDLE";
+	for (const size_t threads : { size_t(1), size_t(std::thread::hardware_concurrency()) }) {
+		for (const FindOption flags : { FindOption::MatchCase, FindOption::None }) {
+			Catch::Timer tikka;
+			tikka.start();
+			Sci::Position lengthFound = needle.length();
+			const Sci::Position pos = doc.document.FindTextParallel(pool, threads, 0, docLength,
+				FlagSet(flags, FindOption::MatchCase) ? "needle" : needle.data(), flags, &lengthFound);
+			REQUIRE(pos == docLength - 7);
+			std::cout << "Find " << (FlagSet(flags, FindOption::MatchCase) ? "case sensitive   " : "case insensitive ") <<
+				threads << " threads " << tikka.getElapsedMilliseconds() << " milliseconds" << std::endl;
+		}
+	}
 }
 
 TEST_CASE("DocumentUndo") {
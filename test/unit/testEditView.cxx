@@ -0,0 +1,799 @@
+/** @file testEditView.cxx
+ ** Unit Tests for Scintilla internal data structures
+ **/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <set>
+#include <forward_list>
+#include <optional>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <iostream>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "ScintillaTypes.h"
+#include "ScintillaMessages.h"
+#include "ScintillaStructures.h"
+#include "ILoader.h"
+#include "ILexer.h"
+
+#include "Debugging.h"
+#include "Geometry.h"
+#include "Platform.h"
+
+#include "CharacterCategoryMap.h"
+#include "Position.h"
+#include "UniqueString.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "ContractionState.h"
+#include "CellBuffer.h"
+#include "PerLine.h"
+#include "KeyMap.h"
+#include "Indicator.h"
+#include "LineMarker.h"
+#include "Style.h"
+#include "ViewStyle.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+#include "Selection.h"
+#include "PositionCache.h"
+#include "EditModel.h"
+#include "MarginView.h"
+#include "EditView.h"
+#include "ThreadPool.h"
+#include "BackgroundWrap.h"
+
+#include "catch.hpp"
+
+using namespace Scintilla;
+using namespace Scintilla::Internal;
+
+// Needed by ViewStyle in code being tested. The platform layer is replaced by a surface
+// with simple, predictable text widths so that layout can be checked without a window system.
+
+std::shared_ptr<Font> Font::Allocate(const FontParameters &) {
+	return std::make_shared<Font>();
+}
+
+ColourRGBA Platform::Chrome() {
+	return ColourRGBA(0xc0, 0xc0, 0xc0);
+}
+
+ColourRGBA Platform::ChromeHighlight() {
+	return ColourRGBA(0xff, 0xff, 0xff);
+}
+
+const char *Platform::DefaultFont() {
+	return "Test";
+}
+
+int Platform::DefaultFontSize() {
+	return 10;
+}
+
+namespace {
+
+// Proportional font where each ASCII character has its own width and, when kerned,
+// "V" after "A" is narrower. UTF-8 continuation bytes share the position of their lead byte.
+class TestSurface : public Surface {
+	XYPOSITION CharacterWidth(unsigned char ch, unsigned char previous) const noexcept {
+		if ((ch & 0xC0) == 0x80) {
+			return 0.0;
+		}
+		if (ch >= 0x80) {
+			return 12.0;
+		}
+		XYPOSITION width = 4.0 + (ch % 5) * 0.75;
+		if (kerned && (previous == 'A') && (ch == 'V')) {
+			width -= 2.0;
+		}
+		return width;
+	}
+	// Pixmaps count their measuring and drawing in the surface that allocated them
+	TestSurface *root = this;
+public:
+	bool kerned = false;
+	// Atomic as layout threads may measure with the same surface
+	std::atomic<size_t> bytesMeasured = 0;
+	// Lines copied to this surface and lines drawn into its pixmaps and flushed
+	size_t copies = 0;
+	size_t flushes = 0;
+
+	void Init(WindowID) override {}
+	void Init(SurfaceID, WindowID) override {}
+	std::unique_ptr<Surface> AllocatePixMap(int, int) override {
+		std::unique_ptr<TestSurface> pixmap = std::make_unique<TestSurface>();
+		pixmap->root = root;
+		pixmap->kerned = kerned;
+		return pixmap;
+	}
+	void SetMode(SurfaceMode) override {}
+	void Release() noexcept override {}
+	int SupportsFeature(Supports feature) noexcept override {
+		return feature == Supports::ThreadSafeMeasureWidths;
+	}
+	bool Initialised() override {
+		return true;
+	}
+	int LogPixelsY() override {
+		return 72;
+	}
+	int PixelDivisions() override {
+		return 1;
+	}
+	int DeviceHeightFont(int points) override {
+		return points;
+	}
+	void LineDraw(Point, Point, Stroke) override {}
+	void PolyLine(const Point *, size_t, Stroke) override {}
+	void Polygon(const Point *, size_t, FillStroke) override {}
+	void RectangleDraw(PRectangle, FillStroke) override {}
+	void RectangleFrame(PRectangle, Stroke) override {}
+	void FillRectangle(PRectangle, Fill) override {}
+	void FillRectangleAligned(PRectangle, Fill) override {}
+	void FillRectangle(PRectangle, Surface &) override {}
+	void RoundedRectangle(PRectangle, FillStroke) override {}
+	void AlphaRectangle(PRectangle, XYPOSITION, FillStroke) override {}
+	void GradientRectangle(PRectangle, const std::vector<ColourStop> &, GradientOptions) override {}
+	void DrawRGBAImage(PRectangle, int, int, const unsigned char *) override {}
+	void Ellipse(PRectangle, FillStroke) override {}
+	void Stadium(PRectangle, FillStroke, Ends) override {}
+	void Copy(PRectangle, Point, Surface &) override {
+		root->copies++;
+	}
+	std::unique_ptr<IScreenLineLayout> Layout(const IScreenLine *) override {
+		return {};
+	}
+	void DrawTextNoClip(PRectangle, const Font *, XYPOSITION, std::string_view, ColourRGBA, ColourRGBA) override {}
+	void DrawTextClipped(PRectangle, const Font *, XYPOSITION, std::string_view, ColourRGBA, ColourRGBA) override {}
+	void DrawTextTransparent(PRectangle, const Font *, XYPOSITION, std::string_view, ColourRGBA) override {}
+	void MeasureWidths(const Font *, std::string_view text, XYPOSITION *positions) override {
+		root->bytesMeasured += text.length();
+		XYPOSITION position = 0.0;
+		unsigned char previous = 0;
+		for (size_t i = 0; i < text.length(); i++) {
+			const unsigned char ch = text[i];
+			position += CharacterWidth(ch, previous);
+			positions[i] = position;
+			previous = ch;
+		}
+	}
+	XYPOSITION WidthText(const Font *font_, std::string_view text) override {
+		if (text.empty()) {
+			return 0.0;
+		}
+		std::vector<XYPOSITION> positions(text.length());
+		MeasureWidths(font_, text, positions.data());
+		return positions.back();
+	}
+	void DrawTextNoClipUTF8(PRectangle, const Font *, XYPOSITION, std::string_view, ColourRGBA, ColourRGBA) override {}
+	void DrawTextClippedUTF8(PRectangle, const Font *, XYPOSITION, std::string_view, ColourRGBA, ColourRGBA) override {}
+	void DrawTextTransparentUTF8(PRectangle, const Font *, XYPOSITION, std::string_view, ColourRGBA) override {}
+	void MeasureWidthsUTF8(const Font *font_, std::string_view text, XYPOSITION *positions) override {
+		MeasureWidths(font_, text, positions);
+	}
+	XYPOSITION WidthTextUTF8(const Font *font_, std::string_view text) override {
+		return WidthText(font_, text);
+	}
+	XYPOSITION Ascent(const Font *) override {
+		return 10.0;
+	}
+	XYPOSITION Descent(const Font *) override {
+		return 3.0;
+	}
+	XYPOSITION InternalLeading(const Font *) override {
+		return 1.0;
+	}
+	XYPOSITION Height(const Font *) override {
+		return 13.0;
+	}
+	XYPOSITION AverageCharWidth(const Font *) override {
+		return 6.0;
+	}
+	void SetClip(PRectangle) override {}
+	void PopClip() override {}
+	void FlushCachedState() override {}
+	void FlushDrawing() override {
+		root->flushes++;
+	}
+};
+
+// Model of a single view with the whole document on screen.
+class TestModel : public EditModel {
+public:
+	Sci::Line TopLineOfMain() const noexcept override {
+		return 0;
+	}
+	Point GetVisibleOriginInMain() const override {
+		return Point();
+	}
+	Sci::Line linesOnScreen = 100;
+	Sci::Line LinesOnScreen() const override {
+		return linesOnScreen;
+	}
+};
+
+// Style each word of the document differently so segments break at style changes.
+void StyleWords(Document *pdoc) {
+	std::string styles;
+	char style = 0;
+	for (Sci::Position position = 0; position < pdoc->Length(); position++) {
+		if (pdoc->CharAt(position) == ' ') {
+			style = static_cast<char>((style + 1) % 3);
+		}
+		styles.push_back(style);
+	}
+	pdoc->StartStyling(0);
+	pdoc->SetStyles(styles.length(), styles.data());
+}
+
+constexpr std::string_view proseASCII = "The quick brown fox jumps over the lazy dog. AVA {x[i] = y->z;} ~!@#$%^&*()_+";
+
+// Lines of different lengths so they wrap to different numbers of sublines.
+void InsertLines(Document *pdoc, int lines) {
+	std::string text;
+	for (int line = 0; line < lines; line++) {
+		for (int i = 0; i < line % 7; i++) {
+			text += proseASCII;
+			text += "\t\xc3\xa9t\xc3\xa9 ";
+		}
+		text += "\n";
+	}
+	pdoc->InsertString(0, text);
+	StyleWords(pdoc);
+}
+
+}
+
+// Test PositionCache.
+
+TEST_CASE("PositionCache") {
+
+	TestSurface surface;
+	std::unique_ptr<IPositionCache> posCache = CreatePositionCache();
+
+	SECTION("ASCIIWidthsMatchMeasurement") {
+		// Every style of a proportional font without kerning has a width table
+		ViewStyle vsTable;
+		vsTable.Refresh(surface, 8);
+		REQUIRE(!vsTable.styles[StyleDefault].checkMonospaced);
+		REQUIRE(!vsTable.styles[StyleDefault].monospaceASCII);
+		REQUIRE(vsTable.styles[StyleDefault].asciiWidths);
+		REQUIRE(vsTable.styles[StyleLineNumber].asciiWidths);
+
+		std::vector<XYPOSITION> positionsTable(proseASCII.length());
+		surface.bytesMeasured = 0;
+		posCache->MeasureWidths(&surface, vsTable, StyleDefault, true, proseASCII, positionsTable.data(), false);
+		// Only the width table was used
+		REQUIRE(surface.bytesMeasured == 0);
+
+		std::vector<XYPOSITION> positionsMeasured(proseASCII.length());
+		surface.MeasureWidthsUTF8(vsTable.styles[StyleDefault].font.get(), proseASCII, positionsMeasured.data());
+		REQUIRE(surface.bytesMeasured == proseASCII.length());
+
+		for (size_t i = 0; i < proseASCII.length(); i++) {
+			REQUIRE(positionsTable[i] == Approx(positionsMeasured[i]));
+		}
+	}
+
+	SECTION("ASCIIWidthsNotUsedForNonASCII") {
+		ViewStyle vsTable;
+		vsTable.Refresh(surface, 8);
+		REQUIRE(vsTable.styles[StyleDefault].asciiWidths);
+
+		constexpr std::string_view textUTF8 = "caf\xc3\xa9 au lait";
+		std::vector<XYPOSITION> positions(textUTF8.length());
+		surface.bytesMeasured = 0;
+		posCache->MeasureWidths(&surface, vsTable, StyleDefault, true, textUTF8, positions.data(), false);
+		REQUIRE(surface.bytesMeasured == textUTF8.length());
+	}
+
+	SECTION("KernedFontHasNoASCIIWidths") {
+		surface.kerned = true;
+		ViewStyle vsKerned;
+		vsKerned.Refresh(surface, 8);
+		REQUIRE(!vsKerned.styles[StyleDefault].asciiWidths);
+	}
+}
+
+// Test EditView.
+
+TEST_CASE("EditView") {
+
+	TestSurface surface;
+	TestModel model;
+	model.pdoc->SetDBCSCodePage(CpUtf8);
+	ViewStyle vs;
+	vs.Refresh(surface, model.pdoc->tabInChars);
+
+	SECTION("IncrementalLayoutMatchesFullLayout") {
+		// A line long enough to be laid out incrementally with tabs and non-ASCII text
+		std::string text;
+		while (text.length() < 6000) {
+			text += proseASCII;
+			text += "\t\xc3\xa9t\xc3\xa9 ";
+		}
+		model.pdoc->InsertString(0, text);
+		StyleWords(model.pdoc);
+
+		EditView view;
+		std::shared_ptr<LineLayout> ll = view.RetrieveLineLayout(0, model);
+		view.LayoutLine(model, &surface, vs, ll.get(), LineLayout::wrapWidthInfinite);
+		REQUIRE(!ll->segmentStarts.empty());
+
+		// Insertions, deletions, and style changes at spread out positions
+		for (int edit = 0; edit < 30; edit++) {
+			const Sci::Position position = (edit * 1847) % (model.pdoc->Length() - 20);
+			switch (edit % 3) {
+			case 0:
+				model.pdoc->InsertString(position, "inserted text ");
+				break;
+			case 1:
+				model.pdoc->DeleteChars(model.pdoc->MovePositionOutsideChar(position, 1), 7);
+				break;
+			default:
+				model.pdoc->StartStyling(position);
+				model.pdoc->SetStyleFor(5, 2);
+				break;
+			}
+			if (edit % 3 != 2) {
+				StyleWords(model.pdoc);
+			}
+			view.llc.Invalidate(LineLayout::ValidLevel::checkTextAndStyle);
+
+			ll = view.RetrieveLineLayout(0, model);
+			surface.bytesMeasured = 0;
+			view.LayoutLine(model, &surface, vs, ll.get(), LineLayout::wrapWidthInfinite);
+			// Only the segments around the edit were measured again
+			REQUIRE(surface.bytesMeasured < static_cast<size_t>(ll->numCharsInLine / 4));
+
+			EditView viewFull;
+			std::shared_ptr<LineLayout> llFull = viewFull.RetrieveLineLayout(0, model);
+			viewFull.LayoutLine(model, &surface, vs, llFull.get(), LineLayout::wrapWidthInfinite);
+
+			REQUIRE(ll->numCharsInLine == llFull->numCharsInLine);
+			REQUIRE(ll->segmentStarts == llFull->segmentStarts);
+			for (int i = 0; i <= ll->numCharsInLine; i++) {
+				REQUIRE(ll->positions[i] == Approx(llFull->positions[i]));
+			}
+		}
+	}
+
+	SECTION("LazyLayoutMatchesFullLayout") {
+		std::string text;
+		while (text.length() < 20000) {
+			text += proseASCII;
+		}
+		model.pdoc->InsertString(0, text);
+		vs.wrap.state = Wrap::Word;
+		constexpr int width = 400;
+		// Enough lines on screen to show every subline
+		model.linesOnScreen = 1000;
+
+		EditView viewFull;
+		std::shared_ptr<LineLayout> llFull = viewFull.RetrieveLineLayout(0, model);
+		viewFull.LayoutLine(model, &surface, vs, llFull.get(), width);
+		REQUIRE(llFull->lines > 1);
+		REQUIRE(viewFull.linesRemeasured.empty());
+
+		EditView view;
+		view.lazyLayoutLength = 1000;
+		std::shared_ptr<LineLayout> ll = view.RetrieveLineLayout(0, model);
+		view.LayoutLine(model, &surface, vs, ll.get(), width);
+		REQUIRE(std::all_of(ll->chunksMeasured.begin(), ll->chunksMeasured.end(), [](bool measured) { return measured; }));
+		REQUIRE(ll->lines == llFull->lines);
+		for (int i = 0; i <= ll->numCharsInLine; i++) {
+			REQUIRE(ll->positions[i] == Approx(llFull->positions[i]));
+		}
+		// Measured widths differ from the estimate so the line wraps differently and is reported
+		REQUIRE(view.linesRemeasured == std::vector<Sci::Line>{0});
+
+		// Nothing more to measure so laying out again does not report the line
+		view.linesRemeasured.clear();
+		view.LayoutLine(model, &surface, vs, ll.get(), width);
+		REQUIRE(view.linesRemeasured.empty());
+	}
+
+	SECTION("LazyLayoutMeasuresViewOnly") {
+		std::string text;
+		while (text.length() < 40000) {
+			text += proseASCII;
+		}
+		model.pdoc->InsertString(0, text);
+		vs.wrap.state = Wrap::Word;
+		model.linesOnScreen = 5;
+
+		EditView view;
+		view.lazyLayoutLength = 1000;
+		std::shared_ptr<LineLayout> ll = view.RetrieveLineLayout(0, model);
+		surface.bytesMeasured = 0;
+		view.LayoutLine(model, &surface, vs, ll.get(), 400);
+		REQUIRE(ll->chunksMeasured.size() > 5);
+		REQUIRE(ll->chunksMeasured.front());
+		REQUIRE(!ll->chunksMeasured.back());
+		REQUIRE(surface.bytesMeasured < text.length() / 4);
+	}
+
+	SECTION("LazyLayoutEditMatchesFullLayout") {
+		std::string text;
+		while (text.length() < 20000) {
+			text += proseASCII;
+			text += "\t\xc3\xa9t\xc3\xa9 ";
+		}
+		model.pdoc->InsertString(0, text);
+		StyleWords(model.pdoc);
+		// Tabs are segments of their own as in Editor
+		model.reprs->SetDefaultRepresentations(model.pdoc->dbcsCodePage);
+		vs.wrap.state = Wrap::Word;
+		constexpr int width = 400;
+		// Enough lines on screen to show every subline so every chunk is measured
+		model.linesOnScreen = 1000;
+
+		EditView view;
+		view.lazyLayoutLength = 1000;
+		std::shared_ptr<LineLayout> ll = view.RetrieveLineLayout(0, model);
+		view.LayoutLine(model, &surface, vs, ll.get(), width);
+
+		const std::string textLong(EditView::bytesPerLayoutChunk * 2, 'x');
+		for (int edit = 0; edit < 31; edit++) {
+			const Sci::Position position = (edit * 1847) % (model.pdoc->Length() - 20);
+			switch (edit % 3) {
+			case 0:
+				// Finally insert text longer than a chunk which is estimated then measured
+				model.pdoc->InsertString(position, (edit == 30) ? textLong : std::string("inserted\ttext "));
+				break;
+			case 1:
+				model.pdoc->DeleteChars(model.pdoc->MovePositionOutsideChar(position, 1), 7);
+				break;
+			default:
+				model.pdoc->StartStyling(position);
+				model.pdoc->SetStyleFor(5, 2);
+				break;
+			}
+			if (edit % 3 != 2) {
+				StyleWords(model.pdoc);
+			}
+			view.llc.Invalidate(LineLayout::ValidLevel::checkTextAndStyle);
+
+			ll = view.RetrieveLineLayout(0, model);
+			surface.bytesMeasured = 0;
+			view.LayoutLine(model, &surface, vs, ll.get(), width);
+			if (edit < 30) {
+				// Only the segments around the edit were measured again
+				REQUIRE(surface.bytesMeasured < static_cast<size_t>(ll->numCharsInLine / 4));
+			}
+			REQUIRE(std::all_of(ll->chunksMeasured.begin(), ll->chunksMeasured.end(), [](bool measured) { return measured; }));
+
+			EditView viewFull;
+			std::shared_ptr<LineLayout> llFull = viewFull.RetrieveLineLayout(0, model);
+			viewFull.LayoutLine(model, &surface, vs, llFull.get(), width);
+
+			REQUIRE(ll->numCharsInLine == llFull->numCharsInLine);
+			REQUIRE(ll->lines == llFull->lines);
+			for (int i = 0; i <= ll->numCharsInLine; i++) {
+				REQUIRE(ll->chars[i] == llFull->chars[i]);
+				REQUIRE(ll->styles[i] == llFull->styles[i]);
+				REQUIRE(ll->positions[i] == Approx(llFull->positions[i]));
+			}
+		}
+	}
+
+	SECTION("ParallelLayoutMatchesLayoutLine") {
+		InsertLines(model.pdoc, 60);
+		model.pcs->InsertLines(0, model.pdoc->LinesTotal() - 1);
+		vs.wrap.state = Wrap::Word;
+		model.wrapWidth = 300;
+
+		EditView view;
+		// Set directly as SetLayoutThreads limits threads to the processors available
+		view.maxLayoutThreads = 4;
+		view.llc.SetLevel(LineCache::Page);
+
+		auto checkLayouts = [&]() {
+			view.LayoutVisibleLines(model, &surface, vs, 0, model.pcs->LinesDisplayed());
+			for (Sci::Line line = 0; line < model.pdoc->LinesTotal(); line++) {
+				std::shared_ptr<LineLayout> ll = view.RetrieveLineLayout(line, model);
+				// Every line was laid out by LayoutVisibleLines
+				REQUIRE(ll->validity == LineLayout::ValidLevel::lines);
+
+				EditView viewSerial;
+				std::shared_ptr<LineLayout> llSerial = viewSerial.RetrieveLineLayout(line, model);
+				viewSerial.LayoutLine(model, &surface, vs, llSerial.get(), model.wrapWidth);
+
+				REQUIRE(ll->numCharsInLine == llSerial->numCharsInLine);
+				for (int i = 0; i <= ll->numCharsInLine; i++) {
+					REQUIRE(ll->chars[i] == llSerial->chars[i]);
+					REQUIRE(ll->styles[i] == llSerial->styles[i]);
+					REQUIRE(ll->positions[i] == Approx(llSerial->positions[i]));
+				}
+				REQUIRE(ll->lines == llSerial->lines);
+				for (int subLine = 0; subLine <= ll->lines; subLine++) {
+					REQUIRE(ll->LineStart(subLine) == llSerial->LineStart(subLine));
+				}
+			}
+		};
+
+		checkLayouts();
+
+		// Layouts to be checked after modifications are laid out again where changed
+		model.pdoc->InsertString(model.pdoc->LineStart(5) + 4, "inserted text ");
+		model.pdoc->DeleteChars(model.pdoc->LineStart(12) + 2, 6);
+		StyleWords(model.pdoc);
+		view.llc.Invalidate(LineLayout::ValidLevel::checkTextAndStyle);
+		checkLayouts();
+	}
+}
+
+// Test retained drawing.
+
+TEST_CASE("RetainedDraw") {
+
+	TestSurface surfaceWindow;
+	TestModel model;
+	model.pdoc->SetDBCSCodePage(CpUtf8);
+	InsertLines(model.pdoc, 200);
+	// Display lines are maintained by Editor so add them here
+	model.pcs->InsertLines(0, model.pdoc->LinesTotal() - 1);
+	ViewStyle vs;
+	vs.Refresh(surfaceWindow, model.pdoc->tabInChars);
+	model.linesOnScreen = 20;
+	const PRectangle rcClient = PRectangle::FromInts(0, 0, 500, static_cast<int>(model.linesOnScreen * vs.lineHeight));
+
+	EditView view;
+	view.bufferedDraw = true;
+	view.retainedDraw = true;
+	// Set directly as SetLayoutThreads limits threads to the processors available
+	view.maxLayoutThreads = 4;
+	view.llc.SetLevel(LineCache::Page);
+	view.pixmapLine = surfaceWindow.AllocatePixMap(static_cast<int>(rcClient.Width()), vs.lineHeight);
+	view.RefreshPixMaps(&surfaceWindow, vs);
+
+	const auto paint = [&]() {
+		surfaceWindow.copies = 0;
+		surfaceWindow.flushes = 0;
+		surfaceWindow.bytesMeasured = 0;
+		view.PaintText(&surfaceWindow, model, vs, rcClient, rcClient);
+	};
+	const size_t linesPainted = model.linesOnScreen;
+
+	// The first paint draws every line
+	paint();
+	REQUIRE(surfaceWindow.copies == linesPainted);
+	REQUIRE(surfaceWindow.flushes == linesPainted);
+
+	SECTION("UnchangedLinesCopied") {
+		// Layouts and measurements are discarded to show that lines that are copied are not laid out
+		view.llc.Invalidate(LineLayout::ValidLevel::invalid);
+		view.posCache->Clear();
+		paint();
+		REQUIRE(surfaceWindow.copies == linesPainted);
+		REQUIRE(surfaceWindow.flushes == 0);
+		REQUIRE(surfaceWindow.bytesMeasured == 0);
+	}
+
+	SECTION("SelectionRedrawsItsLines") {
+		// Select within line 3 then extend into line 4
+		model.sel.RangeMain() = SelectionRange(model.pdoc->LineStart(3) + 3, model.pdoc->LineStart(3) + 1);
+		paint();
+		REQUIRE(surfaceWindow.copies == linesPainted);
+		// The caret moved from line 0 to line 3
+		REQUIRE(surfaceWindow.flushes == 2);
+
+		model.sel.RangeMain() = SelectionRange(model.pdoc->LineStart(4) + 2, model.pdoc->LineStart(3) + 1);
+		paint();
+		REQUIRE(surfaceWindow.flushes == 2);
+
+		paint();
+		REQUIRE(surfaceWindow.flushes == 0);
+	}
+
+	SECTION("ModificationRedrawsItsLine") {
+		const Sci::Line lineModified = 6;
+		model.pdoc->InsertString(model.pdoc->LineStart(lineModified) + 1, "inserted");
+		// As performed by Editor::NotifyModified
+		view.lineBitmaps.InvalidateLines(lineModified, lineModified + 1);
+		view.llc.Invalidate(LineLayout::ValidLevel::checkTextAndStyle);
+		view.posCache->Clear();
+		paint();
+		REQUIRE(surfaceWindow.copies == linesPainted);
+		REQUIRE(surfaceWindow.flushes == 1);
+		// Only the modified line was laid out
+		const Sci::Position lengthModified = model.pdoc->LineEnd(lineModified) - model.pdoc->LineStart(lineModified);
+		REQUIRE(surfaceWindow.bytesMeasured <= static_cast<size_t>(lengthModified));
+	}
+}
+
+// Test BackgroundWrap.
+
+TEST_CASE("BackgroundWrap") {
+
+	TestSurface surface;
+	TestModel model;
+	model.pdoc->SetDBCSCodePage(CpUtf8);
+	InsertLines(model.pdoc, 200);
+	ViewStyle vs;
+	vs.wrap.state = Wrap::Word;
+	vs.Refresh(surface, model.pdoc->tabInChars);
+	EditView view;
+	view.SetLayoutThreads(4);
+	constexpr int width = 300;
+	constexpr Sci::Line lineStart = 10;
+	constexpr Sci::Line lineEnd = 150;
+
+	BackgroundWrap bw;
+	bw.SetSurface(std::make_unique<TestSurface>());
+
+	SECTION("WrapsLikeLayoutLine") {
+		bw.Start(model.pdoc, view, vs, *model.reprs, width, lineStart, lineEnd);
+		REQUIRE(bw.Running());
+		REQUIRE(bw.Finished(60.0));
+		REQUIRE(!bw.Running());
+		REQUIRE(!bw.stale);
+		REQUIRE(!bw.failed);
+		REQUIRE(bw.linesAfterWrap.size() == static_cast<size_t>(lineEnd - lineStart));
+
+		int linesWrapped = 0;
+		for (Sci::Line line = lineStart; line < lineEnd; line++) {
+			std::shared_ptr<LineLayout> ll = view.RetrieveLineLayout(line, model);
+			view.LayoutLine(model, &surface, vs, ll.get(), width);
+			REQUIRE(bw.linesAfterWrap[line - lineStart] == ll->lines);
+			if (ll->lines > 1) {
+				linesWrapped++;
+			}
+		}
+		REQUIRE(linesWrapped > 0);
+	}
+
+	SECTION("ModifiedMarksStale") {
+		bw.Start(model.pdoc, view, vs, *model.reprs, width, lineStart, lineEnd);
+		// Changes after the block do not affect it
+		bw.Modified(model.pdoc->LineStart(lineEnd));
+		REQUIRE(!bw.stale);
+		bw.Modified(model.pdoc->LineStart(lineEnd) - 1);
+		REQUIRE(bw.stale);
+		REQUIRE(bw.Finished(60.0));
+
+		// Once results are read the block is no longer watched
+		bw.Start(model.pdoc, view, vs, *model.reprs, width, lineStart, lineEnd);
+		REQUIRE(!bw.stale);
+		REQUIRE(bw.Finished(60.0));
+		bw.Modified(0);
+		REQUIRE(!bw.stale);
+	}
+
+	SECTION("NeedWrappingMarksStale") {
+		bw.Start(model.pdoc, view, vs, *model.reprs, width, lineStart, lineEnd);
+		bw.NeedWrapping(0, lineStart);
+		REQUIRE(!bw.stale);
+		bw.NeedWrapping(lineEnd, lineEnd + 10);
+		REQUIRE(!bw.stale);
+		bw.NeedWrapping(lineEnd - 1, lineEnd);
+		REQUIRE(bw.stale);
+		REQUIRE(bw.Finished(60.0));
+	}
+
+	SECTION("DropGraphicsStops") {
+		bw.Start(model.pdoc, view, vs, *model.reprs, width, lineStart, lineEnd);
+		bw.DropGraphics();
+		REQUIRE(!bw.Running());
+		REQUIRE(!bw.HasSurface());
+		REQUIRE(bw.styleChanged);
+	}
+}
+
+TEST_CASE("WrapLayoutThreadsBenchmark", "[.benchmark]") {
+
+	// Wrap a large document with different numbers of layout threads, dividing lines between
+	// threads as Editor::WrapBlock does, to show how well measurement through the position cache scales.
+	// SetLayoutThreads limits threads to the processors available so the number used is reported.
+
+	TestSurface surface;
+	TestModel model;
+	model.pdoc->SetDBCSCodePage(CpUtf8);
+	InsertLines(model.pdoc, 100'000);
+	ViewStyle vs;
+	vs.wrap.state = Wrap::Word;
+	vs.Refresh(surface, model.pdoc->tabInChars);
+	model.wrapWidth = 300;
+	const size_t lines = model.pdoc->LinesTotal();
+
+	EditView view;
+	std::vector<int> linesAfterWrapFirst;
+	for (const unsigned int threads : { 1U, 2U, 4U, 8U }) {
+		view.SetLayoutThreads(threads);
+		const size_t threadsUsed = view.GetLayoutThreads();
+		// Discard measurements so each run wraps the same text from scratch
+		view.posCache->Clear();
+		std::vector<std::unique_ptr<LineLayout>> layouts;
+		for (size_t thread = 0; thread < threadsUsed; thread++) {
+			layouts.push_back(std::make_unique<LineLayout>(-1, 200));
+		}
+		std::vector<int> linesAfterWrap(lines);
+		std::atomic<size_t> nextIndex = 0;
+		Catch::Timer tikka;
+		tikka.start();
+		view.layoutPool->Run(threadsUsed, [&](size_t thread) {
+			LineLayout *ll = layouts[thread].get();
+			while (true) {
+				const size_t i = nextIndex.fetch_add(1, std::memory_order_acq_rel);
+				if (i >= lines) {
+					break;
+				}
+				const Sci::Line line = static_cast<Sci::Line>(i);
+				ll->ReSet(line, model.pdoc->LineRange(line).Length());
+				view.LayoutLine(model, &surface, vs, ll, model.wrapWidth, threadsUsed > 1);
+				linesAfterWrap[i] = ll->lines;
+			}
+		});
+		const double seconds = tikka.getElapsedNanoseconds() / 1.0e9;
+		if (linesAfterWrapFirst.empty()) {
+			linesAfterWrapFirst = linesAfterWrap;
+		}
+		REQUIRE(linesAfterWrap == linesAfterWrapFirst);
+		std::cout << "Wrap " << lines << " lines with " << threads << " layout threads (" << threadsUsed <<
+			" used) " << seconds << " s\n";
+	}
+}
+
+TEST_CASE("LazyLayoutEditBenchmark", "[.benchmark]") {
+
+	// Type into the middle of a huge line laid out lazily, updating the layout around each edit
+	// and, for comparison, laying out the whole line again after each edit.
+
+	TestSurface surface;
+	TestModel model;
+	model.pdoc->SetDBCSCodePage(CpUtf8);
+	std::string text;
+	while (text.length() < 4'000'000) {
+		text += proseASCII;
+		text += "\t\xc3\xa9t\xc3\xa9 ";
+	}
+	model.pdoc->InsertString(0, text);
+	model.reprs->SetDefaultRepresentations(model.pdoc->dbcsCodePage);
+	ViewStyle vs;
+	vs.Refresh(surface, model.pdoc->tabInChars);
+	constexpr int edits = 100;
+
+	for (const LineLayout::ValidLevel validity : { LineLayout::ValidLevel::checkTextAndStyle, LineLayout::ValidLevel::invalid }) {
+		EditView view;
+		view.lazyLayoutLength = 100'000;
+		std::shared_ptr<LineLayout> ll = view.RetrieveLineLayout(0, model);
+		view.LayoutLine(model, &surface, vs, ll.get(), LineLayout::wrapWidthInfinite);
+		Sci::Position position = model.pdoc->Length() / 2;
+		Catch::Timer tikka;
+		tikka.start();
+		for (int edit = 0; edit < edits; edit++) {
+			model.pdoc->InsertString(position, "x");
+			position++;
+			model.sel.SetSelection(SelectionRange(position));
+			view.llc.Invalidate(validity);
+			// Released so the cache grows the layout in place instead of replacing it
+			ll.reset();
+			ll = view.RetrieveLineLayout(0, model);
+			view.LayoutLine(model, &surface, vs, ll.get(), LineLayout::wrapWidthInfinite);
+			REQUIRE(ll->numCharsInLine == model.pdoc->Length());
+		}
+		const double seconds = tikka.getElapsedNanoseconds() / 1.0e9;
+		model.pdoc->DeleteChars(position - edits, edits);
+		std::cout << "Lazy layout of " << text.length() << " byte line " <<
+			((validity == LineLayout::ValidLevel::invalid) ? "laid out again" : "updated") <<
+			" after each edit " << seconds * 1000.0 / edits << " ms per edit\n";
+	}
+}
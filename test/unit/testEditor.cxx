@@ -0,0 +1,204 @@
+/** @file testEditor.cxx
+ ** Unit Tests for Scintilla internal data structures
+ **/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <set>
+#include <forward_list>
+#include <optional>
+#include <algorithm>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "ScintillaTypes.h"
+#include "ScintillaMessages.h"
+#include "ScintillaStructures.h"
+#include "ILoader.h"
+#include "ILexer.h"
+
+#include "Debugging.h"
+#include "Geometry.h"
+#include "Platform.h"
+
+#include "CharacterCategoryMap.h"
+#include "Position.h"
+#include "UniqueString.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "ContractionState.h"
+#include "CellBuffer.h"
+#include "PerLine.h"
+#include "KeyMap.h"
+#include "Indicator.h"
+#include "LineMarker.h"
+#include "Style.h"
+#include "ViewStyle.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+#include "Selection.h"
+#include "PositionCache.h"
+#include "EditModel.h"
+#include "MarginView.h"
+#include "EditView.h"
+#include "Editor.h"
+
+#include "catch.hpp"
+
+using namespace Scintilla::Internal;
+
+// Test WrapPending.
+
+TEST_CASE("WrapPending") {
+
+	constexpr Sci::Line linesTotal = 1000;
+	WrapPending wrapPending;
+
+	SECTION("IsEmptyInitially") {
+		REQUIRE(!wrapPending.NeedsWrap());
+		REQUIRE(!wrapPending.HasWrapped());
+		REQUIRE(0 == wrapPending.Remaining(linesTotal));
+	}
+
+	SECTION("WrapInOrder") {
+		REQUIRE(wrapPending.AddRange(0, WrapPending::lineLarge));
+		REQUIRE(linesTotal == wrapPending.Remaining(linesTotal));
+		wrapPending.Wrapped(0);
+		wrapPending.Wrapped(1);
+		REQUIRE(2 == wrapPending.start);
+		REQUIRE(!wrapPending.HasWrapped());
+		REQUIRE(linesTotal - 2 == wrapPending.Remaining(linesTotal));
+		REQUIRE(!wrapPending.NeedsWrap(1));
+		REQUIRE(wrapPending.NeedsWrap(2));
+	}
+
+	SECTION("IslandMerges") {
+		wrapPending.AddRange(0, WrapPending::lineLarge);
+		// Lines wrapped out of order form an island that grows at either end
+		wrapPending.Wrapped(500);
+		wrapPending.Wrapped(501);
+		wrapPending.Wrapped(499);
+		REQUIRE(499 == wrapPending.wrappedStart);
+		REQUIRE(502 == wrapPending.wrappedEnd);
+		REQUIRE(!wrapPending.NeedsWrap(500));
+		REQUIRE(wrapPending.NeedsWrap(502));
+		REQUIRE(linesTotal - 3 == wrapPending.Remaining(linesTotal));
+
+		// A line not next to the island is still pending
+		wrapPending.Wrapped(700);
+		REQUIRE(502 == wrapPending.wrappedEnd);
+		REQUIRE(wrapPending.NeedsWrap(700));
+		REQUIRE(linesTotal - 3 == wrapPending.Remaining(linesTotal));
+
+		// Wrapping continues after the island
+		REQUIRE(502 == wrapPending.Next(0, 10, linesTotal));
+
+		// Reaching the island from start skips over it
+		for (Sci::Line line = 0; line < 499; line++) {
+			wrapPending.Wrapped(line);
+		}
+		REQUIRE(502 == wrapPending.start);
+		REQUIRE(!wrapPending.HasWrapped());
+		REQUIRE(linesTotal - 502 == wrapPending.Remaining(linesTotal));
+	}
+
+	SECTION("IslandAtDocumentEnd") {
+		wrapPending.AddRange(0, WrapPending::lineLarge);
+		wrapPending.Wrapped(linesTotal - 2);
+		wrapPending.Wrapped(linesTotal - 1);
+		REQUIRE(linesTotal - 2 == wrapPending.Remaining(linesTotal));
+		// Lines beyond the document are not counted
+		wrapPending.Wrapped(linesTotal);
+		REQUIRE(linesTotal - 2 == wrapPending.Remaining(linesTotal));
+		// Nothing to continue with after the island so return to start
+		REQUIRE(0 == wrapPending.Next(0, 10, linesTotal));
+	}
+
+	SECTION("NextNearView") {
+		wrapPending.AddRange(0, WrapPending::lineLarge);
+		REQUIRE(290 == wrapPending.Next(300, 10, linesTotal));
+		REQUIRE(0 == wrapPending.Next(5, 10, linesTotal));
+		// Beyond the document
+		REQUIRE(0 == wrapPending.Next(linesTotal + 5, 10, linesTotal));
+	}
+
+	SECTION("RangeOutsideIsland") {
+		wrapPending.AddRange(100, WrapPending::lineLarge);
+		for (Sci::Line line = 500; line < 520; line++) {
+			wrapPending.Wrapped(line);
+		}
+		// Adding lines before the island keeps it
+		REQUIRE(wrapPending.AddRange(50, 60));
+		REQUIRE(50 == wrapPending.start);
+		REQUIRE(500 == wrapPending.wrappedStart);
+		REQUIRE(520 == wrapPending.wrappedEnd);
+		REQUIRE(linesTotal - 50 - 20 == wrapPending.Remaining(linesTotal));
+	}
+
+	SECTION("RangeSplitsIsland") {
+		wrapPending.AddRange(0, WrapPending::lineLarge);
+		for (Sci::Line line = 500; line < 520; line++) {
+			wrapPending.Wrapped(line);
+		}
+
+		// Near the end so the larger part before the range remains
+		REQUIRE(!wrapPending.AddRange(515, 516));
+		REQUIRE(500 == wrapPending.wrappedStart);
+		REQUIRE(515 == wrapPending.wrappedEnd);
+		REQUIRE(wrapPending.NeedsWrap(515));
+		REQUIRE(wrapPending.NeedsWrap(517));
+		REQUIRE(linesTotal - 15 == wrapPending.Remaining(linesTotal));
+
+		// Near the start so the larger part after the range remains
+		wrapPending.AddRange(500, 502);
+		REQUIRE(502 == wrapPending.wrappedStart);
+		REQUIRE(515 == wrapPending.wrappedEnd);
+		REQUIRE(wrapPending.NeedsWrap(500));
+		REQUIRE(!wrapPending.NeedsWrap(510));
+		REQUIRE(linesTotal - 13 == wrapPending.Remaining(linesTotal));
+
+		// Covering the whole island
+		wrapPending.AddRange(490, 530);
+		REQUIRE(!wrapPending.HasWrapped());
+		REQUIRE(linesTotal == wrapPending.Remaining(linesTotal));
+	}
+
+	SECTION("ForgetWrapped") {
+		wrapPending.AddRange(0, WrapPending::lineLarge);
+		wrapPending.Wrapped(200);
+		wrapPending.Wrapped(201);
+		wrapPending.ForgetWrapped();
+		REQUIRE(!wrapPending.HasWrapped());
+		REQUIRE(wrapPending.NeedsWrap(200));
+		REQUIRE(linesTotal == wrapPending.Remaining(linesTotal));
+	}
+
+	SECTION("FiniteRange") {
+		wrapPending.AddRange(10, 20);
+		REQUIRE(10 == wrapPending.Remaining(linesTotal));
+		REQUIRE(5 == wrapPending.Remaining(15));
+		wrapPending.Wrapped(15);
+		REQUIRE(9 == wrapPending.Remaining(linesTotal));
+		// Outside the range is ignored
+		wrapPending.Wrapped(25);
+		REQUIRE(9 == wrapPending.Remaining(linesTotal));
+		for (Sci::Line line = 10; line < 20; line++) {
+			wrapPending.Wrapped(line);
+		}
+		REQUIRE(!wrapPending.NeedsWrap());
+		REQUIRE(0 == wrapPending.Remaining(linesTotal));
+	}
+}
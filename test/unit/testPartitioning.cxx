@@ -11,6 +11,7 @@
 #include <optional>
 #include <algorithm>
 #include <memory>
+#include <iostream>
 
 #include "Debugging.h"
 
@@ -222,3 +223,191 @@ TEST_CASE("Partitioning") {
 	}
 
 }
+
+TEST_CASE("PartitioningLarge") {
+
+	// Enough partitions that searches cross the gap and the step
+
+	constexpr Sci::Position partitions = 200000;
+	Partitioning<Sci::Position> part(256);
+	std::vector<Sci::Position> positions;
+	for (Sci::Position i = 1; i < partitions; i++) {
+		positions.push_back(i * 3);
+	}
+	part.InsertText(0, partitions * 3);
+	part.InsertPartitions(1, positions.data(), positions.size());
+
+	auto checkAll = [&part]() {
+		for (Sci::Position partition = 0; partition < part.Partitions(); partition++) {
+			const Sci::Position start = part.PositionFromPartition(partition);
+			const Sci::Position end = part.PositionFromPartition(partition + 1);
+			REQUIRE(partition == part.PartitionFromPosition(start));
+			REQUIRE(partition == part.PartitionFromPosition(end - 1));
+		}
+		REQUIRE(0 == part.PartitionFromPosition(-1));
+		REQUIRE(part.Partitions() - 1 == part.PartitionFromPosition(part.Length() + 1));
+	};
+
+	SECTION("Search") {
+		checkAll();
+	}
+
+	SECTION("StepInMiddle") {
+		// Step is not applied to body so search must adjust values after the step
+		part.InsertText(100000, 1000);
+		REQUIRE(100000 == part.PartitionFromPosition(300000 + 1000));
+		REQUIRE(100001 == part.PartitionFromPosition(300003 + 1000));
+		checkAll();
+		part.InsertText(50000, -1);
+		checkAll();
+	}
+
+	SECTION("Modify") {
+		// Searches after modifications move the gap
+		REQUIRE(1000 == part.PartitionFromPosition(3000));
+		part.RemovePartition(500);
+		REQUIRE(999 == part.PartitionFromPosition(3000));
+		part.InsertPartition(11, 31);
+		REQUIRE(1000 == part.PartitionFromPosition(3000));
+		part.SetPartitionStartPosition(1000, 2999);
+		REQUIRE(1000 == part.PartitionFromPosition(2999));
+		checkAll();
+		part.DeleteAll();
+		REQUIRE(0 == part.PartitionFromPosition(3000));
+	}
+}
+
+namespace {
+
+template <typename T>
+void ScalarAddDelta(T *values, ptrdiff_t length, T delta) noexcept {
+	// Loop used by RangeAddDelta before vectorization
+	T *writer = values;
+	ptrdiff_t i = 0;
+	while (i < length) {
+		*writer += delta;
+		writer++;
+		i++;
+	}
+}
+
+template <typename T>
+void BenchmarkAddDelta(const char *name) {
+	constexpr ptrdiff_t elements = 10'000'000;
+	constexpr int repetitions = 20;
+	std::vector<T> values(elements);
+	const double gigaElements = elements * static_cast<double>(repetitions) / 1.0e9;
+
+	Catch::Timer tikka;
+	tikka.start();
+	for (int i = 0; i < repetitions; i++) {
+		ScalarAddDelta(values.data(), elements, static_cast<T>(1));
+	}
+	const double scalarSeconds = tikka.getElapsedNanoseconds() / 1.0e9;
+
+	tikka.start();
+	for (int i = 0; i < repetitions; i++) {
+		AddDelta(values.data(), elements, static_cast<T>(1));
+	}
+	const double vectorSeconds = tikka.getElapsedNanoseconds() / 1.0e9;
+	REQUIRE(2 * repetitions == values[elements - 1]);
+
+	std::cout << name << " scalar " << gigaElements / scalarSeconds << " G elements/s, vector " <<
+		gigaElements / vectorSeconds << " G elements/s\n";
+}
+
+}
+
+TEST_CASE("RangeAddDeltaBenchmark", "[.benchmark]") {
+
+	// Add a delta to all elements of a 10 million element SplitVector as when
+	// the step of a Partitioning is applied over a whole large document.
+	// Build with OPTIMIZATION=-O2 to measure.
+
+	SECTION("Int") {
+		BenchmarkAddDelta<int>("int");
+	}
+
+	SECTION("Position") {
+		BenchmarkAddDelta<ptrdiff_t>("ptrdiff_t");
+	}
+
+	SECTION("Partitioning") {
+		// Alternate edits at start and end so each edit applies the step over all partitions
+		constexpr Sci::Position partitions = 10'000'000;
+		constexpr int edits = 200;
+		Partitioning<Sci::Position> part(256);
+		std::vector<Sci::Position> positions(partitions - 1);
+		for (Sci::Position i = 0; i < partitions - 1; i++) {
+			positions[i] = (i + 1) * 10;
+		}
+		part.InsertText(0, partitions * 10);
+		part.InsertPartitions(1, positions.data(), positions.size());
+		Catch::Timer tikka;
+		tikka.start();
+		for (int i = 0; i < edits; i++) {
+			part.InsertText((i % 2) ? 0 : partitions - 1, 1);
+		}
+		const double seconds = tikka.getElapsedNanoseconds() / 1.0e9;
+		REQUIRE(partitions * 10 + edits == part.Length());
+		std::cout << "Partitioning alternating edits " << edits / seconds << " edits/s\n";
+	}
+
+}
+
+TEST_CASE("PartitionFromPositionBenchmark", "[.benchmark]") {
+
+	// Find the lines of random positions in a 10 million line document.
+	// Compared with a binary search that reads each value through ValueAt as used before.
+	// Build with OPTIMIZATION=-O2 to measure.
+
+	constexpr Sci::Position partitions = 10'000'000;
+	constexpr int lookups = 2'000'000;
+	Partitioning<Sci::Position> part(256);
+	std::vector<Sci::Position> positions;
+	Sci::Position position = 0;
+	for (Sci::Position i = 1; i < partitions; i++) {
+		position += 1 + i % 61;
+		positions.push_back(position);
+	}
+	part.InsertText(0, position + 10);
+	part.InsertPartitions(1, positions.data(), positions.size());
+	// Leave a step in the middle as after typing
+	part.InsertText(partitions / 2, 1);
+
+	std::vector<Sci::Position> targets;
+	unsigned int randomValue = 7;
+	for (int i = 0; i < lookups; i++) {
+		randomValue = randomValue * 1103515245 + 12345;
+		targets.push_back(((static_cast<Sci::Position>(randomValue) << 8) ^ i) % part.Length());
+	}
+
+	Catch::Timer tikka;
+	tikka.start();
+	Sci::Position totalFull = 0;
+	for (const Sci::Position target : targets) {
+		Sci::Position lower = 0;
+		Sci::Position upper = part.Partitions();
+		do {
+			const Sci::Position middle = (upper + lower + 1) / 2;
+			if (target < part.PositionFromPartition(middle)) {
+				upper = middle - 1;
+			} else {
+				lower = middle;
+			}
+		} while (lower < upper);
+		totalFull += lower;
+	}
+	const double secondsFull = tikka.getElapsedNanoseconds() / 1.0e9;
+
+	tikka.start();
+	Sci::Position totalDirect = 0;
+	for (const Sci::Position target : targets) {
+		totalDirect += part.PartitionFromPosition(target);
+	}
+	const double secondsDirect = tikka.getElapsedNanoseconds() / 1.0e9;
+	REQUIRE(totalFull == totalDirect);
+
+	std::cout << "PartitionFromPosition ValueAt search " << lookups / secondsFull / 1.0e6 << " M lookups/s, direct " <<
+		lookups / secondsDirect / 1.0e6 << " M lookups/s\n";
+}
@@ -0,0 +1,233 @@
+/** @file testPieceTable.cxx
+ ** Unit Tests for Scintilla internal data structures
+ **/
+
+#include <cstddef>
+#include <cstring>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <functional>
+#include <memory>
+
+#include "Debugging.h"
+
+#include "Position.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "PieceTable.h"
+
+#include "catch.hpp"
+
+using namespace Scintilla::Internal;
+
+// Test PieceTable.
+
+namespace {
+
+std::string Contents(const PieceTable<char> &pt) {
+	std::string s(pt.Length(), '\0');
+	pt.GetRange(s.data(), 0, pt.Length());
+	return s;
+}
+
+class RandomSequence {
+	static constexpr int mult = 109;
+	static constexpr int incr = 853;
+	static constexpr int modulus = 4096;
+	int randomValue = 127;
+public:
+	int Next() noexcept {
+		randomValue = (mult * randomValue + incr) % modulus;
+		return randomValue;
+	}
+};
+
+}
+
+TEST_CASE("PieceTable") {
+
+	// Stands in for read-only memory such as a mapped file
+	constexpr std::string_view original = "0123456789";
+
+	PieceTable<char> pt(16);
+
+	SECTION("IsEmptyInitially") {
+		REQUIRE(0 == pt.Length());
+		REQUIRE(1 == pt.Pieces());
+		pt.Check();
+	}
+
+	SECTION("InsertReference") {
+		pt.InsertReference(0, original.data(), original.length());
+		REQUIRE(10 == pt.Length());
+		REQUIRE(1 == pt.Pieces());
+		REQUIRE(original == Contents(pt));
+		// Referenced, not copied
+		REQUIRE(original.data() == pt.RangePointer(0, 10));
+		ptrdiff_t segmentStart = 0;
+		ptrdiff_t segmentLength = 0;
+		REQUIRE(original.data() == pt.SegmentAt(4, segmentStart, segmentLength));
+		REQUIRE(0 == segmentStart);
+		REQUIRE(10 == segmentLength);
+		pt.Check();
+	}
+
+	SECTION("ReferencesContinue") {
+		// Loading in chunks from contiguous memory produces a single piece
+		pt.InsertReference(0, original.data(), 4);
+		pt.InsertReference(4, original.data() + 4, 6);
+		REQUIRE(1 == pt.Pieces());
+		REQUIRE(original == Contents(pt));
+	}
+
+	SECTION("InsertIntoReference") {
+		pt.InsertReference(0, original.data(), original.length());
+		pt.InsertFromArray(5, "abc", 0, 3);
+		REQUIRE("01234abc56789" == Contents(pt));
+		REQUIRE(3 == pt.Pieces());
+		// Typing after the insertion extends the added piece
+		pt.InsertFromArray(8, "d", 0, 1);
+		pt.InsertFromArray(9, "e", 0, 1);
+		REQUIRE("01234abcde56789" == Contents(pt));
+		REQUIRE(3 == pt.Pieces());
+		pt.InsertValue(0, 2, 'x');
+		REQUIRE("xx01234abcde56789" == Contents(pt));
+		pt.InsertFromArray(pt.Length(), "!", 0, 1);
+		REQUIRE("xx01234abcde56789!" == Contents(pt));
+		pt.Check();
+		// The original memory was not changed
+		REQUIRE(original == "0123456789");
+	}
+
+	SECTION("DeleteRange") {
+		pt.InsertReference(0, original.data(), original.length());
+		pt.InsertFromArray(5, "abc", 0, 3);
+		pt.DeleteRange(3, 4);	// Across pieces
+		REQUIRE("012c56789" == Contents(pt));
+		pt.DeleteRange(0, 1);
+		REQUIRE("12c56789" == Contents(pt));
+		pt.DeleteRange(6, 2);
+		REQUIRE("12c567" == Contents(pt));
+		pt.DeleteRange(2, 1);
+		REQUIRE("12567" == Contents(pt));
+		// Only the two ranges of the original remain
+		REQUIRE(2 == pt.Pieces());
+		pt.DeleteRange(0, pt.Length());
+		REQUIRE(0 == pt.Length());
+		REQUIRE(1 == pt.Pieces());
+		pt.Check();
+	}
+
+	SECTION("SetValue") {
+		pt.InsertReference(0, original.data(), original.length());
+		pt.SetValueAt(5, 'x');
+		REQUIRE("01234x6789" == Contents(pt));
+		REQUIRE(pt.FillRange(1, 3, 'y'));
+		REQUIRE(!pt.FillRange(1, 3, 'y'));
+		REQUIRE("0yyy4x6789" == Contents(pt));
+		REQUIRE(original == "0123456789");
+		pt.Check();
+	}
+
+	SECTION("OutsideBounds") {
+		pt.InsertReference(0, original.data(), original.length());
+		REQUIRE(0 == pt.ValueAt(-1));
+		REQUIRE(0 == pt.ValueAt(10));
+		REQUIRE('9' == pt.ValueAt(9));
+	}
+
+	SECTION("RangePointer") {
+		pt.InsertReference(0, original.data(), original.length());
+		pt.InsertFromArray(5, "abc", 0, 3);
+		const char *range = pt.RangePointer(3, 6);
+		REQUIRE(0 == memcmp(range, "34abc5", 6));
+		REQUIRE("01234abc56789" == Contents(pt));
+		REQUIRE(nullptr == pt.RangePointer(10, 5));
+		pt.Check();
+	}
+
+	SECTION("BufferPointer") {
+		pt.InsertReference(0, original.data(), original.length());
+		pt.InsertFromArray(5, "abc", 0, 3);
+		const char *buffer = pt.BufferPointer();
+		REQUIRE(1 == pt.Pieces());
+		REQUIRE(std::string_view(buffer) == "01234abc56789");
+		// Already flat so not copied again
+		REQUIRE(buffer == pt.BufferPointer());
+		pt.DeleteAll();
+		REQUIRE(std::string_view(pt.BufferPointer()).empty());
+	}
+
+	SECTION("UnusedBlocksReleased") {
+		pt.InsertReference(0, original.data(), original.length());
+		// Typing then deleting what was typed leaves blocks that no piece refers to
+		for (int i = 0; i < 1000; i++) {
+			pt.InsertFromArray(5, "abcdefghij", 0, 10);
+			pt.DeleteRange(5, 10);
+		}
+		REQUIRE(pt.Blocks() <= 2);
+		REQUIRE(original == Contents(pt));
+		pt.Check();
+	}
+
+	SECTION("BlocksInUseRetained") {
+		std::string s(original);
+		pt.InsertReference(0, original.data(), original.length());
+		for (int i = 0; i < 1000; i++) {
+			const char ch = static_cast<char>('a' + i % 26);
+			pt.InsertValue(i % 7, 3, ch);
+			s.insert(i % 7, 3, ch);
+			pt.SetValueAt(i % 11, 'z');
+			s[i % 11] = 'z';
+		}
+		REQUIRE(s == Contents(pt));
+		pt.Check();
+	}
+
+}
+
+TEST_CASE("PieceTableLong") {
+
+	// Compare with std::string after many pseudo-random modifications
+
+	SECTION("Random") {
+		std::string original;
+		for (int i = 0; i < 5000; i++) {
+			original.push_back(static_cast<char>('A' + i % 26));
+		}
+		PieceTable<char> pt(64);
+		pt.InsertReference(0, original.c_str(), original.length());
+		std::string s = original;
+		RandomSequence rseq;
+		for (int i = 0; i < 20000; i++) {
+			const int r = rseq.Next() % 10;
+			if (r <= 4) {
+				const ptrdiff_t pos = rseq.Next() % (s.length() + 1);
+				const int len = rseq.Next() % 40 + 1;
+				std::string sInsert;
+				for (int j = 0; j < len; j++) {
+					sInsert.push_back(static_cast<char>('a' + (i + j) % 26));
+				}
+				pt.InsertFromArray(pos, sInsert.c_str(), 0, len);
+				s.insert(pos, sInsert);
+			} else if (r <= 8) {
+				const ptrdiff_t pos = rseq.Next() % (s.length() + 1);
+				const ptrdiff_t len = std::min<ptrdiff_t>(rseq.Next() % 40 + 1, s.length() - pos);
+				pt.DeleteRange(pos, len);
+				s.erase(pos, len);
+			} else if (!s.empty()) {
+				const ptrdiff_t pos = rseq.Next() % s.length();
+				pt.SetValueAt(pos, 'Z');
+				s[pos] = 'Z';
+			}
+			REQUIRE(static_cast<ptrdiff_t>(s.length()) == pt.Length());
+		}
+		REQUIRE(s == Contents(pt));
+		pt.Check();
+	}
+}
@@ -0,0 +1,276 @@
+/** @file testRopeVector.cxx
+ ** Unit Tests for Scintilla internal data structures
+ **/
+
+#include <cstddef>
+#include <cstring>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <memory>
+
+#include "Debugging.h"
+
+#include "Position.h"
+#include "RopeVector.h"
+
+#include "catch.hpp"
+
+using namespace Scintilla::Internal;
+
+// Test RopeVector.
+
+namespace {
+
+constexpr int lengthTestArray = 4;
+const int testArray[4] = {3, 4, 5, 6};
+
+// Small blocks so that tests cross block boundaries
+constexpr ptrdiff_t smallBlock = 4;
+
+std::string Contents(const RopeVector<char> &rv) {
+	std::string s(rv.Length(), '\0');
+	rv.GetRange(s.data(), 0, rv.Length());
+	return s;
+}
+
+class RandomSequence {
+	static constexpr int mult = 109;
+	static constexpr int incr = 853;
+	static constexpr int modulus = 4096;
+	int randomValue = 127;
+public:
+	int Next() noexcept {
+		randomValue = (mult * randomValue + incr) % modulus;
+		return randomValue;
+	}
+};
+
+}
+
+TEST_CASE("RopeVector") {
+
+	RopeVector<int> rv(smallBlock);
+
+	SECTION("IsEmptyInitially") {
+		REQUIRE(0 == rv.Length());
+		REQUIRE(0 == rv.Blocks());
+	}
+
+	SECTION("Insertion") {
+		rv.InsertValue(0, 10, 0);
+		REQUIRE(10 == rv.Length());
+		for (int i=0; i<rv.Length(); i++) {
+			REQUIRE(0 == rv.ValueAt(i));
+		}
+		// 10 elements need at least 3 blocks of 4
+		REQUIRE(rv.Blocks() >= 3);
+		rv.Check();
+	}
+
+	SECTION("InsertFromArray") {
+		rv.InsertFromArray(0, testArray, 0, lengthTestArray);
+		REQUIRE(lengthTestArray == rv.Length());
+		for (int i=0; i<rv.Length(); i++) {
+			REQUIRE((i+3) == rv.ValueAt(i));
+		}
+	}
+
+	SECTION("InsertionPattern") {
+		const int values[] = {1, 2, 3, 4, 5, 6, 7, 8};
+		rv.InsertFromArray(0, values, 0, 1);	// 1
+		rv.InsertFromArray(0, values, 1, 1);	// 21
+		rv.InsertFromArray(0, values, 2, 1);	// 321
+		rv.InsertFromArray(1, values, 3, 1);	// 3421
+		rv.InsertFromArray(0, values, 4, 1);	// 53421
+		rv.InsertFromArray(1, values, 5, 1);	// 563421
+		rv.InsertFromArray(0, values, 6, 1);	// 7563421
+		rv.InsertFromArray(1, values, 7, 1);	// 78563421
+		REQUIRE(8 == rv.Length());
+		const int expected[] = {7, 8, 5, 6, 3, 4, 2, 1};
+		for (int i=0; i<rv.Length(); i++) {
+			REQUIRE(expected[i] == rv.ValueAt(i));
+		}
+		rv.DeleteRange(4, 1);	// 7856421
+		REQUIRE(7 == rv.Length());
+		const int expectedAfterDelete[] = {7, 8, 5, 6, 4, 2, 1};
+		for (int i=0; i<rv.Length(); i++) {
+			REQUIRE(expectedAfterDelete[i] == rv.ValueAt(i));
+		}
+		rv.Check();
+	}
+
+	SECTION("SetValue") {
+		rv.InsertValue(0, 10, 0);
+		rv.SetValueAt(5, 3);
+		REQUIRE(10 == rv.Length());
+		for (int i=0; i<rv.Length(); i++) {
+			REQUIRE(((i == 5) ? 3 : 0) == rv.ValueAt(i));
+		}
+	}
+
+	SECTION("FillRange") {
+		rv.InsertValue(0, 10, 0);
+		REQUIRE(rv.FillRange(2, 7, 5));
+		REQUIRE(!rv.FillRange(2, 7, 5));
+		for (int i=0; i<rv.Length(); i++) {
+			REQUIRE((((i >= 2) && (i < 9)) ? 5 : 0) == rv.ValueAt(i));
+		}
+	}
+
+	SECTION("DeleteRange") {
+		rv.InsertValue(0, 10, 0);
+		rv.InsertValue(7, 1, 1);
+		REQUIRE(11 == rv.Length());
+		rv.DeleteRange(2, 3);
+		REQUIRE(8 == rv.Length());
+		for (int i=0; i<rv.Length(); i++) {
+			REQUIRE(((i == 4) ? 1 : 0) == rv.ValueAt(i));
+		}
+		rv.Check();
+	}
+
+	SECTION("DeleteAll") {
+		rv.InsertValue(0, 10, 0);
+		rv.DeleteRange(2, 3);
+		rv.DeleteAll();
+		REQUIRE(0 == rv.Length());
+		rv.InsertValue(0, 2, 7);
+		REQUIRE(2 == rv.Length());
+		REQUIRE(7 == rv.ValueAt(1));
+	}
+
+	SECTION("GetRange") {
+		rv.InsertValue(0, 10, 0);
+		rv.InsertValue(7, 1, 1);
+		int retrieveArray[11] = {0};
+		rv.GetRange(retrieveArray, 0, 11);
+		for (int i=0; i<rv.Length(); i++) {
+			REQUIRE(((i==7) ? 1 : 0) == retrieveArray[i]);
+		}
+		int partArray[3] = {0};
+		rv.GetRange(partArray, 6, 3);
+		REQUIRE(0 == partArray[0]);
+		REQUIRE(1 == partArray[1]);
+		REQUIRE(0 == partArray[2]);
+	}
+
+	SECTION("BufferPointer") {
+		rv.InsertFromArray(0, testArray, 0, lengthTestArray);
+		rv.InsertValue(0, 5, 99);
+		const int *retrievePointer = rv.BufferPointer();
+		REQUIRE(1 == rv.Blocks());
+		for (int i=0; i<5; i++) {
+			REQUIRE(99 == retrievePointer[i]);
+		}
+		for (int i=5; i<rv.Length(); i++) {
+			REQUIRE((i+3-5) == retrievePointer[i]);
+		}
+		// Terminated with empty value
+		REQUIRE(0 == retrievePointer[rv.Length()]);
+		// Modifying the oversized block divides it up again
+		rv.InsertValue(3, 1, 1);
+		REQUIRE(rv.Blocks() > 1);
+		REQUIRE(1 == rv.ValueAt(3));
+		REQUIRE(99 == rv.ValueAt(4));
+		REQUIRE(3 == rv.ValueAt(6));
+		rv.Check();
+	}
+
+	SECTION("RangePointer") {
+		rv.InsertValue(0, 12, 0);
+		for (int i=0; i<rv.Length(); i++) {
+			rv.SetValueAt(i, i);
+		}
+		const int *range = rv.RangePointer(2, 7);
+		for (int i=0; i<7; i++) {
+			REQUIRE((i+2) == range[i]);
+		}
+		ptrdiff_t segmentStart = 0;
+		ptrdiff_t segmentLength = 0;
+		rv.SegmentAt(2, segmentStart, segmentLength);
+		REQUIRE(segmentStart <= 2);
+		REQUIRE((segmentStart + segmentLength) >= 9);
+		REQUIRE(nullptr == rv.RangePointer(10, 5));
+	}
+
+	SECTION("SegmentAt") {
+		rv.InsertValue(0, 10, 0);
+		ptrdiff_t position = 0;
+		while (position < rv.Length()) {
+			ptrdiff_t segmentStart = 0;
+			ptrdiff_t segmentLength = 0;
+			const int *segment = rv.SegmentAt(position, segmentStart, segmentLength);
+			REQUIRE(segment);
+			REQUIRE(segmentStart == position);
+			REQUIRE(segmentLength > 0);
+			REQUIRE(segmentLength <= smallBlock);
+			position += segmentLength;
+		}
+		REQUIRE(position == rv.Length());
+	}
+
+	SECTION("OutsideBounds") {
+		rv.InsertValue(0, 10, 87);
+		REQUIRE(0 == rv.ValueAt(-1));
+		REQUIRE(0 == rv.ValueAt(10));
+	}
+
+}
+
+TEST_CASE("RopeVectorLong") {
+
+	// Compare with std::string after many pseudo-random modifications
+
+	SECTION("Random") {
+		RopeVector<char> rv(16);
+		std::string s;
+		RandomSequence rseq;
+		for (int i = 0; i < 20000; i++) {
+			const int r = rseq.Next() % 10;
+			if (r <= 4) {
+				const ptrdiff_t pos = rseq.Next() % (s.length() + 1);
+				const int len = rseq.Next() % 40 + 1;
+				std::string sInsert;
+				for (int j = 0; j < len; j++) {
+					sInsert.push_back(static_cast<char>('a' + (i + j) % 26));
+				}
+				rv.InsertFromArray(pos, sInsert.c_str(), 0, len);
+				s.insert(pos, sInsert);
+			} else if (r <= 8) {
+				const ptrdiff_t pos = rseq.Next() % (s.length() + 1);
+				const ptrdiff_t len = std::min<ptrdiff_t>(rseq.Next() % 40 + 1, s.length() - pos);
+				rv.DeleteRange(pos, len);
+				s.erase(pos, len);
+			} else if (!s.empty()) {
+				const ptrdiff_t pos = rseq.Next() % s.length();
+				rv.SetValueAt(pos, 'Z');
+				s[pos] = 'Z';
+			}
+			REQUIRE(static_cast<ptrdiff_t>(s.length()) == rv.Length());
+		}
+		REQUIRE(s == Contents(rv));
+		rv.Check();
+		// Block count stays near minimum and tree stays balanced
+		REQUIRE(rv.Blocks() <= (rv.Length() / 16 + 1) * 3);
+		REQUIRE(rv.Depth() < 40);
+	}
+
+	SECTION("Large") {
+		RopeVector<char> rv(64);
+		std::string s(100000, 'x');
+		rv.InsertFromArray(0, s.c_str(), 0, s.length());
+		for (int i = 0; i < 1000; i++) {
+			const ptrdiff_t pos = (i * 7919) % (s.length() + 1);
+			rv.InsertFromArray(pos, "ab", 0, 2);
+			s.insert(pos, "ab");
+		}
+		REQUIRE(s == Contents(rv));
+		REQUIRE(rv.Depth() < 60);
+		rv.Check();
+	}
+}
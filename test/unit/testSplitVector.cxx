@@ -371,6 +371,66 @@ TEST_CASE("SplitVector") {
 		REQUIRE(lengthAfterInsertion == sv.GapPosition());
 	}
 
+	SECTION("SegmentAt") {
+		sv.InsertFromArray(0, testArray, 0, lengthTestArray);
+		sv.Insert(1, 99);	// Gap after first element
+		ptrdiff_t segmentStart = -1;
+		ptrdiff_t segmentLength = -1;
+		const int *segment = sv.SegmentAt(0, segmentStart, segmentLength);
+		REQUIRE(0 == segmentStart);
+		REQUIRE(2 == segmentLength);
+		REQUIRE(3 == segment[0]);
+		REQUIRE(99 == segment[1]);
+		segment = sv.SegmentAt(3, segmentStart, segmentLength);
+		REQUIRE(2 == segmentStart);
+		REQUIRE(3 == segmentLength);
+		REQUIRE(4 == segment[0]);
+		REQUIRE(6 == segment[2]);
+	}
+
+	SECTION("FillRange") {
+		sv.InsertValue(0, 10, 0);
+		sv.InsertValue(3, 1, 1);	// Gap after position 3
+		REQUIRE(sv.FillRange(2, 4, 5));
+		REQUIRE(!sv.FillRange(2, 4, 5));
+		for (int i=0; i<sv.Length(); i++) {
+			REQUIRE((((i >= 2) && (i < 6)) ? 5 : 0) == sv.ValueAt(i));
+		}
+	}
+
+	SECTION("RangeAddDelta") {
+		for (int i=0; i<40; i++) {
+			sv.Insert(i, i);
+		}
+		sv.Insert(13, 100);	// Gap after position 13
+		sv.Delete(13);
+		sv.RangeAddDelta(3, 30, 1000);
+		for (int i=0; i<sv.Length(); i++) {
+			REQUIRE((((i >= 3) && (i < 33)) ? i + 1000 : i) == sv.ValueAt(i));
+		}
+		sv.RangeAddDelta(0, 40, -1000);
+		REQUIRE(-1000 == sv.ValueAt(0));
+		REQUIRE(5 == sv.ValueAt(5));
+		REQUIRE(-961 == sv.ValueAt(39));
+	}
+
+	SECTION("AddDelta") {
+		// Every length and alignment for each integer size
+		for (ptrdiff_t start=0; start<4; start++) {
+			for (ptrdiff_t length=0; length<40; length++) {
+				std::vector<int> ints(48, 7);
+				AddDelta(ints.data() + start, length, 3);
+				std::vector<ptrdiff_t> positions(48, 7);
+				AddDelta(positions.data() + start, length, static_cast<ptrdiff_t>(-3));
+				for (ptrdiff_t i=0; i<48; i++) {
+					const bool inRange = (i >= start) && (i < start + length);
+					REQUIRE((inRange ? 10 : 7) == ints[i]);
+					REQUIRE((inRange ? 4 : 7) == positions[i]);
+				}
+			}
+		}
+	}
+
 	SECTION("DeleteBackAndForth") {
 		sv.InsertValue(0, 10, 87);
 		for (int i=0; i<10; i+=2) {
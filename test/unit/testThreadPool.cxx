@@ -0,0 +1,124 @@
+/** @file testThreadPool.cxx
+ ** Unit Tests for Scintilla internal data structures
+ **/
+
+#include <cstddef>
+
+#include <stdexcept>
+#include <exception>
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "Debugging.h"
+
+#include "ThreadPool.h"
+
+#include "catch.hpp"
+
+using namespace Scintilla::Internal;
+
+// Test ThreadPool.
+
+namespace {
+
+// Add up the numbers below items with each participant taking numbers from a counter
+size_t SumInPool(ThreadPool &pool, size_t threads, size_t items) {
+	std::atomic<size_t> nextIndex = 0;
+	std::atomic<size_t> total = 0;
+	pool.Run(threads, [&nextIndex, &total, items](size_t) {
+		while (true) {
+			const size_t i = nextIndex.fetch_add(1);
+			if (i >= items) {
+				break;
+			}
+			total += i;
+		}
+	});
+	return total;
+}
+
+}
+
+TEST_CASE("ThreadPool") {
+
+	ThreadPool pool;
+	constexpr size_t items = 10000;
+	constexpr size_t sum = items * (items - 1) / 2;
+
+	SECTION("IsEmptyInitially") {
+		REQUIRE(1 == pool.Threads());
+	}
+
+	SECTION("SingleThread") {
+		REQUIRE(sum == SumInPool(pool, 1, items));
+		REQUIRE(1 == pool.Threads());
+	}
+
+	SECTION("Reused") {
+		// Workers remain for later calls
+		for (int run = 0; run < 100; run++) {
+			REQUIRE(sum == SumInPool(pool, 4, items));
+		}
+		REQUIRE(4 == pool.Threads());
+		pool.Stop();
+		REQUIRE(1 == pool.Threads());
+		REQUIRE(sum == SumInPool(pool, 2, items));
+	}
+
+	SECTION("DistinctParticipants") {
+		std::vector<int> seen(4);
+		std::mutex mutexSeen;
+		pool.Run(4, [&seen, &mutexSeen](size_t participant) {
+			std::lock_guard<std::mutex> guard(mutexSeen);
+			seen.at(participant)++;
+		});
+		REQUIRE(1 == seen[0]);
+		for (const int count : seen) {
+			REQUIRE(count <= 1);
+		}
+	}
+
+	SECTION("Nested") {
+		// Running from inside a task is performed by that task's thread
+		std::atomic<size_t> total = 0;
+		pool.Run(3, [&pool, &total](size_t) {
+			total += SumInPool(pool, 3, 100);
+		});
+		REQUIRE(total % 4950 == 0);
+		REQUIRE(total >= 4950);
+	}
+
+	SECTION("ConcurrentCallers") {
+		// Callers on other threads either claim the pool or run their task on their own thread
+		std::vector<size_t> totals(4);
+		std::vector<std::thread> callers;
+		for (size_t caller = 0; caller < totals.size(); caller++) {
+			callers.emplace_back([&pool, &totals, caller]() {
+				for (int run = 0; run < 50; run++) {
+					totals[caller] += SumInPool(pool, 3, items);
+				}
+			});
+		}
+		for (std::thread &caller : callers) {
+			caller.join();
+		}
+		for (const size_t total : totals) {
+			REQUIRE(50 * sum == total);
+		}
+		REQUIRE(3 == pool.Threads());
+	}
+
+	SECTION("Exception") {
+		REQUIRE_THROWS_AS(pool.Run(4, [](size_t participant) {
+			if (participant == 0) {
+				throw std::runtime_error("failed");
+			}
+		}), std::runtime_error);
+		// Still usable after an exception
+		REQUIRE(sum == SumInPool(pool, 4, items));
+	}
+}
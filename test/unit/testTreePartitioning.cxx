@@ -0,0 +1,316 @@
+/** @file testTreePartitioning.cxx
+ ** Unit Tests for Scintilla internal data structures
+ **/
+
+#include <cstddef>
+#include <cstring>
+
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <memory>
+#include <iostream>
+
+#include "Debugging.h"
+
+#include "Position.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "TreePartitioning.h"
+#include "RunStyles.h"
+
+#include "catch.hpp"
+
+using namespace Scintilla::Internal;
+
+// Test TreePartitioning.
+
+namespace {
+
+class RandomSequence {
+	static constexpr int mult = 109;
+	static constexpr int incr = 853;
+	static constexpr int modulus = 4096;
+	int randomValue = 127;
+public:
+	int Next() noexcept {
+		randomValue = (mult * randomValue + incr) % modulus;
+		return randomValue;
+	}
+};
+
+template <typename P1, typename P2>
+bool SamePartitions(const P1 &p1, const P2 &p2) {
+	if (p1.Partitions() != p2.Partitions())
+		return false;
+	for (Sci::Position partition = 0; partition <= p1.Partitions(); partition++) {
+		if (p1.PositionFromPartition(partition) != p2.PositionFromPartition(partition))
+			return false;
+	}
+	for (Sci::Position pos = -1; pos <= p1.Length() + 1; pos++) {
+		if (p1.PartitionFromPosition(pos) != p2.PartitionFromPosition(pos))
+			return false;
+	}
+	return true;
+}
+
+// Lines of a document with pseudo-random lengths
+template <typename PARTITIONING>
+void FillLines(PARTITIONING &part, Sci::Position lines) {
+	std::vector<Sci::Position> positions;
+	Sci::Position position = 0;
+	for (Sci::Position line = 1; line <= lines; line++) {
+		position += 1 + line % 97;
+		positions.push_back(position);
+	}
+	part.InsertText(0, position);
+	part.InsertPartitions(1, positions.data(), positions.size() - 1);
+}
+
+// Edits alternate between the start and end of the document, inserting and removing lines
+template <typename PARTITIONING>
+void AlternatingEdits(PARTITIONING &part, int edits) {
+	RandomSequence rseq;
+	for (int i = 0; i < edits; i++) {
+		const Sci::Position partitions = part.Partitions();
+		const Sci::Position line = (i % 2) ? (rseq.Next() % 100) : (partitions - 1 - rseq.Next() % 100);
+		const Sci::Position start = part.PositionFromPartition(line);
+		if (rseq.Next() % 2) {
+			part.InsertText(line, 2);
+			part.InsertPartition(line + 1, start + 1);
+		} else if (line > 0) {
+			const Sci::Position end = part.PositionFromPartition(line + 1);
+			part.RemovePartition(line);
+			part.InsertText(line - 1, start - end);
+		}
+		part.PartitionFromPosition(start);
+	}
+}
+
+}
+
+TEST_CASE("CompileCopying TreePartitioning") {
+
+	// These are compile-time tests to check that basic copy and move
+	// operations are defined correctly.
+
+	SECTION("CopyingMoving") {
+		TreePartitioning<int> s;
+		TreePartitioning<int> s2;
+
+		// Copy constructor
+		const TreePartitioning<int> sa(s);
+		// Copy assignment
+		TreePartitioning<int> sb;
+		sb = s;
+
+		// Move constructor
+		const TreePartitioning<int> sc(std::move(s));
+		// Move assignment
+		TreePartitioning<int> sd;
+		sd = (std::move(s2));
+	}
+
+}
+
+TEST_CASE("FenwickTree") {
+
+	FenwickTree<int> ft;
+
+	SECTION("Sums") {
+		for (int i = 0; i < 10; i++) {
+			ft.PushBack(i);
+		}
+		REQUIRE(10 == ft.Length());
+		REQUIRE(0 == ft.Sum(0));
+		REQUIRE(45 == ft.Sum(10));
+		REQUIRE(10 == ft.Sum(5));
+		ft.Add(2, 5);
+		REQUIRE(1 == ft.Sum(2));
+		REQUIRE(8 == ft.Sum(3));
+		int remainder = 0;
+		REQUIRE(3 == ft.Search(10, remainder));
+		REQUIRE(2 == remainder);
+		REQUIRE(10 == ft.Search(1000, remainder));
+	}
+
+	SECTION("FlattenBuild") {
+		for (int i = 0; i < 13; i++) {
+			ft.PushBack(i + 1);
+		}
+		ft.Flatten();
+		for (size_t i = 0; i < 13; i++) {
+			REQUIRE(static_cast<int>(i + 1) == ft.Value(i));
+		}
+		const int values[] = { 100, 200 };
+		ft.Insert(4, std::begin(values), std::end(values));
+		ft.Erase(0);
+		ft.Build();
+		REQUIRE(14 == ft.Length());
+		REQUIRE(2 + 3 + 4 + 100 == ft.Sum(4));
+		REQUIRE(91 - 1 + 300 == ft.Sum(14));
+	}
+}
+
+TEST_CASE("TreePartitioning") {
+
+	TreePartitioning<Sci::Position> part;
+
+	SECTION("IsEmptyInitially") {
+		REQUIRE(1 == part.Partitions());
+		REQUIRE(0 == part.PositionFromPartition(part.Partitions()));
+		REQUIRE(0 == part.PartitionFromPosition(0));
+	}
+
+	SECTION("TwoPartitions") {
+		part.InsertText(0, 2);
+		part.InsertPartition(1, 1);
+		REQUIRE(2 == part.Partitions());
+		REQUIRE(0 == part.PositionFromPartition(0));
+		REQUIRE(1 == part.PositionFromPartition(1));
+		REQUIRE(2 == part.PositionFromPartition(2));
+	}
+
+	SECTION("MoveStart") {
+		part.InsertText(0, 3);
+		part.InsertPartition(1, 2);
+		part.SetPartitionStartPosition(1,1);
+		REQUIRE(2 == part.Partitions());
+		REQUIRE(0 == part.PositionFromPartition(0));
+		REQUIRE(1 == part.PositionFromPartition(1));
+		REQUIRE(3 == part.PositionFromPartition(2));
+		part.Check();
+	}
+
+	SECTION("InverseSearch") {
+		part.InsertText(0, 3);
+		part.InsertPartition(1, 2);
+		part.SetPartitionStartPosition(1,1);
+		REQUIRE(0 == part.PartitionFromPosition(0));
+		REQUIRE(1 == part.PartitionFromPosition(1));
+		REQUIRE(1 == part.PartitionFromPosition(2));
+		REQUIRE(1 == part.PartitionFromPosition(3));
+		REQUIRE(1 == part.PartitionFromPosition(100));
+		REQUIRE(0 == part.PartitionFromPosition(-1));
+	}
+
+	SECTION("DeleteAll") {
+		FillLines(part, 5000);
+		part.DeleteAll();
+		REQUIRE(1 == part.Partitions());
+		REQUIRE(0 == part.PositionFromPartition(1));
+		part.Check();
+	}
+
+	SECTION("MatchesPartitioning") {
+		// Perform the same operations on both and compare
+		Partitioning<Sci::Position> step(8);
+		FillLines(part, 5000);
+		FillLines(step, 5000);
+		REQUIRE(SamePartitions(step, part));
+		RandomSequence rseq;
+		for (int i = 0; i < 20000; i++) {
+			const int r = rseq.Next() % 10;
+			const Sci::Position partitions = part.Partitions();
+			const Sci::Position partition = rseq.Next() * partitions / 4096;
+			const Sci::Position start = part.PositionFromPartition(partition);
+			const Sci::Position end = part.PositionFromPartition(partition + 1);
+			REQUIRE(start == step.PositionFromPartition(partition));
+			if (r <= 3) {
+				// Insert text
+				const Sci::Position delta = rseq.Next() % 20 + 1;
+				part.InsertText(partition, delta);
+				step.InsertText(partition, delta);
+			} else if (r <= 5) {
+				// Split partition
+				if (end - start > 1) {
+					part.InsertPartition(partition + 1, start + 1);
+					step.InsertPartition(partition + 1, start + 1);
+				}
+			} else if (r <= 7) {
+				// Merge partition with previous
+				if ((partition > 0) && (partitions > 1)) {
+					part.RemovePartition(partition);
+					step.RemovePartition(partition);
+				}
+			} else if (r == 8) {
+				// Delete text
+				if (end - start > 1) {
+					part.InsertText(partition, -1);
+					step.InsertText(partition, -1);
+				}
+			} else {
+				// Insert many partitions
+				const Sci::Position positions[] = { start + 1, start + 2, start + 3 };
+				part.InsertText(partition, 4);
+				step.InsertText(partition, 4);
+				part.InsertPartitions(partition + 1, positions, std::size(positions));
+				step.InsertPartitions(partition + 1, positions, std::size(positions));
+			}
+			REQUIRE(part.Partitions() == step.Partitions());
+			REQUIRE(part.Length() == step.Length());
+			const Sci::Position pos = rseq.Next() * part.Length() / 4096;
+			REQUIRE(part.PartitionFromPosition(pos) == step.PartitionFromPosition(pos));
+		}
+		REQUIRE(SamePartitions(step, part));
+		part.Check();
+		// Remove nearly all partitions so blocks merge
+		while (part.Partitions() > 2) {
+			const Sci::Position partition = part.Partitions() / 2;
+			part.RemovePartition(partition);
+			step.RemovePartition(partition);
+		}
+		REQUIRE(SamePartitions(step, part));
+		part.Check();
+	}
+}
+
+TEST_CASE("TreePartitioningRunStyles") {
+
+	// RunStyles may be instantiated with TreePartitioning
+
+	RunStyles<int, int, TreePartitioning<int>> rs;
+	rs.InsertSpace(0, 10000);
+	for (int i = 0; i < 9999; i += 3) {
+		rs.FillRange(i, i % 7, 2);
+	}
+	for (int i = 0; i < 9999; i++) {
+		REQUIRE(((i % 3) == 2 ? 0 : (i - i % 3) % 7) == rs.ValueAt(i));
+	}
+	rs.DeleteRange(10, 9000);
+	REQUIRE(1000 == rs.Length());
+	REQUIRE(3 == rs.ValueAt(12));	// Was at 9012
+	rs.Check();
+}
+
+TEST_CASE("TreePartitioningBenchmark", "[.benchmark]") {
+
+	// Compare the step scheme with the tree for a 20 million line document
+	// with edits alternating between its start and end.
+	constexpr Sci::Position lines = 20'000'000;
+
+	SECTION("Step") {
+		// Each edit may move every line so only perform a few
+		constexpr int edits = 200;
+		Partitioning<Sci::Position> part(256);
+		FillLines(part, lines);
+		Catch::Timer tikka;
+		tikka.start();
+		AlternatingEdits(part, edits);
+		const double duration = tikka.getElapsedSeconds();
+		std::cout << "Partitioning alternating edits: " << edits / duration << " edits per second\n";
+	}
+
+	SECTION("Tree") {
+		constexpr int edits = 100000;
+		TreePartitioning<Sci::Position> part(256);
+		FillLines(part, lines);
+		Catch::Timer tikka;
+		tikka.start();
+		AlternatingEdits(part, edits);
+		const double duration = tikka.getElapsedSeconds();
+		std::cout << "TreePartitioning alternating edits: " << edits / duration << " edits per second\n";
+	}
+}
@@ -72,6 +72,45 @@ $(DIR_O)/AutoComplete.o: \
 	../src/CharacterType.h \
 	../src/Position.h \
 	../src/AutoComplete.h
+$(DIR_O)/BackgroundWrap.o: \
+	../src/BackgroundWrap.cxx \
+	../include/ScintillaTypes.h \
+	../include/ScintillaMessages.h \
+	../include/ScintillaStructures.h \
+	../include/ILoader.h \
+	../include/Sci_Position.h \
+	../include/ILexer.h \
+	../src/Debugging.h \
+	../src/Geometry.h \
+	../src/Platform.h \
+	../src/CharacterType.h \
+	../src/CharacterCategoryMap.h \
+	../src/Position.h \
+	../src/UniqueString.h \
+	../src/SplitVector.h \
+	../src/Partitioning.h \
+	../src/RunStyles.h \
+	../src/ContractionState.h \
+	../src/CellBuffer.h \
+	../src/PerLine.h \
+	../src/KeyMap.h \
+	../src/Indicator.h \
+	../src/LineMarker.h \
+	../src/Style.h \
+	../src/ViewStyle.h \
+	../src/CharClassify.h \
+	../src/Decoration.h \
+	../src/CaseFolder.h \
+	../src/Document.h \
+	../src/UniConversion.h \
+	../src/Selection.h \
+	../src/PositionCache.h \
+	../src/EditModel.h \
+	../src/MarginView.h \
+	../src/EditView.h \
+	../src/ElapsedPeriod.h \
+	../src/ThreadPool.h \
+	../src/BackgroundWrap.h
 $(DIR_O)/CallTip.o: \
 	../src/CallTip.cxx \
 	../include/ScintillaTypes.h \
@@ -96,7 +135,10 @@ $(DIR_O)/CellBuffer.o: \
 	../src/Debugging.h \
 	../src/Position.h \
 	../src/SplitVector.h \
+	../src/RopeVector.h \
 	../src/Partitioning.h \
+	../src/TreePartitioning.h \
+	../src/PieceTable.h \
 	../src/RunStyles.h \
 	../src/SparseVector.h \
 	../src/ChangeHistory.h \
@@ -130,6 +172,7 @@ $(DIR_O)/ContractionState.o: \
 	../src/UniqueString.h \
 	../src/SplitVector.h \
 	../src/Partitioning.h \
+	../src/TreePartitioning.h \
 	../src/RunStyles.h \
 	../src/SparseVector.h \
 	../src/ContractionState.h
@@ -165,8 +208,10 @@ $(DIR_O)/Document.o: \
 	../src/CaseFolder.h \
 	../src/Document.h \
 	../src/RESearch.h \
+	../src/LinearRegex.h \
 	../src/UniConversion.h \
-	../src/ElapsedPeriod.h
+	../src/ElapsedPeriod.h \
+	../src/ThreadPool.h
 $(DIR_O)/EditModel.o: \
 	../src/EditModel.cxx \
 	../include/ScintillaTypes.h \
@@ -234,7 +279,9 @@ $(DIR_O)/Editor.o: \
 	../src/MarginView.h \
 	../src/EditView.h \
 	../src/Editor.h \
-	../src/ElapsedPeriod.h
+	../src/ElapsedPeriod.h \
+	../src/ThreadPool.h \
+	../src/BackgroundWrap.h
 $(DIR_O)/EditView.o: \
 	../src/EditView.cxx \
 	../include/ScintillaTypes.h \
@@ -271,7 +318,8 @@ $(DIR_O)/EditView.o: \
 	../src/EditModel.h \
 	../src/MarginView.h \
 	../src/EditView.h \
-	../src/ElapsedPeriod.h
+	../src/ElapsedPeriod.h \
+	../src/ThreadPool.h
 $(DIR_O)/Geometry.o: \
 	../src/Geometry.cxx \
 	../src/Geometry.h
@@ -291,6 +339,27 @@ $(DIR_O)/KeyMap.o: \
 	../src/Geometry.h \
 	../src/Platform.h \
 	../src/KeyMap.h
+$(DIR_O)/LinearRegex.o: \
+	../src/LinearRegex.cxx \
+	../include/ScintillaTypes.h \
+	../include/ILoader.h \
+	../include/Sci_Position.h \
+	../include/ILexer.h \
+	../src/Debugging.h \
+	../src/CharacterType.h \
+	../src/CharacterCategoryMap.h \
+	../src/Position.h \
+	../src/SplitVector.h \
+	../src/Partitioning.h \
+	../src/RunStyles.h \
+	../src/CellBuffer.h \
+	../src/PerLine.h \
+	../src/CharClassify.h \
+	../src/Decoration.h \
+	../src/CaseFolder.h \
+	../src/Document.h \
+	../src/LinearRegex.h \
+	../src/UniConversion.h
 $(DIR_O)/LineMarker.o: \
 	../src/LineMarker.cxx \
 	../include/ScintillaTypes.h \
@@ -388,6 +457,7 @@ $(DIR_O)/RunStyles.o: \
 	../src/Position.h \
 	../src/SplitVector.h \
 	../src/Partitioning.h \
+	../src/TreePartitioning.h \
 	../src/RunStyles.h
 $(DIR_O)/ScintillaBase.o: \
 	../src/ScintillaBase.cxx \
@@ -431,6 +501,10 @@ $(DIR_O)/Selection.o: \
 	../src/Debugging.h \
 	../src/Position.h \
 	../src/Selection.h
+$(DIR_O)/SplitVector.o: \
+	../src/SplitVector.cxx \
+	../src/Debugging.h \
+	../src/SplitVector.h
 $(DIR_O)/Style.o: \
 	../src/Style.cxx \
 	../include/ScintillaTypes.h \
@@ -438,6 +512,9 @@ $(DIR_O)/Style.o: \
 	../src/Geometry.h \
 	../src/Platform.h \
 	../src/Style.h
+$(DIR_O)/ThreadPool.o: \
+	../src/ThreadPool.cxx \
+	../src/ThreadPool.h
 $(DIR_O)/UndoHistory.o: \
 	../src/UndoHistory.cxx \
 	../include/ScintillaTypes.h \
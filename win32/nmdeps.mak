@@ -72,6 +72,45 @@ $(DIR_O)/AutoComplete.obj: \
 	../src/CharacterType.h \
 	../src/Position.h \
 	../src/AutoComplete.h
+$(DIR_O)/BackgroundWrap.obj: \
+	../src/BackgroundWrap.cxx \
+	../include/ScintillaTypes.h \
+	../include/ScintillaMessages.h \
+	../include/ScintillaStructures.h \
+	../include/ILoader.h \
+	../include/Sci_Position.h \
+	../include/ILexer.h \
+	../src/Debugging.h \
+	../src/Geometry.h \
+	../src/Platform.h \
+	../src/CharacterType.h \
+	../src/CharacterCategoryMap.h \
+	../src/Position.h \
+	../src/UniqueString.h \
+	../src/SplitVector.h \
+	../src/Partitioning.h \
+	../src/RunStyles.h \
+	../src/ContractionState.h \
+	../src/CellBuffer.h \
+	../src/PerLine.h \
+	../src/KeyMap.h \
+	../src/Indicator.h \
+	../src/LineMarker.h \
+	../src/Style.h \
+	../src/ViewStyle.h \
+	../src/CharClassify.h \
+	../src/Decoration.h \
+	../src/CaseFolder.h \
+	../src/Document.h \
+	../src/UniConversion.h \
+	../src/Selection.h \
+	../src/PositionCache.h \
+	../src/EditModel.h \
+	../src/MarginView.h \
+	../src/EditView.h \
+	../src/ElapsedPeriod.h \
+	../src/ThreadPool.h \
+	../src/BackgroundWrap.h
 $(DIR_O)/CallTip.obj: \
 	../src/CallTip.cxx \
 	../include/ScintillaTypes.h \
@@ -96,7 +135,10 @@ $(DIR_O)/CellBuffer.obj: \
 	../src/Debugging.h \
 	../src/Position.h \
 	../src/SplitVector.h \
+	../src/RopeVector.h \
 	../src/Partitioning.h \
+	../src/TreePartitioning.h \
+	../src/PieceTable.h \
 	../src/RunStyles.h \
 	../src/SparseVector.h \
 	../src/ChangeHistory.h \
@@ -130,6 +172,7 @@ $(DIR_O)/ContractionState.obj: \
 	../src/UniqueString.h \
 	../src/SplitVector.h \
 	../src/Partitioning.h \
+	../src/TreePartitioning.h \
 	../src/RunStyles.h \
 	../src/SparseVector.h \
 	../src/ContractionState.h
@@ -165,8 +208,10 @@ $(DIR_O)/Document.obj: \
 	../src/CaseFolder.h \
 	../src/Document.h \
 	../src/RESearch.h \
+	../src/LinearRegex.h \
 	../src/UniConversion.h \
-	../src/ElapsedPeriod.h
+	../src/ElapsedPeriod.h \
+	../src/ThreadPool.h
 $(DIR_O)/EditModel.obj: \
 	../src/EditModel.cxx \
 	../include/ScintillaTypes.h \
@@ -234,7 +279,9 @@ $(DIR_O)/Editor.obj: \
 	../src/MarginView.h \
 	../src/EditView.h \
 	../src/Editor.h \
-	../src/ElapsedPeriod.h
+	../src/ElapsedPeriod.h \
+	../src/ThreadPool.h \
+	../src/BackgroundWrap.h
 $(DIR_O)/EditView.obj: \
 	../src/EditView.cxx \
 	../include/ScintillaTypes.h \
@@ -271,7 +318,8 @@ $(DIR_O)/EditView.obj: \
 	../src/EditModel.h \
 	../src/MarginView.h \
 	../src/EditView.h \
-	../src/ElapsedPeriod.h
+	../src/ElapsedPeriod.h \
+	../src/ThreadPool.h
 $(DIR_O)/Geometry.obj: \
 	../src/Geometry.cxx \
 	../src/Geometry.h
@@ -291,6 +339,27 @@ $(DIR_O)/KeyMap.obj: \
 	../src/Geometry.h \
 	../src/Platform.h \
 	../src/KeyMap.h
+$(DIR_O)/LinearRegex.obj: \
+	../src/LinearRegex.cxx \
+	../include/ScintillaTypes.h \
+	../include/ILoader.h \
+	../include/Sci_Position.h \
+	../include/ILexer.h \
+	../src/Debugging.h \
+	../src/CharacterType.h \
+	../src/CharacterCategoryMap.h \
+	../src/Position.h \
+	../src/SplitVector.h \
+	../src/Partitioning.h \
+	../src/RunStyles.h \
+	../src/CellBuffer.h \
+	../src/PerLine.h \
+	../src/CharClassify.h \
+	../src/Decoration.h \
+	../src/CaseFolder.h \
+	../src/Document.h \
+	../src/LinearRegex.h \
+	../src/UniConversion.h
 $(DIR_O)/LineMarker.obj: \
 	../src/LineMarker.cxx \
 	../include/ScintillaTypes.h \
@@ -388,6 +457,7 @@ $(DIR_O)/RunStyles.obj: \
 	../src/Position.h \
 	../src/SplitVector.h \
 	../src/Partitioning.h \
+	../src/TreePartitioning.h \
 	../src/RunStyles.h
 $(DIR_O)/ScintillaBase.obj: \
 	../src/ScintillaBase.cxx \
@@ -431,6 +501,10 @@ $(DIR_O)/Selection.obj: \
 	../src/Debugging.h \
 	../src/Position.h \
 	../src/Selection.h
+$(DIR_O)/SplitVector.obj: \
+	../src/SplitVector.cxx \
+	../src/Debugging.h \
+	../src/SplitVector.h
 $(DIR_O)/Style.obj: \
 	../src/Style.cxx \
 	../include/ScintillaTypes.h \
@@ -438,6 +512,9 @@ $(DIR_O)/Style.obj: \
 	../src/Geometry.h \
 	../src/Platform.h \
 	../src/Style.h
+$(DIR_O)/ThreadPool.obj: \
+	../src/ThreadPool.cxx \
+	../src/ThreadPool.h
 $(DIR_O)/UndoHistory.obj: \
 	../src/UndoHistory.cxx \
 	../include/ScintillaTypes.h \
@@ -78,6 +78,7 @@ depend:
 # Required for base Scintilla
 SRC_OBJS=\
 	$(DIR_O)\AutoComplete.obj \
+	$(DIR_O)\BackgroundWrap.obj \
 	$(DIR_O)\CallTip.obj \
 	$(DIR_O)\CaseConvert.obj \
 	$(DIR_O)\CaseFolder.obj \
@@ -96,6 +97,7 @@ SRC_OBJS=\
 	$(DIR_O)\Geometry.obj \
 	$(DIR_O)\Indicator.obj \
 	$(DIR_O)\KeyMap.obj \
+	$(DIR_O)\LinearRegex.obj \
 	$(DIR_O)\LineMarker.obj \
 	$(DIR_O)\MarginView.obj \
 	$(DIR_O)\PerLine.obj \
@@ -103,7 +105,9 @@ SRC_OBJS=\
 	$(DIR_O)\RESearch.obj \
 	$(DIR_O)\RunStyles.obj \
 	$(DIR_O)\Selection.obj \
+	$(DIR_O)\SplitVector.obj \
 	$(DIR_O)\Style.obj \
+	$(DIR_O)\ThreadPool.obj \
 	$(DIR_O)\UndoHistory.obj \
 	$(DIR_O)\UniConversion.obj \
 	$(DIR_O)\UniqueString.obj \